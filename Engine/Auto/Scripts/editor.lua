@@ -77,6 +77,52 @@ project("Editor")
 		}
 	end
 
+	if ENABLE_SHADERC_LIBRARY then
+		dependson { "fcpp", "glslang", "glsl-optimizer", "spirv-cross", "spirv-opt" }
+
+		defines {
+			"ENABLE_SHADERC_LIBRARY"
+		}
+
+		local shadercSourcePath = path.join(ThirdPartySourcePath, "bgfx/tools/shaderc")
+		local bgfx3rdPartyPath = path.join(ThirdPartySourcePath, "bgfx/3rdparty")
+		files {
+			path.join(shadercSourcePath, "*.cpp"),
+			path.join(shadercSourcePath, "*.h"),
+		}
+
+		vpaths {
+			["shaderc"] = {
+				path.join(shadercSourcePath, "*.cpp"),
+				path.join(shadercSourcePath, "*.h"),
+			},
+		}
+
+		includedirs {
+			shadercSourcePath,
+			path.join(ThirdPartySourcePath, "bgfx/src"),
+			path.join(bgfx3rdPartyPath, "dxsdk/include"),
+			path.join(bgfx3rdPartyPath, "fcpp"),
+			path.join(bgfx3rdPartyPath, "glslang/glslang/Public"),
+			path.join(bgfx3rdPartyPath, "glslang/glslang/Include"),
+			path.join(bgfx3rdPartyPath, "glslang"),
+			path.join(bgfx3rdPartyPath, "glsl-optimizer/include"),
+			path.join(bgfx3rdPartyPath, "glsl-optimizer/src/glsl"),
+			path.join(bgfx3rdPartyPath, "spirv-cross"),
+			path.join(bgfx3rdPartyPath, "spirv-tools/include"),
+		}
+
+		links {
+			"fcpp", "glslang", "glsl-optimizer", "spirv-cross", "spirv-opt",
+		}
+
+		-- shaderc is a third party console application. Rename its main function and don't treat its warnings as errors.
+		filter { "files:"..path.join(shadercSourcePath, "*.cpp") }
+			defines { "main=shadercMain" }
+			warnings("Off")
+		filter {}
+	end
+
 	-- use /MT /MTd, not /MD /MDd
 	staticruntime "on"
 	filter { "configurations:Debug" }
@@ -40,6 +40,13 @@ ENABLE_SPDLOG = not USE_CLANG_TOOLSET and not IsLinuxPlatform() and not IsAndroi
 ENABLE_SUBPROCESS = not USE_CLANG_TOOLSET and not IsLinuxPlatform() and not IsAndroidPlatform()
 ENABLE_TRACY = not USE_CLANG_TOOLSET and not IsLinuxPlatform() and not IsAndroidPlatform()
 
+-- Link bgfx shaderc to Editor so that shaders are compiled in the editor process instead of shaderc processes.
+-- It requires shaderc dependencies to be built by bgfx's genie projects.
+ENABLE_SHADERC_LIBRARY = false
+if os.getenv("ENABLE_SHADERC_LIBRARY") then
+	ENABLE_SHADERC_LIBRARY = IsWindowsPlatform() and not USE_CLANG_TOOLSET
+end
+
 PlatformSettings = {}
 PlatformSettings["Windows"] = {
 	DisplayName = "Win64",
@@ -12,6 +12,7 @@ function MakeTest(testName)
 	project(testName)
 		kind("ConsoleApp")
 		SetLanguageAndToolset("Tests/"..testName)
+		dependson { "Engine" }
 
 		files {
 			path.join(testSourcePath, "**.*"),
@@ -28,8 +29,13 @@ function MakeTest(testName)
 			path.join(EnginePath, "BuiltInShaders/UniformDefines"),
 		}
 
-		-- convenient to test multiple threads
-		openmp("On")
+		-- Engine is a static library so only the object files referenced by tests are linked.
+		libdirs {
+			BinariesPath,
+		}
+		links {
+			"Engine",
+		}
 
 		-- use /MT /MTd, not /MD /MDd
 		staticruntime "on"
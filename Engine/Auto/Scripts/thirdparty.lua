@@ -122,5 +122,15 @@ group "ThirdParty/bgfx"
 --		location(bgfxProjectsPath)
 --		targetdir(BinariesPath)
 
+if ENABLE_SHADERC_LIBRARY then
+	group "ThirdParty/bgfx/tools/shaderc"
+		for _, projectName in ipairs({ "fcpp", "glslang", "glsl-optimizer", "spirv-cross", "spirv-opt" }) do
+			externalproject(projectName)
+				kind("StaticLib")
+				location(bgfxProjectsPath)
+				targetdir(BinariesPath)
+		end
+end
+
 group ""
 --print("================================================================")
\ No newline at end of file
@@ -0,0 +1,13 @@
+#define GPU_DRIVEN_THREAD_COUNT 64
+
+// vec4s of an instance in the culling input : world matrix columns, world box center and draw command index, world box extents and always visible flag.
+#define GPU_DRIVEN_INSTANCE_VEC4_COUNT 6
+// uints of a draw command : index count, first index, base vertex, first instance.
+#define GPU_DRIVEN_DRAW_COMMAND_UINT_COUNT 4
+
+#define GPU_DRIVEN_INSTANCE_INPUT_SLOT 0
+#define GPU_DRIVEN_DRAW_COMMAND_SLOT 1
+#define GPU_DRIVEN_INSTANCE_COUNT_SLOT 2
+#define GPU_DRIVEN_INSTANCE_OUTPUT_SLOT 3
+#define GPU_DRIVEN_DRAW_INDIRECT_SLOT 4
+#define GPU_DRIVEN_HIZ_SLOT 5
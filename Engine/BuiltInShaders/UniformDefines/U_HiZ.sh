@@ -0,0 +1,4 @@
+#define HIZ_THREAD_COUNT 8
+
+#define HIZ_SOURCE_SLOT 0
+#define HIZ_TARGET_SLOT 1
@@ -0,0 +1,11 @@
+#define LIGHT_CLUSTER_X_COUNT 16
+#define LIGHT_CLUSTER_Y_COUNT 9
+#define LIGHT_CLUSTER_Z_COUNT 24
+
+#define MAX_CLUSTERED_LIGHT_COUNT 4096
+#define LIGHT_INDEX_TEXTURE_WIDTH 1024
+#define LIGHT_INDEX_TEXTURE_HEIGHT 128
+
+#define LIGHT_CLUSTER_SLOT 8
+#define LIGHT_INDEX_SLOT 9
+#define LIGHT_PARAMS_SLOT 10
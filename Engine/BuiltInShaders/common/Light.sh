@@ -1,13 +1,27 @@
 // @brief Calculates the contribution of all light sources to the direct light color received by the current fragment.
 // 
 // vec3 CalculateLights(Material material, vec3 worldPos, vec3 viewDir, vec3 diffuseBRDF);
+// 
+// Define CLUSTERED_LIGHTING to shade lights in the light cluster of the fragment only.
 
 #include "../UniformDefines/U_Light.sh"
 
+#if defined(CLUSTERED_LIGHTING)
+#include "LightCluster.sh"
+
+vec4 GetLightVec4(int lightIndex, int vec4Index) {
+	return GetClusteredLightParams(lightIndex, vec4Index);
+}
+#else
 uniform vec4 u_lightCountAndStride;
 uniform vec4 u_lightParams[LIGHT_LENGTH];
 
-U_Light GetLightParams(int pointer) {
+vec4 GetLightVec4(int lightIndex, int vec4Index) {
+	return u_lightParams[int(lightIndex * u_lightCountAndStride.y) + vec4Index];
+}
+#endif
+
+U_Light GetLightParams(int lightIndex) {
 	// struct {
 	//   /*0*/ struct { float type; vec3 position; };
 	//   /*1*/ struct { float intensity; vec3 color; };
@@ -16,19 +30,25 @@ U_Light GetLightParams(int pointer) {
 	//   /*4*/ struct { float width, height, lightAngleScale, lightAngleOffeset; };
 	// }
 	
+	vec4 params0 = GetLightVec4(lightIndex, 0);
+	vec4 params1 = GetLightVec4(lightIndex, 1);
+	vec4 params2 = GetLightVec4(lightIndex, 2);
+	vec4 params3 = GetLightVec4(lightIndex, 3);
+	vec4 params4 = GetLightVec4(lightIndex, 4);
+	
 	U_Light light;
-	light.type              = u_lightParams[pointer + 0].x;
-	light.position          = u_lightParams[pointer + 0].yzw;
-	light.intensity         = u_lightParams[pointer + 1].x;
-	light.color             = u_lightParams[pointer + 1].yzw;
-	light.range             = u_lightParams[pointer + 2].x;
-	light.direction         = u_lightParams[pointer + 2].yzw;
-	light.radius            = u_lightParams[pointer + 3].x;
-	light.up                = u_lightParams[pointer + 3].yzw;
-	light.width             = u_lightParams[pointer + 4].x;
-	light.height            = u_lightParams[pointer + 4].y;
-	light.lightAngleScale   = u_lightParams[pointer + 4].z;
-	light.lightAngleOffeset = u_lightParams[pointer + 4].w;
+	light.type              = params0.x;
+	light.position          = params0.yzw;
+	light.intensity         = params1.x;
+	light.color             = params1.yzw;
+	light.range             = params2.x;
+	light.direction         = params2.yzw;
+	light.radius            = params3.x;
+	light.up                = params3.yzw;
+	light.width             = params4.x;
+	light.height            = params4.y;
+	light.lightAngleScale   = params4.z;
+	light.lightAngleOffeset = params4.w;
 	return light;
 }
 
@@ -542,10 +562,24 @@ vec3 CalculateLight(U_Light light, Material material, vec3 worldPos, vec3 viewDi
 
 vec3 CalculateLights(Material material, vec3 worldPos, vec3 viewDir, vec3 diffuseBRDF) {
 	vec3 color = vec3_splat(0.0);
+#if defined(CLUSTERED_LIGHTING)
+	// Global lights, e.g. directional lights, are at the beginning of light indices.
+	for(int index = 0; index < int(u_lightClusterParams.x); ++index) {
+		U_Light light = GetLightParams(GetClusterLightIndex(index));
+		color += CalculateLight(light, material, worldPos, viewDir, diffuseBRDF);
+	}
+	
+	vec2 lightCluster = GetLightCluster(worldPos);
+	int lightEnd = int(lightCluster.x + lightCluster.y);
+	for(int index = int(lightCluster.x); index < lightEnd; ++index) {
+		U_Light light = GetLightParams(GetClusterLightIndex(index));
+		color += CalculateLight(light, material, worldPos, viewDir, diffuseBRDF);
+	}
+#else
 	for(int lightIndex = 0; lightIndex < int(u_lightCountAndStride.x); ++lightIndex) {
-		int pointer = int(lightIndex * u_lightCountAndStride.y);
-		U_Light light = GetLightParams(pointer);
+		U_Light light = GetLightParams(lightIndex);
 		color += CalculateLight(light, material, worldPos, viewDir, diffuseBRDF);
 	}
+#endif
 	return color;
 }
@@ -0,0 +1,35 @@
+// @brief Finds the light list of the cluster which a fragment belongs to.
+// 
+// vec2 GetLightCluster(vec3 worldPos);
+// int GetClusterLightIndex(int index);
+// vec4 GetClusteredLightParams(int lightIndex, int vec4Index);
+
+// Light lists are built by LightClusterGrid on CPU.
+#include "../UniformDefines/U_LightCluster.sh"
+
+SAMPLER2D(s_lightClusters, LIGHT_CLUSTER_SLOT);
+SAMPLER2D(s_lightIndices, LIGHT_INDEX_SLOT);
+SAMPLER2D(s_lightParams, LIGHT_PARAMS_SLOT);
+
+// x : global light count, y : depth slice scale, z : depth slice bias.
+uniform vec4 u_lightClusterParams;
+
+// Returns light index offset and light count of the cluster.
+vec2 GetLightCluster(vec3 worldPos) {
+	vec4 viewPos = mul(u_view, vec4(worldPos, 1.0));
+	vec4 clipPos = mul(u_proj, viewPos);
+	vec2 ndc = clipPos.xy / clipPos.w;
+	
+	vec3 clusterCount = vec3(LIGHT_CLUSTER_X_COUNT, LIGHT_CLUSTER_Y_COUNT, LIGHT_CLUSTER_Z_COUNT);
+	vec2 tile = clamp(floor((ndc * 0.5 + 0.5) * clusterCount.xy), vec2_splat(0.0), clusterCount.xy - 1.0);
+	float slice = clamp(floor(log(max(viewPos.z, 0.0001)) * u_lightClusterParams.y + u_lightClusterParams.z), 0.0, clusterCount.z - 1.0);
+	return texelFetch(s_lightClusters, ivec2(int(tile.x + tile.y * clusterCount.x), int(slice)), 0).xy;
+}
+
+int GetClusterLightIndex(int index) {
+	return int(texelFetch(s_lightIndices, ivec2(index % LIGHT_INDEX_TEXTURE_WIDTH, index / LIGHT_INDEX_TEXTURE_WIDTH), 0).x);
+}
+
+vec4 GetClusteredLightParams(int lightIndex, int vec4Index) {
+	return texelFetch(s_lightParams, ivec2(vec4Index, lightIndex), 0);
+}
@@ -0,0 +1,122 @@
+#include "../common/bgfx_compute.sh"
+#include "../UniformDefines/U_GPUDriven.sh"
+
+BUFFER_RO(s_instanceInput, vec4, GPU_DRIVEN_INSTANCE_INPUT_SLOT);
+BUFFER_RO(s_drawCommands, uint, GPU_DRIVEN_DRAW_COMMAND_SLOT);
+BUFFER_RW(s_instanceCounts, uint, GPU_DRIVEN_INSTANCE_COUNT_SLOT);
+BUFFER_WR(s_instanceOutput, vec4, GPU_DRIVEN_INSTANCE_OUTPUT_SLOT);
+SAMPLER2D(s_hiZ, GPU_DRIVEN_HIZ_SLOT);
+
+// World space frustum planes whose normals point to the inside.
+uniform vec4 u_cullingPlanes[6];
+
+// x : instance count, y : draw command count, z : 1 if NDC depth range is [-1, 1], w : 1 if texture origin is bottom left.
+uniform vec4 u_gpuDrivenParams;
+
+// Projection * view matrix which rendered the Hi-Z pyramid.
+uniform mat4 u_hiZViewProj;
+
+// x : mip 0 width, y : mip 0 height, z : mip count, w : 1 if the pyramid is valid.
+uniform vec4 u_hiZParams;
+
+// The same test as HiZPyramid::IsOccluded. Mips are rounded down so that texel coordinates are clamped.
+bool IsOccludedByHiZ(vec3 center, vec3 extents)
+{
+	vec3 ndcMin = vec3(1.0e30, 1.0e30, 1.0e30);
+	vec3 ndcMax = vec3(-1.0e30, -1.0e30, -1.0e30);
+	for (int cornerIndex = 0; cornerIndex < 8; ++cornerIndex)
+	{
+		vec3 signs = vec3(float(cornerIndex & 1), float((cornerIndex >> 1) & 1), float((cornerIndex >> 2) & 1)) * 2.0 - 1.0;
+		vec4 clip = mul(u_hiZViewProj, vec4(center + extents * signs, 1.0));
+		if (clip.w <= 0.0)
+		{
+			return false;
+		}
+
+		vec3 ndc = clip.xyz / clip.w;
+		ndcMin = min(ndcMin, ndc);
+		ndcMax = max(ndcMax, ndc);
+	}
+
+	float minDepth = u_gpuDrivenParams.z != 0.0 ? ndcMin.z * 0.5 + 0.5 : ndcMin.z;
+	if (minDepth <= 0.0 || minDepth > 1.0 || ndcMax.x < -1.0 || ndcMin.x > 1.0 || ndcMax.y < -1.0 || ndcMin.y > 1.0)
+	{
+		return false;
+	}
+
+	vec2 size = u_hiZParams.xy;
+	vec2 rectMin = (clamp(ndcMin.xy, -1.0, 1.0) * 0.5 + 0.5) * size;
+	vec2 rectMax = (clamp(ndcMax.xy, -1.0, 1.0) * 0.5 + 0.5) * size;
+	if (u_gpuDrivenParams.w == 0.0)
+	{
+		float firstRow = size.y - rectMax.y;
+		rectMax.y = size.y - rectMin.y;
+		rectMin.y = firstRow;
+	}
+
+	ivec2 texelMin = ivec2(max(floor(rectMin) - 1.0, vec2(0.0, 0.0)));
+	ivec2 texelMax = ivec2(min(floor(rectMax) + 1.0, size - 1.0));
+	int mip = 0;
+	int mipCount = int(u_hiZParams.z);
+	while (mip + 1 < mipCount && ((texelMax.x >> mip) - (texelMin.x >> mip) > 3 || (texelMax.y >> mip) - (texelMin.y >> mip) > 3))
+	{
+		++mip;
+	}
+
+	ivec2 mipSize = max(ivec2(size) >> mip, ivec2(1, 1));
+	float maxDepth = 0.0;
+	for (int y = texelMin.y >> mip; y <= (texelMax.y >> mip); ++y)
+	{
+		for (int x = texelMin.x >> mip; x <= (texelMax.x >> mip); ++x)
+		{
+			maxDepth = max(maxDepth, texelFetch(s_hiZ, min(ivec2(x, y), mipSize - ivec2(1, 1)), mip).x);
+		}
+	}
+
+	return minDepth > maxDepth;
+}
+
+NUM_THREADS(GPU_DRIVEN_THREAD_COUNT, 1, 1)
+void main()
+{
+	uint instanceIndex = gl_GlobalInvocationID.x;
+	if (instanceIndex >= uint(u_gpuDrivenParams.x))
+	{
+		return;
+	}
+
+	uint inputOffset = instanceIndex * GPU_DRIVEN_INSTANCE_VEC4_COUNT;
+	vec4 centerAndDrawCommand = s_instanceInput[inputOffset + 4];
+	vec4 extentsAndFlag = s_instanceInput[inputOffset + 5];
+
+	// The same box test as Frustum::Intersects so that visible instances are the same as the CPU path.
+	bool isVisible = true;
+	if (extentsAndFlag.w == 0.0)
+	{
+		for (int planeIndex = 0; planeIndex < 6; ++planeIndex)
+		{
+			vec4 plane = u_cullingPlanes[planeIndex];
+			float distance = dot(plane.xyz, centerAndDrawCommand.xyz) + plane.w;
+			float radius = dot(abs(plane.xyz), extentsAndFlag.xyz);
+			isVisible = isVisible && distance + radius >= 0.0;
+		}
+	}
+
+	// Boxes inside the frustum are tested against depths of the last frame.
+	if (!isVisible || (extentsAndFlag.w == 0.0 && u_hiZParams.w != 0.0 && IsOccludedByHiZ(centerAndDrawCommand.xyz, extentsAndFlag.xyz)))
+	{
+		return;
+	}
+
+	// Visible instances of a draw command are compacted after its first instance.
+	uint drawCommandIndex = uint(centerAndDrawCommand.w);
+	uint slot;
+	atomicFetchAndAdd(s_instanceCounts[drawCommandIndex], 1u, slot);
+
+	uint firstInstance = s_drawCommands[drawCommandIndex * GPU_DRIVEN_DRAW_COMMAND_UINT_COUNT + 3];
+	uint outputOffset = (firstInstance + slot) * 4;
+	s_instanceOutput[outputOffset + 0] = s_instanceInput[inputOffset + 0];
+	s_instanceOutput[outputOffset + 1] = s_instanceInput[inputOffset + 1];
+	s_instanceOutput[outputOffset + 2] = s_instanceInput[inputOffset + 2];
+	s_instanceOutput[outputOffset + 3] = s_instanceInput[inputOffset + 3];
+}
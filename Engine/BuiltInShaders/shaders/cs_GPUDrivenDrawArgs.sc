@@ -0,0 +1,27 @@
+#include "../common/bgfx_compute.sh"
+#include "../UniformDefines/U_GPUDriven.sh"
+
+BUFFER_RO(s_drawCommands, uint, GPU_DRIVEN_DRAW_COMMAND_SLOT);
+BUFFER_RW(s_instanceCounts, uint, GPU_DRIVEN_INSTANCE_COUNT_SLOT);
+BUFFER_WR(s_drawIndirect, uvec4, GPU_DRIVEN_DRAW_INDIRECT_SLOT);
+
+// x : instance count, y : draw command count, z : 1 if NDC depth range is [-1, 1], w : 1 if texture origin is bottom left.
+uniform vec4 u_gpuDrivenParams;
+
+NUM_THREADS(GPU_DRIVEN_THREAD_COUNT, 1, 1)
+void main()
+{
+	uint drawCommandIndex = gl_GlobalInvocationID.x;
+	if (drawCommandIndex >= uint(u_gpuDrivenParams.y))
+	{
+		return;
+	}
+
+	uint commandOffset = drawCommandIndex * GPU_DRIVEN_DRAW_COMMAND_UINT_COUNT;
+	uint instanceCount = s_instanceCounts[drawCommandIndex];
+	drawIndexedIndirect(s_drawIndirect, drawCommandIndex, s_drawCommands[commandOffset + 0], instanceCount,
+		s_drawCommands[commandOffset + 1], s_drawCommands[commandOffset + 2], s_drawCommands[commandOffset + 3]);
+
+	// Counts are reset for culling of the next frame.
+	s_instanceCounts[drawCommandIndex] = 0u;
+}
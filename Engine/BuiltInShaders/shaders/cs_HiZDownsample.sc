@@ -0,0 +1,38 @@
+#include "../common/bgfx_compute.sh"
+#include "../UniformDefines/U_HiZ.sh"
+
+IMAGE2D_RO(s_hiZSource, r32f, HIZ_SOURCE_SLOT);
+IMAGE2D_WR(s_hiZTarget, r32f, HIZ_TARGET_SLOT);
+
+// xy : source size, zw : target size.
+uniform vec4 u_hiZSize;
+
+NUM_THREADS(HIZ_THREAD_COUNT, HIZ_THREAD_COUNT, 1)
+void main()
+{
+	ivec2 targetCoord = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 targetSize = ivec2(u_hiZSize.zw);
+	if (targetCoord.x >= targetSize.x || targetCoord.y >= targetSize.y)
+	{
+		return;
+	}
+
+	// Target sizes are rounded down so that the last column and row also cover remaining texels of odd sources.
+	ivec2 sourceSize = ivec2(u_hiZSize.xy);
+	ivec2 first = targetCoord * 2;
+	ivec2 last = min(first + ivec2(1, 1), sourceSize - ivec2(1, 1));
+	last.x = targetCoord.x == targetSize.x - 1 ? sourceSize.x - 1 : last.x;
+	last.y = targetCoord.y == targetSize.y - 1 ? sourceSize.y - 1 : last.y;
+
+	// Keep the farthest depth so that boxes behind it are hidden by all texels in its footprint.
+	float depth = 0.0;
+	for (int y = first.y; y <= last.y; ++y)
+	{
+		for (int x = first.x; x <= last.x; ++x)
+		{
+			depth = max(depth, imageLoad(s_hiZSource, ivec2(x, y)).x);
+		}
+	}
+
+	imageStore(s_hiZTarget, targetCoord, vec4(depth, 0.0, 0.0, 0.0));
+}
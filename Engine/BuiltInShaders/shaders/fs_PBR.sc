@@ -5,6 +5,7 @@ $input v_worldPos, v_normal, v_texcoord0, v_TBN
 #include "../common/Material.sh"
 #include "../common/Camera.sh"
 
+#define CLUSTERED_LIGHTING
 #include "../common/Light.sh"
 #include "../common/Envirnoment.sh"
 
@@ -0,0 +1,34 @@
+$input a_position, a_normal, a_tangent, a_texcoord0, i_data0, i_data1, i_data2, i_data3
+$output v_worldPos, v_normal, v_texcoord0, v_TBN
+
+#include "../common/common.sh"
+
+void main()
+{
+	// Per-instance world matrix columns.
+	mat4 model = mtxFromCols(i_data0, i_data1, i_data2, i_data3);
+	vec4 worldPos = mul(model, vec4(a_position, 1.0));
+	gl_Position = mul(u_viewProj, worldPos);
+
+	v_worldPos = worldPos.xyz;
+	
+	// Cofactor matrix is the inverse transpose matrix multiplied by determinant.
+	vec3 axisX = i_data0.xyz;
+	vec3 axisY = i_data1.xyz;
+	vec3 axisZ = i_data2.xyz;
+	vec3 cofactorX = cross(axisY, axisZ);
+	float determinantSign = sign(dot(axisX, cofactorX));
+	mat3 normalMatrix = mtxFromCols(cofactorX, cross(axisZ, axisX), cross(axisX, axisY));
+	
+	v_normal     = normalize(determinantSign * mul(normalMatrix, a_normal));
+	vec3 tangent = normalize(mul(mtxFromCols(axisX, axisY, axisZ), a_tangent));
+	
+	// re-orthogonalize T with respect to N
+	tangent        = normalize(tangent - dot(tangent, v_normal) * v_normal);
+	vec3 biTangent = normalize(cross(v_normal, tangent));
+	
+	// TBN
+	v_TBN = mtxFromCols(tangent, biTangent, v_normal);
+	
+	v_texcoord0 = a_texcoord0;
+}
@@ -93,7 +93,7 @@ void ECTerrainConsumer::AddMaterial(engine::Entity entity, const cd::Material* p
 
 	// TODO : ResourceBuilder will move to EditorApp::Update in the future.
 	// Now let's wait all resource build tasks done here.
-	ResourceBuilder::Get().Update();
+	ResourceBuilder::Get().Flush();
 
 	// TODO : create material component before ResourceBuilder done.
 	engine::MaterialComponent& materialComponent = m_pSceneWorld->GetWorld()->CreateComponent<engine::MaterialComponent>(entity);
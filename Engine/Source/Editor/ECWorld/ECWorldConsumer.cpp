@@ -1,5 +1,6 @@
 #include "ECWorldConsumer.h"
 
+#include "Core/Jobs/JobSystem.h"
 #include "ECWorld/ComponentsStorage.hpp"
 #include "ECWorld/DDGIComponent.h"
 #include "ECWorld/HierarchyComponent.h"
@@ -67,10 +68,18 @@ void ECWorldConsumer::Execute(const cd::SceneDatabase* pSceneDatabase)
 	auto ParseMesh = [&](cd::MeshID meshID, const cd::Transform& tranform)
 	{
 		engine::Entity meshEntity = m_pSceneWorld->GetWorld()->CreateEntity();
-		AddTransform(meshEntity, tranform);
-
 		const auto& mesh = pSceneDatabase->GetMesh(meshID.Data());
 
+		// Standard static meshes go to chunks of StaticMeshArchetype when the world enables it.
+		// Their components are created together here and filled by the following Add functions.
+		engine::StaticMeshArchetype* pStaticMeshArchetype = m_pSceneWorld->GetStaticMeshArchetype();
+		if (pStaticMeshArchetype && MeshAssetType::Standard == m_meshAssetType && 0U == mesh.GetVertexInfluenceCount())
+		{
+			pStaticMeshArchetype->CreateComponents(meshEntity);
+		}
+
+		AddTransform(meshEntity, tranform);
+
 		if(m_meshAssetType == MeshAssetType::Standard)
 		{
 			// TODO : Or the user doesn't want to import animation data.
@@ -200,10 +209,21 @@ void ECWorldConsumer::AddLight(engine::Entity entity, const cd::Light& light)
 	transformComponent.Build();
 }
 
+template<typename Component>
+Component& ECWorldConsumer::CreateMeshComponent(engine::Entity entity)
+{
+	engine::StaticMeshArchetype* pStaticMeshArchetype = m_pSceneWorld->GetStaticMeshArchetype();
+	if (pStaticMeshArchetype && pStaticMeshArchetype->Contains(entity))
+	{
+		return *pStaticMeshArchetype->GetComponent<Component>(entity);
+	}
+
+	return m_pSceneWorld->GetWorld()->CreateComponent<Component>(entity);
+}
+
 void ECWorldConsumer::AddTransform(engine::Entity entity, const cd::Transform& transform)
 {
-	engine::World* pWorld = m_pSceneWorld->GetWorld();
-	engine::TransformComponent& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
+	engine::TransformComponent& transformComponent = CreateMeshComponent<engine::TransformComponent>(entity);
 	transformComponent.SetTransform(transform);
 	transformComponent.Build();
 }
@@ -216,10 +236,59 @@ void ECWorldConsumer::AddStaticMesh(engine::Entity entity, const cd::Mesh& mesh,
 	engine::NameComponent& nameComponent = pWorld->CreateComponent<engine::NameComponent>(entity);
 	nameComponent.SetName(mesh.GetName());
 
-	engine::StaticMeshComponent& staticMeshComponent = pWorld->CreateComponent<engine::StaticMeshComponent>(entity);
+	engine::StaticMeshComponent& staticMeshComponent = CreateMeshComponent<engine::StaticMeshComponent>(entity);
 	staticMeshComponent.SetMeshData(&mesh);
 	staticMeshComponent.SetRequiredVertexFormat(&vertexFormat);
+
 	staticMeshComponent.Build();
+
+	// Skinned meshes deform so that errors of LODs don't hold for them.
+	if (m_meshLODSettings.lodCount > 1U && 0U == mesh.GetVertexInfluenceCount())
+	{
+		BuildLODsInBackground(entity, staticMeshComponent);
+	}
+}
+
+void ECWorldConsumer::BuildLODsInBackground(engine::Entity entity, const engine::StaticMeshComponent& staticMeshComponent)
+{
+	// Simplifying large meshes takes seconds so that the mesh shows up with LOD 0 at first.
+	// Inputs are copied as SceneDatabase may reallocate meshes when more models are imported.
+	static_assert(sizeof(cd::Polygon) == 3 * sizeof(uint32_t), "Polygons should be tightly packed 32 bits indexes.");
+	const cd::Mesh* pMesh = staticMeshComponent.GetMeshData();
+	const uint32_t* pPolygonIndices = reinterpret_cast<const uint32_t*>(pMesh->GetPolygons().data());
+	std::vector<uint32_t> indices(pPolygonIndices, pPolygonIndices + pMesh->GetPolygons().size() * 3U);
+	std::vector<cd::Point> positions = pMesh->GetVertexPositions();
+
+	engine::SceneWorld* pSceneWorld = m_pSceneWorld;
+	const uint32_t version = staticMeshComponent.GetVersion();
+	engine::JobSystem::Get().SubmitBackground([pSceneWorld, entity, pMesh, version, positions = cd::MoveTemp(positions),
+		indices = cd::MoveTemp(indices), settings = m_meshLODSettings]() mutable
+	{
+		std::vector<engine::MeshLOD> lods = engine::MeshSimplifier::BuildLODs(positions.data(), static_cast<uint32_t>(positions.size()),
+			indices.data(), static_cast<uint32_t>(indices.size()), settings);
+		if (lods.empty())
+		{
+			return;
+		}
+
+		// Buffers are created in the main thread. Skip components which are removed or rebuilt by others in the meantime.
+		engine::JobSystem::Get().SubmitToMainThread([pSceneWorld, entity, pMesh, version, lods = cd::MoveTemp(lods)]() mutable
+		{
+			engine::StaticMeshComponent* pStaticMeshComponent = pSceneWorld->GetStaticMeshComponent(entity);
+			if (!pStaticMeshComponent && pSceneWorld->GetStaticMeshArchetype())
+			{
+				pStaticMeshComponent = pSceneWorld->GetStaticMeshArchetype()->GetComponent<engine::StaticMeshComponent>(entity);
+			}
+
+			if (!pStaticMeshComponent || pStaticMeshComponent->GetMeshData() != pMesh || pStaticMeshComponent->GetVersion() != version)
+			{
+				return;
+			}
+
+			pStaticMeshComponent->SetLODs(cd::MoveTemp(lods));
+			pStaticMeshComponent->Build();
+		});
+	});
 }
 
 void ECWorldConsumer::AddSkinMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat)
@@ -284,7 +353,7 @@ void ECWorldConsumer::AddMaterial(engine::Entity entity, const cd::Material* pMa
 	}
 
 	// In any bad case, we should have a material component.
-	engine::MaterialComponent& materialComponent = m_pSceneWorld->GetWorld()->CreateComponent<engine::MaterialComponent>(entity);
+	engine::MaterialComponent& materialComponent = CreateMeshComponent<engine::MaterialComponent>(entity);
 	materialComponent.Init();
 
 	cd::Vec3f albedoColor(1.0f);
@@ -369,7 +438,7 @@ void ECWorldConsumer::AddMaterial(engine::Entity entity, const cd::Material* pMa
 
 	// TODO : ResourceBuilder will move to EditorApp::Update in the future.
 	// Now let's wait all resource build tasks done here.
-	ResourceBuilder::Get().Update();
+	ResourceBuilder::Get().Flush();
 
 	// TODO : create material component before ResourceBuilder done.
 	// Assign a special color for loading resource status.
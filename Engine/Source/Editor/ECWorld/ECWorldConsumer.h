@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Base/Template.h"
+#include "Core/Math/MeshSimplifier.h"
 #include "ECWorld/Entity.h"
 #include "Framework/IConsumer.h"
 #include "Material/ShaderSchema.h"
@@ -36,6 +37,7 @@ class MaterialComponent;
 class MaterialType;
 class RenderContext;
 class SceneWorld;
+class StaticMeshComponent;
 
 }
 
@@ -64,11 +66,21 @@ public:
 
 	void ActivateDDGIService() { m_meshAssetType = MeshAssetType::DDGI; }
 
+	// LODs of static meshes are simplified by background jobs after import and applied in the main thread when ready.
+	// Set lodCount to 1 to skip them.
+	void SetMeshLODSettings(const engine::MeshLODSettings& settings) { m_meshLODSettings = settings; }
+	const engine::MeshLODSettings& GetMeshLODSettings() const { return m_meshLODSettings; }
+
 private:
 	void AddCamera(engine::Entity entity, const cd::Camera& camera);
 	void AddLight(engine::Entity entity, const cd::Light& light);
+	// Components of entities in StaticMeshArchetype are created already. Others are created in per-type storages.
+	template<typename Component>
+	Component& CreateMeshComponent(engine::Entity entity);
+
 	void AddTransform(engine::Entity entity, const cd::Transform& transform);
 	void AddStaticMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat);
+	void BuildLODsInBackground(engine::Entity entity, const engine::StaticMeshComponent& staticMeshComponent);
 	void AddSkinMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat);
 	void AddAnimation(engine::Entity entity, const cd::Animation& animation, const cd::SceneDatabase* pSceneDatabase);
 	void AddMaterial(engine::Entity entity, const cd::Material* pMaterial, engine::MaterialType* pMaterialType, const cd::SceneDatabase* pSceneDatabase);
@@ -79,6 +91,7 @@ private:
 	uint32_t m_nodeMinID;
 	uint32_t m_meshMinID;
 	MeshAssetType m_meshAssetType = MeshAssetType::Standard;
+	engine::MeshLODSettings m_meshLODSettings;
 };
 
 }
\ No newline at end of file
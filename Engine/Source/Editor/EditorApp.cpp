@@ -1,6 +1,7 @@
 ﻿#include "EditorApp.h"
 
 #include "Application/Engine.h"
+#include "Core/Jobs/JobSystem.h"
 #include "Display/CameraController.h"
 #include "ECWorld/SceneWorld.h"
 #include "ImGui/EditorImGuiViewport.h"
@@ -14,6 +15,7 @@
 #include "Rendering/BlitRenderTargetPass.h"
 #include "Rendering/DDGIRenderer.h"
 #include "Rendering/DebugRenderer.h"
+#include "Rendering/HiZRenderer.h"
 #include "Rendering/ImGuiRenderer.h"
 #include "Rendering/PBRSkyRenderer.h"
 #include "Rendering/PostProcessRenderer.h"
@@ -47,7 +49,6 @@
 #include "ImGui/imfilebrowser.h"
 
 //#include <format>
-#include <thread>
 
 namespace editor
 {
@@ -92,19 +93,17 @@ void EditorApp::Init(engine::EngineInitArgs initArgs)
 	InitECWorld();
 	m_pEditorImGuiContext->SetSceneWorld(m_pSceneWorld.get());
 
-	// Add shader build tasks and create a thread to update tasks.
+	// Add shader build tasks and update tasks in the builder thread.
 	InitShaderPrograms();
 	m_pEditorImGuiContext->AddStaticLayer(std::make_unique<Splash>("Splash"));
 
-	std::thread resourceThread([]()
-	{
-		ResourceBuilder::Get().Update();
-	});
-	resourceThread.detach();
+	ResourceBuilder::Get().UpdateAsync();
 }
 
 void EditorApp::Shutdown()
 {
+	// Components own GPU buffers so the scene needs to go away before RenderContext shuts down bgfx.
+	m_pSceneWorld.reset();
 }
 
 engine::Window* EditorApp::GetWindow(size_t index) const
@@ -229,6 +228,12 @@ void EditorApp::RegisterImGuiUserData(engine::ImGuiContextInstance* pImGuiContex
 void EditorApp::InitECWorld()
 {
 	m_pSceneWorld = std::make_unique<engine::SceneWorld>();
+	if (m_initArgs.useStaticMeshArchetype)
+	{
+		m_pSceneWorld->EnableStaticMeshArchetype();
+	}
+	m_pSceneWorld->GetFrustumCuller()->SetSoftwareOcclusionEnable(m_initArgs.useSoftwareOcclusionCulling ||
+		engine::GraphicsBackend::Noop == m_initArgs.backend);
 	
 	InitEditorCameraEntity();
 	
@@ -359,7 +364,9 @@ void EditorApp::InitEngineRenderers()
 
 	auto pSceneRenderer = std::make_unique<engine::WorldRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
 	m_pSceneRenderer = pSceneRenderer.get();
+	engine::WorldRenderer* pWorldRenderer = pSceneRenderer.get();
 	pSceneRenderer->SetSceneWorld(m_pSceneWorld.get());
+	pSceneRenderer->SetGPUDriven(m_initArgs.useGPUDrivenRendering);
 	AddEngineRenderer(cd::MoveTemp(pSceneRenderer));
 
 	auto pAnimationRenderer = std::make_unique<engine::AnimationRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
@@ -376,6 +383,12 @@ void EditorApp::InitEngineRenderers()
 	pDDGIRenderer->SetSceneWorld(m_pSceneWorld.get());
 	AddEngineRenderer(cd::MoveTemp(pDDGIRenderer));
 
+	// Hi-Z pyramid is built after all scene depths are written.
+	auto pHiZRenderer = std::make_unique<engine::HiZRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
+	pHiZRenderer->SetSceneWorld(m_pSceneWorld.get());
+	pWorldRenderer->SetHiZRenderer(pHiZRenderer.get());
+	AddEngineRenderer(cd::MoveTemp(pHiZRenderer));
+
 	auto pBlitRTRenderPass = std::make_unique<engine::BlitRenderTargetPass>(m_pRenderContext->CreateView(), pSceneRenderTarget);
 	AddEngineRenderer(cd::MoveTemp(pBlitRTRenderPass));
 
@@ -398,6 +411,12 @@ bool EditorApp::IsAtmosphericScatteringEnable() const
 
 void EditorApp::InitShaderPrograms() const
 {
+	for (engine::MaterialType* pMaterialType : { m_pSceneWorld->GetPBRMaterialType(), m_pSceneWorld->GetAnimationMaterialType(),
+		m_pSceneWorld->GetTerrainMaterialType(), m_pSceneWorld->GetDDGIMaterialType() })
+	{
+		pMaterialType->GetShaderSchema().SetLazyVariants(m_initArgs.useLazyShaderVariants);
+	}
+
 	std::string nonUberBuildPath = CDENGINE_BUILTIN_SHADER_PATH;
 	ShaderBuilder::BuildNonUberShader(nonUberBuildPath + "shaders");
 	if (IsAtmosphericScatteringEnable())
@@ -412,6 +431,28 @@ void EditorApp::InitShaderPrograms() const
 	ShaderBuilder::BuildUberShader(m_pSceneWorld->GetDDGIMaterialType());
 }
 
+void EditorApp::UpdateLazyShaderVariants() const
+{
+	if (!m_initArgs.useLazyShaderVariants)
+	{
+		return;
+	}
+
+	// Variants requested by materials in last frame are built in the builder thread and uploaded by main thread jobs.
+	// Tasks are queued to the builder which is already running if any so that nothing blocks the main thread.
+	uint32_t taskCount = 0U;
+	for (engine::MaterialType* pMaterialType : { m_pSceneWorld->GetPBRMaterialType(), m_pSceneWorld->GetAnimationMaterialType(),
+		m_pSceneWorld->GetTerrainMaterialType(), m_pSceneWorld->GetDDGIMaterialType() })
+	{
+		taskCount += ShaderBuilder::BuildRequestedUberShaderVariants(pMaterialType);
+	}
+
+	if (taskCount > 0U)
+	{
+		ResourceBuilder::Get().UpdateAsync();
+	}
+}
+
 void EditorApp::InitEditorController()
 {
 	// Controller for Input events.
@@ -437,6 +478,9 @@ void EditorApp::AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer)
 
 bool EditorApp::Update(float deltaTime)
 {
+	// Jobs which need to call bgfx APIs in main thread.
+	engine::JobSystem::Get().ExecuteMainThreadJobs();
+
 	// TODO : it is better to remove these logics about splash -> editor switch here.
 	// Better implementation is to have multiple Application or Window classes and they can switch.
 	if (!m_bInitEditor)
@@ -478,6 +522,8 @@ bool EditorApp::Update(float deltaTime)
 	}
 	else
 	{
+		UpdateLazyShaderVariants();
+
 		if (m_pViewportCameraController)
 		{
 			m_pViewportCameraController->Update(deltaTime);
@@ -485,12 +531,13 @@ bool EditorApp::Update(float deltaTime)
 	}
 
 	GetMainWindow()->Update();
-	m_pSceneWorld->Update();
 	m_pEditorImGuiContext->Update(deltaTime);
 
+	// Frustum culling in scene update uses the main camera's projection matrix which may be changed by SceneView.
 	engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
 	assert(pMainCameraComponent);
 	pMainCameraComponent->BuildProjectMatrix();
+	m_pSceneWorld->Update(deltaTime);
 
 	m_pRenderContext->BeginFrame();
 	for (std::unique_ptr<engine::Renderer>& pRenderer : m_pEditorRenderers)
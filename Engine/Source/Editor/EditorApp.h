@@ -51,6 +51,7 @@ public:
 	void InitEditorRenderers();
 	void InitEngineRenderers();
 	void InitShaderPrograms() const;
+	void UpdateLazyShaderVariants() const;
 	void AddEditorRenderer(std::unique_ptr<engine::Renderer> pRenderer);
 	void AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer);
 
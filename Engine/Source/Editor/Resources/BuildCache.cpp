@@ -0,0 +1,233 @@
+#include "BuildCache.h"
+
+#include "Base/Template.h"
+#include "Log/Log.h"
+#include "Resources/ContentHash.h"
+#include "Resources/ShaderDependencyGraph.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+
+namespace editor
+{
+
+namespace
+{
+
+std::string ToHexString(uint64_t value)
+{
+	char buffer[17];
+	std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+	return buffer;
+}
+
+}
+
+BuildCache::BuildCache(std::filesystem::path cacheDirectory, std::filesystem::path indexFilePath, ShaderDependencyGraph* pDependencyGraph)
+	: m_cacheDirectory(cd::MoveTemp(cacheDirectory))
+	, m_indexFilePath(cd::MoveTemp(indexFilePath))
+	, m_pDependencyGraph(pDependencyGraph)
+{
+	assert(pDependencyGraph);
+	if (std::filesystem::exists(m_indexFilePath))
+	{
+		ReadIndexFile();
+	}
+	else
+	{
+		CD_INFO("Build cache index {0} does not exist.", m_indexFilePath.string());
+		CD_WARN("Outputs which are not in build cache {0} will be compiled at the begining.", m_cacheDirectory.string());
+	}
+}
+
+BuildCache::~BuildCache()
+{
+	WriteIndexFile();
+}
+
+void BuildCache::ReadIndexFile()
+{
+	std::ifstream inFile(m_indexFilePath);
+	if (!inFile.is_open())
+	{
+		CD_ERROR("Open file {0} failed!", m_indexFilePath.string());
+		return;
+	}
+
+	CD_INFO("Reading build cache index from {0}.", m_indexFilePath.string());
+
+	std::string line;
+	while (std::getline(inFile, line))
+	{
+		size_t pos = line.rfind("=");
+		if (pos != std::string::npos)
+		{
+			m_outputKeys[line.substr(0, pos)] = std::stoull(line.substr(pos + 1), nullptr, 16);
+		}
+	}
+}
+
+void BuildCache::WriteIndexFile()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_isIndexDirty)
+	{
+		return;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(m_indexFilePath.parent_path(), errorCode);
+	std::ofstream outFile(m_indexFilePath, std::ios::trunc);
+	if (!outFile.is_open())
+	{
+		CD_ERROR("Open file {0} failed!", m_indexFilePath.string());
+		return;
+	}
+
+	CD_INFO("Writing build cache index to {0}.", m_indexFilePath.string());
+
+	for (const auto& [outputFilePath, key] : m_outputKeys)
+	{
+		outFile << outputFilePath << "=" << ToHexString(key) << std::endl;
+	}
+	m_isIndexDirty = false;
+}
+
+std::filesystem::path BuildCache::GetCachedFilePath(uint64_t key, const char* pOutputFilePath) const
+{
+	// Keep the extension of outputs so that cached files are easy to inspect.
+	std::filesystem::path cachedFileName(ToHexString(key));
+	cachedFileName += std::filesystem::path(pOutputFilePath).extension();
+	return m_cacheDirectory / cachedFileName;
+}
+
+uint64_t BuildCache::GetToolHash(const std::string& toolPath)
+{
+	auto itToolHash = m_toolHashes.find(toolPath);
+	if (itToolHash != m_toolHashes.end())
+	{
+		return itToolHash->second;
+	}
+
+	// Tool binaries don't report versions in a common way so that their contents are hashed instead.
+	std::filesystem::path toolFilePath(toolPath);
+	if (!std::filesystem::is_regular_file(toolFilePath))
+	{
+		toolFilePath += ".exe";
+	}
+
+	uint64_t toolHash = ContentHash::HashString(ContentHash::Seed, toolPath);
+	if (std::filesystem::is_regular_file(toolFilePath))
+	{
+		std::ifstream inFile(toolFilePath, std::ios::binary);
+		std::string content((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+		toolHash = ContentHash::HashString(ContentHash::Seed, content);
+	}
+	else
+	{
+		CD_WARN("Tool {0} does not exist. Its path is used as its version in build cache.", toolPath);
+	}
+
+	m_toolHashes[toolPath] = toolHash;
+	return toolHash;
+}
+
+uint64_t BuildCache::ComputeKey(const std::string& toolPath, const std::vector<std::string>& arguments, const char* pOutputFilePath)
+{
+	const std::filesystem::path outputFilePath(pOutputFilePath);
+	const std::string outputPathWithoutExtension = std::filesystem::path(outputFilePath).replace_extension().string();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	uint64_t hash = GetToolHash(toolPath);
+	for (const std::string& argument : arguments)
+	{
+		if (argument == outputFilePath.string() || argument == outputPathWithoutExtension)
+		{
+			hash = ContentHash::HashString(hash, "<output>");
+		}
+		else if (std::filesystem::is_regular_file(argument))
+		{
+			const uint64_t fileHash = m_pDependencyGraph->GetHashWithIncludes(argument);
+			hash = ContentHash::HashString(hash, "<input>");
+			hash = ContentHash::HashBytes(hash, &fileHash, sizeof(fileHash));
+		}
+		else
+		{
+			hash = ContentHash::HashString(hash, argument);
+		}
+	}
+
+	return hash;
+}
+
+bool BuildCache::IsUpToDate(uint64_t key, const char* pOutputFilePath)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto itOutputKey = m_outputKeys.find(pOutputFilePath);
+	return itOutputKey != m_outputKeys.end() && itOutputKey->second == key && std::filesystem::exists(pOutputFilePath);
+}
+
+bool BuildCache::HasRecord(const char* pOutputFilePath)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_outputKeys.find(pOutputFilePath) != m_outputKeys.end();
+}
+
+bool BuildCache::Restore(uint64_t key, const char* pOutputFilePath)
+{
+	const std::filesystem::path cachedFilePath = GetCachedFilePath(key, pOutputFilePath);
+	if (!std::filesystem::exists(cachedFilePath))
+	{
+		return false;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(std::filesystem::path(pOutputFilePath).parent_path(), errorCode);
+	if (!std::filesystem::copy_file(cachedFilePath, pOutputFilePath, std::filesystem::copy_options::overwrite_existing, errorCode))
+	{
+		CD_ERROR("Restore {0} from build cache {1} failed : {2}", pOutputFilePath, cachedFilePath.string(), errorCode.message());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_outputKeys[pOutputFilePath] = key;
+	m_isIndexDirty = true;
+	return true;
+}
+
+void BuildCache::Store(uint64_t key, const char* pOutputFilePath)
+{
+	if (!std::filesystem::exists(pOutputFilePath))
+	{
+		CD_ERROR("Output {0} does not exist to store in build cache.", pOutputFilePath);
+		return;
+	}
+
+	// Copy to a temporary file first so that other threads and editors never see partial cached files.
+	static std::atomic<uint32_t> s_temporaryFileIndex = 0U;
+	const std::filesystem::path cachedFilePath = GetCachedFilePath(key, pOutputFilePath);
+	std::filesystem::path temporaryFilePath = cachedFilePath;
+	temporaryFilePath += ".tmp" + std::to_string(s_temporaryFileIndex++);
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(m_cacheDirectory, errorCode);
+	if (std::filesystem::copy_file(pOutputFilePath, temporaryFilePath, std::filesystem::copy_options::overwrite_existing, errorCode))
+	{
+		std::filesystem::rename(temporaryFilePath, cachedFilePath, errorCode);
+	}
+
+	if (errorCode)
+	{
+		CD_ERROR("Store {0} to build cache {1} failed : {2}", pOutputFilePath, cachedFilePath.string(), errorCode.message());
+		std::filesystem::remove(temporaryFilePath, errorCode);
+	}
+
+	// The output is recorded even if caching failed as it is still built by the key.
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_outputKeys[pOutputFilePath] = key;
+	m_isIndexDirty = true;
+}
+
+}
\ No newline at end of file
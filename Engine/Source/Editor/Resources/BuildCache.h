@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace editor
+{
+
+class ShaderDependencyGraph;
+
+// BuildCache is a content addressed cache of build task outputs.
+// A key hashes everything which affects an output : the tool binary, the command line, contents of input files and their transitive includes.
+// Paths of inputs and outputs are not part of keys so that identical tasks of other projects or branches share cached outputs.
+// Cached outputs are stored as files named by keys in the cache directory. The index file records which key built every output path.
+class BuildCache final
+{
+public:
+	BuildCache() = delete;
+	explicit BuildCache(std::filesystem::path cacheDirectory, std::filesystem::path indexFilePath, ShaderDependencyGraph* pDependencyGraph);
+	BuildCache(const BuildCache&) = delete;
+	BuildCache& operator=(const BuildCache&) = delete;
+	BuildCache(BuildCache&&) = delete;
+	BuildCache& operator=(BuildCache&&) = delete;
+	~BuildCache();
+
+	// Arguments which are paths of existing files are hashed by contents of them and their includes in the dependency graph.
+	// Arguments which are the output path with or without the extension are replaced by a placeholder.
+	uint64_t ComputeKey(const std::string& toolPath, const std::vector<std::string>& arguments, const char* pOutputFilePath);
+
+	// Returns true if the output exists and was built by the key.
+	bool IsUpToDate(uint64_t key, const char* pOutputFilePath);
+
+	// Returns true if the output path has been built by any key.
+	bool HasRecord(const char* pOutputFilePath);
+
+	// Copies the cached output of the key to the output path. Returns false if the key is not cached.
+	bool Restore(uint64_t key, const char* pOutputFilePath);
+
+	// Copies a successfully built output to the cache directory and records it.
+	void Store(uint64_t key, const char* pOutputFilePath);
+
+	void WriteIndexFile();
+
+private:
+	void ReadIndexFile();
+	std::filesystem::path GetCachedFilePath(uint64_t key, const char* pOutputFilePath) const;
+	uint64_t GetToolHash(const std::string& toolPath);
+
+private:
+	std::filesystem::path m_cacheDirectory;
+	std::filesystem::path m_indexFilePath;
+	ShaderDependencyGraph* m_pDependencyGraph;
+
+	// Protects all members below as tasks are added and finished in different threads.
+	std::mutex m_mutex;
+	std::unordered_map<std::string, uint64_t> m_toolHashes;
+	std::unordered_map<std::string, uint64_t> m_outputKeys;
+	bool m_isIndexDirty = false;
+};
+
+}
\ No newline at end of file
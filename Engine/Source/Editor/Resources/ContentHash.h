@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace editor
+{
+
+// 64-bit FNV-1a style hashes which process 8 bytes a step. They are stable across runs so that they can be stored in cache files.
+class ContentHash
+{
+public:
+	static constexpr uint64_t Seed = 0xCBF29CE484222325ULL;
+
+	static uint64_t HashBytes(uint64_t hash, const void* pData, size_t size)
+	{
+		const size_t wordCount = size / sizeof(uint64_t);
+		const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+		for (size_t wordIndex = 0; wordIndex < wordCount; ++wordIndex)
+		{
+			uint64_t word;
+			std::memcpy(&word, pBytes + wordIndex * sizeof(uint64_t), sizeof(uint64_t));
+			hash = (hash ^ word) * 0x100000001B3ULL;
+			hash ^= hash >> 29;
+		}
+
+		for (size_t byteIndex = wordCount * sizeof(uint64_t); byteIndex < size; ++byteIndex)
+		{
+			hash = (hash ^ static_cast<uint64_t>(pBytes[byteIndex])) * 0x100000001B3ULL;
+		}
+
+		return hash;
+	}
+
+	// Hash the size too so that neighboring strings can't be shifted into each other.
+	static uint64_t HashString(uint64_t hash, const std::string& text)
+	{
+		const uint64_t size = text.size();
+		hash = HashBytes(hash, &size, sizeof(size));
+		return HashBytes(hash, text.data(), text.size());
+	}
+};
+
+}
\ No newline at end of file
@@ -2,161 +2,101 @@
 
 #include "Base/Template.h"
 #include "Path/Path.h"
-#include "Time/Clock.h"
 #include "Log/Log.h"
 
+#include <algorithm>
 #include <cassert>
+#include <thread>
 
 namespace editor
 {
 
 ResourceBuilder::ResourceBuilder()
 {
-	std::string modifyCachePath = GetModifyCacheFilePath();
-	if (std::filesystem::exists(modifyCachePath))
+	std::filesystem::path buildCacheRootPath;
+	const auto& appDataPath = engine::Path::GetApplicationDataPath();
+	if (appDataPath.has_value())
 	{
-		ReadModifyCacheFile();
+		buildCacheRootPath = appDataPath.value() / engine::Path::EngineName;
 	}
 	else
 	{
-		CD_INFO("Modify time cache {0} does not exist.", modifyCachePath);
-		CD_WARN("Everything will be compiled at the begining.");
+		CD_ERROR("Can not find application data path!");
 	}
-}
 
-ResourceBuilder::~ResourceBuilder()
-{
-	WriteModifyCacheFile();
+	m_pShaderDependencyGraph = std::make_unique<ShaderDependencyGraph>(buildCacheRootPath / "shaderDependencies.bin");
+	m_pBuildCache = std::make_unique<BuildCache>(buildCacheRootPath / "BuildCache", buildCacheRootPath / "buildCache.bin", m_pShaderDependencyGraph.get());
+	m_pShaderCompiler = std::make_unique<ShaderCompiler>(m_pShaderDependencyGraph.get());
+	m_isInProcessShaderCompile = ShaderCompiler::IsAvailable();
 }
 
-void ResourceBuilder::ReadModifyCacheFile()
+ResourceBuilder::~ResourceBuilder()
 {
-	std::string modifyCachePath = GetModifyCacheFilePath();
-	std::ifstream inFile(modifyCachePath);
-	if (!inFile.is_open())
+	if (m_builderThread.joinable())
 	{
-		CD_ERROR("Open file {0} failed!", modifyCachePath);
-		return;
-	}
-
-	CD_INFO("Reading modify time cache from {0}.", modifyCachePath);
-
-	std::string line;
-	while (std::getline(inFile, line))
-	{
-		size_t pos = line.find("=");
-		if (pos != std::string::npos)
 		{
-			std::string filePath = line.substr(0, pos);
-
-			long long timeStamp = std::stoll(line.substr(pos + 1));
-			m_modifyTimeCache[filePath] = timeStamp;
+			std::lock_guard<std::mutex> builderLock(m_builderMutex);
+			m_isBuilderStopping = true;
 		}
+		m_builderCondition.notify_one();
+		m_builderThread.join();
 	}
-
-	inFile.close();
 }
 
-void ResourceBuilder::WriteModifyCacheFile()
+ProcessStatus ResourceBuilder::CheckFileStatus(const std::string& toolPath, const std::vector<std::string>& commandArguments,
+	const char* pInputFilePath, const char* pOutputFilePath, uint64_t& outCacheKey)
 {
-	if (!HasNewModifyTimeCache())
-	{
-		return;
-	}
-
-	std::string modifyCachePath = GetModifyCacheFilePath();
-
-	if (!std::filesystem::exists(modifyCachePath))
-	{
-		std::filesystem::create_directories(std::filesystem::path(modifyCachePath).parent_path());
-	}
-
-	std::ofstream outFile(modifyCachePath, std::ios::trunc);
-	if (!outFile.is_open())
-	{
-		CD_ERROR("Open file {0} failed!", modifyCachePath);
-		return;
-	}
-
-	CD_INFO("Writing modify time cache to {0}.", modifyCachePath);
-
-	UpdateModifyTimeCache();
-
-	outFile.clear();
-	for (const auto& [filePath, timeStamp] : m_modifyTimeCache)
+	if (!std::filesystem::exists(pInputFilePath))
 	{
-		outFile << filePath << "=" << timeStamp << std::endl;
+		CD_ERROR("Input file path {0} does not exist!", pInputFilePath);
+		return ProcessStatus::InputNotExist;
 	}
 
-	outFile.close();
-}
-
-std::string ResourceBuilder::GetModifyCacheFilePath()
-{
-	const auto& appDataPath = engine::Path::GetApplicationDataPath();
-	if (appDataPath.has_value())
+	outCacheKey = m_pBuildCache->ComputeKey(toolPath, commandArguments, pOutputFilePath);
+	if (m_pBuildCache->IsUpToDate(outCacheKey, pOutputFilePath))
 	{
-		return (appDataPath.value() / engine::Path::EngineName / "modifyTimeCache.bin").string();
+		CD_TRACE("Output file path {0} already exist.", pOutputFilePath);
+		return ProcessStatus::Stable;
 	}
 
-	CD_ERROR("Can not find application data path!");
-	return "";
-}
-
-ProcessStatus ResourceBuilder::CheckFileStatus(const char* pInputFilePath, const char* pOutputFilePath)
-{
-	if (!std::filesystem::exists(pInputFilePath))
+	if (m_pBuildCache->Restore(outCacheKey, pOutputFilePath))
 	{
-		CD_ERROR("Input file path {0} does not exist!", pInputFilePath);
-		return ProcessStatus::InputNotExist;
+		CD_INFO("Output file path {0} is restored from build cache.", pOutputFilePath);
+		return ProcessStatus::Stable;
 	}
 
-	auto crtTimeStamp = engine::Clock::FileTimePointToTimeStamp(std::filesystem::last_write_time(pInputFilePath));
-
-	if (m_modifyTimeCache.find(pInputFilePath) == m_modifyTimeCache.end())
+	if (!m_pBuildCache->HasRecord(pOutputFilePath))
 	{
 		CD_INFO("New input file {0} detected.", pInputFilePath);
-		m_newModifyTimeCache[pInputFilePath] = crtTimeStamp;
 		return ProcessStatus::InputAdded;
 	}
 
-	if (m_modifyTimeCache[pInputFilePath] != crtTimeStamp)
-	{
-		CD_INFO("Input file path {0} has been modified.", pInputFilePath);
-		m_newModifyTimeCache[pInputFilePath] = crtTimeStamp;
-		return ProcessStatus::InputModified;
-	}
-
 	if (!std::filesystem::exists(pOutputFilePath))
 	{
 		CD_INFO("Output file path {0} dose not exist.", pOutputFilePath);
 		return ProcessStatus::OutputNotExist;
 	}
-	else
-	{
-		CD_TRACE("Output file path {0} already exist.", pOutputFilePath);
-		return ProcessStatus::Stable;
-	}
 
-	CD_ERROR("Unknow ProcessStatus of input {0} and output {1}!", pInputFilePath, pOutputFilePath);
-	assert(false);
-	return ProcessStatus::None;
+	CD_INFO("Input file path {0} or its dependencies have been modified.", pInputFilePath);
+	return ProcessStatus::InputModified;
 }
 
-
-bool ResourceBuilder::AddTask(Process process)
+bool ResourceBuilder::AddTask(Process process, const char* pInputFilePath, const char* pOutputFilePath, BuildTaskCallback callback)
 {
-	m_buildTasks.push(cd::MoveTemp(process));
+	AddTask(BuildTask{ cd::MoveTemp(process), nullptr, pInputFilePath ? pInputFilePath : "", pOutputFilePath ? pOutputFilePath : "", cd::MoveTemp(callback), std::nullopt });
 	return true;
 }
 
-bool ResourceBuilder::AddShaderBuildTask(ShaderType shaderType, const char* pInputFilePath, const char* pOutputFilePath, const char* pUberOptions)
+void ResourceBuilder::AddTask(BuildTask task)
 {
-	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(pInputFilePath, pOutputFilePath)))
-	{
-		return false;
-	}
+	std::lock_guard<std::mutex> lock(m_taskMutex);
+	m_buildTasks.push(cd::MoveTemp(task));
+	++m_currentTaskCount;
+}
 
+bool ResourceBuilder::AddShaderBuildTask(ShaderType shaderType, const char* pInputFilePath, const char* pOutputFilePath, const char* pUberOptions,
+	BuildTaskCallback callback)
+{
 	// Document : https://bkaradzic.github.io/bgfx/tools.html#shader-compiler-shaderc
 	std::string cmftExePath = CDENGINE_TOOL_PATH;
 	cmftExePath += "/shaderc";
@@ -244,21 +184,32 @@ bool ResourceBuilder::AddShaderBuildTask(ShaderType shaderType, const char* pInp
 		commandArguments.push_back(shaderLanguageDefine + ";" + pUberOptions);
 	}
 
+	uint64_t cacheKey;
+	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(cmftExePath, commandArguments, pInputFilePath, pOutputFilePath, cacheKey)))
+	{
+		return false;
+	}
+
+	if (m_isInProcessShaderCompile)
+	{
+		BuildTaskFunction function = [pShaderCompiler = m_pShaderCompiler.get(), arguments = cd::MoveTemp(commandArguments)]()
+		{
+			return pShaderCompiler->Compile(arguments);
+		};
+		AddTask(BuildTask{ std::nullopt, cd::MoveTemp(function), pInputFilePath, pOutputFilePath, cd::MoveTemp(callback), cacheKey });
+		return true;
+	}
+
 	process.SetCommandArguments(cd::MoveTemp(commandArguments));
 
 	process.SetWaitUntilFinished(true);
-	AddTask(cd::MoveTemp(process));
+	AddTask(BuildTask{ cd::MoveTemp(process), nullptr, pInputFilePath, pOutputFilePath, cd::MoveTemp(callback), cacheKey });
 
 	return true;
 }
 
-bool ResourceBuilder::AddIrradianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath)
+bool ResourceBuilder::AddIrradianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath, BuildTaskCallback callback)
 {
-	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(pInputFilePath, pOutputFilePath)))
-	{
-		return false;
-	}
-
 	std::string cmftExePath = (std::filesystem::path(CDENGINE_TOOL_PATH) / "cmft").generic_string();
 	Process process(cmftExePath.c_str());
 	std::string pathWithoutExtension = std::filesystem::path(pOutputFilePath).replace_extension().generic_string();
@@ -268,20 +219,21 @@ bool ResourceBuilder::AddIrradianceCubeMapBuildTask(const char* pInputFilePath,
 		"--dstFaceSize", "256",
 		"--outputNum", "1", "--output0", cd::MoveTemp(pathWithoutExtension), "--output0params", "dds,rgba16f,cubemap"};
 
+	uint64_t cacheKey;
+	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(cmftExePath, irradianceCommandArguments, pInputFilePath, pOutputFilePath, cacheKey)))
+	{
+		return false;
+	}
+
 	process.SetCommandArguments(cd::MoveTemp(irradianceCommandArguments));
 	process.SetWaitUntilFinished(true);
-	AddTask(cd::MoveTemp(process));
+	AddTask(BuildTask{ cd::MoveTemp(process), nullptr, pInputFilePath, pOutputFilePath, cd::MoveTemp(callback), cacheKey });
 
 	return true;
 }
 
-bool ResourceBuilder::AddRadianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath)
+bool ResourceBuilder::AddRadianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath, BuildTaskCallback callback)
 {
-	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(pInputFilePath, pOutputFilePath)))
-	{
-		return false;
-	}
-
 	std::string cmftExePath = (std::filesystem::path(CDENGINE_TOOL_PATH) / "cmft").generic_string();
 	Process process(cmftExePath.c_str());
 	std::string pathWithoutExtension = std::filesystem::path(pOutputFilePath).replace_extension().generic_string();
@@ -291,20 +243,22 @@ bool ResourceBuilder::AddRadianceCubeMapBuildTask(const char* pInputFilePath, co
 		"--dstFaceSize", "256",
 		"--outputNum", "1", "--output0", cd::MoveTemp(pathWithoutExtension), "--output0params", "dds,rgba16f,cubemap"};
 
+	uint64_t cacheKey;
+	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(cmftExePath, radianceCommandArguments, pInputFilePath, pOutputFilePath, cacheKey)))
+	{
+		return false;
+	}
+
 	process.SetCommandArguments(cd::MoveTemp(radianceCommandArguments));
 	process.SetWaitUntilFinished(true);
-	AddTask(cd::MoveTemp(process));
+	AddTask(BuildTask{ cd::MoveTemp(process), nullptr, pInputFilePath, pOutputFilePath, cd::MoveTemp(callback), cacheKey });
 
 	return true;
 }
 
-bool ResourceBuilder::AddTextureBuildTask(cd::MaterialTextureType textureType, const char* pInputFilePath, const char* pOutputFilePath)
+bool ResourceBuilder::AddTextureBuildTask(cd::MaterialTextureType textureType, const char* pInputFilePath, const char* pOutputFilePath,
+	BuildTaskCallback callback)
 {
-	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(pInputFilePath, pOutputFilePath)))
-	{
-		return false;
-	}
-
 	// Document : https://bkaradzic.github.io/bgfx/tools.html#texture-compiler-texturec
 	std::string texturecExePath = CDENGINE_TOOL_PATH;
 	texturecExePath += "/texturec";
@@ -319,60 +273,173 @@ bool ResourceBuilder::AddTextureBuildTask(cd::MaterialTextureType textureType, c
 	{
 		commandArguments.push_back("--linear");
 	}
+
+	uint64_t cacheKey;
+	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(texturecExePath, commandArguments, pInputFilePath, pOutputFilePath, cacheKey)))
+	{
+		return false;
+	}
+
 	process.SetCommandArguments(cd::MoveTemp(commandArguments));
 	process.SetWaitUntilFinished(true);
-	AddTask(cd::MoveTemp(process));
+	AddTask(BuildTask{ cd::MoveTemp(process), nullptr, pInputFilePath, pOutputFilePath, cd::MoveTemp(callback), cacheKey });
 
 	return true;
 }
 
+uint32_t ResourceBuilder::GetMaxProcessCount() const
+{
+	return 0U == m_maxProcessCount ? std::max(std::thread::hardware_concurrency(), 1U) : m_maxProcessCount;
+}
+
 void ResourceBuilder::Update()
 {
-	if (m_buildTasks.empty())
 	{
-		return;
+		std::lock_guard<std::mutex> taskLock(m_taskMutex);
+		if (m_isUpdating || m_buildTasks.empty())
+		{
+			return;
+		}
+		m_isUpdating = true;
+		m_failedTasks.clear();
 	}
 
-	// It may wait until process exited which depends on process's setting.
-	while (!m_buildTasks.empty())
+	size_t taskCount = 0U;
+	uint32_t processCount = 0U;
+	const auto startTime = std::chrono::steady_clock::now();
+	std::vector<BuildTaskFailure> failedTasks;
+	while (true)
 	{
-		Process& process = m_buildTasks.front();
-		process.Run();
-		m_buildTasks.pop();
+		// Tasks which are added after the pool finished are run by another round as other Updates returned at once.
+		size_t queuedTaskCount;
+		{
+			std::lock_guard<std::mutex> taskLock(m_taskMutex);
+			if (m_buildTasks.empty())
+			{
+				failedTasks = m_failedTasks;
+				m_isUpdating = false;
+				break;
+			}
+			queuedTaskCount = m_buildTasks.size();
+		}
+
+		// Every thread waits for one process at a time. The calling thread is also one of them.
+		const uint32_t threadCount = static_cast<uint32_t>(std::min<size_t>(GetMaxProcessCount(), queuedTaskCount));
+		std::vector<std::thread> threads;
+		for (uint32_t threadIndex = 1U; threadIndex < threadCount; ++threadIndex)
+		{
+			threads.emplace_back([this]() { RunTasks(); });
+		}
+		RunTasks();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		taskCount += queuedTaskCount;
+		processCount = std::max(processCount, threadCount);
 	}
 
-	if (m_buildTasks.empty())
+	const float duration = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+	CD_INFO("Finished {0} build tasks in {1:.2f} seconds with {2} threads. In process shader compile : {3}.",
+		taskCount, duration, processCount, m_isInProcessShaderCompile);
+	if (!failedTasks.empty())
 	{
-		WriteModifyCacheFile();
+		CD_ERROR("{0} build tasks failed :", failedTasks.size());
+		for (const BuildTaskFailure& failure : failedTasks)
+		{
+			CD_ERROR("\t{0} -> {1} exit code {2}", failure.inputFilePath, failure.outputFilePath, failure.exitCode);
+		}
 	}
-}
 
-bool ResourceBuilder::HasNewModifyTimeCache() const
-{
-	return !m_newModifyTimeCache.empty();
+	m_pBuildCache->WriteIndexFile();
+	m_pShaderDependencyGraph->WriteCacheFile();
 }
 
-void ResourceBuilder::UpdateModifyTimeCache()
+void ResourceBuilder::UpdateAsync()
 {
-	for (auto& [filePath, fileTime] : m_newModifyTimeCache)
+	std::lock_guard<std::mutex> builderLock(m_builderMutex);
+	if (!m_builderThread.joinable())
 	{
-		m_modifyTimeCache[filePath] = cd::MoveTemp(fileTime);
+		m_builderThread = std::thread([this]()
+		{
+			while (true)
+			{
+				std::unique_lock<std::mutex> builderLock(m_builderMutex);
+				m_builderCondition.wait(builderLock, [this]() { return m_isBuilderRequested || m_isBuilderStopping; });
+				if (m_isBuilderStopping)
+				{
+					return;
+				}
+				m_isBuilderRequested = false;
+				builderLock.unlock();
+
+				Update();
+			}
+		});
 	}
 
-	m_newModifyTimeCache.clear();
+	m_isBuilderRequested = true;
+	m_builderCondition.notify_one();
 }
 
-void ResourceBuilder::ClearModifyTimeCache()
+void ResourceBuilder::Flush()
 {
-	m_modifyTimeCache.clear();
-	m_newModifyTimeCache.clear();
+	Update();
+
+	std::unique_lock<std::mutex> taskLock(m_taskMutex);
+	m_idleCondition.wait(taskLock, [this]() { return 0U == m_currentTaskCount.load(); });
 }
 
-void ResourceBuilder::DeleteModifyTimeCache()
+void ResourceBuilder::RunTasks()
 {
-	if (!std::filesystem::remove(GetModifyCacheFilePath()))
+	while (true)
 	{
-		CD_WARN("Delete file {0} failed!", GetModifyCacheFilePath());
+		std::unique_lock<std::mutex> taskLock(m_taskMutex);
+		if (m_buildTasks.empty())
+		{
+			return;
+		}
+
+		BuildTask task = cd::MoveTemp(m_buildTasks.front());
+		m_buildTasks.pop();
+		taskLock.unlock();
+
+		int exitCode;
+		if (task.function)
+		{
+			exitCode = task.function();
+		}
+		else
+		{
+			task.process->SetWaitUntilFinished(true);
+			task.process->Run();
+			exitCode = task.process->GetExitCode();
+		}
+
+		const bool succeeded = 0 == exitCode;
+		if (succeeded && task.cacheKey.has_value())
+		{
+			m_pBuildCache->Store(task.cacheKey.value(), task.outputFilePath.c_str());
+		}
+		else if (!succeeded)
+		{
+			taskLock.lock();
+			m_failedTasks.push_back(BuildTaskFailure{ cd::MoveTemp(task.inputFilePath), cd::MoveTemp(task.outputFilePath), exitCode });
+			taskLock.unlock();
+		}
+
+		if (task.callback)
+		{
+			task.callback(succeeded);
+		}
+
+		if (0U == --m_currentTaskCount)
+		{
+			taskLock.lock();
+			m_idleCondition.notify_all();
+			taskLock.unlock();
+		}
 	}
 }
 
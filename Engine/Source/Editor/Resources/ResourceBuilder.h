@@ -1,14 +1,25 @@
 #pragma once
 
 #include "Process/Process.h"
+#include "Resources/BuildCache.h"
+#include "Resources/ShaderCompiler.h"
+#include "Resources/ShaderDependencyGraph.h"
 #include "Scene/MaterialTextureType.h"
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <queue>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace editor
 {
@@ -33,8 +44,22 @@ enum class ProcessStatus : uint8_t
 
 class Process;
 
+// Called after the process of a build task exited. It runs in one of the threads of ResourceBuilder::Update.
+using BuildTaskCallback = std::function<void(bool succeeded)>;
+
+// Runs a build task in the editor process instead of creating a process. Returns 0 if succeeded like exit codes.
+using BuildTaskFunction = std::function<int()>;
+
+struct BuildTaskFailure
+{
+	std::string inputFilePath;
+	std::string outputFilePath;
+	int exitCode;
+};
+
 // ResourceBuilder is used to create processes to build different resource types.
 // So it is OK to update in the main thread or work thread.
+// Update runs at most max process count of processes at the same time until all queued tasks are finished.
 // For resource build tasks which are using dll calls, it will be wrapped as a task to multithreading JobSystem.
 class ResourceBuilder final
 {
@@ -44,6 +69,18 @@ public:
 		static_cast<uint8_t>(ProcessStatus::InputNotExist) |
 		static_cast<uint8_t>(ProcessStatus::Stable);
 
+	struct BuildTask
+	{
+		// Either a process or a function to run.
+		std::optional<Process> process;
+		BuildTaskFunction function;
+		std::string inputFilePath;
+		std::string outputFilePath;
+		BuildTaskCallback callback;
+		// Outputs of tasks with cache keys are stored to build cache after succeeded.
+		std::optional<uint64_t> cacheKey;
+	};
+
 public:
 	ResourceBuilder(const ResourceBuilder&) = delete;
 	ResourceBuilder& operator=(const ResourceBuilder&) = delete;
@@ -56,38 +93,78 @@ public:
 		return s_instance;
 	}
 
-	bool AddTask(Process process);
-	bool AddIrradianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath);
-	bool AddRadianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath);
-	bool AddShaderBuildTask(ShaderType shaderType, const char* pInputFilePath, const char* pOutputFilePath, const char* pUberOptions = nullptr);
-	bool AddTextureBuildTask(cd::MaterialTextureType textureType, const char* pInputFilePath, const char* pOutputFilePath);
-
+	// Callbacks are optional. Tasks which are skipped as their outputs are up to date don't call callbacks.
+	bool AddTask(Process process, const char* pInputFilePath = nullptr, const char* pOutputFilePath = nullptr, BuildTaskCallback callback = nullptr);
+	bool AddIrradianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath, BuildTaskCallback callback = nullptr);
+	bool AddRadianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath, BuildTaskCallback callback = nullptr);
+	bool AddShaderBuildTask(ShaderType shaderType, const char* pInputFilePath, const char* pOutputFilePath, const char* pUberOptions = nullptr,
+		BuildTaskCallback callback = nullptr);
+	bool AddTextureBuildTask(cd::MaterialTextureType textureType, const char* pInputFilePath, const char* pOutputFilePath,
+		BuildTaskCallback callback = nullptr);
+
+	// 0 means hardware concurrency. 1 runs tasks one by one in the thread which calls Update.
+	void SetMaxProcessCount(uint32_t count) { m_maxProcessCount = count; }
+	uint32_t GetMaxProcessCount() const;
+
+	// Shaders are compiled by the linked shaderc library in threads of Update instead of shaderc processes.
+	// It is enabled by default if the editor is built with ENABLE_SHADERC_LIBRARY.
+	void SetInProcessShaderCompile(bool enable) { m_isInProcessShaderCompile = enable && ShaderCompiler::IsAvailable(); }
+	bool IsInProcessShaderCompile() const { return m_isInProcessShaderCompile; }
+
+	// Runs queued tasks, including ones added during updating, in the calling thread and the pool.
+	// Returns at once if nothing is queued or another thread is updating, which also runs the tasks queued now.
 	void Update();
-	size_t GetCurrentTaskCount() const { return m_buildTasks.size(); }
 
-private:
-	ResourceBuilder();
-	~ResourceBuilder();
+	// Wakes the builder thread to update and returns at once.
+	// Long builds run in the dedicated thread instead of JobSystem workers which are waited by the main thread every frame.
+	void UpdateAsync();
 
-	void ReadModifyCacheFile();
-	void WriteModifyCacheFile();
+	// Updates and blocks until all tasks, including ones run by other threads, are finished.
+	// It is used by callers which need outputs immediately, e.g. importers.
+	void Flush();
 
-	bool HasNewModifyTimeCache() const;
-	void UpdateModifyTimeCache();
-	void ClearModifyTimeCache();
-	void DeleteModifyTimeCache();
+	// Count of tasks which are queued or running. It is safe to query from other threads for progress.
+	size_t GetCurrentTaskCount() const { return m_currentTaskCount.load(); }
 
-	std::string GetModifyCacheFilePath();
+	ShaderDependencyGraph& GetShaderDependencyGraph() { return *m_pShaderDependencyGraph; }
 
-	ProcessStatus CheckFileStatus(const char* pInputFilePath, const char* pOutputFilePath);
+	// Failures of the last finished Update. Outputs of failed tasks are not recorded to build cache so that they are rebuilt next time.
+	const std::vector<BuildTaskFailure>& GetFailedTasks() const { return m_failedTasks; }
 
-	std::queue<Process> m_buildTasks;
-	
-	std::unordered_map<std::string, long long> m_modifyTimeCache;
+private:
+	ResourceBuilder();
+	~ResourceBuilder();
 
-	// We always access to fragment shader multiple times by using ubre options.
-	// So we can not update fragment shader's modify time every time we found it has been modified.
-	std::unordered_map<std::string, long long> m_newModifyTimeCache;
+	// Computes the cache key of the task and restores its output from build cache if possible.
+	ProcessStatus CheckFileStatus(const std::string& toolPath, const std::vector<std::string>& commandArguments,
+		const char* pInputFilePath, const char* pOutputFilePath, uint64_t& outCacheKey);
+
+	void AddTask(BuildTask task);
+	void RunTasks();
+
+	uint32_t m_maxProcessCount = 0U;
+	std::atomic<size_t> m_currentTaskCount = 0U;
+
+	// Protects build tasks, failed tasks and the updating flag.
+	// Only one Update runs at a time so that the count of processes is bounded.
+	std::mutex m_taskMutex;
+	std::queue<BuildTask> m_buildTasks;
+	std::vector<BuildTaskFailure> m_failedTasks;
+	bool m_isUpdating = false;
+	// Notified when the count of current tasks becomes 0.
+	std::condition_variable m_idleCondition;
+
+	// Builder thread is created by the first UpdateAsync.
+	std::mutex m_builderMutex;
+	std::condition_variable m_builderCondition;
+	std::thread m_builderThread;
+	bool m_isBuilderRequested = false;
+	bool m_isBuilderStopping = false;
+
+	std::unique_ptr<ShaderDependencyGraph> m_pShaderDependencyGraph;
+	std::unique_ptr<BuildCache> m_pBuildCache;
+	std::unique_ptr<ShaderCompiler> m_pShaderCompiler;
+	bool m_isInProcessShaderCompile = false;
 };
 
 }
\ No newline at end of file
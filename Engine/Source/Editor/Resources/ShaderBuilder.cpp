@@ -1,33 +1,87 @@
 #include "ShaderBuilder.h"
 
+#include "Core/Jobs/JobSystem.h"
 #include "Log/Log.h"
 #include "Path/Path.h"
 #include "Rendering/RenderContext.h"
 #include "Resources/ResourceLoader.h"
+#include "Resources/ShaderDependencyGraph.h"
+#include "Resources/ShaderLoader.h"
 
 namespace editor
 {
 
-void ShaderBuilder::BuildUberShader(engine::MaterialType* pMaterialType)
+void ShaderBuilder::BuildUberVertexShader(const engine::ShaderSchema& shaderSchema)
 {
-	engine::ShaderSchema& shaderSchema = pMaterialType->GetShaderSchema();
-
 	// No uber option support for VS now.
+	// Instance vertex shader is a non-uber shader in the built-in shader folder so that it is built by BuildNonUberShader.
 	std::string outputVSFilePath = engine::Path::GetShaderOutputPath(shaderSchema.GetVertexShaderPath());
 	ResourceBuilder::Get().AddShaderBuildTask(ShaderType::Vertex,
 		shaderSchema.GetVertexShaderPath(), outputVSFilePath.c_str());
+}
 
+void ShaderBuilder::BuildUberFragmentShader(const engine::ShaderSchema& shaderSchema)
+{
 	// Compile fragment shaders with uber options.
 	for (const auto& combine : shaderSchema.GetUberCombines())
 	{
+		if (shaderSchema.IsLazyVariants() && engine::ShaderSchema::DefaultUberShaderCrc != engine::StringCrc(combine) &&
+			!shaderSchema.IsProgramCompiled(engine::StringCrc(combine)))
+		{
+			continue;
+		}
+
 		std::string outputFSFilePath = engine::Path::GetShaderOutputPath(shaderSchema.GetFragmentShaderPath(), combine);
 		ResourceBuilder::Get().AddShaderBuildTask(ShaderType::Fragment,
 			shaderSchema.GetFragmentShaderPath(), outputFSFilePath.c_str(), combine.c_str());
 	}
+}
+
+void ShaderBuilder::BuildUberShader(engine::MaterialType* pMaterialType)
+{
+	const engine::ShaderSchema& shaderSchema = pMaterialType->GetShaderSchema();
+	BuildUberVertexShader(shaderSchema);
+	BuildUberFragmentShader(shaderSchema);
 
 	CD_ENGINE_INFO("Material type {0} have shader variant count : {1}.", pMaterialType->GetMaterialName(), shaderSchema.GetUberCombines().size());
 }
 
+uint32_t ShaderBuilder::BuildRequestedUberShaderVariants(engine::MaterialType* pMaterialType)
+{
+	uint32_t taskCount = 0U;
+	const engine::ShaderSchema& shaderSchema = pMaterialType->GetShaderSchema();
+	for (const std::string& combine : pMaterialType->GetShaderSchema().TakeRequestedUberCombines())
+	{
+		std::string outputFSFilePath = engine::Path::GetShaderOutputPath(shaderSchema.GetFragmentShaderPath(), combine);
+		auto callback = [pMaterialType, combine](bool succeeded)
+		{
+			if (!succeeded)
+			{
+				CD_ENGINE_ERROR("Failed to build shader variant {0} of material type {1}. DEFAULT variant is used instead.", combine, pMaterialType->GetMaterialName());
+				return;
+			}
+
+			// bgfx APIs are only allowed to be called in the main thread.
+			engine::JobSystem::Get().SubmitToMainThread([pMaterialType, combine]()
+			{
+				engine::ShaderLoader::UploadUberShaderVariant(pMaterialType, combine);
+			});
+		};
+
+		if (ResourceBuilder::Get().AddShaderBuildTask(ShaderType::Fragment, shaderSchema.GetFragmentShaderPath(), outputFSFilePath.c_str(),
+			combine.c_str(), cd::MoveTemp(callback)))
+		{
+			++taskCount;
+		}
+		else
+		{
+			engine::ShaderLoader::UploadUberShaderVariant(pMaterialType, combine);
+		}
+	}
+
+	return taskCount;
+}
+
 void ShaderBuilder::BuildNonUberShader(std::string folderPath)
 {
 	for (const auto& entry : std::filesystem::recursive_directory_iterator(folderPath))
@@ -50,6 +104,48 @@ void ShaderBuilder::BuildNonUberShader(std::string folderPath)
 	}
 }
 
+uint32_t ShaderBuilder::BuildChangedShaders(const std::string& folderPath, const std::vector<engine::MaterialType*>& materialTypes)
+{
+	ShaderDependencyGraph& dependencyGraph = ResourceBuilder::Get().GetShaderDependencyGraph();
+	const std::vector<std::string> changedFiles = dependencyGraph.Scan(folderPath);
+	if (changedFiles.empty())
+	{
+		return 0U;
+	}
+
+	std::unordered_set<std::string> dependents = dependencyGraph.GetDependents(changedFiles);
+	for (engine::MaterialType* pMaterialType : materialTypes)
+	{
+		const engine::ShaderSchema& shaderSchema = pMaterialType->GetShaderSchema();
+		if (dependents.erase(ShaderDependencyGraph::NormalizePath(shaderSchema.GetVertexShaderPath())) > 0U)
+		{
+			BuildUberVertexShader(shaderSchema);
+		}
+
+		if (dependents.erase(ShaderDependencyGraph::NormalizePath(shaderSchema.GetFragmentShaderPath())) > 0U)
+		{
+			CD_ENGINE_INFO("Rebuild {0} shader variants of material type {1}.", shaderSchema.GetUberCombines().size(), pMaterialType->GetMaterialName());
+			BuildUberFragmentShader(shaderSchema);
+		}
+	}
+
+	// Others are non-uber shaders. Headers and removed files are skipped.
+	for (const std::string& dependent : dependents)
+	{
+		const std::filesystem::path dependentPath(dependent);
+		ShaderType shaderType = GetShaderType(dependentPath.stem().string());
+		if (".sc" != dependentPath.extension() || ShaderType::None == shaderType || !std::filesystem::exists(dependentPath))
+		{
+			continue;
+		}
+
+		std::string outputShaderPath = engine::Path::GetShaderOutputPath(dependent.c_str());
+		ResourceBuilder::Get().AddShaderBuildTask(shaderType, dependent.c_str(), outputShaderPath.c_str());
+	}
+
+	return static_cast<uint32_t>(changedFiles.size());
+}
+
 const ShaderType ShaderBuilder::GetShaderType(const std::string& fileName)
 {
 	if (fileName._Starts_with("vs_") || fileName._Starts_with("VS_"))
@@ -5,6 +5,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 namespace editor
 {
@@ -13,10 +14,22 @@ class ShaderBuilder
 {
 public:
 	static void BuildNonUberShader(std::string folderPath);
+	// In lazy mode, only the DEFAULT variant and variants which are already loaded are built.
 	static void BuildUberShader(engine::MaterialType* pMaterialType);
 
+	// Adds build tasks of variants which are requested by materials in lazy mode. They are uploaded in the main thread after built.
+	// Variants whose outputs are up to date are uploaded immediately. Returns the count of added build tasks.
+	static uint32_t BuildRequestedUberShaderVariants(engine::MaterialType* pMaterialType);
+
+	// Rescans shader sources in the folder and only adds build tasks of shaders which include changed files directly or indirectly.
+	// All uber combines of affected fragment shaders of the material types are rebuilt, or only loaded ones in lazy mode.
+	// Returns the count of changed files.
+	static uint32_t BuildChangedShaders(const std::string& folderPath, const std::vector<engine::MaterialType*>& materialTypes);
+
 private:
 	static const ShaderType GetShaderType(const std::string& fileName);
+	static void BuildUberVertexShader(const engine::ShaderSchema& shaderSchema);
+	static void BuildUberFragmentShader(const engine::ShaderSchema& shaderSchema);
 };
 
 } // namespace editor
@@ -0,0 +1,229 @@
+#include "ShaderCompiler.h"
+
+#include "Base/Template.h"
+#include "Log/Log.h"
+#include "Resources/ShaderDependencyGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifdef ENABLE_SHADERC_LIBRARY
+#include <bx/file.h>
+#include <shaderc.h>
+#endif
+
+namespace editor
+{
+
+namespace
+{
+
+#ifdef ENABLE_SHADERC_LIBRARY
+// Returns the value of the first matched option as bx::CommandLine which is used by shaderc.
+const char* FindOption(const std::vector<std::string>& arguments, const char* pShortName, const char* pLongName)
+{
+	for (size_t argumentIndex = 0; argumentIndex + 1 < arguments.size(); ++argumentIndex)
+	{
+		const std::string& argument = arguments[argumentIndex];
+		if ((pShortName && '-' == argument[0] && 0 == argument.compare(1, std::string::npos, pShortName)) ||
+			(pLongName && 0 == argument.compare(0, 2, "--") && 0 == argument.compare(2, std::string::npos, pLongName)))
+		{
+			return arguments[argumentIndex + 1].c_str();
+		}
+	}
+
+	return nullptr;
+}
+
+// Collects messages of shaderc so that messages of parallel compilations are not interleaved in logs.
+class StringWriter final : public bx::WriterI
+{
+public:
+	int32_t write(const void* pData, int32_t size, bx::Error*) override
+	{
+		m_text.append(static_cast<const char*>(pData), size);
+		return size;
+	}
+
+	const std::string& GetText() const { return m_text; }
+
+private:
+	std::string m_text;
+};
+
+// shaderc keeps global state in fcpp, glsl-optimizer and glslang so only one compilation can run at a time.
+std::mutex s_shadercMutex;
+#endif
+
+}
+
+ShaderCompiler::ShaderCompiler(ShaderDependencyGraph* pDependencyGraph)
+	: m_pDependencyGraph(pDependencyGraph)
+{
+	assert(pDependencyGraph);
+}
+
+void ShaderCompiler::InlineIncludes(const std::string& filePath, std::string& outText, std::vector<std::string>& includeStack) const
+{
+	std::ifstream inFile(filePath, std::ios::binary);
+	std::string content((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+
+	// Skip UTF-8 BOM as shaderc does.
+	if (0 == content.compare(0, 3, "\xEF\xBB\xBF"))
+	{
+		content.erase(0, 3);
+	}
+
+	includeStack.push_back(filePath);
+	const std::filesystem::path folderPath = std::filesystem::path(filePath).parent_path();
+	std::istringstream stream(content);
+	std::string line;
+	std::string includeName;
+	while (std::getline(stream, line))
+	{
+		// Includes which can't be resolved are left to include directories of shaderc. Recursive includes are left to include guards.
+		if (ShaderDependencyGraph::ParseIncludeLine(line, includeName))
+		{
+			const std::filesystem::path includePath = folderPath / includeName;
+			std::string normalizedIncludePath = ShaderDependencyGraph::NormalizePath(includePath);
+			if (std::filesystem::is_regular_file(includePath) &&
+				std::find(includeStack.begin(), includeStack.end(), normalizedIncludePath) == includeStack.end())
+			{
+				InlineIncludes(normalizedIncludePath, outText, includeStack);
+				continue;
+			}
+		}
+
+		outText += line;
+		outText += '\n';
+	}
+	includeStack.pop_back();
+}
+
+std::shared_ptr<const std::string> ShaderCompiler::GetPreprocessedSource(const std::string& filePath)
+{
+	const std::string normalizedPath = ShaderDependencyGraph::NormalizePath(filePath);
+	const uint64_t hash = m_pDependencyGraph->GetHashWithIncludes(normalizedPath);
+
+	// Other threads which compile the same source wait for the first one to preprocess it.
+	std::lock_guard<std::mutex> lock(m_mutex);
+	PreprocessedSource& source = m_preprocessedSources[normalizedPath];
+	if (!source.text || source.hash != hash)
+	{
+		auto pText = std::make_shared<std::string>();
+		std::vector<std::string> includeStack;
+		InlineIncludes(normalizedPath, *pText, includeStack);
+		source.hash = hash;
+		source.text = cd::MoveTemp(pText);
+	}
+
+	return source.text;
+}
+
+int ShaderCompiler::Compile(const std::vector<std::string>& arguments)
+{
+#ifdef ENABLE_SHADERC_LIBRARY
+	const char* pInputFilePath = FindOption(arguments, "f", nullptr);
+	const char* pOutputFilePath = FindOption(arguments, "o", nullptr);
+	const char* pShaderType = FindOption(arguments, nullptr, "type");
+	if (!pInputFilePath || !pOutputFilePath || !pShaderType)
+	{
+		CD_ERROR("Input, output and type are required to compile shaders.");
+		return -1;
+	}
+
+	bgfx::Options options;
+	options.inputFilePath = pInputFilePath;
+	options.outputFilePath = pOutputFilePath;
+	options.shaderType = static_cast<char>(std::tolower(pShaderType[0]));
+	options.includeDirs.push_back(std::filesystem::path(pInputFilePath).parent_path().string());
+	if (const char* pPlatform = FindOption(arguments, nullptr, "platform"))
+	{
+		options.platform = pPlatform;
+	}
+	if (const char* pProfile = FindOption(arguments, "p", "profile"))
+	{
+		options.profile = pProfile;
+	}
+	if (const char* pOptimizationLevel = FindOption(arguments, "O", nullptr))
+	{
+		options.optimize = true;
+		options.optimizationLevel = static_cast<uint32_t>(std::atoi(pOptimizationLevel));
+	}
+	if (const char* pDefines = FindOption(arguments, nullptr, "define"))
+	{
+		std::istringstream defineStream(pDefines);
+		std::string define;
+		while (std::getline(defineStream, define, ';'))
+		{
+			if (!define.empty())
+			{
+				options.defines.push_back(cd::MoveTemp(define));
+			}
+		}
+	}
+
+	std::shared_ptr<const std::string> pVarying;
+	if (const char* pVaryingDefFilePath = FindOption(arguments, nullptr, "varyingdef"))
+	{
+		pVarying = GetPreprocessedSource(pVaryingDefFilePath);
+	}
+
+	// shaderc replaces keywords in place so that it needs a copy with padding. A new line is required at the end.
+	constexpr size_t ShaderPadding = 16384;
+	std::shared_ptr<const std::string> pSource = GetPreprocessedSource(pInputFilePath);
+	std::vector<char> shaderText(pSource->size() + ShaderPadding + 1, '\0');
+	std::memcpy(shaderText.data(), pSource->data(), pSource->size());
+	shaderText[pSource->size()] = '\n';
+
+	std::string commandLineComment = "// shaderc command line:\n//";
+	for (const std::string& argument : arguments)
+	{
+		commandLineComment += " " + argument;
+	}
+	commandLineComment += "\n\n";
+
+	bx::FileWriter shaderWriter;
+	bx::Error error;
+	if (!bx::open(&shaderWriter, pOutputFilePath, false, &error))
+	{
+		CD_ERROR("Open file {0} failed!", pOutputFilePath);
+		return -1;
+	}
+
+	StringWriter messageWriter;
+	bool succeeded = false;
+	{
+		std::lock_guard<std::mutex> lock(s_shadercMutex);
+		succeeded = bgfx::compileShader(pVarying ? pVarying->c_str() : "", commandLineComment.c_str(), shaderText.data(),
+			static_cast<uint32_t>(pSource->size()), options, &shaderWriter, &messageWriter);
+	}
+	bx::close(&shaderWriter);
+
+	if (!messageWriter.GetText().empty())
+	{
+		CD_ERROR("{0}\n{1}", pInputFilePath, messageWriter.GetText());
+	}
+
+	if (!succeeded)
+	{
+		std::error_code errorCode;
+		std::filesystem::remove(pOutputFilePath, errorCode);
+		return 1;
+	}
+
+	return 0;
+#else
+	static_cast<void>(arguments);
+	CD_ERROR("Shaderc library is not linked. Define ENABLE_SHADERC_LIBRARY to compile shaders in process.");
+	return -1;
+#endif
+}
+
+}
\ No newline at end of file
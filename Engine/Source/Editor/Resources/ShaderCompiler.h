@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace editor
+{
+
+class ShaderDependencyGraph;
+
+// ShaderCompiler compiles shaders in the editor process by bgfx's shaderc which is linked as a library if ENABLE_SHADERC_LIBRARY is defined.
+// It takes the same command line arguments as the shaderc executable so that both ways build identical outputs with identical cache keys.
+// Sources are preprocessed once by inlining their includes. Uber combines of the same source share the text in different threads.
+class ShaderCompiler final
+{
+public:
+	static constexpr bool IsAvailable()
+	{
+#ifdef ENABLE_SHADERC_LIBRARY
+		return true;
+#else
+		return false;
+#endif
+	}
+
+public:
+	ShaderCompiler() = delete;
+	explicit ShaderCompiler(ShaderDependencyGraph* pDependencyGraph);
+	ShaderCompiler(const ShaderCompiler&) = delete;
+	ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+	ShaderCompiler(ShaderCompiler&&) = delete;
+	ShaderCompiler& operator=(ShaderCompiler&&) = delete;
+	~ShaderCompiler() = default;
+
+	// Returns 0 if succeeded like the exit code of shaderc. It is safe to call in multiple threads.
+	// Only the shaderc compilation itself is serialized. Parsing arguments, preprocessing and file outputs stay parallel.
+	int Compile(const std::vector<std::string>& arguments);
+
+	// Returns the source with includes which can be resolved relative to the including files inlined.
+	std::shared_ptr<const std::string> GetPreprocessedSource(const std::string& filePath);
+
+private:
+	struct PreprocessedSource
+	{
+		uint64_t hash;
+		std::shared_ptr<const std::string> text;
+	};
+
+	void InlineIncludes(const std::string& filePath, std::string& outText, std::vector<std::string>& includeStack) const;
+
+private:
+	ShaderDependencyGraph* m_pDependencyGraph;
+
+	std::mutex m_mutex;
+	std::unordered_map<std::string, PreprocessedSource> m_preprocessedSources;
+};
+
+}
\ No newline at end of file
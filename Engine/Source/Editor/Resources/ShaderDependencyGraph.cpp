@@ -0,0 +1,328 @@
+#include "ShaderDependencyGraph.h"
+
+#include "Base/Template.h"
+#include "Log/Log.h"
+#include "Resources/ContentHash.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace editor
+{
+
+namespace
+{
+
+constexpr const char* VaryingDefFileName = "varying.def.sc";
+
+std::vector<std::string> ParseIncludes(const std::string& source)
+{
+	std::vector<std::string> includes;
+	std::istringstream stream(source);
+	std::string line;
+	std::string includeName;
+	while (std::getline(stream, line))
+	{
+		if (ShaderDependencyGraph::ParseIncludeLine(line, includeName))
+		{
+			includes.push_back(cd::MoveTemp(includeName));
+		}
+	}
+
+	return includes;
+}
+
+bool IsShaderProgram(const std::filesystem::path& filePath)
+{
+	const std::string fileName = filePath.filename().string();
+	return ".sc" == filePath.extension() && VaryingDefFileName != fileName;
+}
+
+}
+
+bool ShaderDependencyGraph::ParseIncludeLine(const std::string& line, std::string& outIncludeName)
+{
+	size_t pos = line.find_first_not_of(" \t");
+	if (std::string::npos == pos || '#' != line[pos])
+	{
+		return false;
+	}
+
+	pos = line.find_first_not_of(" \t", pos + 1);
+	if (std::string::npos == pos || 0 != line.compare(pos, 7, "include"))
+	{
+		return false;
+	}
+
+	const size_t beginPos = line.find_first_of("\"<", pos + 7);
+	if (std::string::npos == beginPos)
+	{
+		return false;
+	}
+
+	const size_t endPos = line.find_first_of("\">", beginPos + 1);
+	if (std::string::npos == endPos)
+	{
+		return false;
+	}
+
+	outIncludeName = line.substr(beginPos + 1, endPos - beginPos - 1);
+	return true;
+}
+
+bool ShaderDependencyGraph::IsShaderSource(const std::filesystem::path& filePath)
+{
+	const std::filesystem::path extension = filePath.extension();
+	return ".sc" == extension || ".sh" == extension;
+}
+
+std::string ShaderDependencyGraph::NormalizePath(const std::filesystem::path& filePath)
+{
+	return filePath.lexically_normal().generic_string();
+}
+
+ShaderDependencyGraph::ShaderDependencyGraph(std::filesystem::path cacheFilePath)
+	: m_cacheFilePath(cd::MoveTemp(cacheFilePath))
+{
+	if (std::filesystem::exists(m_cacheFilePath))
+	{
+		ReadCacheFile();
+	}
+}
+
+ShaderDependencyGraph::~ShaderDependencyGraph()
+{
+	WriteCacheFile();
+}
+
+void ShaderDependencyGraph::ReadCacheFile()
+{
+	std::ifstream inFile(m_cacheFilePath);
+	if (!inFile.is_open())
+	{
+		CD_ERROR("Open file {0} failed!", m_cacheFilePath.string());
+		return;
+	}
+
+	CD_INFO("Reading shader dependency graph from {0}.", m_cacheFilePath.string());
+
+	// Every line is : path \t write time \t file size \t content hash [\t include]...
+	std::string line;
+	while (std::getline(inFile, line))
+	{
+		std::vector<std::string> fields;
+		std::istringstream lineStream(line);
+		std::string field;
+		while (std::getline(lineStream, field, '\t'))
+		{
+			fields.push_back(cd::MoveTemp(field));
+		}
+
+		if (fields.size() < 4)
+		{
+			continue;
+		}
+
+		FileNode& fileNode = m_fileNodes[fields[0]];
+		fileNode.writeTime = std::stoll(fields[1]);
+		fileNode.fileSize = std::stoull(fields[2]);
+		fileNode.contentHash = std::stoull(fields[3], nullptr, 16);
+		fileNode.includes.assign(std::make_move_iterator(fields.begin() + 4), std::make_move_iterator(fields.end()));
+	}
+}
+
+void ShaderDependencyGraph::WriteCacheFile()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_isCacheDirty)
+	{
+		return;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(m_cacheFilePath.parent_path(), errorCode);
+	std::ofstream outFile(m_cacheFilePath, std::ios::trunc);
+	if (!outFile.is_open())
+	{
+		CD_ERROR("Open file {0} failed!", m_cacheFilePath.string());
+		return;
+	}
+
+	CD_INFO("Writing shader dependency graph to {0}.", m_cacheFilePath.string());
+
+	for (const auto& [filePath, fileNode] : m_fileNodes)
+	{
+		outFile << filePath << '\t' << fileNode.writeTime << '\t' << fileNode.fileSize << '\t' << std::hex << fileNode.contentHash << std::dec;
+		for (const std::string& include : fileNode.includes)
+		{
+			outFile << '\t' << include;
+		}
+		outFile << std::endl;
+	}
+	m_isCacheDirty = false;
+}
+
+bool ShaderDependencyGraph::UpdateNode(const std::string& filePath)
+{
+	// Raw ticks of file time are enough to detect changes. They are not converted to time stamps which lose precision.
+	std::error_code errorCode;
+	const long long writeTime = static_cast<long long>(std::filesystem::last_write_time(filePath, errorCode).time_since_epoch().count());
+	const uintmax_t fileSize = std::filesystem::file_size(filePath, errorCode);
+
+	auto itFileNode = m_fileNodes.find(filePath);
+	const bool isNewNode = itFileNode == m_fileNodes.end();
+	if (!isNewNode && itFileNode->second.writeTime == writeTime && itFileNode->second.fileSize == fileSize)
+	{
+		return false;
+	}
+
+	std::ifstream inFile(filePath, std::ios::binary);
+	std::string content((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+
+	FileNode& fileNode = m_fileNodes[filePath];
+	const uint64_t oldContentHash = fileNode.contentHash;
+	fileNode.writeTime = writeTime;
+	fileNode.fileSize = fileSize;
+	fileNode.contentHash = ContentHash::HashString(ContentHash::Seed, content);
+	fileNode.includes.clear();
+	m_isCacheDirty = true;
+
+	const std::filesystem::path path(filePath);
+	if (IsShaderSource(path))
+	{
+		// Includes are relative to the including file.
+		const std::filesystem::path folderPath = path.parent_path();
+		for (std::string& includeName : ParseIncludes(content))
+		{
+			const std::filesystem::path includePath = folderPath / includeName;
+			fileNode.includes.push_back(std::filesystem::exists(includePath) ? NormalizePath(includePath) : cd::MoveTemp(includeName));
+		}
+
+		if (IsShaderProgram(path) && std::filesystem::exists(folderPath / VaryingDefFileName))
+		{
+			fileNode.includes.push_back(NormalizePath(folderPath / VaryingDefFileName));
+		}
+	}
+
+	return isNewNode || oldContentHash != fileNode.contentHash;
+}
+
+std::vector<std::string> ShaderDependencyGraph::Scan(const std::filesystem::path& folderPath)
+{
+	std::vector<std::string> changedFiles;
+	std::unordered_set<std::string> scannedFiles;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(folderPath))
+	{
+		if (!entry.is_regular_file() || !IsShaderSource(entry.path()))
+		{
+			continue;
+		}
+
+		std::string filePath = NormalizePath(entry.path());
+		if (UpdateNode(filePath))
+		{
+			changedFiles.push_back(filePath);
+		}
+		scannedFiles.insert(cd::MoveTemp(filePath));
+	}
+
+	// Files which are recorded in the folder but not scanned are removed.
+	const std::string folderPrefix = NormalizePath(folderPath / "");
+	for (auto itFileNode = m_fileNodes.begin(); itFileNode != m_fileNodes.end();)
+	{
+		const std::string& filePath = itFileNode->first;
+		if (0 == filePath.compare(0, folderPrefix.size(), folderPrefix) && scannedFiles.find(filePath) == scannedFiles.end())
+		{
+			changedFiles.push_back(filePath);
+			itFileNode = m_fileNodes.erase(itFileNode);
+			m_isCacheDirty = true;
+		}
+		else
+		{
+			++itFileNode;
+		}
+	}
+
+	CD_INFO("Scanned {0} shader sources in {1}, {2} changed.", scannedFiles.size(), folderPath.string(), changedFiles.size());
+	return changedFiles;
+}
+
+uint64_t ShaderDependencyGraph::HashWithIncludes(uint64_t hash, const std::string& filePath, std::unordered_set<std::string>& visitedFiles)
+{
+	if (!visitedFiles.insert(filePath).second)
+	{
+		return hash;
+	}
+
+	if (!std::filesystem::is_regular_file(filePath))
+	{
+		return ContentHash::HashString(hash, filePath);
+	}
+
+	UpdateNode(filePath);
+	const FileNode& fileNode = m_fileNodes[filePath];
+	hash = ContentHash::HashBytes(hash, &fileNode.contentHash, sizeof(fileNode.contentHash));
+	for (const std::string& include : fileNode.includes)
+	{
+		hash = HashWithIncludes(hash, include, visitedFiles);
+	}
+
+	return hash;
+}
+
+uint64_t ShaderDependencyGraph::GetHashWithIncludes(const std::string& filePath)
+{
+	std::unordered_set<std::string> visitedFiles;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return HashWithIncludes(ContentHash::Seed, NormalizePath(filePath), visitedFiles);
+}
+
+std::unordered_set<std::string> ShaderDependencyGraph::GetDependents(const std::vector<std::string>& filePaths)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::unordered_map<std::string, std::vector<const std::string*>> includedBy;
+	for (const auto& [filePath, fileNode] : m_fileNodes)
+	{
+		for (const std::string& include : fileNode.includes)
+		{
+			includedBy[include].push_back(&filePath);
+		}
+	}
+
+	std::unordered_set<std::string> dependents;
+	std::vector<std::string> pendingFiles;
+	for (const std::string& filePath : filePaths)
+	{
+		std::string normalizedPath = NormalizePath(filePath);
+		if (dependents.insert(normalizedPath).second)
+		{
+			pendingFiles.push_back(cd::MoveTemp(normalizedPath));
+		}
+	}
+
+	while (!pendingFiles.empty())
+	{
+		std::string filePath = cd::MoveTemp(pendingFiles.back());
+		pendingFiles.pop_back();
+
+		auto itIncludedBy = includedBy.find(filePath);
+		if (itIncludedBy == includedBy.end())
+		{
+			continue;
+		}
+
+		for (const std::string* pDependent : itIncludedBy->second)
+		{
+			if (dependents.insert(*pDependent).second)
+			{
+				pendingFiles.push_back(*pDependent);
+			}
+		}
+	}
+
+	return dependents;
+}
+
+}
\ No newline at end of file
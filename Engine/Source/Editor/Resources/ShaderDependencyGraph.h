@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace editor
+{
+
+// ShaderDependencyGraph records #include edges between shader sources together with content hashes of every file.
+// It is cached to a file so that only files whose write time or size changed are read and parsed again in the next run.
+// Shader programs, e.g. vs_*.sc, fs_*.sc and cs_*.sc, also depend on varying.def.sc in their folders which is passed to shaderc.
+// Other input files of build tasks, e.g. textures, are recorded without includes so that their content hashes are cached too.
+// Paths are normalized generic strings. Includes which can't be resolved are kept as their names in the source.
+class ShaderDependencyGraph final
+{
+public:
+	static bool IsShaderSource(const std::filesystem::path& filePath);
+	static std::string NormalizePath(const std::filesystem::path& filePath);
+
+	// Returns true if the line is #include "name" or #include <name>.
+	static bool ParseIncludeLine(const std::string& line, std::string& outIncludeName);
+
+public:
+	ShaderDependencyGraph() = delete;
+	explicit ShaderDependencyGraph(std::filesystem::path cacheFilePath);
+	ShaderDependencyGraph(const ShaderDependencyGraph&) = delete;
+	ShaderDependencyGraph& operator=(const ShaderDependencyGraph&) = delete;
+	ShaderDependencyGraph(ShaderDependencyGraph&&) = delete;
+	ShaderDependencyGraph& operator=(ShaderDependencyGraph&&) = delete;
+	~ShaderDependencyGraph();
+
+	// Updates all shader sources in the folder recursively.
+	// Returns files which are added, removed or have different contents since they were read by the graph last time.
+	std::vector<std::string> Scan(const std::filesystem::path& folderPath);
+
+	// Hash of contents of the file and all files included by it directly or indirectly.
+	uint64_t GetHashWithIncludes(const std::string& filePath);
+
+	// Returns the files and all shader sources which include them directly or indirectly.
+	std::unordered_set<std::string> GetDependents(const std::vector<std::string>& filePaths);
+
+	void WriteCacheFile();
+
+private:
+	struct FileNode
+	{
+		long long writeTime = 0;
+		uintmax_t fileSize = 0U;
+		uint64_t contentHash = 0U;
+		std::vector<std::string> includes;
+	};
+
+	void ReadCacheFile();
+
+	// Returns true if the file is read again and its contents changed.
+	bool UpdateNode(const std::string& filePath);
+	uint64_t HashWithIncludes(uint64_t hash, const std::string& filePath, std::unordered_set<std::string>& visitedFiles);
+
+private:
+	std::filesystem::path m_cacheFilePath;
+
+	// Protects nodes which are used by adding build tasks in different threads.
+	std::mutex m_mutex;
+	std::unordered_map<std::string, FileNode> m_fileNodes;
+	bool m_isCacheDirty = false;
+};
+
+}
\ No newline at end of file
@@ -226,7 +226,7 @@ bool AssetBrowser::RenderFile(int dirIndex, bool folder, int shownIndex, bool gr
 				 if (!bgfx::isValid(TextureHandle))
 				 {
 					 ResourceBuilder::Get().AddTextureBuildTask(cd::MaterialTextureType::Normal, texturesPath.string().c_str(), texviewPath.string().c_str());
-					 ResourceBuilder::Get().Update();
+					 ResourceBuilder::Get().Flush();
 					 std::string texview = "Textures/textures/";
 					 texview += (nameNoEx + ".dds");
 					 bgfx::TextureHandle textureHandle = pRenderContext->CreateTexture(texview.c_str());
@@ -805,11 +805,11 @@ void AssetBrowser::ImportAssetFile(const char* pFilePath)
 
 			std::string irrdianceOutput = absolutePath.generic_string() + "_irr.dds";
 			ResourceBuilder::Get().AddIrradianceCubeMapBuildTask(pFilePath, irrdianceOutput.c_str());
-			ResourceBuilder::Get().Update();
+			ResourceBuilder::Get().Flush();
 
 			std::string radianceOutput = absolutePath.generic_string() + "_rad.dds";
 			ResourceBuilder::Get().AddRadianceCubeMapBuildTask(pFilePath, radianceOutput.c_str());
-			ResourceBuilder::Get().Update();
+			ResourceBuilder::Get().Flush();
 
 			pSkyComponent->SetIrradianceTexturePath(relativePath + "_irr.dds");
 			pSkyComponent->SetRadianceTexturePath(relativePath + "_rad.dds");
@@ -842,7 +842,7 @@ void AssetBrowser::ImportAssetFile(const char* pFilePath)
 		std::string outputFilePath = CDPROJECT_RESOURCES_ROOT_PATH;
 		outputFilePath += "Shaders/" + inputFileName + ".bin";
 		ResourceBuilder::Get().AddShaderBuildTask(shaderType, pFilePath, outputFilePath.c_str());
-		ResourceBuilder::Get().Update();
+		ResourceBuilder::Get().Flush();
 	}
 	else if (IOAssetType::Light == m_importOptions.AssetType)
 	{
@@ -1083,6 +1083,7 @@ void AssetBrowser::ImportJson(const char* pFilePath)
 				{
 					pMaterialComponent->GetTextureInfo(cd::MaterialPropertyGroup::BaseColor)->SetUVOffset(GetVec2fFormString(UVOffset));
 					pMaterialComponent->GetTextureInfo(cd::MaterialPropertyGroup::BaseColor)->SetUVScale(GetVec2fFormString(UVScale));
+					pMaterialComponent->Dirty();
 				}
 			}
 			else
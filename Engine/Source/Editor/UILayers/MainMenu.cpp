@@ -224,20 +224,35 @@ void MainMenu::BuildMenu()
 	{
 		engine::SceneWorld* pSceneWorld = GetSceneWorld();
 
+		bool isTaskAdded = false;
 		if (ImGui::MenuItem(CD_TEXT("TEXT_REBUILD_NONUBER_SHADERS")))
 		{
 			std::string nonUberPath = CDENGINE_BUILTIN_SHADER_PATH;
 			ShaderBuilder::BuildNonUberShader(nonUberPath + "shaders");
+			isTaskAdded = true;
 		}
 		if (ImGui::MenuItem(CD_TEXT("TEXT_REBUILD_PBR_SHADERS")))
 		{
 			ShaderBuilder::BuildUberShader(pSceneWorld->GetPBRMaterialType());
+			isTaskAdded = true;
 		}
 		if (ImGui::MenuItem(CD_TEXT("TEXT_REBUILD_ANIMATION_SHADERS")))
 		{
 			ShaderBuilder::BuildUberShader(pSceneWorld->GetAnimationMaterialType());
+			isTaskAdded = true;
+		}
+		if (ImGui::MenuItem(CD_TEXT("TEXT_REBUILD_CHANGED_SHADERS")))
+		{
+			ShaderBuilder::BuildChangedShaders(CDENGINE_BUILTIN_SHADER_PATH, { pSceneWorld->GetPBRMaterialType(), pSceneWorld->GetAnimationMaterialType(),
+				pSceneWorld->GetTerrainMaterialType(), pSceneWorld->GetDDGIMaterialType() });
+			isTaskAdded = true;
+		}
+
+		// Build in the builder thread so that the editor is not blocked.
+		if (isTaskAdded)
+		{
+			ResourceBuilder::Get().UpdateAsync();
 		}
-		ResourceBuilder::Get().Update();
 
 		ImGui::EndMenu();
 	}
@@ -212,41 +212,13 @@ void SceneView::PickSceneMesh(float regionWidth, float regionHeight)
 		return;
 	}
 
-	// Loop through scene's all static meshes' AABB to test intersections with Ray.
+	// Only static meshes' world space AABBs along the ray are tested by SceneBVH.
 	engine::SceneWorld* pSceneWorld = GetSceneWorld();
 	engine::CameraComponent* pCameraComponent = pSceneWorld->GetCameraComponent(pSceneWorld->GetMainCameraEntity());
 	cd::Ray pickRay = pCameraComponent->EmitRay(screenX, screenY, screenWidth, screenHeight);
 
-	float minRayTime = FLT_MAX;
-	engine::Entity nearestEntity = engine::INVALID_ENTITY;
-	for (engine::Entity entity : pSceneWorld->GetStaticMeshEntities())
-	{
-		engine::TransformComponent* pTransformComponent = pSceneWorld->GetTransformComponent(entity);
-		if (!pTransformComponent)
-		{
-			continue;
-		}
-
-		engine::StaticMeshComponent* pMeshComponent = pSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
-		{
-			continue;
-		}
-
-		cd::AABB collisonMeshAABB = pMeshComponent->GetAABB();
-		collisonMeshAABB = collisonMeshAABB.Transform(pTransformComponent->GetWorldMatrix());
-
-		float rayTime;
-		if (collisonMeshAABB.Intersects(pickRay, rayTime))
-		{
-			if (rayTime < minRayTime)
-			{
-				minRayTime = rayTime;
-				nearestEntity = entity;
-			}
-		}
-	}
-
+	float rayTime;
+	engine::Entity nearestEntity = pSceneWorld->GetSceneBVH()->GetBVH().RayCast(pickRay, rayTime);
 	pSceneWorld->SetSelectedEntity(nearestEntity);
 }
 
@@ -1,6 +1,7 @@
 ﻿#include "GameApp.h"
 
 #include "Application/Engine.h"
+#include "Core/Jobs/JobSystem.h"
 #include "Display/CameraController.h"
 #include "ECWorld/SceneWorld.h"
 #include "ImGui/ImGuiContextInstance.h"
@@ -12,6 +13,7 @@
 #include "Rendering/AnimationRenderer.h"
 #include "Rendering/DDGIRenderer.h"
 #include "Rendering/DebugRenderer.h"
+#include "Rendering/HiZRenderer.h"
 #include "Rendering/ImGuiRenderer.h"
 #include "Rendering/PBRSkyRenderer.h"
 #include "Rendering/PostProcessRenderer.h"
@@ -68,6 +70,8 @@ void GameApp::Init(engine::EngineInitArgs initArgs)
 
 void GameApp::Shutdown()
 {
+	// Components own GPU buffers so the scene needs to go away before RenderContext shuts down bgfx.
+	m_pSceneWorld.reset();
 }
 
 engine::Window* GameApp::GetWindow(size_t index) const
@@ -124,6 +128,12 @@ void GameApp::RegisterImGuiUserData(engine::ImGuiContextInstance* pImGuiContext)
 void GameApp::InitECWorld()
 {
 	m_pSceneWorld = std::make_unique<engine::SceneWorld>();
+	if (m_initArgs.useStaticMeshArchetype)
+	{
+		m_pSceneWorld->EnableStaticMeshArchetype();
+	}
+	m_pSceneWorld->GetFrustumCuller()->SetSoftwareOcclusionEnable(m_initArgs.useSoftwareOcclusionCulling ||
+		engine::GraphicsBackend::Noop == m_initArgs.backend);
 
 	InitEditorCameraEntity();
 
@@ -251,7 +261,9 @@ void GameApp::InitEngineRenderers()
 
 	auto pSceneRenderer = std::make_unique<engine::WorldRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
 	m_pSceneRenderer = pSceneRenderer.get();
+	engine::WorldRenderer* pWorldRenderer = pSceneRenderer.get();
 	pSceneRenderer->SetSceneWorld(m_pSceneWorld.get());
+	pSceneRenderer->SetGPUDriven(m_initArgs.useGPUDrivenRendering);
 	AddEngineRenderer(cd::MoveTemp(pSceneRenderer));
 
 	auto pAnimationRenderer = std::make_unique<engine::AnimationRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
@@ -268,6 +280,12 @@ void GameApp::InitEngineRenderers()
 	pDDGIRenderer->SetSceneWorld(m_pSceneWorld.get());
 	AddEngineRenderer(cd::MoveTemp(pDDGIRenderer));
 
+	// Hi-Z pyramid is built after all scene depths are written.
+	auto pHiZRenderer = std::make_unique<engine::HiZRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
+	pHiZRenderer->SetSceneWorld(m_pSceneWorld.get());
+	pWorldRenderer->SetHiZRenderer(pHiZRenderer.get());
+	AddEngineRenderer(cd::MoveTemp(pHiZRenderer));
+
 	// We can debug vertex/material/texture information by just output that to screen as fragmentColor.
 	// But postprocess will bring unnecessary confusion. 
 	auto pPostProcessRenderer = std::make_unique<engine::PostProcessRenderer>(m_pRenderContext->CreateView());
@@ -297,6 +315,21 @@ void GameApp::InitController()
 	m_pCameraController->CameraToController();
 }
 
+void GameApp::UpdateLazyShaderVariants() const
+{
+	if (!m_initArgs.useLazyShaderVariants)
+	{
+		return;
+	}
+
+	// Game loads variants built by the editor. Materials draw with them from next frame.
+	for (engine::MaterialType* pMaterialType : { m_pSceneWorld->GetPBRMaterialType(), m_pSceneWorld->GetAnimationMaterialType(),
+		m_pSceneWorld->GetTerrainMaterialType(), m_pSceneWorld->GetDDGIMaterialType() })
+	{
+		engine::ShaderLoader::UploadRequestedUberShaderVariants(pMaterialType);
+	}
+}
+
 void GameApp::AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer)
 {
 	pRenderer->Init();
@@ -305,11 +338,19 @@ void GameApp::AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer)
 
 bool GameApp::Update(float deltaTime)
 {
+	// Jobs which need to call bgfx APIs in main thread.
+	engine::JobSystem::Get().ExecuteMainThreadJobs();
+
 	// TODO : it is better to remove these logics about splash -> editor switch here.
 	// Better implementation is to have multiple Application or Window classes and they can switch.
 	if (!m_bInitEditor)
 	{
 		m_bInitEditor = true;
+		for (engine::MaterialType* pMaterialType : { m_pSceneWorld->GetPBRMaterialType(), m_pSceneWorld->GetAnimationMaterialType(),
+			m_pSceneWorld->GetTerrainMaterialType(), m_pSceneWorld->GetDDGIMaterialType() })
+		{
+			pMaterialType->GetShaderSchema().SetLazyVariants(m_initArgs.useLazyShaderVariants);
+		}
 		engine::ShaderLoader::UploadUberShader(m_pSceneWorld->GetPBRMaterialType());
 		engine::ShaderLoader::UploadUberShader(m_pSceneWorld->GetAnimationMaterialType());
 		engine::ShaderLoader::UploadUberShader(m_pSceneWorld->GetTerrainMaterialType());
@@ -342,6 +383,8 @@ bool GameApp::Update(float deltaTime)
 	}
 	else
 	{
+		UpdateLazyShaderVariants();
+
 		if (m_pCameraController)
 		{
 			m_pCameraController->Update(deltaTime);
@@ -349,11 +392,12 @@ bool GameApp::Update(float deltaTime)
 	}
 
 	GetMainWindow()->Update();
-	m_pSceneWorld->Update();
 
+	// Frustum culling in scene update uses the main camera's projection matrix.
 	engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
 	assert(pMainCameraComponent);
 	pMainCameraComponent->BuildProjectMatrix();
+	m_pSceneWorld->Update(deltaTime);
 
 	m_pRenderContext->BeginFrame();
 	if (m_pEngineImGuiContext)
@@ -49,6 +49,7 @@ public:
 
 	void InitRenderContext(engine::GraphicsBackend backend, void* hwnd = nullptr);
 	void InitEngineRenderers();
+	void UpdateLazyShaderVariants() const;
 	void AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer);
 
 	void InitEngineImGuiContext(engine::Language language);
@@ -19,6 +19,21 @@ struct EngineInitArgs
 	bool useFullScreen = false;
 	Language language = Language::English;
 	GraphicsBackend backend = GraphicsBackend::Direct3D11;
+
+	// Cull and draw static meshes by compute shaders and indirect draws in large scenes.
+	bool useGPUDrivenRendering = false;
+
+	// Rasterize occluders on CPU for occlusion culling instead of reading GPU depths back.
+	// It is always used by Noop backend.
+	bool useSoftwareOcclusionCulling = false;
+
+	// Store imported static meshes in chunks of StaticMeshArchetype for cache friendly render extraction.
+	// Editor UI doesn't show their transforms, meshes and materials.
+	bool useStaticMeshArchetype = false;
+
+	// Only build and load the DEFAULT variant of uber shaders at startup.
+	// Other variants are built and loaded when materials use them for the first time.
+	bool useLazyShaderVariants = false;
 };
 
 class IApplication
@@ -0,0 +1,275 @@
+#include "JobSystem.h"
+
+#include <cassert>
+
+namespace engine
+{
+
+namespace
+{
+
+// Worker threads remember which JobSystem they belong to so that nested submits go to their own deques.
+thread_local const JobSystem* t_pOwnerJobSystem = nullptr;
+thread_local uint32_t t_workerIndex = 0U;
+
+}
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+	if (0U == workerCount)
+	{
+		uint32_t hardwareThreadCount = std::thread::hardware_concurrency();
+		workerCount = hardwareThreadCount > 1U ? hardwareThreadCount - 1U : 1U;
+	}
+
+	for (uint32_t queueIndex = 0U; queueIndex <= workerCount; ++queueIndex)
+	{
+		m_jobQueues.emplace_back(std::make_unique<JobQueue>());
+	}
+
+	m_workers.reserve(workerCount);
+	for (uint32_t workerIndex = 0U; workerIndex < workerCount; ++workerIndex)
+	{
+		m_workers.emplace_back([this, workerIndex]() { WorkerLoop(workerIndex); });
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_isRunning.store(false);
+	}
+	m_wakeCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::Submit(JobFunction job, JobCounter* pCounter, JobCounter* pDependency)
+{
+	if (pCounter)
+	{
+		pCounter->Increment();
+	}
+
+	if (pDependency)
+	{
+		// The last finished job of pDependency will take dependent jobs under the same lock,
+		// so the job is either queued here or released by it.
+		std::lock_guard<std::mutex> lock(pDependency->m_dependentJobsMutex);
+		if (0U != pDependency->m_count.load())
+		{
+			pDependency->m_dependentJobs.push_back(Job{ std::move(job), pCounter });
+			return;
+		}
+	}
+
+	PushJob(Job{ std::move(job), pCounter });
+}
+
+void JobSystem::SubmitToMainThread(JobFunction job, JobCounter* pCounter)
+{
+	if (pCounter)
+	{
+		pCounter->Increment();
+	}
+
+	std::lock_guard<std::mutex> lock(m_mainThreadJobsMutex);
+	m_mainThreadJobs.push_back(Job{ std::move(job), pCounter });
+}
+
+void JobSystem::ExecuteMainThreadJobs()
+{
+	// Jobs submitted during execution will be executed in the next call.
+	std::vector<Job> mainThreadJobs;
+	{
+		std::lock_guard<std::mutex> lock(m_mainThreadJobsMutex);
+		mainThreadJobs.swap(m_mainThreadJobs);
+	}
+
+	for (Job& job : mainThreadJobs)
+	{
+		ExecuteJob(job);
+	}
+}
+
+void JobSystem::SubmitBackground(JobFunction job, JobCounter* pCounter)
+{
+	if (pCounter)
+	{
+		pCounter->Increment();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_pendingBackgroundJobCount.fetch_add(1U, std::memory_order_release);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_backgroundJobQueue.mutex);
+		m_backgroundJobQueue.jobs.push_back(Job{ std::move(job), pCounter });
+	}
+	m_wakeCondition.notify_one();
+}
+
+void JobSystem::PushJob(Job job)
+{
+	{
+		// Count before publishing the job so that the pending count never underflows.
+		// Update under the wake mutex so that a worker can't miss the notification between its check and wait.
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_pendingJobCount.fetch_add(1U, std::memory_order_release);
+	}
+
+	JobQueue& jobQueue = *m_jobQueues[GetCurrentQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(jobQueue.mutex);
+		jobQueue.jobs.push_back(std::move(job));
+	}
+	m_wakeCondition.notify_one();
+}
+
+void JobSystem::ExecuteJob(Job& job)
+{
+	job.function();
+	if (job.pCounter)
+	{
+		FinishJob(*job.pCounter);
+	}
+}
+
+void JobSystem::FinishJob(JobCounter& counter)
+{
+	counter.m_finishingCount.fetch_add(1U);
+	if (1U == counter.m_count.fetch_sub(1U))
+	{
+		std::vector<Job> dependentJobs;
+		{
+			std::lock_guard<std::mutex> lock(counter.m_dependentJobsMutex);
+			dependentJobs.swap(counter.m_dependentJobs);
+		}
+
+		for (Job& dependentJob : dependentJobs)
+		{
+			PushJob(std::move(dependentJob));
+		}
+	}
+
+	// Counter may be destroyed by waiting thread after this line.
+	counter.m_finishingCount.fetch_sub(1U);
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+	const uint32_t queueIndex = GetCurrentQueueIndex();
+	while (!counter.IsDone())
+	{
+		if (!TryExecuteJob(queueIndex))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::WorkerLoop(uint32_t workerIndex)
+{
+	t_pOwnerJobSystem = this;
+	t_workerIndex = workerIndex;
+
+	while (true)
+	{
+		if (TryExecuteJob(workerIndex) || TryExecuteBackgroundJob())
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait(lock, [this]()
+		{
+			return !m_isRunning.load() || m_pendingJobCount.load(std::memory_order_acquire) > 0U ||
+				m_pendingBackgroundJobCount.load(std::memory_order_acquire) > 0U;
+		});
+
+		if (!m_isRunning.load() && 0U == m_pendingJobCount.load(std::memory_order_acquire) &&
+			0U == m_pendingBackgroundJobCount.load(std::memory_order_acquire))
+		{
+			break;
+		}
+	}
+}
+
+bool JobSystem::TryExecuteJob(uint32_t queueIndex)
+{
+	Job job;
+	if (!TryPopJob(queueIndex, job) && !TryStealJob(queueIndex, job))
+	{
+		return false;
+	}
+
+	m_pendingJobCount.fetch_sub(1U, std::memory_order_acq_rel);
+	ExecuteJob(job);
+	return true;
+}
+
+bool JobSystem::TryExecuteBackgroundJob()
+{
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(m_backgroundJobQueue.mutex);
+		if (m_backgroundJobQueue.jobs.empty())
+		{
+			return false;
+		}
+
+		job = std::move(m_backgroundJobQueue.jobs.front());
+		m_backgroundJobQueue.jobs.pop_front();
+	}
+
+	m_pendingBackgroundJobCount.fetch_sub(1U, std::memory_order_acq_rel);
+	ExecuteJob(job);
+	return true;
+}
+
+bool JobSystem::TryPopJob(uint32_t queueIndex, Job& outJob)
+{
+	// Newest job first as its data is still hot in cache.
+	JobQueue& jobQueue = *m_jobQueues[queueIndex];
+	std::lock_guard<std::mutex> lock(jobQueue.mutex);
+	if (jobQueue.jobs.empty())
+	{
+		return false;
+	}
+
+	outJob = std::move(jobQueue.jobs.back());
+	jobQueue.jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::TryStealJob(uint32_t queueIndex, Job& outJob)
+{
+	// Oldest job first from others' deques which is usually the largest piece of remaining work.
+	const uint32_t queueCount = static_cast<uint32_t>(m_jobQueues.size());
+	for (uint32_t offset = 1U; offset < queueCount; ++offset)
+	{
+		JobQueue& jobQueue = *m_jobQueues[(queueIndex + offset) % queueCount];
+		std::lock_guard<std::mutex> lock(jobQueue.mutex);
+		if (!jobQueue.jobs.empty())
+		{
+			outJob = std::move(jobQueue.jobs.front());
+			jobQueue.jobs.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint32_t JobSystem::GetCurrentQueueIndex() const
+{
+	return this == t_pOwnerJobSystem ? t_workerIndex : static_cast<uint32_t>(m_jobQueues.size() - 1);
+}
+
+}
\ No newline at end of file
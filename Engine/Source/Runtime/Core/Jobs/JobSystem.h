@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+
+using JobFunction = std::function<void()>;
+
+// JobCounter counts submitted jobs which are not finished yet.
+// Wait on it by JobSystem::Wait which helps to execute other jobs instead of blocking.
+// It can also be used as a dependency of other jobs which will be queued after it is done.
+class JobCounter final
+{
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+	JobCounter(JobCounter&&) = delete;
+	JobCounter& operator=(JobCounter&&) = delete;
+	~JobCounter() = default;
+
+	void Increment(uint32_t count = 1U) { m_count.fetch_add(count, std::memory_order_relaxed); }
+
+	// Also waits for finishing jobs to leave so that the counter is safe to destroy after it returns true.
+	bool IsDone() const { return 0U == m_count.load() && 0U == m_finishingCount.load(); }
+
+private:
+	friend class JobSystem;
+
+	struct DependentJob
+	{
+		JobFunction function;
+		JobCounter* pCounter;
+	};
+
+	std::atomic<uint32_t> m_count = 0U;
+	std::atomic<uint32_t> m_finishingCount = 0U;
+
+	// Jobs waiting for this counter. Protected by mutex as they are rare compared to increments and decrements.
+	std::mutex m_dependentJobsMutex;
+	std::vector<DependentJob> m_dependentJobs;
+};
+
+// JobSystem owns a group of worker threads. Every worker has its own job deque.
+// A worker pops jobs from the back of its own deque and steals from the front of others' deques when it is idle.
+// Jobs submitted from threads which are not workers, e.g. main thread, go to a shared external deque.
+// Jobs which call bgfx APIs should be submitted by SubmitToMainThread as bgfx is only allowed to be used in the API thread.
+// The exception is encoding draws by bgfx::Encoders which are designed for worker threads, see Renderer::ParallelEncode.
+class JobSystem final
+{
+public:
+	// Engine wide job system which uses all hardware threads except the main thread.
+	static JobSystem& Get()
+	{
+		static JobSystem s_instance;
+		return s_instance;
+	}
+
+public:
+	// 0 means hardware concurrency - 1.
+	explicit JobSystem(uint32_t workerCount = 0U);
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	JobSystem(JobSystem&&) = delete;
+	JobSystem& operator=(JobSystem&&) = delete;
+	~JobSystem();
+
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+	// pCounter is optional. It will be incremented now and decremented after job finished.
+	// pDependency is optional. Job will be queued after pDependency is done.
+	void Submit(JobFunction job, JobCounter* pCounter = nullptr, JobCounter* pDependency = nullptr);
+
+	// Job will be executed in the thread which calls ExecuteMainThreadJobs.
+	void SubmitToMainThread(JobFunction job, JobCounter* pCounter = nullptr);
+
+	// Call it once per frame from main thread.
+	void ExecuteMainThreadJobs();
+
+	// Long jobs, e.g. asset processing, which must not stall frames.
+	// Only workers execute them when their deques and others' are empty. Wait never executes them.
+	void SubmitBackground(JobFunction job, JobCounter* pCounter = nullptr);
+
+	// Execute pending jobs in current thread until counter is done.
+	// Main thread jobs are not executed here so don't wait for them in main thread.
+	void Wait(const JobCounter& counter);
+
+	// Split [0, count) into ranges which have grainSize elements at most and execute them on workers.
+	// Current thread joins to execute ranges and returns after all ranges finished.
+	// 0 grainSize means splitting into several ranges per worker.
+	template<typename Func>
+	void ParallelFor(uint32_t count, uint32_t grainSize, Func&& func)
+	{
+		if (0U == count)
+		{
+			return;
+		}
+
+		if (0U == grainSize)
+		{
+			const uint32_t rangeCount = (GetWorkerCount() + 1U) * 4U;
+			grainSize = (count + rangeCount - 1U) / rangeCount;
+		}
+
+		// Too small to split.
+		if (count <= grainSize)
+		{
+			func(0U, count);
+			return;
+		}
+
+		JobCounter counter;
+		for (uint32_t begin = grainSize; begin < count; begin += grainSize)
+		{
+			const uint32_t end = count - begin > grainSize ? begin + grainSize : count;
+			Submit([&func, begin, end]() { func(begin, end); }, &counter);
+		}
+
+		// The first range is always executed here to save one submit.
+		func(0U, grainSize);
+		Wait(counter);
+	}
+
+private:
+	using Job = JobCounter::DependentJob;
+
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void PushJob(Job job);
+	void ExecuteJob(Job& job);
+	void FinishJob(JobCounter& counter);
+	void WorkerLoop(uint32_t workerIndex);
+	bool TryExecuteJob(uint32_t queueIndex);
+	bool TryExecuteBackgroundJob();
+	bool TryPopJob(uint32_t queueIndex, Job& outJob);
+	bool TryStealJob(uint32_t queueIndex, Job& outJob);
+	uint32_t GetCurrentQueueIndex() const;
+
+private:
+	// [0, workerCount) are owned by workers, the last one is shared by external threads.
+	std::vector<std::unique_ptr<JobQueue>> m_jobQueues;
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_mainThreadJobsMutex;
+	std::vector<Job> m_mainThreadJobs;
+
+	JobQueue m_backgroundJobQueue;
+	std::atomic<uint32_t> m_pendingBackgroundJobCount = 0U;
+
+	std::atomic<uint32_t> m_pendingJobCount = 0U;
+	std::atomic<bool> m_isRunning = true;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "FrustumCulling.h"
+
+#include <cmath>
+
+namespace engine
+{
+
+namespace
+{
+
+struct BoxArrays
+{
+	const float* pCenterX;
+	const float* pCenterY;
+	const float* pCenterZ;
+	const float* pExtentX;
+	const float* pExtentY;
+	const float* pExtentZ;
+};
+
+// Plane components and absolute values of normal components which are used to project extents onto the normal.
+struct PlaneArrays
+{
+	float normalX[Frustum::PlaneCount];
+	float normalY[Frustum::PlaneCount];
+	float normalZ[Frustum::PlaneCount];
+	float distance[Frustum::PlaneCount];
+	float absNormalX[Frustum::PlaneCount];
+	float absNormalY[Frustum::PlaneCount];
+	float absNormalZ[Frustum::PlaneCount];
+};
+
+PlaneArrays GetPlaneArrays(const Frustum& frustum)
+{
+	PlaneArrays planes;
+	for (uint32_t planeIndex = 0U; planeIndex < Frustum::PlaneCount; ++planeIndex)
+	{
+		const cd::Vec4f& plane = frustum.GetPlane(static_cast<FrustumPlane>(planeIndex));
+		planes.normalX[planeIndex] = plane.x();
+		planes.normalY[planeIndex] = plane.y();
+		planes.normalZ[planeIndex] = plane.z();
+		planes.distance[planeIndex] = plane.w();
+		planes.absNormalX[planeIndex] = std::fabs(plane.x());
+		planes.absNormalY[planeIndex] = std::fabs(plane.y());
+		planes.absNormalZ[planeIndex] = std::fabs(plane.z());
+	}
+
+	return planes;
+}
+
+// A box is outside if the signed distance of its center is less than the projected radius to the negative side.
+void CullScalar(const PlaneArrays& planes, const BoxArrays& boxes, uint32_t beginIndex, uint32_t endIndex, uint8_t* pOutVisibilities)
+{
+	for (uint32_t index = beginIndex; index < endIndex; ++index)
+	{
+		bool isVisible = true;
+		for (uint32_t planeIndex = 0U; planeIndex < Frustum::PlaneCount && isVisible; ++planeIndex)
+		{
+			float distance = planes.normalX[planeIndex] * boxes.pCenterX[index] +
+				planes.normalY[planeIndex] * boxes.pCenterY[index] +
+				planes.normalZ[planeIndex] * boxes.pCenterZ[index] + planes.distance[planeIndex];
+			float radius = planes.absNormalX[planeIndex] * boxes.pExtentX[index] +
+				planes.absNormalY[planeIndex] * boxes.pExtentY[index] +
+				planes.absNormalZ[planeIndex] * boxes.pExtentZ[index];
+			isVisible = distance + radius >= 0.0f;
+		}
+
+		pOutVisibilities[index] = isVisible ? 1U : 0U;
+	}
+}
+
+#ifdef CD_SIMD_X86
+
+uint32_t CullSSE(const PlaneArrays& planes, const BoxArrays& boxes, uint32_t count, uint8_t* pOutVisibilities)
+{
+	const __m128 zero = _mm_setzero_ps();
+
+	uint32_t index = 0U;
+	for (; index + 4U <= count; index += 4U)
+	{
+		__m128 centerX = _mm_loadu_ps(boxes.pCenterX + index);
+		__m128 centerY = _mm_loadu_ps(boxes.pCenterY + index);
+		__m128 centerZ = _mm_loadu_ps(boxes.pCenterZ + index);
+		__m128 extentX = _mm_loadu_ps(boxes.pExtentX + index);
+		__m128 extentY = _mm_loadu_ps(boxes.pExtentY + index);
+		__m128 extentZ = _mm_loadu_ps(boxes.pExtentZ + index);
+
+		__m128 outside = zero;
+		for (uint32_t planeIndex = 0U; planeIndex < Frustum::PlaneCount; ++planeIndex)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.normalX[planeIndex]), centerX), _mm_mul_ps(_mm_set1_ps(planes.normalY[planeIndex]), centerY)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.normalZ[planeIndex]), centerZ), _mm_set1_ps(planes.distance[planeIndex])));
+			__m128 radius = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.absNormalX[planeIndex]), extentX), _mm_mul_ps(_mm_set1_ps(planes.absNormalY[planeIndex]), extentY)),
+				_mm_mul_ps(_mm_set1_ps(planes.absNormalZ[planeIndex]), extentZ));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		for (uint32_t lane = 0U; lane < 4U; ++lane)
+		{
+			pOutVisibilities[index + lane] = (outsideMask >> lane) & 1 ? 0U : 1U;
+		}
+	}
+
+	return index;
+}
+
+CD_TARGET_AVX2 uint32_t CullAVX2(const PlaneArrays& planes, const BoxArrays& boxes, uint32_t count, uint8_t* pOutVisibilities)
+{
+	const __m256 zero = _mm256_setzero_ps();
+
+	uint32_t index = 0U;
+	for (; index + 8U <= count; index += 8U)
+	{
+		__m256 centerX = _mm256_loadu_ps(boxes.pCenterX + index);
+		__m256 centerY = _mm256_loadu_ps(boxes.pCenterY + index);
+		__m256 centerZ = _mm256_loadu_ps(boxes.pCenterZ + index);
+		__m256 extentX = _mm256_loadu_ps(boxes.pExtentX + index);
+		__m256 extentY = _mm256_loadu_ps(boxes.pExtentY + index);
+		__m256 extentZ = _mm256_loadu_ps(boxes.pExtentZ + index);
+
+		__m256 outside = zero;
+		for (uint32_t planeIndex = 0U; planeIndex < Frustum::PlaneCount; ++planeIndex)
+		{
+			__m256 distance = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.normalX[planeIndex]), centerX), _mm256_mul_ps(_mm256_set1_ps(planes.normalY[planeIndex]), centerY)),
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.normalZ[planeIndex]), centerZ), _mm256_set1_ps(planes.distance[planeIndex])));
+			__m256 radius = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.absNormalX[planeIndex]), extentX), _mm256_mul_ps(_mm256_set1_ps(planes.absNormalY[planeIndex]), extentY)),
+				_mm256_mul_ps(_mm256_set1_ps(planes.absNormalZ[planeIndex]), extentZ));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+		}
+
+		int outsideMask = _mm256_movemask_ps(outside);
+		for (uint32_t lane = 0U; lane < 8U; ++lane)
+		{
+			pOutVisibilities[index + lane] = (outsideMask >> lane) & 1 ? 0U : 1U;
+		}
+	}
+
+	return index;
+}
+
+#endif
+
+}
+
+void Frustum::Build(const cd::Matrix4x4& viewProjection, bool homogeneousDepth)
+{
+	// Gribb-Hartmann : clip = M * p, so every plane is a combination of M's rows.
+	const float* pMatrix = viewProjection.Begin();
+	auto GetRow = [pMatrix](uint32_t rowIndex)
+	{
+		return cd::Vec4f(pMatrix[rowIndex], pMatrix[4 + rowIndex], pMatrix[8 + rowIndex], pMatrix[12 + rowIndex]);
+	};
+	auto SetPlane = [this](FrustumPlane plane, const cd::Vec4f& row0, const cd::Vec4f& row1, float sign)
+	{
+		float x = row0.x() + sign * row1.x();
+		float y = row0.y() + sign * row1.y();
+		float z = row0.z() + sign * row1.z();
+		float w = row0.w() + sign * row1.w();
+		float length = std::sqrt(x * x + y * y + z * z);
+		float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+		m_planes[static_cast<uint32_t>(plane)] = cd::Vec4f(x * invLength, y * invLength, z * invLength, w * invLength);
+	};
+
+	cd::Vec4f row0 = GetRow(0U);
+	cd::Vec4f row1 = GetRow(1U);
+	cd::Vec4f row2 = GetRow(2U);
+	cd::Vec4f row3 = GetRow(3U);
+	SetPlane(FrustumPlane::Left, row3, row0, 1.0f);
+	SetPlane(FrustumPlane::Right, row3, row0, -1.0f);
+	SetPlane(FrustumPlane::Bottom, row3, row1, 1.0f);
+	SetPlane(FrustumPlane::Top, row3, row1, -1.0f);
+	SetPlane(FrustumPlane::Near, homogeneousDepth ? row3 : cd::Vec4f(0.0f, 0.0f, 0.0f, 0.0f), row2, 1.0f);
+	SetPlane(FrustumPlane::Far, row3, row2, -1.0f);
+}
+
+bool Frustum::Intersects(const cd::Vec3f& center, const cd::Vec3f& extents) const
+{
+	for (const cd::Vec4f& plane : m_planes)
+	{
+		float distance = plane.x() * center.x() + plane.y() * center.y() + plane.z() * center.z() + plane.w();
+		float radius = std::fabs(plane.x()) * extents.x() + std::fabs(plane.y()) * extents.y() + std::fabs(plane.z()) * extents.z();
+		if (distance + radius < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Frustum::Contains(const cd::Vec3f& center, const cd::Vec3f& extents) const
+{
+	for (const cd::Vec4f& plane : m_planes)
+	{
+		float distance = plane.x() * center.x() + plane.y() * center.y() + plane.z() * center.z() + plane.w();
+		float radius = std::fabs(plane.x()) * extents.x() + std::fabs(plane.y()) * extents.y() + std::fabs(plane.z()) * extents.z();
+		if (distance - radius < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FrustumCullingBatch::Clear()
+{
+	for (std::vector<float>* pArray : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ })
+	{
+		pArray->clear();
+	}
+}
+
+void FrustumCullingBatch::Reserve(uint32_t count)
+{
+	for (std::vector<float>* pArray : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ })
+	{
+		pArray->reserve(count);
+	}
+}
+
+void FrustumCullingBatch::Add(const cd::Vec3f& center, const cd::Vec3f& extents)
+{
+	m_centerX.push_back(center.x());
+	m_centerY.push_back(center.y());
+	m_centerZ.push_back(center.z());
+	m_extentX.push_back(extents.x());
+	m_extentY.push_back(extents.y());
+	m_extentZ.push_back(extents.z());
+}
+
+void FrustumCullingBatch::Add(const cd::Matrix4x4& worldMatrix, const cd::Vec3f& localMin, const cd::Vec3f& localMax)
+{
+	cd::Vec3f center;
+	cd::Vec3f extents;
+	TransformBox(worldMatrix, localMin, localMax, center, extents);
+	Add(center, extents);
+}
+
+void FrustumCullingBatch::TransformBox(const cd::Matrix4x4& worldMatrix, const cd::Vec3f& localMin, const cd::Vec3f& localMax,
+	cd::Vec3f& outCenter, cd::Vec3f& outExtents)
+{
+	// Arvo : world center is the transformed local center and world extents are local extents transformed by |M|.
+	const float* pMatrix = worldMatrix.Begin();
+	float localCenter[3] = { (localMin.x() + localMax.x()) * 0.5f, (localMin.y() + localMax.y()) * 0.5f, (localMin.z() + localMax.z()) * 0.5f };
+	float localExtents[3] = { (localMax.x() - localMin.x()) * 0.5f, (localMax.y() - localMin.y()) * 0.5f, (localMax.z() - localMin.z()) * 0.5f };
+
+	float center[3];
+	float extents[3];
+	for (uint32_t rowIndex = 0U; rowIndex < 3U; ++rowIndex)
+	{
+		center[rowIndex] = pMatrix[12 + rowIndex];
+		extents[rowIndex] = 0.0f;
+		for (uint32_t columnIndex = 0U; columnIndex < 3U; ++columnIndex)
+		{
+			float element = pMatrix[columnIndex * 4 + rowIndex];
+			center[rowIndex] += element * localCenter[columnIndex];
+			extents[rowIndex] += std::fabs(element) * localExtents[columnIndex];
+		}
+	}
+
+	outCenter = cd::Vec3f(center[0], center[1], center[2]);
+	outExtents = cd::Vec3f(extents[0], extents[1], extents[2]);
+}
+
+uint32_t FrustumCullingBatch::Cull(const Frustum& frustum, uint8_t* pOutVisibilities, SIMDPath path) const
+{
+	PlaneArrays planes = GetPlaneArrays(frustum);
+	BoxArrays boxes{ m_centerX.data(), m_centerY.data(), m_centerZ.data(), m_extentX.data(), m_extentY.data(), m_extentZ.data() };
+
+	const uint32_t count = GetCount();
+
+	// Remaining boxes which can't fill SIMD lanes use scalar path.
+	uint32_t testedCount = 0U;
+	path = ClampSIMDPath(path);
+#ifdef CD_SIMD_X86
+	if (SIMDPath::AVX2 == path)
+	{
+		testedCount = CullAVX2(planes, boxes, count, pOutVisibilities);
+	}
+	else if (SIMDPath::SSE == path)
+	{
+		testedCount = CullSSE(planes, boxes, count, pOutVisibilities);
+	}
+#endif
+
+	CullScalar(planes, boxes, testedCount, count, pOutVisibilities);
+
+	uint32_t visibleCount = 0U;
+	for (uint32_t index = 0U; index < count; ++index)
+	{
+		visibleCount += pOutVisibilities[index];
+	}
+
+	return visibleCount;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Core/Math/SIMD.h"
+#include "Math/Matrix.hpp"
+#include "Math/Vector.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+enum class FrustumPlane : uint8_t
+{
+	Left,
+	Right,
+	Bottom,
+	Top,
+	Near,
+	Far,
+	Count,
+};
+
+// Frustum planes in world space. Plane normals point to the inside so that inside points have positive distances.
+class Frustum final
+{
+public:
+	static constexpr uint32_t PlaneCount = static_cast<uint32_t>(FrustumPlane::Count);
+
+public:
+	Frustum() = default;
+	Frustum(const Frustum&) = default;
+	Frustum& operator=(const Frustum&) = default;
+	Frustum(Frustum&&) = default;
+	Frustum& operator=(Frustum&&) = default;
+	~Frustum() = default;
+
+	// Extract planes from a column major projection * view matrix.
+	// homogeneousDepth means that NDC depth range is [-1, 1], otherwise it is [0, 1].
+	void Build(const cd::Matrix4x4& viewProjection, bool homogeneousDepth);
+
+	// Plane is (normal.x, normal.y, normal.z, distance) and normal is normalized.
+	const cd::Vec4f& GetPlane(FrustumPlane plane) const { return m_planes[static_cast<uint32_t>(plane)]; }
+
+	// Returns false only if the box is fully outside one of planes.
+	bool Intersects(const cd::Vec3f& center, const cd::Vec3f& extents) const;
+
+	// Returns true if the box is fully inside all planes.
+	bool Contains(const cd::Vec3f& center, const cd::Vec3f& extents) const;
+
+private:
+	cd::Vec4f m_planes[PlaneCount];
+};
+
+// FrustumCullingBatch stores world space boxes as centers and extents in SoA layout so that SIMD lanes test different boxes.
+class FrustumCullingBatch final
+{
+public:
+	FrustumCullingBatch() = default;
+	FrustumCullingBatch(const FrustumCullingBatch&) = default;
+	FrustumCullingBatch& operator=(const FrustumCullingBatch&) = default;
+	FrustumCullingBatch(FrustumCullingBatch&&) = default;
+	FrustumCullingBatch& operator=(FrustumCullingBatch&&) = default;
+	~FrustumCullingBatch() = default;
+
+	uint32_t GetCount() const { return static_cast<uint32_t>(m_centerX.size()); }
+	void Clear();
+	void Reserve(uint32_t count);
+	void Add(const cd::Vec3f& center, const cd::Vec3f& extents);
+
+	// Transform a local space box by an affine matrix and add the world space box which bounds it.
+	void Add(const cd::Matrix4x4& worldMatrix, const cd::Vec3f& localMin, const cd::Vec3f& localMax);
+
+	// World space box which bounds a local space box transformed by an affine matrix.
+	static void TransformBox(const cd::Matrix4x4& worldMatrix, const cd::Vec3f& localMin, const cd::Vec3f& localMax,
+		cd::Vec3f& outCenter, cd::Vec3f& outExtents);
+
+	// Write 1 for visible boxes and 0 for culled boxes of [0, GetCount()) into pOutVisibilities. Returns visible count.
+	uint32_t Cull(const Frustum& frustum, uint8_t* pOutVisibilities, SIMDPath path) const;
+	uint32_t Cull(const Frustum& frustum, uint8_t* pOutVisibilities) const { return Cull(frustum, pOutVisibilities, GetBestSIMDPath()); }
+
+private:
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_extentX;
+	std::vector<float> m_extentY;
+	std::vector<float> m_extentZ;
+};
+
+}
\ No newline at end of file
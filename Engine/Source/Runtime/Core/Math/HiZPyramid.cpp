@@ -0,0 +1,145 @@
+#include "HiZPyramid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace engine
+{
+
+void HiZPyramid::Build(const float* pDepths, uint32_t width, uint32_t height, const cd::Matrix4x4& viewProjection, bool homogeneousDepth, bool originBottomLeft)
+{
+	assert(pDepths && width > 0U && height > 0U);
+
+	// Mip sizes are rounded up so that every texel of the previous mip is covered by a texel of the next one.
+	uint32_t depthCount = 0U;
+	m_mipCount = 0U;
+	uint32_t mipWidth = width;
+	uint32_t mipHeight = height;
+	while (m_mipCount < MaxMipCount)
+	{
+		m_mipOffsets[m_mipCount] = depthCount;
+		m_mipWidths[m_mipCount] = mipWidth;
+		m_mipHeights[m_mipCount] = mipHeight;
+		depthCount += mipWidth * mipHeight;
+		++m_mipCount;
+
+		if (1U == mipWidth && 1U == mipHeight)
+		{
+			break;
+		}
+		mipWidth = (mipWidth + 1U) / 2U;
+		mipHeight = (mipHeight + 1U) / 2U;
+	}
+
+	m_depths.resize(depthCount);
+	std::copy(pDepths, pDepths + width * height, m_depths.begin());
+	for (uint32_t mip = 1U; mip < m_mipCount; ++mip)
+	{
+		const uint32_t sourceWidth = m_mipWidths[mip - 1U];
+		const uint32_t sourceHeight = m_mipHeights[mip - 1U];
+		const float* pSource = m_depths.data() + m_mipOffsets[mip - 1U];
+		float* pTarget = m_depths.data() + m_mipOffsets[mip];
+		for (uint32_t y = 0U; y < m_mipHeights[mip]; ++y)
+		{
+			const uint32_t y0 = y * 2U;
+			const uint32_t y1 = std::min(y0 + 1U, sourceHeight - 1U);
+			for (uint32_t x = 0U; x < m_mipWidths[mip]; ++x)
+			{
+				const uint32_t x0 = x * 2U;
+				const uint32_t x1 = std::min(x0 + 1U, sourceWidth - 1U);
+				pTarget[y * m_mipWidths[mip] + x] = std::max(std::max(pSource[y0 * sourceWidth + x0], pSource[y0 * sourceWidth + x1]),
+					std::max(pSource[y1 * sourceWidth + x0], pSource[y1 * sourceWidth + x1]));
+			}
+		}
+	}
+
+	m_viewProjection = viewProjection;
+	m_homogeneousDepth = homogeneousDepth;
+	m_originBottomLeft = originBottomLeft;
+}
+
+void HiZPyramid::Reset()
+{
+	m_depths.clear();
+	m_mipCount = 0U;
+}
+
+bool HiZPyramid::IsOccluded(const cd::Vec3f& center, const cd::Vec3f& extents) const
+{
+	if (!IsValid())
+	{
+		return false;
+	}
+
+	// Bounds of the box's 8 corners in NDC. Matrix is column major so that clip = M * p.
+	const float* pMatrix = m_viewProjection.Begin();
+	float minX = INFINITY;
+	float minY = INFINITY;
+	float maxX = -INFINITY;
+	float maxY = -INFINITY;
+	float minDepth = INFINITY;
+	for (uint32_t cornerIndex = 0U; cornerIndex < 8U; ++cornerIndex)
+	{
+		float x = center.x() + ((cornerIndex & 1U) ? extents.x() : -extents.x());
+		float y = center.y() + ((cornerIndex & 2U) ? extents.y() : -extents.y());
+		float z = center.z() + ((cornerIndex & 4U) ? extents.z() : -extents.z());
+		float clipX = pMatrix[0] * x + pMatrix[4] * y + pMatrix[8] * z + pMatrix[12];
+		float clipY = pMatrix[1] * x + pMatrix[5] * y + pMatrix[9] * z + pMatrix[13];
+		float clipZ = pMatrix[2] * x + pMatrix[6] * y + pMatrix[10] * z + pMatrix[14];
+		float clipW = pMatrix[3] * x + pMatrix[7] * y + pMatrix[11] * z + pMatrix[15];
+		if (clipW <= 0.0f)
+		{
+			return false;
+		}
+
+		float invW = 1.0f / clipW;
+		float depth = clipZ * invW;
+		minX = std::min(minX, clipX * invW);
+		maxX = std::max(maxX, clipX * invW);
+		minY = std::min(minY, clipY * invW);
+		maxY = std::max(maxY, clipY * invW);
+		minDepth = std::min(minDepth, m_homogeneousDepth ? depth * 0.5f + 0.5f : depth);
+	}
+
+	if (minDepth <= 0.0f || minDepth > 1.0f || maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+	{
+		return false;
+	}
+
+	// Texel rect in mip 0. It is dilated by one texel as depth images may be downsampled from larger attachments
+	// whose texels don't align with the ones here.
+	const float width = static_cast<float>(m_mipWidths[0]);
+	const float height = static_cast<float>(m_mipHeights[0]);
+	float left = (std::max(minX, -1.0f) * 0.5f + 0.5f) * width;
+	float right = (std::min(maxX, 1.0f) * 0.5f + 0.5f) * width;
+	float bottom = (std::max(minY, -1.0f) * 0.5f + 0.5f) * height;
+	float top = (std::min(maxY, 1.0f) * 0.5f + 0.5f) * height;
+	float firstRow = m_originBottomLeft ? bottom : height - top;
+	float lastRow = m_originBottomLeft ? top : height - bottom;
+
+	uint32_t x0 = static_cast<uint32_t>(std::max(std::floor(left) - 1.0f, 0.0f));
+	uint32_t x1 = static_cast<uint32_t>(std::min(std::floor(right) + 1.0f, width - 1.0f));
+	uint32_t y0 = static_cast<uint32_t>(std::max(std::floor(firstRow) - 1.0f, 0.0f));
+	uint32_t y1 = static_cast<uint32_t>(std::min(std::floor(lastRow) + 1.0f, height - 1.0f));
+
+	// The first mip where the rect covers at most 4 x 4 texels. Coarser mips read less but cover more unrelated depths.
+	uint32_t mip = 0U;
+	while (mip + 1U < m_mipCount && ((x1 >> mip) - (x0 >> mip) > 3U || (y1 >> mip) - (y0 >> mip) > 3U))
+	{
+		++mip;
+	}
+
+	float maxDepth = 0.0f;
+	for (uint32_t y = y0 >> mip; y <= (y1 >> mip); ++y)
+	{
+		for (uint32_t x = x0 >> mip; x <= (x1 >> mip); ++x)
+		{
+			maxDepth = std::max(maxDepth, GetDepth(mip, x, y));
+		}
+	}
+
+	return minDepth > maxDepth;
+}
+
+}
\ No newline at end of file
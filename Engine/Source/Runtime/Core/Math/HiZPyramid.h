@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+#include "Math/Vector.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// HiZPyramid stores the farthest depth of every texel's footprint in each mip of a depth image.
+// A box is occluded if its nearest depth is farther than all texels which its screen rect covers.
+// Depths are in [0, 1] and larger values are farther, which is the same as D32F attachments rendered with less depth tests.
+class HiZPyramid final
+{
+public:
+	static constexpr uint32_t MaxMipCount = 16U;
+
+public:
+	HiZPyramid() = default;
+	HiZPyramid(const HiZPyramid&) = default;
+	HiZPyramid& operator=(const HiZPyramid&) = default;
+	HiZPyramid(HiZPyramid&&) = default;
+	HiZPyramid& operator=(HiZPyramid&&) = default;
+	~HiZPyramid() = default;
+
+	// Build mips from a width x height depth image which is rendered by a column major projection * view matrix.
+	// homogeneousDepth means that NDC depth range is [-1, 1], otherwise it is [0, 1].
+	// originBottomLeft means that the first row of the image is the bottom of the screen.
+	void Build(const float* pDepths, uint32_t width, uint32_t height, const cd::Matrix4x4& viewProjection, bool homogeneousDepth, bool originBottomLeft);
+	void Reset();
+
+	bool IsValid() const { return m_mipCount > 0U; }
+	uint32_t GetMipCount() const { return m_mipCount; }
+	uint32_t GetMipWidth(uint32_t mip) const { return m_mipWidths[mip]; }
+	uint32_t GetMipHeight(uint32_t mip) const { return m_mipHeights[mip]; }
+	float GetDepth(uint32_t mip, uint32_t x, uint32_t y) const { return m_depths[m_mipOffsets[mip] + y * m_mipWidths[mip] + x]; }
+	const cd::Matrix4x4& GetViewProjection() const { return m_viewProjection; }
+
+	// Returns true only if the world space box is fully hidden by depths.
+	// Boxes which cross the near plane or are outside of the screen are never occluded as frustum culling handles them.
+	bool IsOccluded(const cd::Vec3f& center, const cd::Vec3f& extents) const;
+
+private:
+	std::vector<float> m_depths;
+	uint32_t m_mipOffsets[MaxMipCount];
+	uint32_t m_mipWidths[MaxMipCount];
+	uint32_t m_mipHeights[MaxMipCount];
+	uint32_t m_mipCount = 0U;
+
+	cd::Matrix4x4 m_viewProjection;
+	bool m_homogeneousDepth = false;
+	bool m_originBottomLeft = false;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace engine
+{
+
+namespace
+{
+
+// FIFO cache which stores the time of each vertex's last insertion. A vertex is in cache if fewer than size vertices are inserted after it.
+class VertexCacheSimulator
+{
+public:
+	VertexCacheSimulator(uint32_t vertexCount, uint32_t cacheSize) :
+		m_timestamps(vertexCount, 0U),
+		m_time(cacheSize + 1U),
+		m_cacheSize(cacheSize)
+	{
+	}
+
+	void Reset()
+	{
+		// Jump over the cache size so that all vertices are out of cache.
+		m_time += m_cacheSize + 1U;
+	}
+
+	// Returns the number of vertices which are transformed again.
+	uint32_t AddTriangle(const uint32_t* pTriangle)
+	{
+		uint32_t missCount = 0U;
+		for (uint32_t corner = 0U; corner < 3U; ++corner)
+		{
+			uint32_t vertex = pTriangle[corner];
+			if (m_time - m_timestamps[vertex] > m_cacheSize)
+			{
+				m_timestamps[vertex] = m_time++;
+				++missCount;
+			}
+		}
+		return missCount;
+	}
+
+private:
+	std::vector<uint32_t> m_timestamps;
+	uint32_t m_time;
+	uint32_t m_cacheSize;
+};
+
+uint32_t GetMissCount(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheSimulator cache(vertexCount, cacheSize);
+	uint32_t missCount = 0U;
+	for (uint32_t index = 0U; index + 3U <= indexCount; index += 3U)
+	{
+		missCount += cache.AddTriangle(pIndices + index);
+	}
+	return missCount;
+}
+
+// Triangles of every vertex in CSR layout.
+struct VertexTriangles
+{
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> triangles;
+
+	VertexTriangles(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount) :
+		offsets(vertexCount + 1U, 0U),
+		triangles(indexCount / 3U * 3U)
+	{
+		const uint32_t triangleCount = indexCount / 3U;
+		for (uint32_t index = 0U; index < triangleCount * 3U; ++index)
+		{
+			++offsets[pIndices[index] + 1U];
+		}
+
+		for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+		{
+			offsets[vertexIndex + 1U] += offsets[vertexIndex];
+		}
+
+		std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+		for (uint32_t triangleIndex = 0U; triangleIndex < triangleCount; ++triangleIndex)
+		{
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				triangles[cursors[pIndices[triangleIndex * 3U + corner]]++] = triangleIndex;
+			}
+		}
+	}
+};
+
+}
+
+float MeshOptimizer::GetACMR(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	const uint32_t triangleCount = indexCount / 3U;
+	if (0U == triangleCount)
+	{
+		return 0.0f;
+	}
+
+	return static_cast<float>(GetMissCount(pIndices, indexCount, vertexCount, cacheSize)) / static_cast<float>(triangleCount);
+}
+
+float MeshOptimizer::GetATVR(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	std::vector<uint8_t> isUsed(vertexCount, 0U);
+	uint32_t usedCount = 0U;
+	for (uint32_t index = 0U; index < indexCount / 3U * 3U; ++index)
+	{
+		usedCount += isUsed[pIndices[index]] ? 0U : 1U;
+		isUsed[pIndices[index]] = 1U;
+	}
+
+	if (0U == usedCount)
+	{
+		return 0.0f;
+	}
+
+	return static_cast<float>(GetMissCount(pIndices, indexCount, vertexCount, cacheSize)) / static_cast<float>(usedCount);
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	const uint32_t triangleCount = indexCount / 3U;
+	if (0U == triangleCount)
+	{
+		return;
+	}
+
+	VertexTriangles vertexTriangles(pIndices, indexCount, vertexCount);
+	std::vector<uint32_t> liveCounts(vertexCount);
+	for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		liveCounts[vertexIndex] = vertexTriangles.offsets[vertexIndex + 1U] - vertexTriangles.offsets[vertexIndex];
+	}
+
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0U);
+	std::vector<uint8_t> isEmitted(triangleCount, 0U);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> outIndices;
+	outIndices.reserve(triangleCount * 3U);
+
+	uint32_t time = cacheSize + 1U;
+	uint32_t cursor = 0U;
+	uint32_t fanVertex = 0U;
+	while (cursor < vertexCount && 0U == liveCounts[cursor])
+	{
+		++cursor;
+	}
+	fanVertex = cursor;
+
+	while (fanVertex < vertexCount)
+	{
+		// Emit all remaining triangles around the fanning vertex.
+		candidates.clear();
+		for (uint32_t offset = vertexTriangles.offsets[fanVertex]; offset < vertexTriangles.offsets[fanVertex + 1U]; ++offset)
+		{
+			uint32_t triangleIndex = vertexTriangles.triangles[offset];
+			if (isEmitted[triangleIndex])
+			{
+				continue;
+			}
+
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				uint32_t vertex = pIndices[triangleIndex * 3U + corner];
+				outIndices.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveCounts[vertex];
+				if (time - cacheTimestamps[vertex] > cacheSize)
+				{
+					cacheTimestamps[vertex] = time++;
+				}
+			}
+			isEmitted[triangleIndex] = 1U;
+		}
+
+		// The next fanning vertex is the oldest candidate which stays in cache after its remaining triangles are emitted.
+		uint32_t nextVertex = UINT32_MAX;
+		uint32_t bestPriority = 0U;
+		for (uint32_t candidate : candidates)
+		{
+			if (0U == liveCounts[candidate])
+			{
+				continue;
+			}
+
+			uint32_t priority = 1U;
+			uint32_t age = time - cacheTimestamps[candidate];
+			if (age + 2U * liveCounts[candidate] <= cacheSize)
+			{
+				priority += age;
+			}
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = candidate;
+			}
+		}
+
+		// Dead end. Prefer recently used vertices, then the next vertex in input order.
+		while (UINT32_MAX == nextVertex && !deadEnds.empty())
+		{
+			uint32_t deadEnd = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveCounts[deadEnd] > 0U)
+			{
+				nextVertex = deadEnd;
+			}
+		}
+
+		if (UINT32_MAX == nextVertex)
+		{
+			while (cursor < vertexCount && 0U == liveCounts[cursor])
+			{
+				++cursor;
+			}
+			nextVertex = cursor;
+		}
+
+		fanVertex = nextVertex;
+	}
+
+	std::copy(outIndices.begin(), outIndices.end(), pIndices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* pIndices, uint32_t indexCount, const cd::Vec3f* pPositions, uint32_t vertexCount,
+	float threshold, uint32_t cacheSize)
+{
+	const uint32_t triangleCount = indexCount / 3U;
+	if (triangleCount < 2U)
+	{
+		return;
+	}
+
+	// Hard boundaries are triangles whose vertices all miss the cache where Tipsify jumped.
+	std::vector<uint32_t> hardClusters;
+	{
+		VertexCacheSimulator cache(vertexCount, cacheSize);
+		for (uint32_t triangleIndex = 0U; triangleIndex < triangleCount; ++triangleIndex)
+		{
+			if (3U == cache.AddTriangle(pIndices + triangleIndex * 3U) || 0U == triangleIndex)
+			{
+				hardClusters.push_back(triangleIndex);
+			}
+		}
+	}
+	hardClusters.push_back(triangleCount);
+
+	// Soft boundaries split clusters once their ACMR warms up to the threshold so that more clusters can be sorted.
+	std::vector<uint32_t> clusters;
+	VertexCacheSimulator cache(vertexCount, cacheSize);
+	for (size_t hardIndex = 0U; hardIndex + 1U < hardClusters.size(); ++hardIndex)
+	{
+		const uint32_t beginTriangle = hardClusters[hardIndex];
+		const uint32_t endTriangle = hardClusters[hardIndex + 1U];
+		cache.Reset();
+		uint32_t clusterMissCount = 0U;
+		for (uint32_t triangleIndex = beginTriangle; triangleIndex < endTriangle; ++triangleIndex)
+		{
+			clusterMissCount += cache.AddTriangle(pIndices + triangleIndex * 3U);
+		}
+		const float clusterThreshold = threshold * static_cast<float>(clusterMissCount) / static_cast<float>(endTriangle - beginTriangle);
+
+		cache.Reset();
+		clusters.push_back(beginTriangle);
+		uint32_t runningMissCount = 0U;
+		uint32_t runningTriangleCount = 0U;
+		for (uint32_t triangleIndex = beginTriangle; triangleIndex < endTriangle; ++triangleIndex)
+		{
+			runningMissCount += cache.AddTriangle(pIndices + triangleIndex * 3U);
+			++runningTriangleCount;
+			if (triangleIndex + 1U < endTriangle && static_cast<float>(runningMissCount) <= clusterThreshold * static_cast<float>(runningTriangleCount))
+			{
+				clusters.push_back(triangleIndex + 1U);
+				cache.Reset();
+				runningMissCount = 0U;
+				runningTriangleCount = 0U;
+			}
+		}
+	}
+	const uint32_t clusterCount = static_cast<uint32_t>(clusters.size());
+	clusters.push_back(triangleCount);
+
+	// Centroids of triangles weighted by areas.
+	double meshCenter[3] = { 0.0, 0.0, 0.0 };
+	double meshArea = 0.0;
+	std::vector<double> clusterData(clusterCount * 7U, 0.0);
+	for (uint32_t clusterIndex = 0U; clusterIndex < clusterCount; ++clusterIndex)
+	{
+		double* pData = &clusterData[clusterIndex * 7U];
+		for (uint32_t triangleIndex = clusters[clusterIndex]; triangleIndex < clusters[clusterIndex + 1U]; ++triangleIndex)
+		{
+			const cd::Vec3f& a = pPositions[pIndices[triangleIndex * 3U]];
+			const cd::Vec3f& b = pPositions[pIndices[triangleIndex * 3U + 1U]];
+			const cd::Vec3f& c = pPositions[pIndices[triangleIndex * 3U + 2U]];
+			double ab[3] = { b.x() - a.x(), b.y() - a.y(), b.z() - a.z() };
+			double ac[3] = { c.x() - a.x(), c.y() - a.y(), c.z() - a.z() };
+			double normal[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+			double area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			double center[3] = { (a.x() + b.x() + c.x()) / 3.0, (a.y() + b.y() + c.y()) / 3.0, (a.z() + b.z() + c.z()) / 3.0 };
+			for (uint32_t axis = 0U; axis < 3U; ++axis)
+			{
+				pData[axis] += center[axis] * area;
+				pData[3U + axis] += normal[axis];
+				meshCenter[axis] += center[axis] * area;
+			}
+			pData[6] += area;
+			meshArea += area;
+		}
+	}
+
+	if (meshArea <= 0.0)
+	{
+		return;
+	}
+
+	for (double& value : meshCenter)
+	{
+		value /= meshArea;
+	}
+
+	// Clusters whose normals point away from the mesh center are drawn first.
+	std::vector<double> sortKeys(clusterCount, 0.0);
+	for (uint32_t clusterIndex = 0U; clusterIndex < clusterCount; ++clusterIndex)
+	{
+		const double* pData = &clusterData[clusterIndex * 7U];
+		if (pData[6] <= 0.0)
+		{
+			continue;
+		}
+
+		double normalLength = std::sqrt(pData[3] * pData[3] + pData[4] * pData[4] + pData[5] * pData[5]);
+		if (normalLength <= 0.0)
+		{
+			continue;
+		}
+
+		double dot = 0.0;
+		for (uint32_t axis = 0U; axis < 3U; ++axis)
+		{
+			dot += (pData[axis] / pData[6] - meshCenter[axis]) * pData[3U + axis] / normalLength;
+		}
+		sortKeys[clusterIndex] = dot;
+	}
+
+	std::vector<uint32_t> clusterOrder(clusterCount);
+	for (uint32_t clusterIndex = 0U; clusterIndex < clusterCount; ++clusterIndex)
+	{
+		clusterOrder[clusterIndex] = clusterIndex;
+	}
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t lhs, uint32_t rhs)
+	{
+		return sortKeys[lhs] > sortKeys[rhs];
+	});
+
+	std::vector<uint32_t> outIndices;
+	outIndices.reserve(triangleCount * 3U);
+	for (uint32_t clusterIndex : clusterOrder)
+	{
+		outIndices.insert(outIndices.end(), pIndices + clusters[clusterIndex] * 3U, pIndices + clusters[clusterIndex + 1U] * 3U);
+	}
+	std::copy(outIndices.begin(), outIndices.end(), pIndices);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& outRemap)
+{
+	outRemap.assign(vertexCount, UINT32_MAX);
+	uint32_t nextVertex = 0U;
+	for (uint32_t index = 0U; index < indexCount; ++index)
+	{
+		uint32_t& newVertex = outRemap[pIndices[index]];
+		if (UINT32_MAX == newVertex)
+		{
+			newVertex = nextVertex++;
+		}
+		pIndices[index] = newVertex;
+	}
+
+	for (uint32_t& newVertex : outRemap)
+	{
+		if (UINT32_MAX == newVertex)
+		{
+			newVertex = nextVertex++;
+		}
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Math/Vector.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// MeshOptimizer reorders indexed triangle lists so that GPUs transform and fetch fewer vertices. Triangles keep their windings.
+// Steps are expected to run in order: vertex cache, overdraw, vertex fetch.
+class MeshOptimizer
+{
+public:
+	// Size of the simulated post-transform FIFO cache.
+	static constexpr uint32_t DefaultCacheSize = 16U;
+
+	// Allowed ACMR increase of overdraw optimization over the vertex cache order.
+	static constexpr float DefaultOverdrawThreshold = 1.05f;
+
+public:
+	// Average cache miss ratio which is transformed vertices per triangle. 0.5 is ideal for large regular grids and 3 is the worst.
+	static float GetACMR(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+	// Average transformed to vertex ratio which is transformed vertices per referenced vertex. 1 is ideal.
+	static float GetATVR(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+	// Reorder triangles to hit the post-transform cache by Tipsify which fans around vertices and jumps to recent ones at dead ends.
+	static void OptimizeVertexCache(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+	// Split the cache ordered triangles into clusters at cache resets and where ACMR stays under threshold * ACMR of the cluster.
+	// Clusters which face outwards from the mesh center are drawn first so that they occlude inner and back facing ones by early z.
+	static void OptimizeOverdraw(uint32_t* pIndices, uint32_t indexCount, const cd::Vec3f* pPositions, uint32_t vertexCount,
+		float threshold = DefaultOverdrawThreshold, uint32_t cacheSize = DefaultCacheSize);
+
+	// Renumber vertices in the order of first uses so that vertex fetches are sequential. Unreferenced vertices are moved to the end.
+	// outRemap maps old vertex indexes to new ones which are applied to indices already.
+	static void OptimizeVertexFetch(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& outRemap);
+};
+
+}
\ No newline at end of file
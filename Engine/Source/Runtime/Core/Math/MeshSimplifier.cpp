@@ -0,0 +1,580 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace engine
+{
+
+namespace
+{
+
+// A level which keeps more triangles than it of the previous level is not worth another index buffer.
+constexpr float MaxLODTriangleRatio = 0.95f;
+
+struct Point
+{
+	double x;
+	double y;
+	double z;
+};
+
+Point ToPoint(const cd::Vec3f& position)
+{
+	return Point{ static_cast<double>(position.x()), static_cast<double>(position.y()), static_cast<double>(position.z()) };
+}
+
+Point Subtract(const Point& a, const Point& b)
+{
+	return Point{ a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+Point Cross(const Point& a, const Point& b)
+{
+	return Point{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+double Dot(const Point& a, const Point& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Sum of squared distances to planes of triangles weighted by their areas.
+struct Quadric
+{
+	double a2 = 0.0;
+	double b2 = 0.0;
+	double c2 = 0.0;
+	double d2 = 0.0;
+	double ab = 0.0;
+	double ac = 0.0;
+	double ad = 0.0;
+	double bc = 0.0;
+	double bd = 0.0;
+	double cd = 0.0;
+	double weight = 0.0;
+
+	void AddPlane(const Point& normal, double d, double planeWeight)
+	{
+		a2 += planeWeight * normal.x * normal.x;
+		b2 += planeWeight * normal.y * normal.y;
+		c2 += planeWeight * normal.z * normal.z;
+		d2 += planeWeight * d * d;
+		ab += planeWeight * normal.x * normal.y;
+		ac += planeWeight * normal.x * normal.z;
+		ad += planeWeight * normal.x * d;
+		bc += planeWeight * normal.y * normal.z;
+		bd += planeWeight * normal.y * d;
+		cd += planeWeight * normal.z * d;
+		weight += planeWeight;
+	}
+
+	void Add(const Quadric& other)
+	{
+		a2 += other.a2;
+		b2 += other.b2;
+		c2 += other.c2;
+		d2 += other.d2;
+		ab += other.ab;
+		ac += other.ac;
+		ad += other.ad;
+		bc += other.bc;
+		bd += other.bd;
+		cd += other.cd;
+		weight += other.weight;
+	}
+
+	// Weighted mean of squared distances so that errors don't depend on triangle sizes.
+	double Evaluate(const Point& p) const
+	{
+		if (weight <= 0.0)
+		{
+			return 0.0;
+		}
+
+		double sum = a2 * p.x * p.x + b2 * p.y * p.y + c2 * p.z * p.z + d2 +
+			2.0 * (ab * p.x * p.y + ac * p.x * p.z + bc * p.y * p.z + ad * p.x + bd * p.y + cd * p.z);
+		return std::max(sum, 0.0) / weight;
+	}
+};
+
+struct PositionKey
+{
+	uint32_t bits[3];
+
+	bool operator==(const PositionKey& other) const
+	{
+		return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+	}
+};
+
+struct PositionKeyHash
+{
+	size_t operator()(const PositionKey& key) const
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (uint32_t bits : key.bits)
+		{
+			hash = (hash ^ bits) * 1099511628211ULL;
+		}
+		return static_cast<size_t>(hash);
+	}
+};
+
+PositionKey GetPositionKey(const cd::Vec3f& position)
+{
+	// -0 and 0 are the same position.
+	float values[3] = { position.x() + 0.0f, position.y() + 0.0f, position.z() + 0.0f };
+	PositionKey key;
+	std::memcpy(key.bits, values, sizeof(values));
+	return key;
+}
+
+uint64_t GetEdgeKey(uint32_t a, uint32_t b)
+{
+	return a < b ? (static_cast<uint64_t>(a) << 32U) | b : (static_cast<uint64_t>(b) << 32U) | a;
+}
+
+struct Collapse
+{
+	double cost;
+	uint32_t vertex;
+
+	// The source vertex which replaces the collapsed vertex in its triangles.
+	uint32_t target;
+};
+
+// Topology is tracked on welded vertices so that attribute seams are edges inside the mesh.
+// A welded vertex is the first source vertex at its position.
+class SimplifyContext
+{
+public:
+	SimplifyContext(const cd::Vec3f* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount) :
+		m_pPositions(pPositions)
+	{
+		m_welded.resize(vertexCount);
+		m_groupSizes.assign(vertexCount, 0U);
+		std::unordered_map<PositionKey, uint32_t, PositionKeyHash> weldedVertices;
+		weldedVertices.reserve(vertexCount);
+		for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+		{
+			auto itWelded = weldedVertices.emplace(GetPositionKey(pPositions[vertexIndex]), vertexIndex).first;
+			m_welded[vertexIndex] = itWelded->second;
+			++m_groupSizes[itWelded->second];
+		}
+
+		// Degenerate triangles can't be shown so that they are dropped at first.
+		m_indices.reserve(indexCount);
+		for (uint32_t index = 0U; index + 3U <= indexCount; index += 3U)
+		{
+			uint32_t w0 = m_welded[pIndices[index]];
+			uint32_t w1 = m_welded[pIndices[index + 1U]];
+			uint32_t w2 = m_welded[pIndices[index + 2U]];
+			if (w0 != w1 && w1 != w2 && w2 != w0)
+			{
+				m_indices.insert(m_indices.end(), pIndices + index, pIndices + index + 3U);
+			}
+		}
+		m_isTriangleRemoved.assign(m_indices.size() / 3U, 0U);
+		m_triangleCount = static_cast<uint32_t>(m_indices.size() / 3U);
+
+		m_quadrics.resize(vertexCount);
+		for (uint32_t triangleIndex = 0U; triangleIndex < m_triangleCount; ++triangleIndex)
+		{
+			const uint32_t* pTriangle = &m_indices[triangleIndex * 3U];
+			Point p0 = ToPoint(pPositions[pTriangle[0]]);
+			Point normal = Cross(Subtract(ToPoint(pPositions[pTriangle[1]]), p0), Subtract(ToPoint(pPositions[pTriangle[2]]), p0));
+			double length = std::sqrt(Dot(normal, normal));
+			if (length <= 0.0)
+			{
+				continue;
+			}
+
+			normal = Point{ normal.x / length, normal.y / length, normal.z / length };
+			double d = -Dot(normal, p0);
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				m_quadrics[m_welded[pTriangle[corner]]].AddPlane(normal, d, length * 0.5);
+			}
+		}
+
+		// Seams are locked. Borders are found for each pass.
+		m_isLocked.resize(vertexCount);
+		for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+		{
+			m_isLocked[vertexIndex] = m_groupSizes[m_welded[vertexIndex]] > 1U ? 1U : 0U;
+		}
+	}
+
+	double Run(uint32_t targetTriangleCount, double targetErrorSquare)
+	{
+		double maxCost = 0.0;
+		std::vector<Collapse> collapses;
+		std::vector<uint8_t> isDirty;
+		while (m_triangleCount > targetTriangleCount)
+		{
+			BuildAdjacency();
+
+			collapses.clear();
+			for (uint32_t vertexIndex = 0U; vertexIndex < m_welded.size(); ++vertexIndex)
+			{
+				Collapse collapse;
+				if (FindCollapse(vertexIndex, collapse))
+				{
+					collapses.push_back(collapse);
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs)
+			{
+				return lhs.cost < rhs.cost || (lhs.cost == rhs.cost && lhs.vertex < rhs.vertex);
+			});
+
+			// Collapses only touch triangles around their vertices. Vertices whose triangles changed wait for the next pass
+			// so that costs and checks computed for this pass are still valid.
+			// Skipped collapses whose costs are in budget are tried again with new costs in the next pass.
+			isDirty.assign(m_welded.size(), 0U);
+			uint32_t appliedCount = 0U;
+			for (const Collapse& collapse : collapses)
+			{
+				if (m_triangleCount <= targetTriangleCount || collapse.cost > targetErrorSquare)
+				{
+					break;
+				}
+
+				if (isDirty[collapse.vertex] || isDirty[m_welded[collapse.target]])
+				{
+					continue;
+				}
+
+				ApplyCollapse(collapse, isDirty);
+				maxCost = std::max(maxCost, collapse.cost);
+				++appliedCount;
+			}
+
+			if (0U == appliedCount)
+			{
+				break;
+			}
+		}
+
+		return maxCost;
+	}
+
+	void GetIndices(std::vector<uint32_t>& outIndices) const
+	{
+		outIndices.clear();
+		outIndices.reserve(m_triangleCount * 3U);
+		for (uint32_t triangleIndex = 0U; triangleIndex < m_isTriangleRemoved.size(); ++triangleIndex)
+		{
+			if (!m_isTriangleRemoved[triangleIndex])
+			{
+				outIndices.insert(outIndices.end(), m_indices.begin() + triangleIndex * 3U, m_indices.begin() + triangleIndex * 3U + 3U);
+			}
+		}
+	}
+
+	uint32_t GetTriangleCount() const { return m_triangleCount; }
+
+private:
+	void BuildAdjacency()
+	{
+		const uint32_t vertexCount = static_cast<uint32_t>(m_welded.size());
+		m_triangleOffsets.assign(vertexCount + 1U, 0U);
+		std::unordered_map<uint64_t, uint32_t> edgeUseCounts;
+		edgeUseCounts.reserve(m_triangleCount * 3U);
+		for (uint32_t triangleIndex = 0U; triangleIndex < m_isTriangleRemoved.size(); ++triangleIndex)
+		{
+			if (m_isTriangleRemoved[triangleIndex])
+			{
+				continue;
+			}
+
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				uint32_t w0 = m_welded[m_indices[triangleIndex * 3U + corner]];
+				uint32_t w1 = m_welded[m_indices[triangleIndex * 3U + (corner + 1U) % 3U]];
+				++m_triangleOffsets[w0 + 1U];
+				++edgeUseCounts[GetEdgeKey(w0, w1)];
+			}
+		}
+
+		for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+		{
+			m_triangleOffsets[vertexIndex + 1U] += m_triangleOffsets[vertexIndex];
+		}
+
+		m_vertexTriangles.resize(m_triangleOffsets[vertexCount]);
+		std::vector<uint32_t> cursors(m_triangleOffsets.begin(), m_triangleOffsets.end() - 1);
+		for (uint32_t triangleIndex = 0U; triangleIndex < m_isTriangleRemoved.size(); ++triangleIndex)
+		{
+			if (m_isTriangleRemoved[triangleIndex])
+			{
+				continue;
+			}
+
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				m_vertexTriangles[cursors[m_welded[m_indices[triangleIndex * 3U + corner]]]++] = triangleIndex;
+			}
+		}
+
+		// Edges which are not shared by two triangles are open borders or non-manifold.
+		for (const auto& [edgeKey, useCount] : edgeUseCounts)
+		{
+			if (2U != useCount)
+			{
+				m_isLocked[static_cast<uint32_t>(edgeKey >> 32U)] = 1U;
+				m_isLocked[static_cast<uint32_t>(edgeKey & UINT32_MAX)] = 1U;
+			}
+		}
+	}
+
+	void GetNeighbors(uint32_t weldedVertex, std::vector<uint32_t>& outNeighbors) const
+	{
+		outNeighbors.clear();
+		for (uint32_t offset = m_triangleOffsets[weldedVertex]; offset < m_triangleOffsets[weldedVertex + 1U]; ++offset)
+		{
+			const uint32_t* pTriangle = &m_indices[m_vertexTriangles[offset] * 3U];
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				uint32_t neighbor = m_welded[pTriangle[corner]];
+				if (neighbor != weldedVertex)
+				{
+					outNeighbors.push_back(neighbor);
+				}
+			}
+		}
+		std::sort(outNeighbors.begin(), outNeighbors.end());
+		outNeighbors.erase(std::unique(outNeighbors.begin(), outNeighbors.end()), outNeighbors.end());
+	}
+
+	bool FindCollapse(uint32_t vertexIndex, Collapse& outCollapse)
+	{
+		// Only welded vertices own triangles in adjacency. Locked vertices don't move.
+		if (m_welded[vertexIndex] != vertexIndex || m_isLocked[vertexIndex] ||
+			m_triangleOffsets[vertexIndex] == m_triangleOffsets[vertexIndex + 1U])
+		{
+			return false;
+		}
+
+		GetNeighbors(vertexIndex, m_neighbors);
+		bool isFound = false;
+		for (uint32_t neighbor : m_neighbors)
+		{
+			uint32_t target = UINT32_MAX;
+			if (!FindCollapseTarget(vertexIndex, neighbor, target))
+			{
+				continue;
+			}
+
+			double cost = m_quadrics[vertexIndex].Evaluate(ToPoint(m_pPositions[target]));
+			if (isFound && cost >= outCollapse.cost)
+			{
+				continue;
+			}
+
+			if (!IsCollapseValid(vertexIndex, neighbor, ToPoint(m_pPositions[target])))
+			{
+				continue;
+			}
+
+			outCollapse = Collapse{ cost, vertexIndex, target };
+			isFound = true;
+		}
+
+		return isFound;
+	}
+
+	// Triangles of the vertex must see one source vertex of the neighbor's seam group. Otherwise attributes of the other side leak.
+	bool FindCollapseTarget(uint32_t vertexIndex, uint32_t neighbor, uint32_t& outTarget) const
+	{
+		for (uint32_t offset = m_triangleOffsets[vertexIndex]; offset < m_triangleOffsets[vertexIndex + 1U]; ++offset)
+		{
+			const uint32_t* pTriangle = &m_indices[m_vertexTriangles[offset] * 3U];
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				if (m_welded[pTriangle[corner]] != neighbor)
+				{
+					continue;
+				}
+
+				if (UINT32_MAX != outTarget && outTarget != pTriangle[corner])
+				{
+					return false;
+				}
+				outTarget = pTriangle[corner];
+			}
+		}
+
+		return UINT32_MAX != outTarget;
+	}
+
+	bool IsCollapseValid(uint32_t vertexIndex, uint32_t neighbor, const Point& targetPosition)
+	{
+		// Edges inside manifold meshes are shared by two triangles whose third vertices are the only common neighbors.
+		// More common neighbors mean that the collapse folds the mesh.
+		GetNeighbors(neighbor, m_targetNeighbors);
+		uint32_t commonCount = 0U;
+		auto itTarget = m_targetNeighbors.begin();
+		for (uint32_t vertexNeighbor : m_neighbors)
+		{
+			itTarget = std::lower_bound(itTarget, m_targetNeighbors.end(), vertexNeighbor);
+			if (itTarget != m_targetNeighbors.end() && *itTarget == vertexNeighbor)
+			{
+				++commonCount;
+			}
+		}
+		if (2U != commonCount)
+		{
+			return false;
+		}
+
+		// Triangles which are kept must not flip.
+		for (uint32_t offset = m_triangleOffsets[vertexIndex]; offset < m_triangleOffsets[vertexIndex + 1U]; ++offset)
+		{
+			const uint32_t* pTriangle = &m_indices[m_vertexTriangles[offset] * 3U];
+			Point points[3];
+			Point movedPoints[3];
+			bool hasNeighbor = false;
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				uint32_t welded = m_welded[pTriangle[corner]];
+				hasNeighbor = hasNeighbor || welded == neighbor;
+				points[corner] = ToPoint(m_pPositions[pTriangle[corner]]);
+				movedPoints[corner] = welded == vertexIndex ? targetPosition : points[corner];
+			}
+			if (hasNeighbor)
+			{
+				continue;
+			}
+
+			Point normal = Cross(Subtract(points[1], points[0]), Subtract(points[2], points[0]));
+			Point movedNormal = Cross(Subtract(movedPoints[1], movedPoints[0]), Subtract(movedPoints[2], movedPoints[0]));
+			if (Dot(normal, movedNormal) <= 0.0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void ApplyCollapse(const Collapse& collapse, std::vector<uint8_t>& isDirty)
+	{
+		const uint32_t targetWelded = m_welded[collapse.target];
+		for (uint32_t offset = m_triangleOffsets[collapse.vertex]; offset < m_triangleOffsets[collapse.vertex + 1U]; ++offset)
+		{
+			uint32_t triangleIndex = m_vertexTriangles[offset];
+			uint32_t* pTriangle = &m_indices[triangleIndex * 3U];
+			bool hasTarget = false;
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				isDirty[m_welded[pTriangle[corner]]] = 1U;
+				hasTarget = hasTarget || m_welded[pTriangle[corner]] == targetWelded;
+			}
+
+			if (hasTarget)
+			{
+				m_isTriangleRemoved[triangleIndex] = 1U;
+				--m_triangleCount;
+				continue;
+			}
+
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				if (m_welded[pTriangle[corner]] == collapse.vertex)
+				{
+					pTriangle[corner] = collapse.target;
+				}
+			}
+		}
+
+		m_quadrics[targetWelded].Add(m_quadrics[collapse.vertex]);
+	}
+
+private:
+	const cd::Vec3f* m_pPositions;
+
+	std::vector<uint32_t> m_welded;
+	std::vector<uint32_t> m_groupSizes;
+	std::vector<Quadric> m_quadrics;
+	std::vector<uint8_t> m_isLocked;
+
+	std::vector<uint32_t> m_indices;
+	std::vector<uint8_t> m_isTriangleRemoved;
+	uint32_t m_triangleCount = 0U;
+
+	// Live triangles of welded vertices in CSR layout. Rebuilt for each pass.
+	std::vector<uint32_t> m_triangleOffsets;
+	std::vector<uint32_t> m_vertexTriangles;
+
+	std::vector<uint32_t> m_neighbors;
+	std::vector<uint32_t> m_targetNeighbors;
+};
+
+}
+
+float MeshSimplifier::Simplify(const cd::Vec3f* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount,
+	uint32_t targetIndexCount, float targetError, std::vector<uint32_t>& outIndices)
+{
+	SimplifyContext context(pPositions, vertexCount, pIndices, indexCount);
+	double targetErrorSquare = static_cast<double>(targetError) * static_cast<double>(targetError);
+	double maxCost = context.Run(targetIndexCount / 3U, targetErrorSquare);
+	context.GetIndices(outIndices);
+	return static_cast<float>(std::sqrt(maxCost));
+}
+
+std::vector<MeshLOD> MeshSimplifier::BuildLODs(const cd::Vec3f* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount,
+	const MeshLODSettings& settings)
+{
+	std::vector<MeshLOD> lods;
+	if (0U == vertexCount || indexCount < 3U)
+	{
+		return lods;
+	}
+
+	cd::Vec3f minPosition = pPositions[pIndices[0]];
+	cd::Vec3f maxPosition = minPosition;
+	for (uint32_t index = 1U; index < indexCount; ++index)
+	{
+		const cd::Vec3f& position = pPositions[pIndices[index]];
+		minPosition = cd::Vec3f(std::min(minPosition.x(), position.x()), std::min(minPosition.y(), position.y()), std::min(minPosition.z(), position.z()));
+		maxPosition = cd::Vec3f(std::max(maxPosition.x(), position.x()), std::max(maxPosition.y(), position.y()), std::max(maxPosition.z(), position.z()));
+	}
+	float extentX = maxPosition.x() - minPosition.x();
+	float extentY = maxPosition.y() - minPosition.y();
+	float extentZ = maxPosition.z() - minPosition.z();
+	float meshSize = std::sqrt(extentX * extentX + extentY * extentY + extentZ * extentZ);
+
+	// Every level continues collapsing the previous level instead of starting from LOD 0 so that the chain costs about one Simplify.
+	// Quadrics keep planes of source triangles so that errors are still measured from LOD 0 and don't accumulate.
+	SimplifyContext context(pPositions, vertexCount, pIndices, indexCount);
+	const uint32_t sourceTriangleCount = indexCount / 3U;
+	uint32_t previousIndexCount = sourceTriangleCount * 3U;
+	double maxCost = 0.0;
+	const uint32_t lodCount = std::min(settings.lodCount, MeshLODSettings::MaxLODCount);
+	for (uint32_t lod = 1U; lod < lodCount; ++lod)
+	{
+		uint32_t targetTriangleCount = std::max(static_cast<uint32_t>(static_cast<float>(sourceTriangleCount) * settings.targetRatios[lod - 1U]), 1U);
+		double targetError = static_cast<double>(settings.targetErrors[lod - 1U]) * static_cast<double>(meshSize);
+		maxCost = std::max(maxCost, context.Run(targetTriangleCount, targetError * targetError));
+
+		MeshLOD meshLOD;
+		context.GetIndices(meshLOD.indices);
+		meshLOD.error = static_cast<float>(std::sqrt(maxCost));
+		if (meshLOD.indices.empty() || static_cast<float>(meshLOD.indices.size()) > static_cast<float>(previousIndexCount) * MaxLODTriangleRatio)
+		{
+			break;
+		}
+
+		previousIndexCount = static_cast<uint32_t>(meshLOD.indices.size());
+		lods.push_back(std::move(meshLOD));
+	}
+
+	return lods;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Math/Vector.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// Settings of a LOD chain whose LOD 0 is the source mesh.
+// LOD i keeps targetRatios[i - 1] of source triangles unless surfaces move farther than targetErrors[i - 1] * mesh size,
+// where mesh size is the diagonal of the source mesh's bounding box.
+struct MeshLODSettings
+{
+	static constexpr uint32_t MaxLODCount = 4U;
+
+	uint32_t lodCount = MaxLODCount;
+	float targetRatios[MaxLODCount - 1] = { 0.5f, 0.25f, 0.125f };
+	float targetErrors[MaxLODCount - 1] = { 0.005f, 0.02f, 0.05f };
+};
+
+// Indices of a simplified mesh which reuses vertices of the source mesh.
+struct MeshLOD
+{
+	std::vector<uint32_t> indices;
+
+	// Max distance in mesh space which surfaces moved from the source mesh.
+	float error;
+};
+
+// MeshSimplifier removes triangles by collapsing vertices onto neighbor vertices in the order of quadric errors.
+// Vertices on open borders and attribute seams, which are different vertices at the same position, never move so that meshes don't crack.
+// Results only depend on inputs so that the same imports always produce the same LODs.
+class MeshSimplifier
+{
+public:
+	// Simplify until triangles are not more than targetIndexCount / 3 or the next collapse moves surfaces farther than targetError.
+	// Returns the error of the result.
+	static float Simplify(const cd::Vec3f* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount,
+		uint32_t targetIndexCount, float targetError, std::vector<uint32_t>& outIndices);
+
+	// Build LODs after LOD 0. A level which can't remove enough triangles ends the chain so that it may be shorter than settings.
+	static std::vector<MeshLOD> BuildLODs(const cd::Vec3f* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount,
+		const MeshLODSettings& settings);
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "OcclusionRasterizer.h"
+
+#include "Core/Math/HiZPyramid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace engine
+{
+
+namespace
+{
+
+// Vertices whose w are not larger than it are treated as crossing the near plane.
+constexpr float MinClipW = 1e-6f;
+
+// Triangles whose doubled areas in pixels are smaller than it don't cover any pixel centers reliably.
+constexpr float MinDoubleArea = 1e-8f;
+
+// Edge values and depth of a row at x = 0 so that a pixel only adds A * x.
+struct RowSetup
+{
+	float edgeA[3];
+	float edgeRow[3];
+	float depthA;
+	float depthRow;
+};
+
+void RasterizeRowScalar(const RowSetup& row, float* pDepths, uint32_t beginX, uint32_t endX)
+{
+	for (uint32_t x = beginX; x < endX; ++x)
+	{
+		float pixelX = static_cast<float>(x) + 0.5f;
+		if (row.edgeA[0] * pixelX + row.edgeRow[0] >= 0.0f &&
+			row.edgeA[1] * pixelX + row.edgeRow[1] >= 0.0f &&
+			row.edgeA[2] * pixelX + row.edgeRow[2] >= 0.0f)
+		{
+			pDepths[x] = std::min(pDepths[x], row.depthA * pixelX + row.depthRow);
+		}
+	}
+}
+
+#ifdef CD_SIMD_X86
+
+uint32_t RasterizeRowSSE(const RowSetup& row, float* pDepths, uint32_t beginX, uint32_t endX)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+	uint32_t x = beginX;
+	for (; x + 4U <= endX; x += 4U)
+	{
+		__m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x) + 0.5f), laneOffsets);
+		__m128 edge0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row.edgeA[0]), pixelX), _mm_set1_ps(row.edgeRow[0]));
+		__m128 edge1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row.edgeA[1]), pixelX), _mm_set1_ps(row.edgeRow[1]));
+		__m128 edge2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row.edgeA[2]), pixelX), _mm_set1_ps(row.edgeRow[2]));
+		__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+		if (0 == _mm_movemask_ps(inside))
+		{
+			continue;
+		}
+
+		__m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row.depthA), pixelX), _mm_set1_ps(row.depthRow));
+		__m128 oldDepth = _mm_loadu_ps(pDepths + x);
+		__m128 newDepth = _mm_min_ps(oldDepth, depth);
+		_mm_storeu_ps(pDepths + x, _mm_or_ps(_mm_and_ps(inside, newDepth), _mm_andnot_ps(inside, oldDepth)));
+	}
+
+	return x;
+}
+
+CD_TARGET_AVX2 uint32_t RasterizeRowAVX2(const RowSetup& row, float* pDepths, uint32_t beginX, uint32_t endX)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 laneOffsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+
+	uint32_t x = beginX;
+	for (; x + 8U <= endX; x += 8U)
+	{
+		__m256 pixelX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x) + 0.5f), laneOffsets);
+		__m256 edge0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(row.edgeA[0]), pixelX), _mm256_set1_ps(row.edgeRow[0]));
+		__m256 edge1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(row.edgeA[1]), pixelX), _mm256_set1_ps(row.edgeRow[1]));
+		__m256 edge2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(row.edgeA[2]), pixelX), _mm256_set1_ps(row.edgeRow[2]));
+		__m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(edge0, zero, _CMP_GE_OQ), _mm256_cmp_ps(edge1, zero, _CMP_GE_OQ)),
+			_mm256_cmp_ps(edge2, zero, _CMP_GE_OQ));
+		if (0 == _mm256_movemask_ps(inside))
+		{
+			continue;
+		}
+
+		__m256 depth = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(row.depthA), pixelX), _mm256_set1_ps(row.depthRow));
+		__m256 oldDepth = _mm256_loadu_ps(pDepths + x);
+		_mm256_storeu_ps(pDepths + x, _mm256_blendv_ps(oldDepth, _mm256_min_ps(oldDepth, depth), inside));
+	}
+
+	return x;
+}
+
+#endif
+
+}
+
+void OcclusionRasterizer::Begin(uint32_t width, uint32_t height, const cd::Matrix4x4& viewProjection, bool homogeneousDepth)
+{
+	assert(width > 0U && height > 0U);
+
+	m_width = width;
+	m_height = height;
+	m_viewProjection = viewProjection;
+	m_homogeneousDepth = homogeneousDepth;
+	m_depths.resize(width * height);
+	m_triangles.clear();
+}
+
+void OcclusionRasterizer::AddOccluder(const cd::Matrix4x4& worldMatrix, const cd::Vec3f* pPositions, uint32_t vertexCount,
+	const uint32_t* pIndices, uint32_t indexCount)
+{
+	// Vertices are stored as (pixel x, pixel y, depth, clip w). Matrix is column major so that clip = M * p.
+	const cd::Matrix4x4 worldViewProjection = m_viewProjection * worldMatrix;
+	const float* pMatrix = worldViewProjection.Begin();
+	const float width = static_cast<float>(m_width);
+	const float height = static_cast<float>(m_height);
+	m_screenVertices.resize(vertexCount);
+	for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		const cd::Vec3f& position = pPositions[vertexIndex];
+		float clipX = pMatrix[0] * position.x() + pMatrix[4] * position.y() + pMatrix[8] * position.z() + pMatrix[12];
+		float clipY = pMatrix[1] * position.x() + pMatrix[5] * position.y() + pMatrix[9] * position.z() + pMatrix[13];
+		float clipZ = pMatrix[2] * position.x() + pMatrix[6] * position.y() + pMatrix[10] * position.z() + pMatrix[14];
+		float clipW = pMatrix[3] * position.x() + pMatrix[7] * position.y() + pMatrix[11] * position.z() + pMatrix[15];
+		if (clipW <= MinClipW)
+		{
+			m_screenVertices[vertexIndex] = cd::Vec4f(0.0f, 0.0f, -1.0f, clipW);
+			continue;
+		}
+
+		float invW = 1.0f / clipW;
+		float depth = clipZ * invW;
+		m_screenVertices[vertexIndex] = cd::Vec4f((clipX * invW * 0.5f + 0.5f) * width, (0.5f - clipY * invW * 0.5f) * height,
+			m_homogeneousDepth ? depth * 0.5f + 0.5f : depth, clipW);
+	}
+
+	for (uint32_t index = 0U; index + 3U <= indexCount; index += 3U)
+	{
+		assert(pIndices[index] < vertexCount && pIndices[index + 1U] < vertexCount && pIndices[index + 2U] < vertexCount);
+		const cd::Vec4f& a = m_screenVertices[pIndices[index]];
+		const cd::Vec4f& b = m_screenVertices[pIndices[index + 1U]];
+		const cd::Vec4f& c = m_screenVertices[pIndices[index + 2U]];
+		if (a.w() <= MinClipW || b.w() <= MinClipW || c.w() <= MinClipW || a.z() < 0.0f || b.z() < 0.0f || c.z() < 0.0f)
+		{
+			continue;
+		}
+
+		// Pixel centers at (x + 0.5, y + 0.5) inside the screen.
+		float minX = std::ceil(std::min({ a.x(), b.x(), c.x() }) - 0.5f);
+		float maxX = std::floor(std::max({ a.x(), b.x(), c.x() }) - 0.5f);
+		float minY = std::ceil(std::min({ a.y(), b.y(), c.y() }) - 0.5f);
+		float maxY = std::floor(std::max({ a.y(), b.y(), c.y() }) - 0.5f);
+		minX = std::max(minX, 0.0f);
+		maxX = std::min(maxX, width - 1.0f);
+		minY = std::max(minY, 0.0f);
+		maxY = std::min(maxY, height - 1.0f);
+		if (minX > maxX || minY > maxY)
+		{
+			continue;
+		}
+
+		float doubleArea = (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
+		if (std::fabs(doubleArea) < MinDoubleArea)
+		{
+			continue;
+		}
+
+		// Edge i is opposite to vertex i so that edge values divided by the area are barycentric coordinates.
+		// Both windings are accepted by flipping edges of clockwise triangles.
+		Triangle triangle;
+		const float sign = doubleArea > 0.0f ? 1.0f : -1.0f;
+		const cd::Vec4f* pVertices[3] = { &a, &b, &c };
+		for (uint32_t edgeIndex = 0U; edgeIndex < 3U; ++edgeIndex)
+		{
+			const cd::Vec4f& p = *pVertices[(edgeIndex + 1U) % 3U];
+			const cd::Vec4f& q = *pVertices[(edgeIndex + 2U) % 3U];
+			triangle.edgeA[edgeIndex] = sign * (p.y() - q.y());
+			triangle.edgeB[edgeIndex] = sign * (q.x() - p.x());
+			triangle.edgeC[edgeIndex] = sign * ((q.y() - p.y()) * p.x() - (q.x() - p.x()) * p.y());
+		}
+
+		const float invArea = 1.0f / std::fabs(doubleArea);
+		triangle.depthA = (triangle.edgeA[0] * a.z() + triangle.edgeA[1] * b.z() + triangle.edgeA[2] * c.z()) * invArea;
+		triangle.depthB = (triangle.edgeB[0] * a.z() + triangle.edgeB[1] * b.z() + triangle.edgeB[2] * c.z()) * invArea;
+		triangle.depthC = (triangle.edgeC[0] * a.z() + triangle.edgeC[1] * b.z() + triangle.edgeC[2] * c.z()) * invArea;
+		triangle.minX = static_cast<uint32_t>(minX);
+		triangle.maxX = static_cast<uint32_t>(maxX);
+		triangle.minY = static_cast<uint32_t>(minY);
+		triangle.maxY = static_cast<uint32_t>(maxY);
+		m_triangles.push_back(triangle);
+	}
+}
+
+void OcclusionRasterizer::RasterizeBands(uint32_t beginBand, uint32_t endBand, SIMDPath path)
+{
+	path = ClampSIMDPath(path);
+	for (uint32_t bandIndex = beginBand; bandIndex < endBand; ++bandIndex)
+	{
+		const uint32_t beginRow = bandIndex * BandHeight;
+		const uint32_t endRow = std::min(beginRow + BandHeight, m_height);
+		std::fill(m_depths.begin() + beginRow * m_width, m_depths.begin() + endRow * m_width, 1.0f);
+
+		for (const Triangle& triangle : m_triangles)
+		{
+			if (triangle.maxY >= beginRow && triangle.minY < endRow)
+			{
+				RasterizeTriangle(triangle, std::max(beginRow, triangle.minY), std::min(endRow, triangle.maxY + 1U), path);
+			}
+		}
+	}
+}
+
+void OcclusionRasterizer::BuildHiZPyramid(HiZPyramid& outPyramid) const
+{
+	outPyramid.Build(m_depths.data(), m_width, m_height, m_viewProjection, m_homogeneousDepth, false);
+}
+
+void OcclusionRasterizer::RasterizeTriangle(const Triangle& triangle, uint32_t beginRow, uint32_t endRow, SIMDPath path)
+{
+	RowSetup row;
+	row.edgeA[0] = triangle.edgeA[0];
+	row.edgeA[1] = triangle.edgeA[1];
+	row.edgeA[2] = triangle.edgeA[2];
+	row.depthA = triangle.depthA;
+
+	const uint32_t beginX = triangle.minX;
+	const uint32_t endX = triangle.maxX + 1U;
+	for (uint32_t y = beginRow; y < endRow; ++y)
+	{
+		float pixelY = static_cast<float>(y) + 0.5f;
+		for (uint32_t edgeIndex = 0U; edgeIndex < 3U; ++edgeIndex)
+		{
+			row.edgeRow[edgeIndex] = triangle.edgeB[edgeIndex] * pixelY + triangle.edgeC[edgeIndex];
+		}
+		row.depthRow = triangle.depthB * pixelY + triangle.depthC;
+
+		// Remaining pixels which can't fill SIMD lanes use scalar path.
+		float* pDepths = m_depths.data() + y * m_width;
+		uint32_t rasterizedX = beginX;
+#ifdef CD_SIMD_X86
+		if (SIMDPath::AVX2 == path)
+		{
+			rasterizedX = RasterizeRowAVX2(row, pDepths, beginX, endX);
+		}
+		else if (SIMDPath::SSE == path)
+		{
+			rasterizedX = RasterizeRowSSE(row, pDepths, beginX, endX);
+		}
+#endif
+
+		RasterizeRowScalar(row, pDepths, rasterizedX, endX);
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Core/Math/SIMD.h"
+#include "Math/Matrix.hpp"
+#include "Math/Vector.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class HiZPyramid;
+
+// OcclusionRasterizer renders occluder triangles into a small depth buffer on CPU for devices which can't read GPU depths back.
+// Depths are in [0, 1] and larger values are farther, the same as HiZPyramid. Row 0 is the top of the screen.
+// Rows are split into bands which don't share depths so that different threads rasterize different bands.
+class OcclusionRasterizer final
+{
+public:
+	// Rows of a band which a job rasterizes.
+	static constexpr uint32_t BandHeight = 8U;
+
+public:
+	OcclusionRasterizer() = default;
+	OcclusionRasterizer(const OcclusionRasterizer&) = default;
+	OcclusionRasterizer& operator=(const OcclusionRasterizer&) = default;
+	OcclusionRasterizer(OcclusionRasterizer&&) = default;
+	OcclusionRasterizer& operator=(OcclusionRasterizer&&) = default;
+	~OcclusionRasterizer() = default;
+
+	// Clear triangles and prepare a width x height depth buffer for a column major projection * view matrix.
+	// homogeneousDepth means that NDC depth range is [-1, 1], otherwise it is [0, 1].
+	void Begin(uint32_t width, uint32_t height, const cd::Matrix4x4& viewProjection, bool homogeneousDepth);
+
+	// Transform indexed triangles of an occluder to screen space. Triangles which cross the near plane are skipped
+	// and triangles outside of the screen are dropped. Skipped triangles only make occlusion less aggressive.
+	void AddOccluder(const cd::Matrix4x4& worldMatrix, const cd::Vec3f* pPositions, uint32_t vertexCount,
+		const uint32_t* pIndices, uint32_t indexCount);
+
+	uint32_t GetTriangleCount() const { return static_cast<uint32_t>(m_triangles.size()); }
+	uint32_t GetBandCount() const { return (m_height + BandHeight - 1U) / BandHeight; }
+
+	// Clear depths of bands [beginBand, endBand) and rasterize all triangles into them.
+	void RasterizeBands(uint32_t beginBand, uint32_t endBand, SIMDPath path);
+	void RasterizeBands(uint32_t beginBand, uint32_t endBand) { RasterizeBands(beginBand, endBand, GetBestSIMDPath()); }
+
+	uint32_t GetWidth() const { return m_width; }
+	uint32_t GetHeight() const { return m_height; }
+	const std::vector<float>& GetDepths() const { return m_depths; }
+	float GetDepth(uint32_t x, uint32_t y) const { return m_depths[y * m_width + x]; }
+
+	// Build the pyramid from rasterized depths for the same matrix so that occludees are tested without latency.
+	void BuildHiZPyramid(HiZPyramid& outPyramid) const;
+
+private:
+	// Edge functions and the depth plane in pixel space. A pixel center (x, y) is covered if all edges are not negative.
+	// Depth of a covered pixel is depthA * x + depthB * y + depthC.
+	struct Triangle
+	{
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		float depthA;
+		float depthB;
+		float depthC;
+		uint32_t minX;
+		uint32_t maxX;
+		uint32_t minY;
+		uint32_t maxY;
+	};
+
+	void RasterizeTriangle(const Triangle& triangle, uint32_t beginRow, uint32_t endRow, SIMDPath path);
+
+private:
+	uint32_t m_width = 0U;
+	uint32_t m_height = 0U;
+	cd::Matrix4x4 m_viewProjection;
+	bool m_homogeneousDepth = false;
+
+	std::vector<float> m_depths;
+	std::vector<Triangle> m_triangles;
+
+	// Reused by AddOccluder to transform vertices.
+	std::vector<cd::Vec4f> m_screenVertices;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "SIMD.h"
+
+namespace engine
+{
+
+namespace
+{
+
+#ifdef CD_SIMD_X86
+
+bool IsAVX2Supported()
+{
+#ifdef _MSC_VER
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	if (cpuInfo[0] < 7)
+	{
+		return false;
+	}
+
+	// OS needs to save YMM registers too.
+	__cpuid(cpuInfo, 1);
+	constexpr int OSXSAVEBit = 1 << 27;
+	constexpr int AVXBit = 1 << 28;
+	if ((cpuInfo[2] & (OSXSAVEBit | AVXBit)) != (OSXSAVEBit | AVXBit) || (_xgetbv(0) & 0x6) != 0x6)
+	{
+		return false;
+	}
+
+	__cpuidex(cpuInfo, 7, 0);
+	constexpr int AVX2Bit = 1 << 5;
+	return (cpuInfo[1] & AVX2Bit) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+}
+
+SIMDPath GetBestSIMDPath()
+{
+#ifdef CD_SIMD_X86
+	static const SIMDPath s_bestPath = IsAVX2Supported() ? SIMDPath::AVX2 : SIMDPath::SSE;
+	return s_bestPath;
+#else
+	return SIMDPath::Scalar;
+#endif
+}
+
+const char* GetSIMDPathName(SIMDPath path)
+{
+	switch (path)
+	{
+	case SIMDPath::SSE:
+		return "SSE";
+	case SIMDPath::AVX2:
+		return "AVX2";
+	default:
+		return "Scalar";
+	}
+}
+
+}
\ No newline at end of file
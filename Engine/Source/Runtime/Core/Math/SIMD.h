@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CD_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC allows to use AVX2 intrinsics without /arch:AVX2. GCC and Clang need to enable it per function.
+#if defined(CD_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CD_TARGET_AVX2
+#endif
+
+namespace engine
+{
+
+enum class SIMDPath : uint8_t
+{
+	Scalar,
+	SSE,
+	AVX2,
+};
+
+// Returns the widest SIMD path which current CPU supports.
+SIMDPath GetBestSIMDPath();
+const char* GetSIMDPathName(SIMDPath path);
+
+// Unsupported paths fall back to the best one.
+inline SIMDPath ClampSIMDPath(SIMDPath path)
+{
+	return static_cast<uint8_t>(path) > static_cast<uint8_t>(GetBestSIMDPath()) ? GetBestSIMDPath() : path;
+}
+
+}
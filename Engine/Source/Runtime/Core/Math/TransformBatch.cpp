@@ -0,0 +1,271 @@
+#include "TransformBatch.h"
+
+namespace engine
+{
+
+namespace
+{
+
+static_assert(sizeof(cd::Matrix4x4) == 16 * sizeof(float), "Matrix4x4 is expected to be 16 continuous floats.");
+
+struct TransformArrays
+{
+	const float* pTranslationX;
+	const float* pTranslationY;
+	const float* pTranslationZ;
+	const float* pRotationX;
+	const float* pRotationY;
+	const float* pRotationZ;
+	const float* pRotationW;
+	const float* pScaleX;
+	const float* pScaleY;
+	const float* pScaleZ;
+};
+
+// Column major T * R * S which is the same as cd::Transform::GetMatrix.
+void BuildMatricesScalar(const TransformArrays& arrays, uint32_t beginIndex, uint32_t endIndex, float* pOutMatrices)
+{
+	for (uint32_t index = beginIndex; index < endIndex; ++index)
+	{
+		float x = arrays.pRotationX[index];
+		float y = arrays.pRotationY[index];
+		float z = arrays.pRotationZ[index];
+		float w = arrays.pRotationW[index];
+		float xx = x * x;
+		float yy = y * y;
+		float zz = z * z;
+		float xy = x * y;
+		float xz = x * z;
+		float yz = y * z;
+		float wx = w * x;
+		float wy = w * y;
+		float wz = w * z;
+		float sx = arrays.pScaleX[index];
+		float sy = arrays.pScaleY[index];
+		float sz = arrays.pScaleZ[index];
+
+		float* pMatrix = pOutMatrices + index * 16;
+		pMatrix[0] = (1.0f - 2.0f * (yy + zz)) * sx;
+		pMatrix[1] = 2.0f * (xy + wz) * sx;
+		pMatrix[2] = 2.0f * (xz - wy) * sx;
+		pMatrix[3] = 0.0f;
+		pMatrix[4] = 2.0f * (xy - wz) * sy;
+		pMatrix[5] = (1.0f - 2.0f * (xx + zz)) * sy;
+		pMatrix[6] = 2.0f * (yz + wx) * sy;
+		pMatrix[7] = 0.0f;
+		pMatrix[8] = 2.0f * (xz + wy) * sz;
+		pMatrix[9] = 2.0f * (yz - wx) * sz;
+		pMatrix[10] = (1.0f - 2.0f * (xx + yy)) * sz;
+		pMatrix[11] = 0.0f;
+		pMatrix[12] = arrays.pTranslationX[index];
+		pMatrix[13] = arrays.pTranslationY[index];
+		pMatrix[14] = arrays.pTranslationZ[index];
+		pMatrix[15] = 1.0f;
+	}
+}
+
+#ifdef CD_SIMD_X86
+
+// Every register stores one matrix element of 4 transforms. Transpose 4 elements to store one column per transform.
+void StoreColumnSSE(__m128 row0, __m128 row1, __m128 row2, __m128 row3, float* pFirstMatrix, uint32_t columnIndex)
+{
+	_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+	_mm_storeu_ps(pFirstMatrix + columnIndex * 4, row0);
+	_mm_storeu_ps(pFirstMatrix + 16 + columnIndex * 4, row1);
+	_mm_storeu_ps(pFirstMatrix + 32 + columnIndex * 4, row2);
+	_mm_storeu_ps(pFirstMatrix + 48 + columnIndex * 4, row3);
+}
+
+uint32_t BuildMatricesSSE(const TransformArrays& arrays, uint32_t count, float* pOutMatrices)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	uint32_t index = 0U;
+	for (; index + 4U <= count; index += 4U)
+	{
+		__m128 x = _mm_loadu_ps(arrays.pRotationX + index);
+		__m128 y = _mm_loadu_ps(arrays.pRotationY + index);
+		__m128 z = _mm_loadu_ps(arrays.pRotationZ + index);
+		__m128 w = _mm_loadu_ps(arrays.pRotationW + index);
+		__m128 xx = _mm_mul_ps(x, x);
+		__m128 yy = _mm_mul_ps(y, y);
+		__m128 zz = _mm_mul_ps(z, z);
+		__m128 xy = _mm_mul_ps(x, y);
+		__m128 xz = _mm_mul_ps(x, z);
+		__m128 yz = _mm_mul_ps(y, z);
+		__m128 wx = _mm_mul_ps(w, x);
+		__m128 wy = _mm_mul_ps(w, y);
+		__m128 wz = _mm_mul_ps(w, z);
+		__m128 sx = _mm_loadu_ps(arrays.pScaleX + index);
+		__m128 sy = _mm_loadu_ps(arrays.pScaleY + index);
+		__m128 sz = _mm_loadu_ps(arrays.pScaleZ + index);
+
+		float* pFirstMatrix = pOutMatrices + index * 16;
+		StoreColumnSSE(
+			_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+			zero, pFirstMatrix, 0U);
+		StoreColumnSSE(
+			_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+			_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+			zero, pFirstMatrix, 1U);
+		StoreColumnSSE(
+			_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+			_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+			zero, pFirstMatrix, 2U);
+		StoreColumnSSE(
+			_mm_loadu_ps(arrays.pTranslationX + index),
+			_mm_loadu_ps(arrays.pTranslationY + index),
+			_mm_loadu_ps(arrays.pTranslationZ + index),
+			one, pFirstMatrix, 3U);
+	}
+
+	return index;
+}
+
+// Same as StoreColumnSSE but two 128-bit lanes store 8 transforms.
+CD_TARGET_AVX2 void StoreColumnAVX2(__m256 row0, __m256 row1, __m256 row2, __m256 row3, float* pFirstMatrix, uint32_t columnIndex)
+{
+	__m256 t0 = _mm256_unpacklo_ps(row0, row1);
+	__m256 t1 = _mm256_unpackhi_ps(row0, row1);
+	__m256 t2 = _mm256_unpacklo_ps(row2, row3);
+	__m256 t3 = _mm256_unpackhi_ps(row2, row3);
+	__m256 column0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 column1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 column2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 column3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+	float* pColumn = pFirstMatrix + columnIndex * 4;
+	_mm_storeu_ps(pColumn, _mm256_castps256_ps128(column0));
+	_mm_storeu_ps(pColumn + 16, _mm256_castps256_ps128(column1));
+	_mm_storeu_ps(pColumn + 32, _mm256_castps256_ps128(column2));
+	_mm_storeu_ps(pColumn + 48, _mm256_castps256_ps128(column3));
+	_mm_storeu_ps(pColumn + 64, _mm256_extractf128_ps(column0, 1));
+	_mm_storeu_ps(pColumn + 80, _mm256_extractf128_ps(column1, 1));
+	_mm_storeu_ps(pColumn + 96, _mm256_extractf128_ps(column2, 1));
+	_mm_storeu_ps(pColumn + 112, _mm256_extractf128_ps(column3, 1));
+}
+
+CD_TARGET_AVX2 uint32_t BuildMatricesAVX2(const TransformArrays& arrays, uint32_t count, float* pOutMatrices)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 zero = _mm256_setzero_ps();
+
+	uint32_t index = 0U;
+	for (; index + 8U <= count; index += 8U)
+	{
+		__m256 x = _mm256_loadu_ps(arrays.pRotationX + index);
+		__m256 y = _mm256_loadu_ps(arrays.pRotationY + index);
+		__m256 z = _mm256_loadu_ps(arrays.pRotationZ + index);
+		__m256 w = _mm256_loadu_ps(arrays.pRotationW + index);
+		__m256 xx = _mm256_mul_ps(x, x);
+		__m256 yy = _mm256_mul_ps(y, y);
+		__m256 zz = _mm256_mul_ps(z, z);
+		__m256 xy = _mm256_mul_ps(x, y);
+		__m256 xz = _mm256_mul_ps(x, z);
+		__m256 yz = _mm256_mul_ps(y, z);
+		__m256 wx = _mm256_mul_ps(w, x);
+		__m256 wy = _mm256_mul_ps(w, y);
+		__m256 wz = _mm256_mul_ps(w, z);
+		__m256 sx = _mm256_loadu_ps(arrays.pScaleX + index);
+		__m256 sy = _mm256_loadu_ps(arrays.pScaleY + index);
+		__m256 sz = _mm256_loadu_ps(arrays.pScaleZ + index);
+
+		float* pFirstMatrix = pOutMatrices + index * 16;
+		StoreColumnAVX2(
+			_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx),
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+			zero, pFirstMatrix, 0U);
+		StoreColumnAVX2(
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+			_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy),
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+			zero, pFirstMatrix, 1U);
+		StoreColumnAVX2(
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+			_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz),
+			zero, pFirstMatrix, 2U);
+		StoreColumnAVX2(
+			_mm256_loadu_ps(arrays.pTranslationX + index),
+			_mm256_loadu_ps(arrays.pTranslationY + index),
+			_mm256_loadu_ps(arrays.pTranslationZ + index),
+			one, pFirstMatrix, 3U);
+	}
+
+	return index;
+}
+
+#endif
+
+}
+
+void TransformBatch::Clear()
+{
+	for (std::vector<float>* pArray : { &m_translationX, &m_translationY, &m_translationZ,
+		&m_rotationX, &m_rotationY, &m_rotationZ, &m_rotationW, &m_scaleX, &m_scaleY, &m_scaleZ })
+	{
+		pArray->clear();
+	}
+}
+
+void TransformBatch::Reserve(uint32_t count)
+{
+	for (std::vector<float>* pArray : { &m_translationX, &m_translationY, &m_translationZ,
+		&m_rotationX, &m_rotationY, &m_rotationZ, &m_rotationW, &m_scaleX, &m_scaleY, &m_scaleZ })
+	{
+		pArray->reserve(count);
+	}
+}
+
+void TransformBatch::Add(const cd::Transform& transform)
+{
+	const cd::Vec3f& translation = transform.GetTranslation();
+	const cd::Quaternion& rotation = transform.GetRotation();
+	const cd::Vec3f& scale = transform.GetScale();
+	m_translationX.push_back(translation.x());
+	m_translationY.push_back(translation.y());
+	m_translationZ.push_back(translation.z());
+	m_rotationX.push_back(rotation.x());
+	m_rotationY.push_back(rotation.y());
+	m_rotationZ.push_back(rotation.z());
+	m_rotationW.push_back(rotation.w());
+	m_scaleX.push_back(scale.x());
+	m_scaleY.push_back(scale.y());
+	m_scaleZ.push_back(scale.z());
+}
+
+void TransformBatch::BuildMatrices(cd::Matrix4x4* pOutMatrices, SIMDPath path) const
+{
+	TransformArrays arrays{ m_translationX.data(), m_translationY.data(), m_translationZ.data(),
+		m_rotationX.data(), m_rotationY.data(), m_rotationZ.data(), m_rotationW.data(),
+		m_scaleX.data(), m_scaleY.data(), m_scaleZ.data() };
+
+	const uint32_t count = GetCount();
+	float* pOutFloats = reinterpret_cast<float*>(pOutMatrices);
+
+	// Unsupported paths fall back to the best one. Remaining transforms which can't fill SIMD lanes use scalar path.
+	uint32_t builtCount = 0U;
+	path = ClampSIMDPath(path);
+#ifdef CD_SIMD_X86
+	if (SIMDPath::AVX2 == path)
+	{
+		builtCount = BuildMatricesAVX2(arrays, count, pOutFloats);
+	}
+	else if (SIMDPath::SSE == path)
+	{
+		builtCount = BuildMatricesSSE(arrays, count, pOutFloats);
+	}
+#endif
+
+	BuildMatricesScalar(arrays, builtCount, count, pOutFloats);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Core/Math/SIMD.h"
+#include "Math/Transform.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// TransformBatch stores translation, rotation and scale in SoA layout so that SIMD lanes process different transforms.
+class TransformBatch final
+{
+public:
+	TransformBatch() = default;
+	TransformBatch(const TransformBatch&) = default;
+	TransformBatch& operator=(const TransformBatch&) = default;
+	TransformBatch(TransformBatch&&) = default;
+	TransformBatch& operator=(TransformBatch&&) = default;
+	~TransformBatch() = default;
+
+	uint32_t GetCount() const { return static_cast<uint32_t>(m_translationX.size()); }
+	void Clear();
+	void Reserve(uint32_t count);
+	void Add(const cd::Transform& transform);
+
+	// Build T * R * S matrices of [0, GetCount()) into pOutMatrices in the same order.
+	void BuildMatrices(cd::Matrix4x4* pOutMatrices, SIMDPath path) const;
+	void BuildMatrices(cd::Matrix4x4* pOutMatrices) const { BuildMatrices(pOutMatrices, GetBestSIMDPath()); }
+
+private:
+	std::vector<float> m_translationX;
+	std::vector<float> m_translationY;
+	std::vector<float> m_translationZ;
+	std::vector<float> m_rotationX;
+	std::vector<float> m_rotationY;
+	std::vector<float> m_rotationZ;
+	std::vector<float> m_rotationW;
+	std::vector<float> m_scaleX;
+	std::vector<float> m_scaleY;
+	std::vector<float> m_scaleZ;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "ComponentsStorage.hpp"
+#include "Entity.h"
+#include "SparseEntityIndex.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+
+// ArchetypeStorage stores entities which own the same set of Components in fixed-size chunks.
+// Every chunk keeps one contiguous array per component type (SoA) so that iterating all Components together
+// walks a few linear memory regions per chunk instead of one unrelated std::vector per component type.
+template<typename... Components>
+class ArchetypeStorage : public IComponentsStorage
+{
+public:
+	static_assert(sizeof...(Components) > 0, "ArchetypeStorage needs at least one component type.");
+	static_assert(((!std::is_pointer_v<Components> && !std::is_reference_v<Components>) && ...));
+
+	static constexpr size_t ChunkSizeInBytes = 16 * 1024;
+	static constexpr size_t EntitySizeInBytes = (sizeof(Entity) + ... + sizeof(Components));
+	static constexpr uint32_t ChunkCapacity = static_cast<uint32_t>(ChunkSizeInBytes > EntitySizeInBytes ? ChunkSizeInBytes / EntitySizeInBytes : 1);
+
+	struct Chunk
+	{
+		std::array<Entity, ChunkCapacity> entities;
+		std::tuple<std::array<Components, ChunkCapacity>...> components;
+		uint32_t count = 0;
+	};
+
+	// Key to register archetype in the World. It depends on the order of Components.
+	static constexpr uint32_t GetArchetypeKey()
+	{
+		uint32_t key = 0;
+		((key = key * 31U + Components::GetClassName().Value()), ...);
+		return key;
+	}
+
+public:
+	ArchetypeStorage() = default;
+	ArchetypeStorage(const ArchetypeStorage&) = delete;
+	ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+	ArchetypeStorage(ArchetypeStorage&&) = default;
+	ArchetypeStorage& operator=(ArchetypeStorage&&) = default;
+	virtual ~ArchetypeStorage() = default;
+
+	bool Contains(Entity entity) const { return m_entityToIndex.Get(entity) != SparseEntityIndex::InvalidIndex; }
+	size_t GetCount() const { return m_count; }
+	size_t GetChunkCount() const { return m_chunks.size(); }
+
+	// Increased when entities are created or removed so that systems can detect entity set changes to rebuild cached data.
+	uint32_t GetVersion() const { return m_version; }
+
+	// Index is the order of entities in chunks which is the order of Each(). It is valid until entities are created or removed.
+	template<typename Component>
+	Component& GetComponentByIndex(uint32_t index)
+	{
+		assert(index < m_count);
+		return std::get<std::array<Component, ChunkCapacity>>(m_chunks[index / ChunkCapacity]->components)[index % ChunkCapacity];
+	}
+
+	template<typename Component>
+	const Component& GetComponentByIndex(uint32_t index) const
+	{
+		assert(index < m_count);
+		return std::get<std::array<Component, ChunkCapacity>>(m_chunks[index / ChunkCapacity]->components)[index % ChunkCapacity];
+	}
+
+	template<typename Component>
+	Component* GetComponent(Entity entity)
+	{
+		uint32_t index = m_entityToIndex.Get(entity);
+		return SparseEntityIndex::InvalidIndex == index ? nullptr : &GetComponentByIndex<Component>(index);
+	}
+
+	// Create all Components for entity at the end of the last chunk.
+	std::tuple<Components&...> CreateComponents(Entity entity)
+	{
+		assert(entity != INVALID_ENTITY && !Contains(entity));
+
+		if (m_chunks.empty() || ChunkCapacity == m_chunks.back()->count)
+		{
+			m_chunks.emplace_back(std::make_unique<Chunk>());
+		}
+
+		Chunk& chunk = *m_chunks.back();
+		uint32_t slot = chunk.count++;
+		chunk.entities[slot] = entity;
+		m_entityToIndex.Set(entity, static_cast<uint32_t>(m_count++));
+		++m_version;
+
+		return std::apply([slot](auto&... componentArray) { return std::tuple<Components&...>(componentArray[slot]...); }, chunk.components);
+	}
+
+	// Remove all Components of entity. The last entity is moved into the hole to keep chunks packed.
+	void RemoveComponents(Entity entity)
+	{
+		uint32_t unusedIndex = m_entityToIndex.Get(entity);
+		if (SparseEntityIndex::InvalidIndex == unusedIndex)
+		{
+			return;
+		}
+
+		uint32_t lastIndex = static_cast<uint32_t>(m_count - 1);
+		Chunk& lastChunk = *m_chunks[lastIndex / ChunkCapacity];
+		uint32_t lastSlot = lastIndex % ChunkCapacity;
+		if (unusedIndex != lastIndex)
+		{
+			Chunk& unusedChunk = *m_chunks[unusedIndex / ChunkCapacity];
+			uint32_t unusedSlot = unusedIndex % ChunkCapacity;
+
+			Entity lastEntity = lastChunk.entities[lastSlot];
+			unusedChunk.entities[unusedSlot] = lastEntity;
+			MoveComponents(unusedChunk, unusedSlot, lastChunk, lastSlot, std::index_sequence_for<Components...>());
+			m_entityToIndex.Set(lastEntity, unusedIndex);
+		}
+
+		// Release resources held by the last slot's components.
+		std::apply([lastSlot](auto&... componentArray) { ((componentArray[lastSlot] = {}), ...); }, lastChunk.components);
+		--lastChunk.count;
+		--m_count;
+		m_entityToIndex.Reset(entity);
+		++m_version;
+
+		if (0U == lastChunk.count)
+		{
+			m_chunks.pop_back();
+		}
+	}
+
+	// Calls func(Entity, Components&...) for every entity chunk by chunk.
+	template<typename Func>
+	void Each(Func&& func)
+	{
+		for (std::unique_ptr<Chunk>& pChunk : m_chunks)
+		{
+			Chunk& chunk = *pChunk;
+			std::apply([&func, &chunk](auto&... componentArray)
+			{
+				for (uint32_t slot = 0U; slot < chunk.count; ++slot)
+				{
+					func(chunk.entities[slot], componentArray[slot]...);
+				}
+			}, chunk.components);
+		}
+	}
+
+	// Calls func(const Entity* pEntities, uint32_t count, Components*...) once per chunk for batch processing.
+	template<typename Func>
+	void EachChunk(Func&& func)
+	{
+		for (std::unique_ptr<Chunk>& pChunk : m_chunks)
+		{
+			Chunk& chunk = *pChunk;
+			std::apply([&func, &chunk](auto&... componentArray)
+			{
+				func(chunk.entities.data(), chunk.count, componentArray.data()...);
+			}, chunk.components);
+		}
+	}
+
+private:
+	template<size_t... Indexes>
+	static void MoveComponents(Chunk& dstChunk, uint32_t dstSlot, Chunk& srcChunk, uint32_t srcSlot, std::index_sequence<Indexes...>)
+	{
+		((std::get<Indexes>(dstChunk.components)[dstSlot] = cd::MoveTemp(std::get<Indexes>(srcChunk.components)[srcSlot])), ...);
+	}
+
+private:
+	std::vector<std::unique_ptr<Chunk>> m_chunks;
+	SparseEntityIndex m_entityToIndex;
+	size_t m_count = 0;
+	uint32_t m_version = 0U;
+};
+
+class MaterialComponent;
+class StaticMeshComponent;
+class TransformComponent;
+
+// Entities which are only drawn as static meshes, see SceneWorld::GetStaticMeshArchetype.
+using StaticMeshArchetype = ArchetypeStorage<TransformComponent, StaticMeshComponent, MaterialComponent>;
+
+}
\ No newline at end of file
@@ -1,11 +1,11 @@
 #pragma once
 
+#include "Base/Template.h"
 #include "Entity.h"
+#include "SparseEntityIndex.hpp"
 
-#include <algorithm>
 #include <cassert>
-#include <map>
-#include <unordered_map>
+#include <cstdint>
 #include <vector>
 
 namespace engine
@@ -18,11 +18,13 @@ public:
 };
 
 // ComponentsStorage stores an array of Components in the same type and the entity which contains the component.
+// Entity to dense index mapping is a paged sparse set so that lookups are two array reads without hashing.
 template<typename Component>
 class ComponentsStorage : public IComponentsStorage
 {
 public:
 	static_assert(!std::is_pointer_v<Component> && !std::is_reference_v<Component>);
+	static constexpr uint32_t InvalidIndex = SparseEntityIndex::InvalidIndex;
 
 public:
 	ComponentsStorage() = default;
@@ -33,10 +35,13 @@ public:
 	virtual ~ComponentsStorage() = default;
 
 	// Returns if ComponentStorage stores component for entity.
-	bool Contains(Entity entity) const { return m_entityToIndex.find(entity) != m_entityToIndex.end(); }
+	bool Contains(Entity entity) const { return GetDenseIndex(entity) != InvalidIndex; }
 
 	// Returns current active components count.
-	size_t GetCount() const { return m_entityToIndex.size(); }
+	size_t GetCount() const { return m_entities.size(); }
+
+	// Increased when components are created or removed so that systems can detect entity set changes to rebuild cached data.
+	uint32_t GetVersion() const { return m_version; }
 
 	// Returns current components capcity.
 	size_t GetCapcity() const { assert(m_entities.size() == m_components.size()); return m_entities.size(); }
@@ -44,11 +49,24 @@ public:
 	// Need to check if it is still active.
 	const std::vector<Entity>& GetEntities() const { return m_entities; }
 
+	// Dense components array which has the same order as GetEntities().
+	std::vector<Component>& GetDenseComponents() { return m_components; }
+	const std::vector<Component>& GetDenseComponents() const { return m_components; }
+
+	// Returns the index of entity's component in the dense arrays or InvalidIndex.
+	uint32_t GetDenseIndex(Entity entity) const { return m_entityToIndex.Get(entity); }
+
 	// Get component by entity.
 	Component* GetComponent(Entity entity)
 	{
-		auto itIndex = m_entityToIndex.find(entity);
-		return itIndex == m_entityToIndex.end() ? nullptr : &m_components[itIndex->second];
+		uint32_t denseIndex = GetDenseIndex(entity);
+		return InvalidIndex == denseIndex ? nullptr : &m_components[denseIndex];
+	}
+
+	const Component* GetComponent(Entity entity) const
+	{
+		uint32_t denseIndex = GetDenseIndex(entity);
+		return InvalidIndex == denseIndex ? nullptr : &m_components[denseIndex];
 	}
 
 	// Create component for entity.
@@ -56,39 +74,42 @@ public:
 	{
 		assert(entity != INVALID_ENTITY && !Contains(entity));
 
-		m_entityToIndex[entity] = m_components.size();
+		m_entityToIndex.Set(entity, static_cast<uint32_t>(m_components.size()));
 		m_entities.emplace_back(entity);
 		m_components.emplace_back();
+		++m_version;
 		return m_components.back();
 	}
 
 	// Remove actvie component from storage.
 	void RemoveComponent(Entity entity)
 	{
-		auto itIndex = m_entityToIndex.find(entity);
-		if (itIndex == m_entityToIndex.end())
+		uint32_t unusedIndex = GetDenseIndex(entity);
+		if (InvalidIndex == unusedIndex)
 		{
 			return;
 		}
 
-		if (m_entityToIndex.size() > 1)
+		// Swap the last component into the hole to keep dense arrays packed.
+		Entity lastEntity = m_entities.back();
+		if (lastEntity != entity)
 		{
-			size_t unusedIndex = itIndex->second;
-			Entity lastEntity = m_entities.back();
 			m_entities[unusedIndex] = lastEntity;
 			m_components[unusedIndex] = cd::MoveTemp(m_components.back());
-			m_entityToIndex[lastEntity] = unusedIndex;
+			m_entityToIndex.Set(lastEntity, unusedIndex);
 		}
 
 		m_entities.pop_back();
 		m_components.pop_back();
-		m_entityToIndex.erase(entity);
+		m_entityToIndex.Reset(entity);
+		++m_version;
 	}
 
 private:
 	std::vector<Entity> m_entities;
 	std::vector<Component> m_components;
-	std::unordered_map<Entity, size_t> m_entityToIndex;
+	SparseEntityIndex m_entityToIndex;
+	uint32_t m_version = 0U;
 };
 
 }
\ No newline at end of file
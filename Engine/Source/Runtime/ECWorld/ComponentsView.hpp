@@ -0,0 +1,116 @@
+#pragma once
+
+#include "ComponentsStorage.hpp"
+#include "Entity.h"
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace engine
+{
+
+// ComponentsView iterates over entities which own all of the queried component types.
+// Iteration is driven by the smallest storage and other storages are resolved by sparse set lookups.
+// Usage :
+// for (auto [entity, material, mesh, transform] : world.View<MaterialComponent, StaticMeshComponent, TransformComponent>())
+// world.View<MaterialComponent, StaticMeshComponent>().Each([](Entity entity, MaterialComponent& material, StaticMeshComponent& mesh) {});
+template<typename... Components>
+class ComponentsView
+{
+public:
+	static_assert(sizeof...(Components) > 0, "ComponentsView needs at least one component type.");
+
+	using StorageTuple = std::tuple<ComponentsStorage<Components>*...>;
+	using ValueType = std::tuple<Entity, Components&...>;
+
+	class Iterator
+	{
+	public:
+		Iterator(const ComponentsView* pView, size_t index) : m_pView(pView), m_index(index) { SkipInvalid(); }
+
+		ValueType operator*() const
+		{
+			Entity entity = (*m_pView->m_pDrivingEntities)[m_index];
+			return std::apply([entity](auto*... pComponent) { return ValueType(entity, *pComponent...); }, m_pCurrent);
+		}
+
+		Iterator& operator++() { ++m_index; SkipInvalid(); return *this; }
+		bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+		bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+
+	private:
+		void SkipInvalid()
+		{
+			const size_t entityCount = m_pView->GetDrivingEntityCount();
+			for (; m_index < entityCount; ++m_index)
+			{
+				Entity entity = (*m_pView->m_pDrivingEntities)[m_index];
+				m_pCurrent = m_pView->GetComponents(entity);
+				if (std::apply([](auto*... pComponent) { return ((pComponent != nullptr) && ...); }, m_pCurrent))
+				{
+					return;
+				}
+			}
+		}
+
+	private:
+		const ComponentsView* m_pView;
+		size_t m_index;
+		std::tuple<Components*...> m_pCurrent;
+	};
+
+public:
+	explicit ComponentsView(ComponentsStorage<Components>*... pStorages) :
+		m_storages(pStorages...)
+	{
+		// Pick the storage with the least entities to drive iteration.
+		std::apply([this](auto*... pStorage)
+		{
+			((m_pDrivingEntities = (!m_pDrivingEntities || pStorage->GetCount() < m_pDrivingEntities->size()) ? &pStorage->GetEntities() : m_pDrivingEntities), ...);
+		}, m_storages);
+	}
+
+	ComponentsView(const ComponentsView&) = default;
+	ComponentsView& operator=(const ComponentsView&) = default;
+	ComponentsView(ComponentsView&&) = default;
+	ComponentsView& operator=(ComponentsView&&) = default;
+	~ComponentsView() = default;
+
+	Iterator begin() const { return Iterator(this, 0); }
+	Iterator end() const { return Iterator(this, GetDrivingEntityCount()); }
+
+	// Count of entities to visit. It is an upper bound of the entities which own all queried components.
+	size_t GetDrivingEntityCount() const { return m_pDrivingEntities->size(); }
+
+	// Calls func(Entity, Components&...) for every matched entity.
+	template<typename Func>
+	void Each(Func&& func) const
+	{
+		const std::vector<Entity>& drivingEntities = *m_pDrivingEntities;
+		for (size_t index = 0; index < drivingEntities.size(); ++index)
+		{
+			Entity entity = drivingEntities[index];
+			std::tuple<Components*...> pComponents = GetComponents(entity);
+			std::apply([&func, entity](auto*... pComponent)
+			{
+				if (((pComponent != nullptr) && ...))
+				{
+					func(entity, *pComponent...);
+				}
+			}, pComponents);
+		}
+	}
+
+private:
+	std::tuple<Components*...> GetComponents(Entity entity) const
+	{
+		return std::apply([entity](auto*... pStorage) { return std::make_tuple(pStorage->GetComponent(entity)...); }, m_storages);
+	}
+
+private:
+	StorageTuple m_storages;
+	const std::vector<Entity>* m_pDrivingEntities = nullptr;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "FrustumCuller.h"
+
+#include "Core/Jobs/JobSystem.h"
+#include "ECWorld/CameraComponent.h"
+#include "ECWorld/SceneBVH.h"
+#include "ECWorld/StaticMeshComponent.h"
+#include "ECWorld/TransformComponent.h"
+
+#include <atomic>
+
+namespace engine
+{
+
+namespace
+{
+
+// Reused by CullRange in every thread to avoid allocations per frame.
+thread_local FrustumCullingBatch t_cullingBatch;
+thread_local std::vector<uint32_t> t_batchDenseIndexes;
+thread_local std::vector<uint8_t> t_batchVisibilities;
+
+}
+
+FrustumCuller::FrustumCuller(ComponentsStorage<CameraComponent>* pCameraStorage,
+	ComponentsStorage<StaticMeshComponent>* pStaticMeshStorage, ComponentsStorage<TransformComponent>* pTransformStorage)
+	: m_pCameraStorage(pCameraStorage)
+	, m_pStaticMeshStorage(pStaticMeshStorage)
+	, m_pTransformStorage(pTransformStorage)
+{
+	assert(pCameraStorage && pStaticMeshStorage && pTransformStorage);
+}
+
+void FrustumCuller::Update(JobSystem* pJobSystem)
+{
+	const CameraComponent* pCameraComponent = m_pCameraStorage->GetComponent(m_cameraEntity);
+	const uint32_t meshCount = static_cast<uint32_t>(m_pStaticMeshStorage->GetCount());
+	if (!m_isEnable || !pCameraComponent)
+	{
+		m_visibilities.clear();
+		m_staticMeshVersion = UINT32_MAX;
+		m_visibleCount = meshCount;
+		m_culledCount = 0U;
+		m_occludedCount = 0U;
+		m_occluderCount = 0U;
+		return;
+	}
+
+	const cd::Matrix4x4 viewProjection = pCameraComponent->GetProjectionMatrix() * pCameraComponent->GetViewMatrix();
+	const bool homogeneousDepth = cd::NDCDepth::MinusOneToOne == pCameraComponent->GetNDCDepth();
+	m_frustum.Build(viewProjection, homogeneousDepth);
+
+	m_visibilities.resize(meshCount);
+	uint32_t visibleCount = 0U;
+	if (m_pSceneBVH)
+	{
+		visibleCount = CullBVH();
+	}
+	else if (pJobSystem)
+	{
+		std::atomic<uint32_t> parallelVisibleCount = 0U;
+		pJobSystem->ParallelFor(meshCount, CullBatchSize, [this, &parallelVisibleCount](uint32_t beginIndex, uint32_t endIndex)
+		{
+			parallelVisibleCount.fetch_add(CullRange(beginIndex, endIndex), std::memory_order_relaxed);
+		});
+		visibleCount = parallelVisibleCount.load();
+	}
+	else
+	{
+		visibleCount = CullRange(0U, meshCount);
+	}
+
+	m_occluderCount = 0U;
+	if (m_isOcclusionEnable && m_isSoftwareOcclusionEnable)
+	{
+		RasterizeOccluders(viewProjection, homogeneousDepth, pJobSystem);
+	}
+
+	uint32_t occludedCount = 0U;
+	if (m_isOcclusionEnable && m_hiZPyramid.IsValid())
+	{
+		if (pJobSystem)
+		{
+			std::atomic<uint32_t> parallelOccludedCount = 0U;
+			pJobSystem->ParallelFor(meshCount, CullBatchSize, [this, &parallelOccludedCount](uint32_t beginIndex, uint32_t endIndex)
+			{
+				parallelOccludedCount.fetch_add(OccludeRange(beginIndex, endIndex), std::memory_order_relaxed);
+			});
+			occludedCount = parallelOccludedCount.load();
+		}
+		else
+		{
+			occludedCount = OccludeRange(0U, meshCount);
+		}
+	}
+
+	m_staticMeshVersion = m_pStaticMeshStorage->GetVersion();
+	m_visibleCount = visibleCount - occludedCount;
+	m_culledCount = meshCount - visibleCount;
+	m_occludedCount = occludedCount;
+}
+
+void FrustumCuller::SetSoftwareOcclusionEnable(bool enable)
+{
+	// The pyramid of software occlusion is not for depths which renderers read back.
+	if (m_isSoftwareOcclusionEnable != enable)
+	{
+		m_hiZPyramid.Reset();
+	}
+	m_isSoftwareOcclusionEnable = enable;
+}
+
+bool FrustumCuller::IsVisible(Entity entity) const
+{
+	if (m_staticMeshVersion != m_pStaticMeshStorage->GetVersion())
+	{
+		return true;
+	}
+
+	uint32_t denseIndex = m_pStaticMeshStorage->GetDenseIndex(entity);
+	return ComponentsStorage<StaticMeshComponent>::InvalidIndex == denseIndex || m_visibilities[denseIndex];
+}
+
+bool FrustumCuller::IsVisible(const cd::Matrix4x4& worldMatrix, const cd::AABB& localAABB) const
+{
+	// Culling is disabled or there is no camera in last Update.
+	if (UINT32_MAX == m_staticMeshVersion || localAABB.IsEmpty())
+	{
+		return true;
+	}
+
+	cd::Vec3f center;
+	cd::Vec3f extents;
+	FrustumCullingBatch::TransformBox(worldMatrix, localAABB.Min(), localAABB.Max(), center, extents);
+	return m_frustum.Intersects(center, extents);
+}
+
+uint32_t FrustumCuller::CullRange(uint32_t beginIndex, uint32_t endIndex)
+{
+	const std::vector<Entity>& entities = m_pStaticMeshStorage->GetEntities();
+	const std::vector<StaticMeshComponent>& meshComponents = m_pStaticMeshStorage->GetDenseComponents();
+
+	t_cullingBatch.Clear();
+	t_batchDenseIndexes.clear();
+	uint32_t visibleCount = 0U;
+	for (uint32_t denseIndex = beginIndex; denseIndex < endIndex; ++denseIndex)
+	{
+		// Meshes without valid bounding boxes are never culled.
+		const cd::AABB& aabb = meshComponents[denseIndex].GetAABB();
+		if (aabb.IsEmpty())
+		{
+			m_visibilities[denseIndex] = 1U;
+			++visibleCount;
+			continue;
+		}
+
+		// Entities without TransformComponent are in world space already.
+		const TransformComponent* pTransformComponent = m_pTransformStorage->GetComponent(entities[denseIndex]);
+		t_cullingBatch.Add(pTransformComponent ? pTransformComponent->GetWorldMatrix() : cd::Matrix4x4::Identity(), aabb.Min(), aabb.Max());
+		t_batchDenseIndexes.push_back(denseIndex);
+	}
+
+	const uint32_t batchCount = t_cullingBatch.GetCount();
+	t_batchVisibilities.resize(batchCount);
+	visibleCount += t_cullingBatch.Cull(m_frustum, t_batchVisibilities.data());
+	for (uint32_t batchIndex = 0U; batchIndex < batchCount; ++batchIndex)
+	{
+		m_visibilities[t_batchDenseIndexes[batchIndex]] = t_batchVisibilities[batchIndex];
+	}
+
+	return visibleCount;
+}
+
+uint32_t FrustumCuller::CullBVH()
+{
+	// Meshes without valid bounding boxes are not in BVH and never culled.
+	uint32_t visibleCount = 0U;
+	const std::vector<StaticMeshComponent>& meshComponents = m_pStaticMeshStorage->GetDenseComponents();
+	for (uint32_t denseIndex = 0U; denseIndex < meshComponents.size(); ++denseIndex)
+	{
+		m_visibilities[denseIndex] = meshComponents[denseIndex].GetAABB().IsEmpty() ? 1U : 0U;
+		visibleCount += m_visibilities[denseIndex];
+	}
+
+	m_visibleEntities.clear();
+	m_pSceneBVH->GetBVH().QueryFrustum(m_frustum, m_visibleEntities);
+	for (Entity entity : m_visibleEntities)
+	{
+		uint32_t denseIndex = m_pStaticMeshStorage->GetDenseIndex(entity);
+		if (ComponentsStorage<StaticMeshComponent>::InvalidIndex != denseIndex && !m_visibilities[denseIndex])
+		{
+			m_visibilities[denseIndex] = 1U;
+			++visibleCount;
+		}
+	}
+
+	return visibleCount;
+}
+
+
+uint32_t FrustumCuller::OccludeRange(uint32_t beginIndex, uint32_t endIndex)
+{
+	const std::vector<Entity>& entities = m_pStaticMeshStorage->GetEntities();
+	const std::vector<StaticMeshComponent>& meshComponents = m_pStaticMeshStorage->GetDenseComponents();
+
+	uint32_t occludedCount = 0U;
+	for (uint32_t denseIndex = beginIndex; denseIndex < endIndex; ++denseIndex)
+	{
+		// Meshes without valid bounding boxes are never occluded.
+		const cd::AABB& aabb = meshComponents[denseIndex].GetAABB();
+		if (!m_visibilities[denseIndex] || aabb.IsEmpty())
+		{
+			continue;
+		}
+
+		const TransformComponent* pTransformComponent = m_pTransformStorage->GetComponent(entities[denseIndex]);
+		cd::Vec3f center = cd::Vec3f::Zero();
+		cd::Vec3f extents = cd::Vec3f::Zero();
+		FrustumCullingBatch::TransformBox(pTransformComponent ? pTransformComponent->GetWorldMatrix() : cd::Matrix4x4::Identity(),
+			aabb.Min(), aabb.Max(), center, extents);
+		if (m_hiZPyramid.IsOccluded(center, extents))
+		{
+			m_visibilities[denseIndex] = 0U;
+			++occludedCount;
+		}
+	}
+
+	return occludedCount;
+}
+
+void FrustumCuller::RasterizeOccluders(const cd::Matrix4x4& viewProjection, bool homogeneousDepth, JobSystem* pJobSystem)
+{
+	static_assert(sizeof(cd::Polygon) == 3 * sizeof(uint32_t), "Polygons should be tightly packed 32 bits indexes.");
+
+	const std::vector<Entity>& entities = m_pStaticMeshStorage->GetEntities();
+	const std::vector<StaticMeshComponent>& meshComponents = m_pStaticMeshStorage->GetDenseComponents();
+	const float minSizeSquare = m_occluderMinSize * m_occluderMinSize;
+
+	// Occluders outside the frustum can't hide anything inside it.
+	m_occlusionRasterizer.Begin(SoftwareOcclusionWidth, SoftwareOcclusionHeight, viewProjection, homogeneousDepth);
+	for (uint32_t denseIndex = 0U; denseIndex < meshComponents.size(); ++denseIndex)
+	{
+		const StaticMeshComponent& meshComponent = meshComponents[denseIndex];
+		const cd::Mesh* pMeshData = meshComponent.GetMeshData();
+		if (!m_visibilities[denseIndex] || !pMeshData || meshComponent.GetAABB().IsEmpty())
+		{
+			continue;
+		}
+
+		const TransformComponent* pTransformComponent = m_pTransformStorage->GetComponent(entities[denseIndex]);
+		const cd::Matrix4x4 worldMatrix = pTransformComponent ? pTransformComponent->GetWorldMatrix() : cd::Matrix4x4::Identity();
+		if (!meshComponent.IsOccluder())
+		{
+			if (m_occluderMinSize <= 0.0f)
+			{
+				continue;
+			}
+
+			cd::Vec3f center = cd::Vec3f::Zero();
+			cd::Vec3f extents = cd::Vec3f::Zero();
+			FrustumCullingBatch::TransformBox(worldMatrix, meshComponent.GetAABB().Min(), meshComponent.GetAABB().Max(), center, extents);
+			if (4.0f * (extents.x() * extents.x() + extents.y() * extents.y() + extents.z() * extents.z()) < minSizeSquare)
+			{
+				continue;
+			}
+		}
+
+		const std::vector<cd::Point>& positions = pMeshData->GetVertexPositions();
+		const std::vector<cd::Polygon>& polygons = pMeshData->GetPolygons();
+		m_occlusionRasterizer.AddOccluder(worldMatrix, positions.data(), static_cast<uint32_t>(positions.size()),
+			reinterpret_cast<const uint32_t*>(polygons.data()), static_cast<uint32_t>(polygons.size()) * 3U);
+		++m_occluderCount;
+	}
+
+	// Bands don't share depths so that every job rasterizes all triangles into its own rows.
+	const uint32_t bandCount = m_occlusionRasterizer.GetBandCount();
+	if (pJobSystem)
+	{
+		pJobSystem->ParallelFor(bandCount, 1U, [this](uint32_t beginBand, uint32_t endBand)
+		{
+			m_occlusionRasterizer.RasterizeBands(beginBand, endBand);
+		});
+	}
+	else
+	{
+		m_occlusionRasterizer.RasterizeBands(0U, bandCount);
+	}
+
+	m_occlusionRasterizer.BuildHiZPyramid(m_hiZPyramid);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Core/Math/FrustumCulling.h"
+#include "Core/Math/HiZPyramid.h"
+#include "Core/Math/OcclusionRasterizer.h"
+#include "ECWorld/ComponentsStorage.hpp"
+#include "ECWorld/Entity.h"
+#include "Math/Box.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class CameraComponent;
+class JobSystem;
+class SceneBVH;
+class StaticMeshComponent;
+class TransformComponent;
+
+// FrustumCuller tests world space AABBs of static meshes against the camera's frustum once per frame
+// so that renderers only submit visible entities. It runs after TransformHierarchy to use up-to-date world matrices.
+// With a SceneBVH, subtrees outside or inside the frustum are skipped. Otherwise all boxes are tested linearly.
+// Boxes inside the frustum are tested against a HiZPyramid at last if occlusion culling is enabled and the pyramid is valid.
+// With software occlusion, the pyramid is rebuilt every frame from occluders rasterized on CPU instead of depths of renderers.
+class FrustumCuller final
+{
+public:
+	// Static meshes count of a job to cull in SIMD batches.
+	static constexpr uint32_t CullBatchSize = 4096;
+
+	// Depth buffer size of software occlusion which is independent of the back buffer.
+	static constexpr uint32_t SoftwareOcclusionWidth = 256;
+	static constexpr uint32_t SoftwareOcclusionHeight = 128;
+
+public:
+	FrustumCuller() = delete;
+	explicit FrustumCuller(ComponentsStorage<CameraComponent>* pCameraStorage,
+		ComponentsStorage<StaticMeshComponent>* pStaticMeshStorage, ComponentsStorage<TransformComponent>* pTransformStorage);
+	FrustumCuller(const FrustumCuller&) = delete;
+	FrustumCuller& operator=(const FrustumCuller&) = delete;
+	FrustumCuller(FrustumCuller&&) = default;
+	FrustumCuller& operator=(FrustumCuller&&) = default;
+	~FrustumCuller() = default;
+
+	void SetCameraEntity(Entity entity) { m_cameraEntity = entity; }
+	Entity GetCameraEntity() const { return m_cameraEntity; }
+
+	// SceneBVH should be updated before culling.
+	void SetSceneBVH(const SceneBVH* pSceneBVH) { m_pSceneBVH = pSceneBVH; }
+	const SceneBVH* GetSceneBVH() const { return m_pSceneBVH; }
+
+	// Every entity is visible when culling is disabled.
+	void SetEnable(bool enable) { m_isEnable = enable; }
+	bool IsEnable() const { return m_isEnable; }
+
+	// The pyramid is built from depths of previous frames by renderers, e.g. HiZRenderer.
+	// Entities hidden by it are skipped so that newly disoccluded entities may appear some frames later.
+	void SetOcclusionEnable(bool enable) { m_isOcclusionEnable = enable; }
+	bool IsOcclusionEnable() const { return m_isOcclusionEnable; }
+	HiZPyramid& GetHiZPyramid() { return m_hiZPyramid; }
+	const HiZPyramid& GetHiZPyramid() const { return m_hiZPyramid; }
+
+	// Occluders are visible static meshes which are flagged on StaticMeshComponent or whose world space boxes' diagonals
+	// are not shorter than occluder min size. Size 0 only selects flagged meshes. It is for targets which can't read GPU depths back.
+	void SetSoftwareOcclusionEnable(bool enable);
+	bool IsSoftwareOcclusionEnable() const { return m_isSoftwareOcclusionEnable; }
+	void SetOccluderMinSize(float size) { m_occluderMinSize = size; }
+	float GetOccluderMinSize() const { return m_occluderMinSize; }
+	const OcclusionRasterizer& GetOcclusionRasterizer() const { return m_occlusionRasterizer; }
+
+	// pJobSystem is optional. Cull serially if it is nullptr.
+	void Update(JobSystem* pJobSystem = nullptr);
+
+	// Entities which are created after last Update or don't have StaticMeshComponent are treated as visible.
+	bool IsVisible(Entity entity) const;
+
+	// For meshes which are not in the static mesh storage, e.g. in StaticMeshArchetype. Their boxes are tested against
+	// the frustum of last Update without occlusion. Empty boxes are visible.
+	bool IsVisible(const cd::Matrix4x4& worldMatrix, const cd::AABB& localAABB) const;
+
+	const Frustum& GetFrustum() const { return m_frustum; }
+	uint32_t GetVisibleCount() const { return m_visibleCount; }
+	uint32_t GetCulledCount() const { return m_culledCount; }
+	uint32_t GetOccludedCount() const { return m_occludedCount; }
+	uint32_t GetOccluderCount() const { return m_occluderCount; }
+
+private:
+	uint32_t CullRange(uint32_t beginIndex, uint32_t endIndex);
+	uint32_t CullBVH();
+	uint32_t OccludeRange(uint32_t beginIndex, uint32_t endIndex);
+	void RasterizeOccluders(const cd::Matrix4x4& viewProjection, bool homogeneousDepth, JobSystem* pJobSystem);
+
+private:
+	ComponentsStorage<CameraComponent>* m_pCameraStorage;
+	ComponentsStorage<StaticMeshComponent>* m_pStaticMeshStorage;
+	ComponentsStorage<TransformComponent>* m_pTransformStorage;
+	const SceneBVH* m_pSceneBVH = nullptr;
+	Entity m_cameraEntity = INVALID_ENTITY;
+	bool m_isEnable = true;
+	bool m_isOcclusionEnable = true;
+	bool m_isSoftwareOcclusionEnable = false;
+	float m_occluderMinSize = 0.0f;
+
+	Frustum m_frustum;
+	HiZPyramid m_hiZPyramid;
+	OcclusionRasterizer m_occlusionRasterizer;
+
+	// Indexed by dense indexes of static mesh storage which are valid until its version changes.
+	std::vector<uint8_t> m_visibilities;
+	uint32_t m_staticMeshVersion = UINT32_MAX;
+	std::vector<Entity> m_visibleEntities;
+
+	uint32_t m_visibleCount = 0U;
+	uint32_t m_culledCount = 0U;
+	uint32_t m_occludedCount = 0U;
+	uint32_t m_occluderCount = 0U;
+};
+
+}
\ No newline at end of file
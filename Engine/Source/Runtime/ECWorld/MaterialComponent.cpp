@@ -141,21 +141,38 @@ const MaterialComponent::TextureInfo* MaterialComponent::GetTextureInfo(cd::Mate
 void MaterialComponent::ActiveUberShaderOption(engine::Uber option)
 {
 	m_uberShaderOptions.insert(option);
+	Dirty();
 }
 
 void MaterialComponent::DeactiveUberShaderOption(engine::Uber option)
 {
 	m_uberShaderOptions.erase(option);
+	Dirty();
 }
 
 void MaterialComponent::MatchUberShaderCrc()
 {
 	m_uberShaderCrc = m_pMaterialType->GetShaderSchema().GetOptionsCrc(m_uberShaderOptions);
+	Dirty();
 }
 
 uint16_t MaterialComponent::GetShadreProgram() const
 {
-	return m_pMaterialType->GetShaderSchema().GetCompiledProgram(m_uberShaderCrc);
+	const ShaderSchema& shaderSchema = m_pMaterialType->GetShaderSchema();
+	if (shaderSchema.IsProgramCompiled(m_uberShaderCrc))
+	{
+		return shaderSchema.GetCompiledProgram(m_uberShaderCrc);
+	}
+
+	// Variant is built and loaded on demand. Draw with the DEFAULT program until it is ready.
+	shaderSchema.RequestProgram(m_uberShaderCrc);
+	return shaderSchema.GetCompiledProgram(ShaderSchema::DefaultUberShaderCrc);
+}
+
+uint16_t MaterialComponent::GetInstanceShaderProgram() const
+{
+	const ShaderSchema& shaderSchema = m_pMaterialType->GetShaderSchema();
+	return shaderSchema.GetCompiledInstanceProgram(shaderSchema.IsProgramCompiled(m_uberShaderCrc) ? m_uberShaderCrc : ShaderSchema::DefaultUberShaderCrc);
 }
 
 void MaterialComponent::Reset()
@@ -174,6 +191,7 @@ void MaterialComponent::Reset()
 	m_alphaCutOff = 1.0f;
 	m_textureResources.clear();
 	m_skyType = SkyType::None;
+	Dirty();
 }
 
 void MaterialComponent::AddTextureBlob(cd::MaterialTextureType textureType, cd::TextureFormat textureFormat, cd::TextureMapMode uMapMode, cd::TextureMapMode vMapMode,
@@ -197,6 +215,7 @@ void MaterialComponent::AddTextureBlob(cd::MaterialTextureType textureType, cd::
 	textureInfo.uvOffset = cd::Vec2f::Zero();
 	textureInfo.uvScale = cd::Vec2f::One();
 	m_textureResources[textureType] = cd::MoveTemp(textureInfo);
+	Dirty();
 }
 
 void MaterialComponent::AddTextureFileBlob(cd::MaterialTextureType textureType, const cd::Material* pMaterial, const cd::Texture& texture, TextureBlob textureBlob)
@@ -226,6 +245,7 @@ void MaterialComponent::AddTextureFileBlob(cd::MaterialTextureType textureType,
 		textureInfo.uvOffset = optUVOffset.value();
 	}
 	m_textureResources[textureType] = cd::MoveTemp(textureInfo);
+	Dirty();
 }
 
 void MaterialComponent::Build()
@@ -247,6 +267,8 @@ void MaterialComponent::Build()
 		assert(textureInfo.textureHandle != bgfx::kInvalidHandle);
 		assert(textureInfo.samplerHandle != bgfx::kInvalidHandle);
 	}
+
+	Dirty();
 }
 
 void MaterialComponent::SetSkyType(SkyType crtType)
@@ -268,6 +290,7 @@ void MaterialComponent::SetSkyType(SkyType crtType)
 
 	m_uberShaderCrc = m_pMaterialType->GetShaderSchema().GetOptionsCrc(m_uberShaderOptions);
 	m_skyType = crtType;
+	Dirty();
 }
 
 }
\ No newline at end of file
@@ -81,7 +81,7 @@ public:
 	cd::Material* GetMaterialData() { return const_cast<cd::Material*>(m_pMaterialData); }
 	const cd::Material* GetMaterialData() const { return m_pMaterialData; }
 
-	void SetMaterialType(const engine::MaterialType* pMaterialType) { m_pMaterialType = pMaterialType; }
+	void SetMaterialType(const engine::MaterialType* pMaterialType) { m_pMaterialType = pMaterialType; Dirty(); }
 	const engine::MaterialType* GetMaterialType() const { return m_pMaterialType; }
 
 	void Reset();
@@ -99,7 +99,9 @@ public:
 	void SetUberShaderOptions(std::unordered_set<engine::Uber> options) { m_uberShaderOptions = cd::MoveTemp(m_uberShaderOptions); }
 	const std::unordered_set<engine::Uber>& GetUberShaderOptions() const { return m_uberShaderOptions; }
 	std::unordered_set<engine::Uber>& GetUberShaderOptions() { return m_uberShaderOptions; }
+	// Returns the DEFAULT program and requests the variant if it is not loaded. Call it in the main thread.
 	uint16_t GetShadreProgram() const;
+	uint16_t GetInstanceShaderProgram() const;
 
 	// Texture data.
 	void AddTextureBlob(cd::MaterialTextureType textureType, cd::TextureFormat textureFormat, cd::TextureMapMode uMapMode, cd::TextureMapMode vMapMode, TextureBlob textureBlob, uint32_t width, uint32_t height, uint32_t depth = 1);
@@ -109,33 +111,33 @@ public:
 	TextureInfo* GetTextureInfo(cd::MaterialTextureType textureType);
 	const TextureInfo* GetTextureInfo(cd::MaterialTextureType textureType) const;
 
-	void SetAlbedoColor(cd::Vec3f color) { m_albedoColor = cd::MoveTemp(color); }
+	void SetAlbedoColor(cd::Vec3f color) { m_albedoColor = cd::MoveTemp(color); Dirty(); }
 	cd::Vec3f& GetAlbedoColor() { return m_albedoColor; }
 	const cd::Vec3f& GetAlbedoColor() const { return m_albedoColor; }
 
-	void SetMetallicFactor(float factor) { m_metallicFactor = factor; }
+	void SetMetallicFactor(float factor) { m_metallicFactor = factor; Dirty(); }
 	float& GetMetallicFactor() { return m_metallicFactor; }
 	float GetMetallicFactor() const { return m_metallicFactor; }
 
-	void SetRoughnessFactor(float factor) { m_roughnessFactor = factor; }
+	void SetRoughnessFactor(float factor) { m_roughnessFactor = factor; Dirty(); }
 	float& GetRoughnessFactor() { return m_roughnessFactor; }
 	float GetRoughnessFactor() const { return m_roughnessFactor; }
 
-	void SetEmissiveColor(cd::Vec3f color) { m_emissiveColor = cd::MoveTemp(color); }
+	void SetEmissiveColor(cd::Vec3f color) { m_emissiveColor = cd::MoveTemp(color); Dirty(); }
 	cd::Vec3f& GetEmissiveColor() { return m_emissiveColor; }
 	const cd::Vec3f& GetEmissiveColor() const { return m_emissiveColor; }
 
 	// Cull parameters. 
-	void SetTwoSided(bool value) { m_twoSided = value; }
+	void SetTwoSided(bool value) { m_twoSided = value; Dirty(); }
 	bool& GetTwoSided() { return m_twoSided; }
 	bool GetTwoSided() const { return m_twoSided; }
 
 	// Blend parameters.
-	void SetBlendMode(cd::BlendMode blendMode) { m_blendMode = blendMode; }
+	void SetBlendMode(cd::BlendMode blendMode) { m_blendMode = blendMode; Dirty(); }
 	cd::BlendMode& GetBlendMode() { return m_blendMode; }
 	cd::BlendMode GetBlendMode() const { return m_blendMode; }
 
-	void SetAlphaCutOff(float value) { m_alphaCutOff = value; }
+	void SetAlphaCutOff(float value) { m_alphaCutOff = value; Dirty(); }
 	float& GetAlphaCutOff() { return m_alphaCutOff; }
 	float GetAlphaCutOff() const { return m_alphaCutOff; }
 
@@ -144,6 +146,11 @@ public:
 	const SkyType GetSkyType() const { return m_skyType; }
 	SkyType GetSkyType() { return m_skyType; }
 
+	// Increased when any rendering data changes so that render proxies can skip unchanged materials.
+	// Setters increase it automatically. Call Dirty() after writing through non-const getters.
+	void Dirty() { ++m_version; }
+	uint32_t GetVersion() const { return m_version; }
+
 private:
 	// Input
 	const cd::Material* m_pMaterialData = nullptr;
@@ -161,6 +168,7 @@ private:
 	float m_alphaCutOff;
 
 	SkyType m_skyType;
+	uint32_t m_version = 0U;
 
 	// Output
 	std::map<cd::MaterialTextureType, TextureInfo> m_textureResources;
@@ -0,0 +1,137 @@
+#include "MeshLODSelector.h"
+
+#include "Core/Jobs/JobSystem.h"
+#include "ECWorld/CameraComponent.h"
+#include "ECWorld/StaticMeshComponent.h"
+#include "ECWorld/TransformComponent.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace engine
+{
+
+MeshLODSelector::MeshLODSelector(ComponentsStorage<CameraComponent>* pCameraStorage,
+	ComponentsStorage<StaticMeshComponent>* pStaticMeshStorage, ComponentsStorage<TransformComponent>* pTransformStorage)
+	: m_pCameraStorage(pCameraStorage)
+	, m_pStaticMeshStorage(pStaticMeshStorage)
+	, m_pTransformStorage(pTransformStorage)
+{
+	assert(pCameraStorage && pStaticMeshStorage && pTransformStorage);
+}
+
+uint32_t MeshLODSelector::SelectLOD(const float* pLODErrors, uint32_t lodCount, float worldScale, float distance, float projectionScaleY, float maxScreenError)
+{
+	if (lodCount <= 1U || distance <= 0.0f)
+	{
+		return 0U;
+	}
+
+	// NDC height is 2 so that a world space length l at the distance covers l * projectionScaleY / (2 * distance) of the viewport.
+	const float maxLODError = maxScreenError * 2.0f * distance / (projectionScaleY * worldScale);
+	uint32_t lod = 0U;
+	while (lod + 1U < lodCount && pLODErrors[lod + 1U] <= maxLODError)
+	{
+		++lod;
+	}
+	return lod;
+}
+
+void MeshLODSelector::Update(JobSystem* pJobSystem)
+{
+	const CameraComponent* pCameraComponent = m_pCameraStorage->GetComponent(m_cameraEntity);
+	const uint32_t meshCount = static_cast<uint32_t>(m_pStaticMeshStorage->GetCount());
+	std::fill(std::begin(m_lodMeshCounts), std::end(m_lodMeshCounts), 0U);
+	if (!m_isEnable || !pCameraComponent)
+	{
+		m_lods.clear();
+		m_staticMeshVersion = UINT32_MAX;
+		m_lodMeshCounts[0] = meshCount;
+		return;
+	}
+
+	m_viewMatrix = pCameraComponent->GetViewMatrix();
+	m_projectionScaleY = pCameraComponent->GetProjectionMatrix().Begin()[5];
+	m_lods.resize(meshCount);
+	if (pJobSystem)
+	{
+		pJobSystem->ParallelFor(meshCount, SelectBatchSize, [this](uint32_t beginIndex, uint32_t endIndex)
+		{
+			SelectRange(beginIndex, endIndex);
+		});
+	}
+	else
+	{
+		SelectRange(0U, meshCount);
+	}
+
+	for (uint8_t lod : m_lods)
+	{
+		++m_lodMeshCounts[lod];
+	}
+	m_staticMeshVersion = m_pStaticMeshStorage->GetVersion();
+}
+
+uint32_t MeshLODSelector::GetLOD(Entity entity) const
+{
+	uint32_t denseIndex = m_pStaticMeshStorage->GetDenseIndex(entity);
+	return ComponentsStorage<StaticMeshComponent>::InvalidIndex == denseIndex ? 0U : GetLODByDenseIndex(denseIndex);
+}
+
+uint32_t MeshLODSelector::GetLODByDenseIndex(uint32_t denseIndex) const
+{
+	return m_staticMeshVersion == m_pStaticMeshStorage->GetVersion() ? m_lods[denseIndex] : 0U;
+}
+
+uint32_t MeshLODSelector::SelectLOD(const StaticMeshComponent& meshComponent, const cd::Matrix4x4& worldMatrix) const
+{
+	// Selection is disabled or there is no camera in last Update.
+	return UINT32_MAX == m_staticMeshVersion ? 0U : SelectMeshLOD(meshComponent, worldMatrix);
+}
+
+void MeshLODSelector::SelectRange(uint32_t beginIndex, uint32_t endIndex)
+{
+	const std::vector<Entity>& entities = m_pStaticMeshStorage->GetEntities();
+	const std::vector<StaticMeshComponent>& meshComponents = m_pStaticMeshStorage->GetDenseComponents();
+	for (uint32_t denseIndex = beginIndex; denseIndex < endIndex; ++denseIndex)
+	{
+		// Entities without TransformComponent are in world space already.
+		const TransformComponent* pTransformComponent = m_pTransformStorage->GetComponent(entities[denseIndex]);
+		const cd::Matrix4x4& worldMatrix = pTransformComponent ? pTransformComponent->GetWorldMatrix() : cd::Matrix4x4::Identity();
+		m_lods[denseIndex] = static_cast<uint8_t>(SelectMeshLOD(meshComponents[denseIndex], worldMatrix));
+	}
+}
+
+uint32_t MeshLODSelector::SelectMeshLOD(const StaticMeshComponent& meshComponent, const cd::Matrix4x4& worldMatrix) const
+{
+	// Meshes without LODs or valid bounding boxes always use LOD 0.
+	const cd::AABB& aabb = meshComponent.GetAABB();
+	if (meshComponent.GetLODCount() <= 1U || aabb.IsEmpty())
+	{
+		return 0U;
+	}
+
+	// Matrices are column major.
+	const float* pWorld = worldMatrix.Begin();
+	float worldScale = 0.0f;
+	for (uint32_t column = 0U; column < 3U; ++column)
+	{
+		const float* pAxis = pWorld + column * 4U;
+		worldScale = std::max(worldScale, pAxis[0] * pAxis[0] + pAxis[1] * pAxis[1] + pAxis[2] * pAxis[2]);
+	}
+	worldScale = std::sqrt(worldScale);
+
+	const cd::Vec3f localCenter = aabb.Center();
+	float worldCenter[3];
+	for (uint32_t axis = 0U; axis < 3U; ++axis)
+	{
+		worldCenter[axis] = pWorld[axis] * localCenter.x() + pWorld[4 + axis] * localCenter.y() + pWorld[8 + axis] * localCenter.z() + pWorld[12 + axis];
+	}
+
+	const float* pView = m_viewMatrix.Begin();
+	const float worldRadius = (aabb.Max() - localCenter).Length() * worldScale;
+	const float viewDepth = pView[2] * worldCenter[0] + pView[6] * worldCenter[1] + pView[10] * worldCenter[2] + pView[14];
+	return SelectLOD(meshComponent.GetLODErrors(), meshComponent.GetLODCount(), worldScale, viewDepth - worldRadius, m_projectionScaleY, m_maxScreenError);
+}
+
+}
\ No newline at end of file
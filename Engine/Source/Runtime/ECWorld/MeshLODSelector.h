@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Core/Math/MeshSimplifier.h"
+#include "ECWorld/ComponentsStorage.hpp"
+#include "ECWorld/Entity.h"
+#include "Math/Matrix.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class CameraComponent;
+class JobSystem;
+class StaticMeshComponent;
+class TransformComponent;
+
+// MeshLODSelector picks a LOD of every static mesh once per frame by the projected size of its error on the camera's screen.
+// The coarsest LOD whose error covers not more than max screen error of the viewport height is used so that switches are hard to see.
+// It runs after TransformHierarchy to use up-to-date world matrices.
+class MeshLODSelector final
+{
+public:
+	// Static meshes count of a job to select LODs.
+	static constexpr uint32_t SelectBatchSize = 4096;
+
+	// About one pixel of a 1080p viewport.
+	static constexpr float DefaultMaxScreenError = 1.0f / 1080.0f;
+
+public:
+	MeshLODSelector() = delete;
+	explicit MeshLODSelector(ComponentsStorage<CameraComponent>* pCameraStorage,
+		ComponentsStorage<StaticMeshComponent>* pStaticMeshStorage, ComponentsStorage<TransformComponent>* pTransformStorage);
+	MeshLODSelector(const MeshLODSelector&) = delete;
+	MeshLODSelector& operator=(const MeshLODSelector&) = delete;
+	MeshLODSelector(MeshLODSelector&&) = default;
+	MeshLODSelector& operator=(MeshLODSelector&&) = default;
+	~MeshLODSelector() = default;
+
+	// Returns the coarsest LOD whose error is not larger than maxScreenError in fractions of the viewport height.
+	// worldScale scales mesh space errors to world space. distance is the view depth of the nearest point of the mesh's bounds.
+	// projectionScaleY is the [1][1] element of the projection matrix. LOD 0 is used when the camera is inside the bounds.
+	static uint32_t SelectLOD(const float* pLODErrors, uint32_t lodCount, float worldScale, float distance, float projectionScaleY, float maxScreenError);
+
+	void SetCameraEntity(Entity entity) { m_cameraEntity = entity; }
+	Entity GetCameraEntity() const { return m_cameraEntity; }
+
+	// Every mesh uses LOD 0 when selection is disabled.
+	void SetEnable(bool enable) { m_isEnable = enable; }
+	bool IsEnable() const { return m_isEnable; }
+
+	void SetMaxScreenError(float error) { m_maxScreenError = error; }
+	float GetMaxScreenError() const { return m_maxScreenError; }
+
+	// pJobSystem is optional. Select serially if it is nullptr.
+	void Update(JobSystem* pJobSystem = nullptr);
+
+	// Meshes which are created after last Update use LOD 0.
+	uint32_t GetLOD(Entity entity) const;
+	uint32_t GetLODByDenseIndex(uint32_t denseIndex) const;
+
+	// For meshes which are not in the static mesh storage, e.g. in StaticMeshArchetype. It uses the camera of last Update.
+	uint32_t SelectLOD(const StaticMeshComponent& meshComponent, const cd::Matrix4x4& worldMatrix) const;
+
+	// Count of meshes which use the LOD in last Update.
+	uint32_t GetLODMeshCount(uint32_t lod) const { return m_lodMeshCounts[lod]; }
+
+private:
+	void SelectRange(uint32_t beginIndex, uint32_t endIndex);
+	uint32_t SelectMeshLOD(const StaticMeshComponent& meshComponent, const cd::Matrix4x4& worldMatrix) const;
+
+private:
+	ComponentsStorage<CameraComponent>* m_pCameraStorage;
+	ComponentsStorage<StaticMeshComponent>* m_pStaticMeshStorage;
+	ComponentsStorage<TransformComponent>* m_pTransformStorage;
+	Entity m_cameraEntity = INVALID_ENTITY;
+	bool m_isEnable = true;
+	float m_maxScreenError = DefaultMaxScreenError;
+
+	// Camera of last Update.
+	cd::Matrix4x4 m_viewMatrix = cd::Matrix4x4::Identity();
+	float m_projectionScaleY = 1.0f;
+
+	// Indexed by dense indexes of static mesh storage which are valid until its version changes.
+	std::vector<uint8_t> m_lods;
+	uint32_t m_staticMeshVersion = UINT32_MAX;
+	uint32_t m_lodMeshCounts[MeshLODSettings::MaxLODCount] = {};
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "SceneBVH.h"
+
+#include "ECWorld/StaticMeshComponent.h"
+#include "ECWorld/TransformComponent.h"
+
+namespace engine
+{
+
+SceneBVH::SceneBVH(ComponentsStorage<StaticMeshComponent>* pStaticMeshStorage, ComponentsStorage<TransformComponent>* pTransformStorage)
+	: m_pStaticMeshStorage(pStaticMeshStorage)
+	, m_pTransformStorage(pTransformStorage)
+{
+	assert(pStaticMeshStorage && pTransformStorage);
+}
+
+void SceneBVH::Update()
+{
+	m_refittedCount = 0U;
+	m_reinsertedCount = 0U;
+
+	// Components are created or removed so that every proxy is checked again.
+	const bool isEntitySetChanged = m_staticMeshVersion != m_pStaticMeshStorage->GetVersion() ||
+		m_transformVersion != m_pTransformStorage->GetVersion();
+	if (isEntitySetChanged)
+	{
+		for (uint32_t proxyIndex = 0U; proxyIndex < m_proxyEntities.size(); ++proxyIndex)
+		{
+			Entity entity = m_proxyEntities[proxyIndex];
+			if (INVALID_ENTITY != entity && !m_pStaticMeshStorage->Contains(entity))
+			{
+				m_bvh.DestroyProxy(proxyIndex);
+				m_entityToProxy.Reset(entity);
+				m_proxyEntities[proxyIndex] = INVALID_ENTITY;
+			}
+		}
+	}
+
+	const std::vector<Entity>& entities = m_pStaticMeshStorage->GetEntities();
+	const std::vector<StaticMeshComponent>& meshComponents = m_pStaticMeshStorage->GetDenseComponents();
+	for (uint32_t denseIndex = 0U; denseIndex < entities.size(); ++denseIndex)
+	{
+		Entity entity = entities[denseIndex];
+		uint32_t proxyIndex = m_entityToProxy.Get(entity);
+		const cd::AABB& aabb = meshComponents[denseIndex].GetAABB();
+		if (aabb.IsEmpty())
+		{
+			if (SparseEntityIndex::InvalidIndex != proxyIndex)
+			{
+				m_bvh.DestroyProxy(proxyIndex);
+				m_entityToProxy.Reset(entity);
+				m_proxyEntities[proxyIndex] = INVALID_ENTITY;
+			}
+			continue;
+		}
+
+		const TransformComponent* pTransformComponent = m_pTransformStorage->GetComponent(entity);
+		uint32_t worldMatrixVersion = pTransformComponent ? pTransformComponent->GetWorldMatrixVersion() : InvalidVersion;
+		if (SparseEntityIndex::InvalidIndex != proxyIndex && !isEntitySetChanged &&
+			worldMatrixVersion == m_proxyWorldMatrixVersions[proxyIndex])
+		{
+			continue;
+		}
+
+		// Entities without TransformComponent are in world space already.
+		cd::AABB worldAABB = pTransformComponent ? aabb.Transform(pTransformComponent->GetWorldMatrix()) : aabb;
+		if (SparseEntityIndex::InvalidIndex == proxyIndex)
+		{
+			proxyIndex = m_bvh.CreateProxy(worldAABB, entity);
+			m_entityToProxy.Set(entity, proxyIndex);
+			if (proxyIndex >= m_proxyEntities.size())
+			{
+				m_proxyEntities.resize(proxyIndex + 1U, INVALID_ENTITY);
+				m_proxyWorldMatrixVersions.resize(proxyIndex + 1U, InvalidVersion);
+			}
+			m_proxyEntities[proxyIndex] = entity;
+			++m_reinsertedCount;
+		}
+		else if (m_bvh.MoveProxy(proxyIndex, worldAABB))
+		{
+			++m_reinsertedCount;
+		}
+		else
+		{
+			++m_refittedCount;
+		}
+
+		m_proxyWorldMatrixVersions[proxyIndex] = worldMatrixVersion;
+	}
+
+	m_staticMeshVersion = m_pStaticMeshStorage->GetVersion();
+	m_transformVersion = m_pTransformStorage->GetVersion();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Core/StringCrc.h"
+#include "ECWorld/ComponentsStorage.hpp"
+#include "ECWorld/Entity.h"
+#include "ECWorld/SparseEntityIndex.hpp"
+#include "Spatial/DynamicBVH.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class StaticMeshComponent;
+class TransformComponent;
+
+// SceneBVH keeps a DynamicBVH of static meshes' world space AABBs in sync with the ECWorld.
+// Proxies are only refitted for entities whose world matrices changed after last Update.
+// Meshes without valid bounding boxes are not in the tree.
+class SceneBVH final
+{
+public:
+	// Systems declare accesses to SceneBVH by it so that queries run after Update.
+	static constexpr StringCrc GetClassName()
+	{
+		constexpr StringCrc className("SceneBVH");
+		return className;
+	}
+
+	static constexpr uint32_t InvalidVersion = UINT32_MAX;
+
+public:
+	SceneBVH() = delete;
+	explicit SceneBVH(ComponentsStorage<StaticMeshComponent>* pStaticMeshStorage, ComponentsStorage<TransformComponent>* pTransformStorage);
+	SceneBVH(const SceneBVH&) = delete;
+	SceneBVH& operator=(const SceneBVH&) = delete;
+	SceneBVH(SceneBVH&&) = default;
+	SceneBVH& operator=(SceneBVH&&) = default;
+	~SceneBVH() = default;
+
+	void Update();
+
+	const DynamicBVH& GetBVH() const { return m_bvh; }
+
+	// Counts of proxies whose boxes are updated or reinserted by last Update.
+	uint32_t GetRefittedCount() const { return m_refittedCount; }
+	uint32_t GetReinsertedCount() const { return m_reinsertedCount; }
+
+private:
+	ComponentsStorage<StaticMeshComponent>* m_pStaticMeshStorage;
+	ComponentsStorage<TransformComponent>* m_pTransformStorage;
+	uint32_t m_staticMeshVersion = InvalidVersion;
+	uint32_t m_transformVersion = InvalidVersion;
+
+	DynamicBVH m_bvh;
+	SparseEntityIndex m_entityToProxy;
+
+	// Indexed by proxy index. Entities are kept to remove proxies of deleted components.
+	std::vector<Entity> m_proxyEntities;
+	std::vector<uint32_t> m_proxyWorldMatrixVersions;
+
+	uint32_t m_refittedCount = 0U;
+	uint32_t m_reinsertedCount = 0U;
+};
+
+}
\ No newline at end of file
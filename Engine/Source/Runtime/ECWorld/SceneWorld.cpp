@@ -1,5 +1,6 @@
 #include "SceneWorld.h"
 
+#include "Core/Jobs/JobSystem.h"
 #include "Log/Log.h"
 #include "Path/Path.h"
 #include "U_BaseSlot.sh"
@@ -37,6 +38,39 @@ SceneWorld::SceneWorld()
 	m_pStaticMeshComponentStorage = m_pWorld->Register<engine::StaticMeshComponent>();
 	m_pTransformComponentStorage = m_pWorld->Register<engine::TransformComponent>();
 
+	// Systems run before render submission every frame. Capture pointers instead of this as SceneWorld is movable.
+	m_pTransformHierarchy = std::make_unique<TransformHierarchy>(m_pHierarchyComponentStorage, m_pTransformComponentStorage);
+	m_systemScheduler.AddSystem("TransformHierarchy", SystemAccess().Read<HierarchyComponent>().Write<TransformComponent>(),
+		[pTransformHierarchy = m_pTransformHierarchy.get()](float deltaTime)
+		{
+			pTransformHierarchy->Update(&JobSystem::Get());
+		});
+
+	// Refit world space bounding boxes of entities moved by TransformHierarchy.
+	m_pSceneBVH = std::make_unique<SceneBVH>(m_pStaticMeshComponentStorage, m_pTransformComponentStorage);
+	m_systemScheduler.AddSystem("SceneBVH", SystemAccess().Read<StaticMeshComponent, TransformComponent>().Write<SceneBVH>(),
+		[pSceneBVH = m_pSceneBVH.get()](float deltaTime)
+		{
+			pSceneBVH->Update();
+		});
+
+	// Use SceneBVH and the main camera's matrices built before scene update.
+	m_pFrustumCuller = std::make_unique<FrustumCuller>(m_pCameraComponentStorage, m_pStaticMeshComponentStorage, m_pTransformComponentStorage);
+	m_pFrustumCuller->SetSceneBVH(m_pSceneBVH.get());
+	m_systemScheduler.AddSystem("FrustumCulling", SystemAccess().Read<CameraComponent, StaticMeshComponent, TransformComponent, SceneBVH>(),
+		[pFrustumCuller = m_pFrustumCuller.get()](float deltaTime)
+		{
+			pFrustumCuller->Update(&JobSystem::Get());
+		});
+
+	// Pick LODs of static meshes by their screen sizes on the main camera.
+	m_pMeshLODSelector = std::make_unique<MeshLODSelector>(m_pCameraComponentStorage, m_pStaticMeshComponentStorage, m_pTransformComponentStorage);
+	m_systemScheduler.AddSystem("MeshLODSelection", SystemAccess().Read<CameraComponent, StaticMeshComponent, TransformComponent>(),
+		[pMeshLODSelector = m_pMeshLODSelector.get()](float deltaTime)
+		{
+			pMeshLODSelector->Update(&JobSystem::Get());
+		});
+
 	CreatePBRMaterialType();
 	CreateAnimationMaterialType();
 	CreateTerrainMaterialType();
@@ -49,6 +83,7 @@ void SceneWorld::CreatePBRMaterialType()
 	m_pPBRMaterialType->SetMaterialName("CD_PBR");
 
 	ShaderSchema shaderSchema(Path::GetBuiltinShaderInputPath("shaders/vs_PBR"), Path::GetBuiltinShaderInputPath("shaders/fs_PBR"));
+	shaderSchema.SetInstanceVertexShaderPath(Path::GetBuiltinShaderInputPath("shaders/vs_PBR_instance"));
 	shaderSchema.RegisterUberOption(Uber::ALBEDO_MAP);
 	shaderSchema.RegisterUberOption(Uber::NORMAL_MAP);
 	shaderSchema.RegisterUberOption(Uber::ORM_MAP);
@@ -136,6 +171,17 @@ void SceneWorld::CreateDDGIMaterialType()
 	m_pDDGIMaterialType->AddOptionalTextureType(cd::MaterialTextureType::Emissive, EMISSIVE_MAP_SLOT);
 }
 
+void SceneWorld::EnableStaticMeshArchetype()
+{
+	if (m_pStaticMeshArchetype)
+	{
+		return;
+	}
+
+	m_pStaticMeshArchetype = m_pWorld->RegisterArchetype<engine::TransformComponent, engine::StaticMeshComponent, engine::MaterialComponent>();
+	m_pTransformHierarchy->SetStaticMeshArchetype(m_pStaticMeshArchetype);
+}
+
 void SceneWorld::SetSelectedEntity(engine::Entity entity)
 {
 	CD_TRACE("Select entity : {0}", entity);
@@ -146,6 +192,8 @@ void SceneWorld::SetMainCameraEntity(engine::Entity entity)
 {
 	CD_TRACE("Setup main camera entity : {0}", entity);
 	m_mainCameraEntity = entity;
+	m_pFrustumCuller->SetCameraEntity(entity);
+	m_pMeshLODSelector->SetCameraEntity(entity);
 }
 
 void SceneWorld::SetDDGIEntity(engine::Entity entity)
@@ -160,6 +208,18 @@ void SceneWorld::SetSkyEntity(engine::Entity entity)
 	m_skyEntity = entity;
 }
 
+void SceneWorld::SetParentEntity(engine::Entity entity, engine::Entity parentEntity)
+{
+	HierarchyComponent* pHierarchyComponent = GetHierarchyComponent(entity);
+	if (!pHierarchyComponent)
+	{
+		pHierarchyComponent = &m_pWorld->CreateComponent<HierarchyComponent>(entity);
+	}
+
+	pHierarchyComponent->SetParentEntity(parentEntity);
+	m_pTransformHierarchy->MarkTopologyDirty();
+}
+
 void SceneWorld::AddCameraToSceneDatabase(engine::Entity entity)
 {
 	engine::CameraComponent* pCameraComponent = GetCameraComponent(entity);
@@ -271,8 +331,10 @@ void SceneWorld::InitDDGISDK()
 #endif 
 }
 
-void SceneWorld::Update()
+void SceneWorld::Update(float deltaTime)
 {
+	m_systemScheduler.Run(deltaTime, JobSystem::Get());
+
 #ifdef ENABLE_DDGI_SDK
 	// Send request 30 times per second.
 	static auto startTime = std::chrono::steady_clock::now();
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "ECWorld/AllComponentsHeader.h"
+#include "ECWorld/FrustumCuller.h"
+#include "ECWorld/MeshLODSelector.h"
+#include "ECWorld/SceneBVH.h"
+#include "ECWorld/SystemScheduler.h"
+#include "ECWorld/TransformHierarchy.h"
 #include "ECWorld/World.h"
 #include "Log/Log.h"
 #include "Material/MaterialType.h"
@@ -51,6 +56,20 @@ public:
 	CD_FORCEINLINE engine::World* GetWorld() { return m_pWorld.get(); }
 	CD_FORCEINLINE const engine::World* GetWorld() const { return m_pWorld.get(); }
 
+	template<typename... Components>
+	CD_FORCEINLINE engine::ComponentsView<Components...> View() const { return m_pWorld->View<Components...>(); }
+
+	// Static meshes which are only drawn, e.g. scattered props, are created by importers in StaticMeshArchetype chunks
+	// instead of per-type storages after it is enabled. Call it before creating entities and renderers.
+	// They are extracted by renderers from chunks and their transforms are built by TransformHierarchy as roots.
+	// As they are not in per-type storages, editor UI and systems which iterate storages don't see them.
+	// Renderers cull them against the frustum without occlusion and select their LODs by themselves.
+	void EnableStaticMeshArchetype();
+	CD_FORCEINLINE bool IsStaticMeshArchetypeEnabled() const { return nullptr != m_pStaticMeshArchetype; }
+
+	// nullptr if the archetype is not enabled.
+	CD_FORCEINLINE engine::StaticMeshArchetype* GetStaticMeshArchetype() const { return m_pStaticMeshArchetype; }
+
 	void SetSelectedEntity(engine::Entity entity);
 	CD_FORCEINLINE engine::Entity GetSelectedEntity() const { return m_selectedEntity; }
 
@@ -63,6 +82,9 @@ public:
 	void SetSkyEntity(engine::Entity entity);
 	CD_FORCEINLINE engine::Entity GetSkyEntity() const { return m_skyEntity; }
 
+	// Create HierarchyComponent if needed. INVALID_ENTITY parent means that entity becomes a root.
+	void SetParentEntity(engine::Entity entity, engine::Entity parentEntity);
+
 	void DeleteEntity(engine::Entity entity)
 	{
 		if (entity == m_mainCameraEntity)
@@ -88,6 +110,10 @@ public:
 		DeleteSkyComponent(entity);
 		DeleteStaticMeshComponent(entity);
 		DeleteTransformComponent(entity);
+		if (m_pStaticMeshArchetype)
+		{
+			m_pStaticMeshArchetype->RemoveComponents(entity);
+		}
 	}
 
 	void CreatePBRMaterialType();
@@ -106,12 +132,24 @@ public:
 	void AddLightToSceneDatabase(engine::Entity entity);
 	void AddMaterialToSceneDatabase(engine::Entity entity);
 
+	CD_FORCEINLINE engine::SystemScheduler* GetSystemScheduler() { return &m_systemScheduler; }
+	CD_FORCEINLINE engine::TransformHierarchy* GetTransformHierarchy() const { return m_pTransformHierarchy.get(); }
+	CD_FORCEINLINE engine::SceneBVH* GetSceneBVH() const { return m_pSceneBVH.get(); }
+	CD_FORCEINLINE engine::FrustumCuller* GetFrustumCuller() const { return m_pFrustumCuller.get(); }
+	CD_FORCEINLINE engine::MeshLODSelector* GetMeshLODSelector() const { return m_pMeshLODSelector.get(); }
+
 	void InitDDGISDK();
-	void Update();
+	void Update(float deltaTime);
 
 private:
 	std::unique_ptr<cd::SceneDatabase> m_pSceneDatabase;
 	std::unique_ptr<engine::World> m_pWorld;
+	engine::StaticMeshArchetype* m_pStaticMeshArchetype = nullptr;
+	engine::SystemScheduler m_systemScheduler;
+	std::unique_ptr<engine::TransformHierarchy> m_pTransformHierarchy;
+	std::unique_ptr<engine::SceneBVH> m_pSceneBVH;
+	std::unique_ptr<engine::FrustumCuller> m_pFrustumCuller;
+	std::unique_ptr<engine::MeshLODSelector> m_pMeshLODSelector;
 
 	std::unique_ptr<engine::MaterialType> m_pPBRMaterialType;
 	std::unique_ptr<engine::MaterialType> m_pAnimationMaterialType;
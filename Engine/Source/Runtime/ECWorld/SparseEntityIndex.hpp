@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Entity.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace engine
+{
+
+// SparseEntityIndex maps entity to an uint32_t dense index by lazily allocated pages.
+// Lookup is two array reads without hashing. Sparse entity ids only allocate the pages they touch.
+class SparseEntityIndex
+{
+public:
+	static constexpr uint32_t PageBits = 12;
+	static constexpr uint32_t PageSize = 1U << PageBits;
+	static constexpr uint32_t PageMask = PageSize - 1;
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+public:
+	SparseEntityIndex() = default;
+	SparseEntityIndex(const SparseEntityIndex&) = delete;
+	SparseEntityIndex& operator=(const SparseEntityIndex&) = delete;
+	SparseEntityIndex(SparseEntityIndex&&) = default;
+	SparseEntityIndex& operator=(SparseEntityIndex&&) = default;
+	~SparseEntityIndex() = default;
+
+	// Returns the dense index of entity or InvalidIndex.
+	uint32_t Get(Entity entity) const
+	{
+		const size_t pageIndex = entity >> PageBits;
+		if (pageIndex >= m_pages.size() || !m_pages[pageIndex])
+		{
+			return InvalidIndex;
+		}
+
+		return m_pages[pageIndex][entity & PageMask];
+	}
+
+	// Set the dense index of entity. Allocates a page when needed.
+	void Set(Entity entity, uint32_t index)
+	{
+		const size_t pageIndex = entity >> PageBits;
+		if (pageIndex >= m_pages.size())
+		{
+			m_pages.resize(pageIndex + 1);
+		}
+
+		std::unique_ptr<uint32_t[]>& pPage = m_pages[pageIndex];
+		if (!pPage)
+		{
+			pPage = std::make_unique<uint32_t[]>(PageSize);
+			std::fill_n(pPage.get(), PageSize, InvalidIndex);
+		}
+
+		pPage[entity & PageMask] = index;
+	}
+
+	// Entity must be inside an allocated page which is always true after Set.
+	void Reset(Entity entity) { m_pages[entity >> PageBits][entity & PageMask] = InvalidIndex; }
+
+private:
+	std::vector<std::unique_ptr<uint32_t[]>> m_pages;
+};
+
+}
\ No newline at end of file
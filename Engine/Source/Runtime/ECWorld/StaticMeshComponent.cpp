@@ -1,5 +1,7 @@
 #include "StaticMeshComponent.h"
 
+#include "Base/Template.h"
+#include "Core/Math/MeshOptimizer.h"
 #include "ECWorld/World.h"
 #include "Log/Log.h"
 #include "Math/MeshGenerator.h"
@@ -8,21 +10,177 @@
 
 #include <bgfx/bgfx.h>
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
 
 namespace engine
 {
 
+// GPU buffers and the CPU copies of their data.
+struct StaticMeshBuffers
+{
+	StaticMeshBuffers() = default;
+	StaticMeshBuffers(const StaticMeshBuffers&) = delete;
+	StaticMeshBuffers& operator=(const StaticMeshBuffers&) = delete;
+	StaticMeshBuffers(StaticMeshBuffers&&) = delete;
+	StaticMeshBuffers& operator=(StaticMeshBuffers&&) = delete;
+
+	~StaticMeshBuffers()
+	{
+		if (vertexBufferHandle != UINT16_MAX)
+		{
+			bgfx::destroy(bgfx::VertexBufferHandle{ vertexBufferHandle });
+		}
+
+		if (indexBufferHandle != UINT16_MAX)
+		{
+			bgfx::destroy(bgfx::IndexBufferHandle{ indexBufferHandle });
+		}
+
+		for (uint16_t lodIndexBufferHandle : lodIndexBufferHandles)
+		{
+			bgfx::destroy(bgfx::IndexBufferHandle{ lodIndexBufferHandle });
+		}
+	}
+
+	bgfx::VertexLayout vertexLayout;
+	std::vector<std::byte> vertexBuffer;
+	std::vector<std::byte> indexBuffer;
+	uint16_t vertexBufferHandle = UINT16_MAX;
+	uint16_t indexBufferHandle = UINT16_MAX;
+
+	// Index buffers of LODs after LOD 0.
+	std::vector<std::vector<std::byte>> lodIndexBuffers;
+	std::vector<uint16_t> lodIndexBufferHandles;
+};
+
+namespace
+{
+
+uint64_t HashBytes(uint64_t hash, const std::vector<std::byte>& bytes)
+{
+	const size_t wordCount = bytes.size() / sizeof(uint64_t);
+	const std::byte* pBytes = bytes.data();
+	for (size_t wordIndex = 0; wordIndex < wordCount; ++wordIndex)
+	{
+		uint64_t word;
+		std::memcpy(&word, pBytes + wordIndex * sizeof(uint64_t), sizeof(uint64_t));
+		hash = (hash ^ word) * 0x100000001B3ULL;
+		hash ^= hash >> 29;
+	}
+
+	for (size_t byteIndex = wordCount * sizeof(uint64_t); byteIndex < bytes.size(); ++byteIndex)
+	{
+		hash = (hash ^ static_cast<uint64_t>(pBytes[byteIndex])) * 0x100000001B3ULL;
+	}
+
+	return hash;
+}
+
+// Buffers are shared by content so that copies of one mesh, e.g. the same model imported many times or
+// generated shapes, can be drawn by instancing. Buffers are destroyed when the last component releases them
+// and their entries are erased on the next lookup of the same hash.
+class StaticMeshBuffersCache
+{
+public:
+	static StaticMeshBuffersCache& Get()
+	{
+		static StaticMeshBuffersCache s_cache;
+		return s_cache;
+	}
+
+	std::shared_ptr<const StaticMeshBuffers> FindOrAdd(std::unique_ptr<StaticMeshBuffers> pNewBuffers)
+	{
+		uint64_t hash = HashBytes(pNewBuffers->vertexLayout.m_hash, pNewBuffers->vertexBuffer);
+		hash = HashBytes(hash, pNewBuffers->indexBuffer);
+		for (const std::vector<std::byte>& lodIndexBuffer : pNewBuffers->lodIndexBuffers)
+		{
+			hash = HashBytes(hash, lodIndexBuffer);
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto [itBegin, itEnd] = m_hashToBuffers.equal_range(hash);
+		for (auto it = itBegin; it != itEnd;)
+		{
+			std::shared_ptr<const StaticMeshBuffers> pBuffers = it->second.lock();
+			if (!pBuffers)
+			{
+				it = m_hashToBuffers.erase(it);
+				continue;
+			}
+
+			if (pBuffers->vertexLayout.m_hash == pNewBuffers->vertexLayout.m_hash &&
+				pBuffers->vertexBuffer == pNewBuffers->vertexBuffer && pBuffers->indexBuffer == pNewBuffers->indexBuffer &&
+				pBuffers->lodIndexBuffers == pNewBuffers->lodIndexBuffers)
+			{
+				return pBuffers;
+			}
+			++it;
+		}
+
+		StaticMeshBuffers& newBuffers = *pNewBuffers;
+		bgfx::VertexBufferHandle vertexBufferHandle = bgfx::createVertexBuffer(bgfx::copy(newBuffers.vertexBuffer.data(), static_cast<uint32_t>(newBuffers.vertexBuffer.size())), newBuffers.vertexLayout);
+		assert(bgfx::isValid(vertexBufferHandle));
+		newBuffers.vertexBufferHandle = vertexBufferHandle.idx;
+
+		bgfx::IndexBufferHandle indexBufferHandle = bgfx::createIndexBuffer(bgfx::copy(newBuffers.indexBuffer.data(), static_cast<uint32_t>(newBuffers.indexBuffer.size())), BGFX_BUFFER_INDEX32);
+		assert(bgfx::isValid(indexBufferHandle));
+		newBuffers.indexBufferHandle = indexBufferHandle.idx;
+
+		for (const std::vector<std::byte>& lodIndexBuffer : newBuffers.lodIndexBuffers)
+		{
+			bgfx::IndexBufferHandle lodIndexBufferHandle = bgfx::createIndexBuffer(bgfx::copy(lodIndexBuffer.data(), static_cast<uint32_t>(lodIndexBuffer.size())), BGFX_BUFFER_INDEX32);
+			assert(bgfx::isValid(lodIndexBufferHandle));
+			newBuffers.lodIndexBufferHandles.push_back(lodIndexBufferHandle.idx);
+		}
+
+		std::shared_ptr<const StaticMeshBuffers> pBuffers = cd::MoveTemp(pNewBuffers);
+		m_hashToBuffers.emplace(hash, pBuffers);
+		return pBuffers;
+	}
+
+private:
+	std::mutex m_mutex;
+	std::unordered_multimap<uint64_t, std::weak_ptr<const StaticMeshBuffers>> m_hashToBuffers;
+};
+
+}
+
+const std::vector<std::byte>& StaticMeshComponent::GetVertexBufferData() const
+{
+	static const std::vector<std::byte> s_emptyData;
+	return m_pBuffers ? m_pBuffers->vertexBuffer : s_emptyData;
+}
+
+const std::vector<std::byte>& StaticMeshComponent::GetIndexBufferData() const
+{
+	static const std::vector<std::byte> s_emptyData;
+	return m_pBuffers ? m_pBuffers->indexBuffer : s_emptyData;
+}
+
+void StaticMeshComponent::SetLODs(std::vector<MeshLOD> lods)
+{
+	m_lods = cd::MoveTemp(lods);
+	if (m_lods.size() >= MeshLODSettings::MaxLODCount)
+	{
+		m_lods.resize(MeshLODSettings::MaxLODCount - 1U);
+	}
+}
+
 void StaticMeshComponent::Reset()
 {
 	m_pMeshData = nullptr;
 	m_pRequiredVertexFormat = nullptr;
+	m_lods.clear();
 
-	m_vertexBuffer.clear();
+	m_pBuffers.reset();
 	m_vertexBufferHandle = UINT16_MAX;
-
-	m_indexBuffer.clear();
 	m_indexBufferHandle = UINT16_MAX;
+	m_lodCount = 1U;
+	std::fill(std::begin(m_lodIndexBufferHandles), std::end(m_lodIndexBufferHandles), UINT16_MAX);
 
 	// Debug
 	m_aabb.Clear();
@@ -31,6 +189,8 @@ void StaticMeshComponent::Reset()
 
 	m_aabbIndexBuffer.clear();
 	m_aabbIBH = UINT16_MAX;
+
+	++m_version;
 }
 
 void StaticMeshComponent::BuildDebug()
@@ -76,8 +236,8 @@ void StaticMeshComponent::BuildDebug()
 
 	bgfx::VertexLayout vertexLayout;
 	VertexLayoutUtility::CreateVertexLayout(vertexLayout, vertexFormat.GetVertexLayout());
-	m_aabbVBH = bgfx::createVertexBuffer(bgfx::makeRef(m_aabbVertexBuffer.data(), static_cast<uint32_t>(m_aabbVertexBuffer.size())), vertexLayout).idx;
-	m_aabbIBH = bgfx::createIndexBuffer(bgfx::makeRef(m_aabbIndexBuffer.data(), static_cast<uint32_t>(m_aabbIndexBuffer.size())), BGFX_BUFFER_INDEX32).idx;
+	m_aabbVBH = bgfx::createVertexBuffer(bgfx::copy(m_aabbVertexBuffer.data(), static_cast<uint32_t>(m_aabbVertexBuffer.size())), vertexLayout).idx;
+	m_aabbIBH = bgfx::createIndexBuffer(bgfx::copy(m_aabbIndexBuffer.data(), static_cast<uint32_t>(m_aabbIndexBuffer.size())), BGFX_BUFFER_INDEX32).idx;
 }
 
 void StaticMeshComponent::Build()
@@ -104,10 +264,28 @@ void StaticMeshComponent::Build()
 	const uint32_t vertexCount = m_pMeshData->GetVertexCount();
 	const uint32_t vertexFormatStride = m_pRequiredVertexFormat->GetStride();
 
-	m_vertexBuffer.resize(vertexCount * vertexFormatStride);
+	// Reorder triangles for the post-transform cache and overdraw, then renumber vertices in the order of first uses.
+	// Mesh data keeps its import order.
+	static_assert(sizeof(cd::Polygon) == 3 * sizeof(uint32_t), "Polygons should be tightly packed 32 bits indexes.");
+	const std::vector<cd::Polygon>& polygons = m_pMeshData->GetPolygons();
+	const uint32_t* pPolygonIndices = reinterpret_cast<const uint32_t*>(polygons.data());
+	const uint32_t indexCount = static_cast<uint32_t>(polygons.size()) * cd::Polygon::Size;
+	std::vector<uint32_t> indices(pPolygonIndices, pPolygonIndices + indexCount);
+	MeshOptimizer::OptimizeVertexCache(indices.data(), indexCount, vertexCount);
+	MeshOptimizer::OptimizeOverdraw(indices.data(), indexCount, m_pMeshData->GetVertexPositions().data(), vertexCount);
+	std::vector<uint32_t> vertexRemap;
+	MeshOptimizer::OptimizeVertexFetch(indices.data(), indexCount, vertexCount, vertexRemap);
+	std::vector<uint32_t> vertexOrder(vertexCount);
+	for (uint32_t vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		vertexOrder[vertexRemap[vertexIndex]] = vertexIndex;
+	}
+
+	auto pBuffers = std::make_unique<StaticMeshBuffers>();
+	pBuffers->vertexBuffer.resize(vertexCount * vertexFormatStride);
 
 	uint32_t currentDataSize = 0U;
-	auto currentDataPtr = m_vertexBuffer.data();
+	auto currentDataPtr = pBuffers->vertexBuffer.data();
 
 	auto FillVertexBuffer = [&currentDataPtr, &currentDataSize](const void* pData, uint32_t dataSize)
 	{
@@ -115,8 +293,10 @@ void StaticMeshComponent::Build()
 		currentDataSize += dataSize;
 	};
 
-	for (uint32_t vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex)
+	for (uint32_t bufferVertexIndex = 0; bufferVertexIndex < vertexCount; ++bufferVertexIndex)
 	{
+		const uint32_t vertexIndex = vertexOrder[bufferVertexIndex];
+
 		if (containsPosition)
 		{
 			constexpr uint32_t dataSize = cd::Point::Size * sizeof(cd::Point::ValueType);
@@ -184,22 +364,45 @@ void StaticMeshComponent::Build()
 		}
 	}
 
-	// Create vertex buffer.
-	bgfx::VertexLayout vertexLayout;
-	VertexLayoutUtility::CreateVertexLayout(vertexLayout, m_pRequiredVertexFormat->GetVertexLayout());
-	bgfx::VertexBufferHandle vertexBufferHandle = bgfx::createVertexBuffer(bgfx::makeRef(m_vertexBuffer.data(), static_cast<uint32_t>(m_vertexBuffer.size())), vertexLayout);
-	assert(bgfx::isValid(vertexBufferHandle));
-	m_vertexBufferHandle = vertexBufferHandle.idx;
-
-	// Create index buffer.
-	m_indexBuffer.resize(m_pMeshData->GetPolygonCount() * cd::Polygon::Size * sizeof(cd::Polygon::ValueType));
-	std::memcpy(m_indexBuffer.data(), m_pMeshData->GetPolygons().data(), m_indexBuffer.size());
-	bgfx::IndexBufferHandle indexBufferHandle = bgfx::createIndexBuffer(bgfx::makeRef(m_indexBuffer.data(), static_cast<uint32_t>(m_indexBuffer.size())), BGFX_BUFFER_INDEX32);
-	assert(bgfx::isValid(indexBufferHandle));
-	m_indexBufferHandle = indexBufferHandle.idx;
+	VertexLayoutUtility::CreateVertexLayout(pBuffers->vertexLayout, m_pRequiredVertexFormat->GetVertexLayout());
+	pBuffers->indexBuffer.resize(indexCount * sizeof(uint32_t));
+	std::memcpy(pBuffers->indexBuffer.data(), indices.data(), pBuffers->indexBuffer.size());
+
+	// LODs reference vertices in import order.
+	for (const MeshLOD& lod : m_lods)
+	{
+		const uint32_t lodIndexCount = static_cast<uint32_t>(lod.indices.size());
+		std::vector<uint32_t> lodIndices(lodIndexCount);
+		for (uint32_t index = 0; index < lodIndexCount; ++index)
+		{
+			lodIndices[index] = vertexRemap[lod.indices[index]];
+		}
+		MeshOptimizer::OptimizeVertexCache(lodIndices.data(), lodIndexCount, vertexCount);
+
+		std::vector<std::byte>& lodIndexBuffer = pBuffers->lodIndexBuffers.emplace_back(lodIndexCount * sizeof(uint32_t));
+		std::memcpy(lodIndexBuffer.data(), lodIndices.data(), lodIndexBuffer.size());
+	}
+
+	// Create vertex buffer and index buffer or reuse existing ones which have the same data.
+	m_pBuffers = StaticMeshBuffersCache::Get().FindOrAdd(cd::MoveTemp(pBuffers));
+	m_vertexBufferHandle = m_pBuffers->vertexBufferHandle;
+	m_indexBufferHandle = m_pBuffers->indexBufferHandle;
+
+	m_lodCount = 1U + static_cast<uint32_t>(m_lods.size());
+	m_lodIndexBufferHandles[0] = m_indexBufferHandle;
+	m_lodIndexCounts[0] = indexCount;
+	m_lodErrors[0] = 0.0f;
+	for (uint32_t lod = 1U; lod < m_lodCount; ++lod)
+	{
+		m_lodIndexBufferHandles[lod] = m_pBuffers->lodIndexBufferHandles[lod - 1U];
+		m_lodIndexCounts[lod] = static_cast<uint32_t>(m_lods[lod - 1U].indices.size());
+		m_lodErrors[lod] = m_lods[lod - 1U].error;
+	}
 
 	// Build debug data.
 	BuildDebug();
+
+	++m_version;
 }
 
 }
\ No newline at end of file
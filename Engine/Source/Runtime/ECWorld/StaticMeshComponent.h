@@ -1,11 +1,13 @@
 #pragma once
 
+#include "Core/Math/MeshSimplifier.h"
 #include "Core/StringCrc.h"
 #include "ECWorld/Entity.h"
 #include "Math/Box.hpp"
 #include "Scene/Mesh.h"
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace cd
@@ -20,6 +22,7 @@ namespace engine
 {
 
 class World;
+struct StaticMeshBuffers;
 
 class StaticMeshComponent final
 {
@@ -43,11 +46,36 @@ public:
 	void SetRequiredVertexFormat(const cd::VertexFormat* pVertexFormat) { m_pRequiredVertexFormat = pVertexFormat; }
 
 	const cd::AABB& GetAABB() const { return m_aabb; }
+
+	// Occluders are rasterized by software occlusion culling to hide other meshes. Large and simple meshes such as walls fit best.
+	void SetOccluder(bool value) { m_isOccluder = value; }
+	bool& GetOccluder() { return m_isOccluder; }
+	bool IsOccluder() const { return m_isOccluder; }
+
+	// Components whose meshes have the same vertex layout and data share the same buffers.
 	uint16_t GetVertexBuffer() const { return m_vertexBufferHandle; }
 	uint16_t GetIndexBuffer() const { return m_indexBufferHandle; }
 	uint16_t GetAABBVertexBuffer() const { return m_aabbVBH; }
 	uint16_t GetAABBIndexBuffer() const { return m_aabbIBH; }
 
+	// Simplified LODs after LOD 0 which share vertices of the mesh. They are built into their own index buffers.
+	void SetLODs(std::vector<MeshLOD> lods);
+
+	// LOD 0 is the mesh itself. LOD buffers and counts are valid after Build.
+	uint32_t GetLODCount() const { return m_lodCount; }
+	uint16_t GetLODIndexBuffer(uint32_t lod) const { return m_lodIndexBufferHandles[lod]; }
+	uint32_t GetLODIndexCount(uint32_t lod) const { return m_lodIndexCounts[lod]; }
+
+	// Max distances in mesh space which surfaces of LODs moved from LOD 0. They are ascending from 0.
+	const float* GetLODErrors() const { return m_lodErrors; }
+
+	// Data of buffers which are empty before Build. GPU driven rendering merges them into shared buffers.
+	const std::vector<std::byte>& GetVertexBufferData() const;
+	const std::vector<std::byte>& GetIndexBufferData() const;
+
+	// Increased when buffers or bounding box change so that render proxies can skip unchanged meshes.
+	uint32_t GetVersion() const { return m_version; }
+
 	void Reset();
 	void Build();
 
@@ -58,12 +86,19 @@ private:
 	// Input
 	const cd::Mesh* m_pMeshData = nullptr;
 	const cd::VertexFormat* m_pRequiredVertexFormat = nullptr;
+	std::vector<MeshLOD> m_lods;
 
 	// Output
-	std::vector<std::byte> m_vertexBuffer;
-	std::vector<std::byte> m_indexBuffer;
+	std::shared_ptr<const StaticMeshBuffers> m_pBuffers;
 	uint16_t m_vertexBufferHandle = UINT16_MAX;
 	uint16_t m_indexBufferHandle = UINT16_MAX;
+	uint32_t m_version = 0U;
+	bool m_isOccluder = false;
+
+	uint32_t m_lodCount = 1U;
+	uint16_t m_lodIndexBufferHandles[MeshLODSettings::MaxLODCount] = { UINT16_MAX, UINT16_MAX, UINT16_MAX, UINT16_MAX };
+	uint32_t m_lodIndexCounts[MeshLODSettings::MaxLODCount] = {};
+	float m_lodErrors[MeshLODSettings::MaxLODCount] = {};
 
 	// For debug use
 	cd::AABB m_aabb;
@@ -0,0 +1,139 @@
+#include "SystemScheduler.h"
+
+#include "Base/Template.h"
+#include "Core/Jobs/JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace engine
+{
+
+namespace
+{
+
+bool ContainsAny(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+	for (uint32_t component : a)
+	{
+		if (std::find(b.begin(), b.end(), component) != b.end())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+}
+
+bool SystemAccess::ConflictsWith(const SystemAccess& other) const
+{
+	return ContainsAny(m_writeComponents, other.m_writeComponents) ||
+		ContainsAny(m_writeComponents, other.m_readComponents) ||
+		ContainsAny(m_readComponents, other.m_writeComponents);
+}
+
+void SystemScheduler::AddSystem(std::string name, SystemAccess access, SystemFunction function)
+{
+	System system;
+	system.name = cd::MoveTemp(name);
+	system.access = cd::MoveTemp(access);
+	system.function = cd::MoveTemp(function);
+	m_systems.emplace_back(cd::MoveTemp(system));
+	m_isGraphDirty = true;
+}
+
+const std::vector<uint32_t>& SystemScheduler::GetDependencies(size_t systemIndex)
+{
+	BuildGraph();
+	return m_systems[systemIndex].dependencies;
+}
+
+void SystemScheduler::BuildGraph()
+{
+	if (!m_isGraphDirty)
+	{
+		return;
+	}
+
+	for (System& system : m_systems)
+	{
+		system.dependencies.clear();
+		system.successors.clear();
+	}
+
+	// Registration order decides the direction of edges so the graph is always acyclic.
+	for (uint32_t systemIndex = 0U; systemIndex < m_systems.size(); ++systemIndex)
+	{
+		System& system = m_systems[systemIndex];
+		for (uint32_t previousIndex = 0U; previousIndex < systemIndex; ++previousIndex)
+		{
+			System& previousSystem = m_systems[previousIndex];
+			if (system.access.ConflictsWith(previousSystem.access))
+			{
+				system.dependencies.push_back(previousIndex);
+				previousSystem.successors.push_back(systemIndex);
+			}
+		}
+	}
+
+	m_isGraphDirty = false;
+}
+
+void SystemScheduler::Run(float deltaTime, JobSystem& jobSystem)
+{
+	BuildGraph();
+	if (m_systems.empty())
+	{
+		return;
+	}
+
+	const size_t systemCount = m_systems.size();
+	auto remainingDependencies = std::make_unique<std::atomic<uint32_t>[]>(systemCount);
+	for (size_t systemIndex = 0; systemIndex < systemCount; ++systemIndex)
+	{
+		remainingDependencies[systemIndex].store(static_cast<uint32_t>(m_systems[systemIndex].dependencies.size()));
+	}
+
+	// A finished system submits successors whose dependencies are all finished.
+	// Successors are submitted before the finished job decrements counter so Wait can't return early.
+	JobCounter counter;
+	std::function<void(uint32_t)> submitSystem;
+	submitSystem = [this, deltaTime, &jobSystem, &counter, &remainingDependencies, &submitSystem](uint32_t systemIndex)
+	{
+		jobSystem.Submit([this, deltaTime, &remainingDependencies, &submitSystem, systemIndex]()
+		{
+			const System& system = m_systems[systemIndex];
+			system.function(deltaTime);
+			for (uint32_t successorIndex : system.successors)
+			{
+				if (1U == remainingDependencies[successorIndex].fetch_sub(1U, std::memory_order_acq_rel))
+				{
+					submitSystem(successorIndex);
+				}
+			}
+		}, &counter);
+	};
+
+	for (uint32_t systemIndex = 0U; systemIndex < systemCount; ++systemIndex)
+	{
+		if (m_systems[systemIndex].dependencies.empty())
+		{
+			submitSystem(systemIndex);
+		}
+	}
+
+	jobSystem.Wait(counter);
+}
+
+void SystemScheduler::RunSerial(float deltaTime)
+{
+	for (const System& system : m_systems)
+	{
+		system.function(deltaTime);
+	}
+}
+
+}
\ No newline at end of file
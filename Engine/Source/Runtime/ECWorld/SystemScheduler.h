@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Core/StringCrc.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+class JobSystem;
+
+// SystemAccess declares which component types a system reads and writes.
+// Two systems conflict if one of them writes a component type which the other one reads or writes.
+// Other shared data which has a static GetClassName, e.g. SceneBVH, can be declared in the same way.
+class SystemAccess final
+{
+public:
+	SystemAccess() = default;
+	SystemAccess(const SystemAccess&) = default;
+	SystemAccess& operator=(const SystemAccess&) = default;
+	SystemAccess(SystemAccess&&) = default;
+	SystemAccess& operator=(SystemAccess&&) = default;
+	~SystemAccess() = default;
+
+	template<typename... Components>
+	SystemAccess& Read()
+	{
+		(m_readComponents.push_back(Components::GetClassName().Value()), ...);
+		return *this;
+	}
+
+	template<typename... Components>
+	SystemAccess& Write()
+	{
+		(m_writeComponents.push_back(Components::GetClassName().Value()), ...);
+		return *this;
+	}
+
+	const std::vector<uint32_t>& GetReadComponents() const { return m_readComponents; }
+	const std::vector<uint32_t>& GetWriteComponents() const { return m_writeComponents; }
+
+	bool ConflictsWith(const SystemAccess& other) const;
+
+private:
+	std::vector<uint32_t> m_readComponents;
+	std::vector<uint32_t> m_writeComponents;
+};
+
+// SystemScheduler runs registered systems in a dependency graph built from their component accesses.
+// A system depends on every previously registered system which conflicts with it,
+// so parallel execution always produces the same results as running systems serially in registration order.
+class SystemScheduler final
+{
+public:
+	using SystemFunction = std::function<void(float deltaTime)>;
+
+public:
+	SystemScheduler() = default;
+	SystemScheduler(const SystemScheduler&) = delete;
+	SystemScheduler& operator=(const SystemScheduler&) = delete;
+	SystemScheduler(SystemScheduler&&) = default;
+	SystemScheduler& operator=(SystemScheduler&&) = default;
+	~SystemScheduler() = default;
+
+	void AddSystem(std::string name, SystemAccess access, SystemFunction function);
+	size_t GetSystemCount() const { return m_systems.size(); }
+	const char* GetSystemName(size_t systemIndex) const { return m_systems[systemIndex].name.c_str(); }
+
+	// Indexes of systems which must finish before systemIndex starts.
+	const std::vector<uint32_t>& GetDependencies(size_t systemIndex);
+
+	// Run systems which don't conflict with each other on JobSystem workers and wait until all finished.
+	void Run(float deltaTime, JobSystem& jobSystem);
+
+	// Run systems one by one in current thread by registration order.
+	void RunSerial(float deltaTime);
+
+private:
+	struct System
+	{
+		std::string name;
+		SystemAccess access;
+		SystemFunction function;
+		std::vector<uint32_t> dependencies;
+		std::vector<uint32_t> successors;
+	};
+
+	void BuildGraph();
+
+private:
+	std::vector<System> m_systems;
+	bool m_isGraphDirty = false;
+};
+
+}
\ No newline at end of file
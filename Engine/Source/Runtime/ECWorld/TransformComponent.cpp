@@ -6,18 +6,47 @@ namespace engine
 void TransformComponent::Reset()
 {
 	m_transform.Clear();
+	m_localToParentMatrix.Clear();
 	m_localToWorldMatrix.Clear();
 	m_isMatrixDirty = true;
+	m_isWorldMatrixDirty = true;
+	++m_worldMatrixVersion;
 }
 
 void TransformComponent::Build()
 {
 	if (m_isMatrixDirty)
 	{
-		m_localToWorldMatrix = m_transform.GetMatrix();
+		m_localToParentMatrix = m_transform.GetMatrix();
+		if (!m_hasParent)
+		{
+			m_localToWorldMatrix = m_localToParentMatrix;
+			++m_worldMatrixVersion;
+		}
 		m_isMatrixDirty = false;
+		m_isWorldMatrixDirty = true;
 	}
 }
+
+void TransformComponent::SetLocalMatrix(const cd::Matrix4x4& localMatrix)
+{
+	m_localToParentMatrix = localMatrix;
+	if (!m_hasParent)
+	{
+		m_localToWorldMatrix = m_localToParentMatrix;
+		++m_worldMatrixVersion;
+	}
+	m_isMatrixDirty = false;
+	m_isWorldMatrixDirty = true;
+}
+
+void TransformComponent::BuildWorldMatrix(const cd::Matrix4x4* pParentWorldMatrix)
+{
+	Build();
+	m_localToWorldMatrix = pParentWorldMatrix ? *pParentWorldMatrix * m_localToParentMatrix : m_localToParentMatrix;
+	m_isWorldMatrixDirty = false;
+	++m_worldMatrixVersion;
+}
 #ifdef EDITOR_MODE
 bool TransformComponent::m_doUseUniformScale = false;
 #endif
@@ -27,13 +27,33 @@ public:
 	cd::Transform& GetTransform() { return m_transform; }
 	void SetTransform(cd::Transform transform) { m_transform = cd::MoveTemp(transform); m_isMatrixDirty = true;  }
 
+	const cd::Matrix4x4& GetLocalMatrix() const { return m_localToParentMatrix; }
 	const cd::Matrix4x4& GetWorldMatrix() const { return m_localToWorldMatrix; }
 
 	void Dirty() const { m_isMatrixDirty = true; }
+	bool IsMatrixDirty() const { return m_isMatrixDirty; }
+
+	// Returns true if local matrix changed after last world matrix propagation.
+	bool IsWorldMatrixDirty() const { return m_isMatrixDirty || m_isWorldMatrixDirty; }
+
+	// Set by TransformHierarchy. World matrix of a child is only built with its parent's world matrix.
+	void SetHasParent(bool hasParent) { m_hasParent = hasParent; }
+	bool HasParent() const { return m_hasParent; }
+
+	// Increased when world matrix changes so that systems can find moved entities without comparing matrices.
+	uint32_t GetWorldMatrixVersion() const { return m_worldMatrixVersion; }
 
 	void Reset();
+
+	// Build local matrix if transform changed. World matrix is the same as local matrix if it has no parent.
 	void Build();
 
+	// Same as Build but local matrix is built outside, e.g. by TransformBatch for many transforms at once.
+	void SetLocalMatrix(const cd::Matrix4x4& localMatrix);
+
+	// Build world matrix by parent's world matrix. nullptr means it is a root.
+	void BuildWorldMatrix(const cd::Matrix4x4* pParentWorldMatrix);
+
 #ifdef EDITOR_MODE
 	static bool DoUseUniformScale() { return m_doUseUniformScale; }
 	static void SetUseUniformScale(bool use) { m_doUseUniformScale = use; }
@@ -44,9 +64,13 @@ private:
 	cd::Transform m_transform;
 
 	// Status
-	mutable bool m_isMatrixDirty;
+	mutable bool m_isMatrixDirty = true;
+	bool m_isWorldMatrixDirty = true;
+	bool m_hasParent = false;
+	uint32_t m_worldMatrixVersion = 0U;
 
 	// Output
+	cd::Matrix4x4 m_localToParentMatrix;
 	cd::Matrix4x4 m_localToWorldMatrix;
 
 #ifdef EDITOR_MODE
@@ -0,0 +1,389 @@
+#include "TransformHierarchy.h"
+
+#include "Core/Jobs/JobSystem.h"
+#include "Core/Math/TransformBatch.h"
+#include "ECWorld/HierarchyComponent.h"
+#include "ECWorld/MaterialComponent.h"
+#include "ECWorld/StaticMeshComponent.h"
+#include "ECWorld/TransformComponent.h"
+#include "Log/Log.h"
+
+#include <atomic>
+
+namespace engine
+{
+
+namespace
+{
+
+// Marks a stack item as leaving the node's subtree in depth first traversal.
+constexpr uint32_t SubtreeExitBit = 1U << 31;
+
+// Reused by BuildLocalMatrices in every thread to avoid allocations per frame.
+thread_local TransformBatch t_transformBatch;
+thread_local std::vector<TransformComponent*> t_pDirtyTransforms;
+thread_local std::vector<cd::Matrix4x4> t_localMatrices;
+
+}
+
+TransformHierarchy::TransformHierarchy(ComponentsStorage<HierarchyComponent>* pHierarchyStorage, ComponentsStorage<TransformComponent>* pTransformStorage)
+	: m_pHierarchyStorage(pHierarchyStorage)
+	, m_pTransformStorage(pTransformStorage)
+{
+	assert(pHierarchyStorage && pTransformStorage);
+}
+
+void TransformHierarchy::Update(JobSystem* pJobSystem)
+{
+	if (m_isTopologyDirty ||
+		m_hierarchyVersion != m_pHierarchyStorage->GetVersion() ||
+		m_transformVersion != m_pTransformStorage->GetVersion())
+	{
+		Rebuild();
+	}
+
+	const uint32_t nodeCount = static_cast<uint32_t>(m_pTransforms.size());
+	if (pJobSystem)
+	{
+		pJobSystem->ParallelFor(nodeCount, LocalMatrixBatchSize, [this](uint32_t beginIndex, uint32_t endIndex)
+		{
+			BuildLocalMatrices(beginIndex, endIndex);
+		});
+	}
+	else
+	{
+		BuildLocalMatrices(0U, nodeCount);
+	}
+
+	uint32_t updatedCount = 0U;
+	for (uint32_t nodeIndex : m_serialIndexes)
+	{
+		updatedCount += UpdateNode(nodeIndex);
+	}
+
+	const uint32_t rangeCount = static_cast<uint32_t>(m_rangeBeginIndexes.size());
+	if (pJobSystem && rangeCount > 1U)
+	{
+		std::atomic<uint32_t> parallelUpdatedCount = 0U;
+		pJobSystem->ParallelFor(rangeCount, 1U, [this, &parallelUpdatedCount](uint32_t beginRange, uint32_t endRange)
+		{
+			uint32_t rangeUpdatedCount = 0U;
+			for (uint32_t rangeIndex = beginRange; rangeIndex < endRange; ++rangeIndex)
+			{
+				rangeUpdatedCount += UpdateRange(m_rangeBeginIndexes[rangeIndex], m_rangeEndIndexes[rangeIndex]);
+			}
+			parallelUpdatedCount.fetch_add(rangeUpdatedCount, std::memory_order_relaxed);
+		});
+		updatedCount += parallelUpdatedCount.load();
+	}
+	else
+	{
+		for (uint32_t rangeIndex = 0U; rangeIndex < rangeCount; ++rangeIndex)
+		{
+			updatedCount += UpdateRange(m_rangeBeginIndexes[rangeIndex], m_rangeEndIndexes[rangeIndex]);
+		}
+	}
+
+	if (m_pStaticMeshArchetype)
+	{
+		updatedCount += UpdateArchetype(pJobSystem);
+	}
+
+	m_updatedCount = updatedCount;
+	m_isFullUpdateRequired = false;
+}
+
+void TransformHierarchy::Rebuild()
+{
+	const std::vector<Entity>& entities = m_pTransformStorage->GetEntities();
+	const uint32_t nodeCount = static_cast<uint32_t>(entities.size());
+	assert(nodeCount < SubtreeExitBit);
+
+	// Children lists by dense indexes of transform storage.
+	std::vector<uint32_t> parentDenseIndexes(nodeCount, InvalidIndex);
+	std::vector<uint32_t> childOffsets(nodeCount + 1U, 0U);
+	for (uint32_t denseIndex = 0U; denseIndex < nodeCount; ++denseIndex)
+	{
+		const HierarchyComponent* pHierarchyComponent = m_pHierarchyStorage->GetComponent(entities[denseIndex]);
+		if (!pHierarchyComponent || pHierarchyComponent->GetParentEntity() == entities[denseIndex])
+		{
+			continue;
+		}
+
+		// Parent without TransformComponent is treated as identity.
+		uint32_t parentDenseIndex = m_pTransformStorage->GetDenseIndex(pHierarchyComponent->GetParentEntity());
+		if (InvalidIndex != parentDenseIndex)
+		{
+			parentDenseIndexes[denseIndex] = parentDenseIndex;
+			++childOffsets[parentDenseIndex + 1U];
+		}
+	}
+
+	for (uint32_t denseIndex = 0U; denseIndex < nodeCount; ++denseIndex)
+	{
+		childOffsets[denseIndex + 1U] += childOffsets[denseIndex];
+	}
+
+	std::vector<uint32_t> children(childOffsets[nodeCount]);
+	std::vector<uint32_t> childCursors(childOffsets.begin(), childOffsets.end() - 1);
+	for (uint32_t denseIndex = 0U; denseIndex < nodeCount; ++denseIndex)
+	{
+		if (InvalidIndex != parentDenseIndexes[denseIndex])
+		{
+			children[childCursors[parentDenseIndexes[denseIndex]]++] = denseIndex;
+		}
+	}
+
+	// Depth first traversal from roots. Nodes in cycles are not reachable from roots so they are visited at last.
+	m_sortedEntities.clear();
+	m_pTransforms.clear();
+	m_parentIndexes.clear();
+	m_subtreeEnds.assign(nodeCount, 0U);
+	m_worldMatrixChanged.assign(nodeCount, 0U);
+	m_sortedEntities.reserve(nodeCount);
+	m_pTransforms.reserve(nodeCount);
+	m_parentIndexes.reserve(nodeCount);
+
+	std::vector<uint32_t> denseToSortedIndexes(nodeCount, InvalidIndex);
+	std::vector<uint32_t> stack;
+	auto VisitSubtree = [&](uint32_t rootDenseIndex)
+	{
+		stack.push_back(rootDenseIndex);
+		while (!stack.empty())
+		{
+			uint32_t item = stack.back();
+			stack.pop_back();
+			if (item & SubtreeExitBit)
+			{
+				m_subtreeEnds[denseToSortedIndexes[item & ~SubtreeExitBit]] = static_cast<uint32_t>(m_sortedEntities.size());
+				continue;
+			}
+
+			uint32_t sortedIndex = static_cast<uint32_t>(m_sortedEntities.size());
+			denseToSortedIndexes[item] = sortedIndex;
+
+			uint32_t parentDenseIndex = parentDenseIndexes[item];
+			uint32_t parentIndex = InvalidIndex == parentDenseIndex ? InvalidIndex : denseToSortedIndexes[parentDenseIndex];
+			TransformComponent* pTransformComponent = &m_pTransformStorage->GetDenseComponents()[item];
+			pTransformComponent->SetHasParent(InvalidIndex != parentIndex);
+			m_sortedEntities.push_back(entities[item]);
+			m_pTransforms.push_back(pTransformComponent);
+			m_parentIndexes.push_back(parentIndex);
+
+			// Push children reversely so that they are visited by the order in storage.
+			stack.push_back(item | SubtreeExitBit);
+			for (uint32_t childOffset = childOffsets[item + 1U]; childOffset > childOffsets[item]; --childOffset)
+			{
+				uint32_t childDenseIndex = children[childOffset - 1U];
+				if (InvalidIndex == denseToSortedIndexes[childDenseIndex])
+				{
+					stack.push_back(childDenseIndex);
+				}
+			}
+		}
+	};
+
+	for (uint32_t denseIndex = 0U; denseIndex < nodeCount; ++denseIndex)
+	{
+		if (InvalidIndex == parentDenseIndexes[denseIndex])
+		{
+			VisitSubtree(denseIndex);
+		}
+	}
+
+	if (m_sortedEntities.size() != nodeCount)
+	{
+		CD_ENGINE_WARN("Transform hierarchy has cycles. Entities in cycles are treated as roots.");
+		for (uint32_t denseIndex = 0U; denseIndex < nodeCount; ++denseIndex)
+		{
+			if (InvalidIndex == denseToSortedIndexes[denseIndex])
+			{
+				VisitSubtree(denseIndex);
+			}
+		}
+	}
+
+	// Split large subtrees until the remaining ones are small enough to be parallel ranges.
+	// Use a stack to visit nodes in depth first order so that serial nodes are still parent before child.
+	m_serialIndexes.clear();
+	m_rangeBeginIndexes.clear();
+	m_rangeEndIndexes.clear();
+	for (uint32_t nodeIndex = nodeCount; nodeIndex > 0U; --nodeIndex)
+	{
+		if (InvalidIndex == m_parentIndexes[nodeIndex - 1U])
+		{
+			stack.push_back(nodeIndex - 1U);
+		}
+	}
+
+	std::vector<uint32_t> childIndexes;
+	while (!stack.empty())
+	{
+		uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+
+		uint32_t subtreeEnd = m_subtreeEnds[nodeIndex];
+		if (subtreeEnd - nodeIndex <= ParallelRangeSize)
+		{
+			// Neighbor small subtrees are merged into one range.
+			if (!m_rangeEndIndexes.empty() && m_rangeEndIndexes.back() == nodeIndex &&
+				subtreeEnd - m_rangeBeginIndexes.back() <= ParallelRangeSize)
+			{
+				m_rangeEndIndexes.back() = subtreeEnd;
+			}
+			else
+			{
+				m_rangeBeginIndexes.push_back(nodeIndex);
+				m_rangeEndIndexes.push_back(subtreeEnd);
+			}
+			continue;
+		}
+
+		m_serialIndexes.push_back(nodeIndex);
+
+		childIndexes.clear();
+		for (uint32_t childIndex = nodeIndex + 1U; childIndex < subtreeEnd; childIndex = m_subtreeEnds[childIndex])
+		{
+			childIndexes.push_back(childIndex);
+		}
+		stack.insert(stack.end(), childIndexes.rbegin(), childIndexes.rend());
+	}
+
+	m_hierarchyVersion = m_pHierarchyStorage->GetVersion();
+	m_transformVersion = m_pTransformStorage->GetVersion();
+	m_isTopologyDirty = false;
+
+	// Parents may be changed so that all world matrices are rebuilt once.
+	m_isFullUpdateRequired = true;
+}
+
+void TransformHierarchy::BuildLocalMatrices(uint32_t beginIndex, uint32_t endIndex)
+{
+	t_transformBatch.Clear();
+	t_pDirtyTransforms.clear();
+	for (uint32_t nodeIndex = beginIndex; nodeIndex < endIndex; ++nodeIndex)
+	{
+		TransformComponent* pTransformComponent = m_pTransforms[nodeIndex];
+		if (pTransformComponent->IsMatrixDirty())
+		{
+			t_transformBatch.Add(pTransformComponent->GetTransform());
+			t_pDirtyTransforms.push_back(pTransformComponent);
+		}
+	}
+
+	const uint32_t dirtyCount = t_transformBatch.GetCount();
+	if (0U == dirtyCount)
+	{
+		return;
+	}
+
+	t_localMatrices.resize(dirtyCount);
+	t_transformBatch.BuildMatrices(t_localMatrices.data());
+	for (uint32_t dirtyIndex = 0U; dirtyIndex < dirtyCount; ++dirtyIndex)
+	{
+		t_pDirtyTransforms[dirtyIndex]->SetLocalMatrix(t_localMatrices[dirtyIndex]);
+	}
+}
+
+uint32_t TransformHierarchy::UpdateNode(uint32_t nodeIndex)
+{
+	TransformComponent* pTransformComponent = m_pTransforms[nodeIndex];
+	uint32_t parentIndex = m_parentIndexes[nodeIndex];
+	bool isParentChanged = InvalidIndex != parentIndex && m_worldMatrixChanged[parentIndex];
+	if (!m_isFullUpdateRequired && !isParentChanged && !pTransformComponent->IsWorldMatrixDirty())
+	{
+		m_worldMatrixChanged[nodeIndex] = 0U;
+		return 0U;
+	}
+
+	pTransformComponent->BuildWorldMatrix(InvalidIndex == parentIndex ? nullptr : &m_pTransforms[parentIndex]->GetWorldMatrix());
+	m_worldMatrixChanged[nodeIndex] = 1U;
+	return 1U;
+}
+
+uint32_t TransformHierarchy::UpdateRange(uint32_t beginIndex, uint32_t endIndex)
+{
+	uint32_t updatedCount = 0U;
+	for (uint32_t nodeIndex = beginIndex; nodeIndex < endIndex; ++nodeIndex)
+	{
+		updatedCount += UpdateNode(nodeIndex);
+	}
+
+	return updatedCount;
+}
+
+uint32_t TransformHierarchy::UpdateArchetype(JobSystem* pJobSystem)
+{
+	m_archetypeChunks.clear();
+	m_pStaticMeshArchetype->EachChunk([this](const Entity*, uint32_t count, TransformComponent* pTransforms, StaticMeshComponent*, MaterialComponent*)
+	{
+		m_archetypeChunks.emplace_back(pTransforms, count);
+	});
+
+	const uint32_t chunkCount = static_cast<uint32_t>(m_archetypeChunks.size());
+	if (!pJobSystem || chunkCount <= 1U)
+	{
+		uint32_t updatedCount = 0U;
+		for (const auto& [pTransforms, count] : m_archetypeChunks)
+		{
+			updatedCount += UpdateArchetypeChunk(pTransforms, count);
+		}
+
+		return updatedCount;
+	}
+
+	std::atomic<uint32_t> updatedCount = 0U;
+	pJobSystem->ParallelFor(chunkCount, 1U, [this, &updatedCount](uint32_t beginChunk, uint32_t endChunk)
+	{
+		uint32_t chunkUpdatedCount = 0U;
+		for (uint32_t chunkIndex = beginChunk; chunkIndex < endChunk; ++chunkIndex)
+		{
+			chunkUpdatedCount += UpdateArchetypeChunk(m_archetypeChunks[chunkIndex].first, m_archetypeChunks[chunkIndex].second);
+		}
+		updatedCount.fetch_add(chunkUpdatedCount, std::memory_order_relaxed);
+	});
+
+	return updatedCount.load();
+}
+
+uint32_t TransformHierarchy::UpdateArchetypeChunk(TransformComponent* pTransforms, uint32_t count)
+{
+	t_transformBatch.Clear();
+	t_pDirtyTransforms.clear();
+	for (uint32_t transformIndex = 0U; transformIndex < count; ++transformIndex)
+	{
+		TransformComponent* pTransformComponent = &pTransforms[transformIndex];
+		if (pTransformComponent->IsMatrixDirty())
+		{
+			t_transformBatch.Add(pTransformComponent->GetTransform());
+			t_pDirtyTransforms.push_back(pTransformComponent);
+		}
+	}
+
+	const uint32_t dirtyCount = t_transformBatch.GetCount();
+	if (dirtyCount > 0U)
+	{
+		t_localMatrices.resize(dirtyCount);
+		t_transformBatch.BuildMatrices(t_localMatrices.data());
+		for (uint32_t dirtyIndex = 0U; dirtyIndex < dirtyCount; ++dirtyIndex)
+		{
+			t_pDirtyTransforms[dirtyIndex]->SetLocalMatrix(t_localMatrices[dirtyIndex]);
+		}
+	}
+
+	// Transforms which are built outside, e.g. by importers, still need their world matrices to be marked clean once.
+	uint32_t updatedCount = 0U;
+	for (uint32_t transformIndex = 0U; transformIndex < count; ++transformIndex)
+	{
+		TransformComponent& transformComponent = pTransforms[transformIndex];
+		if (transformComponent.IsWorldMatrixDirty())
+		{
+			transformComponent.BuildWorldMatrix(nullptr);
+			++updatedCount;
+		}
+	}
+
+	return updatedCount;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ECWorld/ArchetypeStorage.hpp"
+#include "ECWorld/ComponentsStorage.hpp"
+#include "ECWorld/Entity.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+
+class HierarchyComponent;
+class JobSystem;
+class TransformComponent;
+
+// TransformHierarchy composes local transforms with parents' world matrices.
+// Entities which have TransformComponent are sorted in depth first order so that parents are always before children
+// and every subtree is a continuous range. World matrices are only rebuilt for dirty transforms and their subtrees.
+// Dirty local matrices are built in SIMD batches at first, then large subtrees are split into
+// independent ranges which are updated in parallel.
+class TransformHierarchy final
+{
+public:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	// Subtrees which have more nodes than it are split into their children's subtrees.
+	static constexpr uint32_t ParallelRangeSize = 2048;
+
+	// Nodes count of a job to build dirty local matrices in SIMD batches.
+	static constexpr uint32_t LocalMatrixBatchSize = 4096;
+
+public:
+	TransformHierarchy() = delete;
+	explicit TransformHierarchy(ComponentsStorage<HierarchyComponent>* pHierarchyStorage, ComponentsStorage<TransformComponent>* pTransformStorage);
+	TransformHierarchy(const TransformHierarchy&) = delete;
+	TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+	TransformHierarchy(TransformHierarchy&&) = default;
+	TransformHierarchy& operator=(TransformHierarchy&&) = default;
+	~TransformHierarchy() = default;
+
+	// Entities in StaticMeshArchetype have no HierarchyComponents so that they are roots.
+	// Their world matrices are built chunk by chunk after the hierarchy. nullptr means that the World doesn't use it.
+	void SetStaticMeshArchetype(StaticMeshArchetype* pStaticMeshArchetype) { m_pStaticMeshArchetype = pStaticMeshArchetype; }
+
+	// Creating or removing components is detected automatically. Call it after changing parent of an existing HierarchyComponent.
+	void MarkTopologyDirty() { m_isTopologyDirty = true; }
+
+	// pJobSystem is optional. Update serially if it is nullptr.
+	void Update(JobSystem* pJobSystem = nullptr);
+
+	// Entities in the order of update which is parent before child.
+	const std::vector<Entity>& GetSortedEntities() const { return m_sortedEntities; }
+
+	// Counts of world matrices rebuilt by last Update.
+	uint32_t GetUpdatedCount() const { return m_updatedCount; }
+
+private:
+	void Rebuild();
+	void BuildLocalMatrices(uint32_t beginIndex, uint32_t endIndex);
+	uint32_t UpdateNode(uint32_t nodeIndex);
+	uint32_t UpdateRange(uint32_t beginIndex, uint32_t endIndex);
+	uint32_t UpdateArchetype(JobSystem* pJobSystem);
+	uint32_t UpdateArchetypeChunk(TransformComponent* pTransforms, uint32_t count);
+
+private:
+	ComponentsStorage<HierarchyComponent>* m_pHierarchyStorage;
+	ComponentsStorage<TransformComponent>* m_pTransformStorage;
+	uint32_t m_hierarchyVersion = UINT32_MAX;
+	uint32_t m_transformVersion = UINT32_MAX;
+	bool m_isTopologyDirty = true;
+	bool m_isFullUpdateRequired = true;
+
+	// Flat arrays in depth first order.
+	std::vector<Entity> m_sortedEntities;
+	std::vector<TransformComponent*> m_pTransforms;
+	std::vector<uint32_t> m_parentIndexes;
+	std::vector<uint32_t> m_subtreeEnds;
+	std::vector<uint8_t> m_worldMatrixChanged;
+
+	// Ancestors of large subtrees are updated serially in depth first order,
+	// then the remaining ranges don't depend on each other.
+	std::vector<uint32_t> m_serialIndexes;
+	std::vector<uint32_t> m_rangeBeginIndexes;
+	std::vector<uint32_t> m_rangeEndIndexes;
+
+	StaticMeshArchetype* m_pStaticMeshArchetype = nullptr;
+	std::vector<std::pair<TransformComponent*, uint32_t>> m_archetypeChunks;
+
+	uint32_t m_updatedCount = 0U;
+};
+
+}
\ No newline at end of file
@@ -1,12 +1,15 @@
 #pragma once
 
+#include "ArchetypeStorage.hpp"
 #include "ComponentsStorage.hpp"
+#include "ComponentsView.hpp"
 #include "Entity.h"
 #include "Core/StringCrc.h"
 
 #include <atomic>
 #include <cassert>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace engine
@@ -58,8 +61,36 @@ public:
 		return pStorage->CreateComponent(entity);
 	}
 
+	// Query entities which own all of the Components types.
+	template<typename... Components>
+	ComponentsView<Components...> View()
+	{
+		return ComponentsView<Components...>(GetComponents<Components>()...);
+	}
+
+	// Archetype storage is optional. A World registers an archetype when entities with exactly these Components
+	// are iterated together frequently, e.g. render extraction. These Components are not visible in GetComponents() and View()
+	// so that systems which should see them take the archetype explicitly, see SceneWorld::GetStaticMeshArchetype.
+	template<typename... Components>
+	ArchetypeStorage<Components...>* RegisterArchetype()
+	{
+		constexpr uint32_t archetypeKey = ArchetypeStorage<Components...>::GetArchetypeKey();
+		assert(m_archetypesLib.find(archetypeKey) == m_archetypesLib.end());
+		m_archetypesLib[archetypeKey] = std::make_unique<ArchetypeStorage<Components...>>();
+		return static_cast<ArchetypeStorage<Components...>*>(m_archetypesLib[archetypeKey].get());
+	}
+
+	template<typename... Components>
+	ArchetypeStorage<Components...>* GetArchetype()
+	{
+		constexpr uint32_t archetypeKey = ArchetypeStorage<Components...>::GetArchetypeKey();
+		assert(m_archetypesLib.find(archetypeKey) != m_archetypesLib.end());
+		return static_cast<ArchetypeStorage<Components...>*>(m_archetypesLib[archetypeKey].get());
+	}
+
 private:
 	std::unordered_map<size_t, std::unique_ptr<IComponentsStorage>> m_componentsLib;
+	std::unordered_map<uint32_t, std::unique_ptr<IComponentsStorage>> m_archetypesLib;
 };
 
 }
\ No newline at end of file
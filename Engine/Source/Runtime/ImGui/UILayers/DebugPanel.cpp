@@ -1,5 +1,6 @@
 #include "DebugPanel.h"
 #include "Display/CameraController.h"
+#include "ECWorld/SceneWorld.h"
 #include "ImGui/IconFont/IconsMaterialDesignIcons.h"
 
 #include <bgfx/bgfx.h>
@@ -77,11 +78,12 @@ void DebugPanel::Init()
 
 void DebugPanel::Update()
 {
-	ImGui::SetNextWindowSize(ImVec2(350, 200.0f));
+	ImGui::SetNextWindowSize(ImVec2(350, 240.0f));
 
 	ImGui::Begin(GetName(), &m_isEnable);
 
 	ShowProfiler();
+	ShowCullingStats();
 
 	ImGui::Separator();
 
@@ -147,7 +149,9 @@ void DebugPanel::ShowProfiler()
 		, static_cast<float>(stats->gpuTimeEnd - stats->gpuTimeBegin) * toMsGpu
 		, stats->maxGpuLatency
 	);
-	
+
+	ImGui::Text("Draw calls %u, Compute calls %u", stats->numDraw, stats->numCompute);
+
 	if (-INT64_MAX != stats->gpuMemoryUsed)
 	{
 		char tmp0[64];
@@ -160,4 +164,55 @@ void DebugPanel::ShowProfiler()
 	}
 }
 
+void DebugPanel::ShowCullingStats()
+{
+	SceneWorld* pSceneWorld = GetSceneWorld();
+	if (!pSceneWorld)
+	{
+		return;
+	}
+
+	FrustumCuller* pFrustumCuller = pSceneWorld->GetFrustumCuller();
+	bool isCullingEnable = pFrustumCuller->IsEnable();
+	if (ImGui::Checkbox("Frustum Culling", &isCullingEnable))
+	{
+		pFrustumCuller->SetEnable(isCullingEnable);
+	}
+
+	ImGui::SameLine();
+	bool isOcclusionEnable = pFrustumCuller->IsOcclusionEnable();
+	if (ImGui::Checkbox("Occlusion Culling", &isOcclusionEnable))
+	{
+		pFrustumCuller->SetOcclusionEnable(isOcclusionEnable);
+	}
+
+	ImGui::SameLine();
+	bool isSoftwareOcclusionEnable = pFrustumCuller->IsSoftwareOcclusionEnable();
+	if (ImGui::Checkbox("Software Occlusion", &isSoftwareOcclusionEnable))
+	{
+		pFrustumCuller->SetSoftwareOcclusionEnable(isSoftwareOcclusionEnable);
+	}
+
+	ImGui::Text("Visible %u, Culled %u, Occluded %u, Occluders %u", pFrustumCuller->GetVisibleCount(), pFrustumCuller->GetCulledCount(),
+		pFrustumCuller->GetOccludedCount(), pFrustumCuller->GetOccluderCount());
+
+	MeshLODSelector* pMeshLODSelector = pSceneWorld->GetMeshLODSelector();
+	bool isLODEnable = pMeshLODSelector->IsEnable();
+	if (ImGui::Checkbox("Mesh LOD", &isLODEnable))
+	{
+		pMeshLODSelector->SetEnable(isLODEnable);
+	}
+
+	// In pixels of a 1080p viewport.
+	ImGui::SameLine();
+	float maxScreenError = pMeshLODSelector->GetMaxScreenError() * 1080.0f;
+	if (ImGui::SliderFloat("Max LOD Error", &maxScreenError, 0.0f, 16.0f))
+	{
+		pMeshLODSelector->SetMaxScreenError(maxScreenError / 1080.0f);
+	}
+
+	ImGui::Text("LOD Meshes %u, %u, %u, %u", pMeshLODSelector->GetLODMeshCount(0), pMeshLODSelector->GetLODMeshCount(1),
+		pMeshLODSelector->GetLODMeshCount(2), pMeshLODSelector->GetLODMeshCount(3));
+}
+
 }
\ No newline at end of file
@@ -18,6 +18,7 @@ public:
 	void SetCameraController(std::shared_ptr<engine::CameraController> cameraController) { m_pCameraController = cameraController; }
 
 	void ShowProfiler();
+	void ShowCullingStats();
 
 private:
 	std::shared_ptr<engine::CameraController> m_pCameraController;
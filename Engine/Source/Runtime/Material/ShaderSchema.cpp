@@ -86,18 +86,48 @@ void ShaderSchema::SetCompiledProgram(StringCrc uberOption, uint16_t programHand
 {
 	assert(IsUberOptionValid(uberOption));
 	m_compiledProgramHandles[uberOption.Value()] = programHandle;
+	++m_programVersion;
 }
 
 uint16_t ShaderSchema::GetCompiledProgram(StringCrc uberOption) const
 {
 	auto itProgram = m_compiledProgramHandles.find(uberOption.Value());
 	assert(itProgram != m_compiledProgramHandles.end());
-	uint16_t programHandle = itProgram->second;
+	return itProgram->second;
+}
+
+void ShaderSchema::RequestProgram(StringCrc uberOption) const
+{
+	assert(IsUberOptionValid(uberOption));
+	if (IsProgramCompiled(uberOption) || !m_requestedUberOptions.insert(uberOption.Value()).second)
+	{
+		return;
+	}
 
-	// Registered but not compiled.
-	assert(programHandle != InvalidProgramHandle);
+	auto itCombine = std::find_if(m_uberCombines.begin(), m_uberCombines.end(),
+		[&uberOption](const std::string& combine) { return StringCrc(combine) == uberOption; });
+	assert(itCombine != m_uberCombines.end());
+	m_newRequestedUberCombines.push_back(*itCombine);
+}
 
-	return programHandle;
+std::vector<std::string> ShaderSchema::TakeRequestedUberCombines()
+{
+	std::vector<std::string> requestedCombines;
+	requestedCombines.swap(m_newRequestedUberCombines);
+	return requestedCombines;
+}
+
+void ShaderSchema::SetCompiledInstanceProgram(StringCrc uberOption, uint16_t programHandle)
+{
+	assert(IsUberOptionValid(uberOption));
+	m_compiledInstanceProgramHandles[uberOption.Value()] = programHandle;
+	++m_programVersion;
+}
+
+uint16_t ShaderSchema::GetCompiledInstanceProgram(StringCrc uberOption) const
+{
+	auto itProgram = m_compiledInstanceProgramHandles.find(uberOption.Value());
+	return itProgram != m_compiledInstanceProgramHandles.end() ? itProgram->second : InvalidProgramHandle;
 }
 
 StringCrc ShaderSchema::GetOptionsCrc(const std::unordered_set<Uber>& options) const
@@ -131,6 +161,16 @@ void ShaderSchema::AddUberOptionVSBlob(ShaderBlob shaderBlob)
 	m_pVSBlob = std::make_unique<ShaderBlob>(cd::MoveTemp(shaderBlob));
 }
 
+void ShaderSchema::AddInstanceVSBlob(ShaderBlob shaderBlob)
+{
+	if (m_pInstanceVSBlob)
+	{
+		return;
+	}
+
+	m_pInstanceVSBlob = std::make_unique<ShaderBlob>(cd::MoveTemp(shaderBlob));
+}
+
 void ShaderSchema::AddUberOptionFSBlob(StringCrc uberOption, ShaderBlob shaderBlob)
 {
 	if (m_uberOptionToFSBlobs.find(uberOption.Value()) != m_uberOptionToFSBlobs.end())
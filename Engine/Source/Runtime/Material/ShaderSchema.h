@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Base/Template.h"
 #include "Core/StringCrc.h"
 
 #include <map>
@@ -44,6 +45,7 @@ class ShaderSchema
 {
 public:
 	static constexpr uint16_t InvalidProgramHandle = UINT16_MAX;
+	static constexpr uint16_t InvalidShaderHandle = UINT16_MAX;
 	static constexpr StringCrc DefaultUberShaderCrc = StringCrc("");
 	using ShaderBlob = std::vector<std::byte>;
 
@@ -59,14 +61,46 @@ public:
 	const char* GetVertexShaderPath() const { return m_vertexShaderPath.c_str(); }
 	const char* GetFragmentShaderPath() const { return m_fragmentShaderPath.c_str(); }
 
+	// Optional vertex shader which reads world matrices from instance data.
+	// It is combined with every fragment uber shader to draw instances which have the same mesh and material.
+	void SetInstanceVertexShaderPath(std::string vsPath) { m_instanceVertexShaderPath = cd::MoveTemp(vsPath); }
+	const char* GetInstanceVertexShaderPath() const { return m_instanceVertexShaderPath.c_str(); }
+	bool HasInstanceVertexShader() const { return !m_instanceVertexShaderPath.empty(); }
+
 	// This option will combien with every exists combination.
 	void RegisterUberOption(Uber uberOption);
 
 	bool IsUberOptionValid(StringCrc uberOption) const;
 	StringCrc GetOptionsCrc(const std::unordered_set<Uber>& options) const;
 
+	// In lazy mode, only the DEFAULT variant is built and loaded at startup.
+	// Other variants are built and loaded after materials request them and the DEFAULT program is used as a fallback before that.
+	void SetLazyVariants(bool lazy) { m_isLazyVariants = lazy; }
+	bool IsLazyVariants() const { return m_isLazyVariants; }
+
 	void SetCompiledProgram(StringCrc uberOption, uint16_t programHandle);
+	// Returns InvalidProgramHandle if the option is registered but not compiled.
 	uint16_t GetCompiledProgram(StringCrc uberOption) const;
+	bool IsProgramCompiled(StringCrc uberOption) const { return InvalidProgramHandle != GetCompiledProgram(uberOption); }
+
+	// Records a registered variant which is not compiled. Every variant is only requested once. Call it in the main thread.
+	// It is const as materials request variants when their programs are queried.
+	void RequestProgram(StringCrc uberOption) const;
+	// Returns uber combines of variants which are requested since last call.
+	std::vector<std::string> TakeRequestedUberCombines();
+
+	// Vertex shaders are shared by programs of all variants so that they are kept to create programs of variants loaded later.
+	void SetVertexShaderHandle(uint16_t shaderHandle) { m_vertexShaderHandle = shaderHandle; }
+	uint16_t GetVertexShaderHandle() const { return m_vertexShaderHandle; }
+	void SetInstanceVertexShaderHandle(uint16_t shaderHandle) { m_instanceVertexShaderHandle = shaderHandle; }
+	uint16_t GetInstanceVertexShaderHandle() const { return m_instanceVertexShaderHandle; }
+
+	// Returns InvalidProgramHandle if there is no instance vertex shader or instancing is not supported.
+	void SetCompiledInstanceProgram(StringCrc uberOption, uint16_t programHandle);
+	uint16_t GetCompiledInstanceProgram(StringCrc uberOption) const;
+
+	// Increased when any compiled program handle changes so that cached handles can be refreshed.
+	uint32_t GetProgramVersion() const { return m_programVersion; }
 
 	const std::vector<Uber>& GetUberOptions() const { return m_uberOptions; }
 	const std::vector<std::string>& GetUberCombines() const { return m_uberCombines; }
@@ -74,6 +108,8 @@ public:
 
 	// TODO : More generic.
 	void AddUberOptionVSBlob(ShaderBlob shaderBlob);
+	void AddInstanceVSBlob(ShaderBlob shaderBlob);
+	const ShaderBlob& GetInstanceVSBlob() const { return *m_pInstanceVSBlob.get(); }
 	void AddUberOptionFSBlob(StringCrc uberOption, ShaderBlob shaderBlob);
 	const ShaderBlob& GetVSBlob() const { return *m_pVSBlob.get(); }
 	const ShaderBlob& GetFSBlob(StringCrc uberOption) const;
@@ -81,6 +117,7 @@ public:
 private:
 	std::string m_vertexShaderPath;
 	std::string m_fragmentShaderPath;
+	std::string m_instanceVertexShaderPath;
 
 	// Registration order of options. 
 	std::vector<Uber> m_uberOptions;
@@ -88,8 +125,18 @@ private:
 	std::vector<std::string> m_uberCombines;
 	// Key: StringCrc(option combine), Value: shader handle.
 	std::map<uint32_t, uint16_t> m_compiledProgramHandles;
+	std::map<uint32_t, uint16_t> m_compiledInstanceProgramHandles;
+	uint32_t m_programVersion = 0U;
+	uint16_t m_vertexShaderHandle = InvalidShaderHandle;
+	uint16_t m_instanceVertexShaderHandle = InvalidShaderHandle;
+
+	bool m_isLazyVariants = false;
+	// Key: StringCrc(option combine) of variants which are requested once.
+	mutable std::set<uint32_t> m_requestedUberOptions;
+	mutable std::vector<std::string> m_newRequestedUberCombines;
 
 	std::unique_ptr<ShaderBlob> m_pVSBlob;
+	std::unique_ptr<ShaderBlob> m_pInstanceVSBlob;
 	std::map<uint32_t, std::unique_ptr<ShaderBlob>> m_uberOptionToFSBlobs;
 };
 
@@ -38,7 +38,13 @@ void Process::Run()
 	}
 	environments.push_back(nullptr);
 
-	subprocess_create_ex(commandLine.data(), 0, environments.data(), m_pProcess.get());
+	m_exitCode = -1;
+	if (0 != subprocess_create_ex(commandLine.data(), 0, environments.data(), m_pProcess.get()))
+	{
+		CD_ENGINE_ERROR("Failed to start process {0}", m_processName.c_str());
+		m_pProcess.reset();
+		return;
+	}
 
 	// LOG
 	CD_ENGINE_INFO("Start process {0}", m_processName.c_str());
@@ -54,19 +60,20 @@ void Process::Run()
 
 	// Read logs from process.
 	using SubProcessReadLogFunction = unsigned (*)(struct subprocess_s* const, char* const, unsigned);
+	// Output is read into a local buffer as processes may run in multiple threads of ResourceBuilder at the same time.
 	auto PrintSubProcessLog = [](const char* pTagName, subprocess_s* const pSubProcess, SubProcessReadLogFunction readMethod)
 	{
-		static char processOutputData[65536] = { 0 };
-		uint32_t processOutputDataIndex = 0U;
+		char processOutputBuffer[4096];
+		std::string processOutputData;
 		uint32_t processOutputDataReadBytes = 0U;
 
 		do
 		{
-			processOutputDataReadBytes = readMethod(pSubProcess, processOutputData + processOutputDataIndex, sizeof(processOutputData) - 1 - processOutputDataIndex);
-			processOutputDataIndex += processOutputDataReadBytes;
+			processOutputDataReadBytes = readMethod(pSubProcess, processOutputBuffer, sizeof(processOutputBuffer));
+			processOutputData.append(processOutputBuffer, processOutputDataReadBytes);
 		} while (processOutputDataReadBytes != 0U);
 
-		if (processOutputDataIndex > 0U)
+		if (!processOutputData.empty())
 		{
 			// Logs from child process's stdout maybe error info because many tool authors will use stdout to print rather than stderr.
 			CD_ENGINE_ERROR("{0}\n{1}", pTagName, processOutputData);
@@ -79,9 +86,12 @@ void Process::Run()
 	if (m_waitUntilFinished)
 	{
 		int processResult;
-		subprocess_join(m_pProcess.get(), &processResult);
+		if (0 == subprocess_join(m_pProcess.get(), &processResult))
+		{
+			m_exitCode = processResult;
+		}
 	}
-	CD_ENGINE_INFO("End process {0}", m_processName.c_str());
+	CD_ENGINE_INFO("End process {0} with exit code {1}", m_processName.c_str(), m_exitCode);
 }
 
 }
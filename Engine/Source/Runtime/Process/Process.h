@@ -27,13 +27,17 @@ public:
 	void SetEnvironments(std::vector<std::string> environments) { m_environments = cd::MoveTemp(environments); }
 	void Run();
 
+	// Valid after Run if it waits until finished. -1 means that the process failed to start or didn't finish.
+	int GetExitCode() const { return m_exitCode; }
+
 private:
 	std::unique_ptr<subprocess_s> m_pProcess;
 
 	std::string m_processName;
 	std::vector<std::string> m_commandArguments;
 	std::vector<std::string> m_environments;
-	bool m_waitUntilFinished;
+	bool m_waitUntilFinished = false;
+	int m_exitCode = -1;
 };
 
 }
@@ -64,6 +68,7 @@ public:
 	void SetCommandArguments(std::vector<std::string> arguments) {}
 	void SetEnvironments(std::vector<std::string> environments) {}
 	void Run() {}
+	int GetExitCode() const { return 0; }
 };
 
 }
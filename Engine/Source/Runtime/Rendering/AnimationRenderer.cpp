@@ -131,6 +131,9 @@ void CalculateBoneTransform(std::vector<cd::Matrix4x4>& boneMatrices, const cd::
 	}
 };
 
+// Animated meshes in a chunk are encoded by one job.
+constexpr uint32_t MinEncodeChunkSize = 8U;
+
 }
 
 void AnimationRenderer::Init()
@@ -156,45 +159,65 @@ void AnimationRenderer::Render(float deltaTime)
 #ifdef VISUALIZE_BONE_WEIGHTS
 	constexpr float changeTime = 0.2f;
 	static float passedTime = 0.0f;
-	static float selectedBoneIndex[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 	passedTime += deltaTime;
 	if (passedTime > changeTime)
 	{
-		selectedBoneIndex[0] = selectedBoneIndex[0] + 1.0f;
-		if (selectedBoneIndex[0] > 100.0f)
+		m_selectedBoneIndex[0] = m_selectedBoneIndex[0] + 1.0f;
+		if (m_selectedBoneIndex[0] > 100.0f)
 		{
-			selectedBoneIndex[0] = 0.0f;
+			m_selectedBoneIndex[0] = 0.0f;
 		}
 		passedTime -= changeTime;
 	}
-
-	constexpr StringCrc boneIndexUniform("u_debugBoneIndex");
-	bgfx::setUniform(m_pRenderContext->GetUniform(boneIndexUniform), selectedBoneIndex, 1);
 #endif
 
-	static float animationRunningTime = 0.0f;
-	animationRunningTime += deltaTime;
+	m_animationRunningTime += deltaTime;
 
-	const cd::SceneDatabase* pSceneDatabase = m_pCurrentSceneWorld->GetSceneDatabase();
+	// Culled by bind pose bounding box.
+	const FrustumCuller* pFrustumCuller = m_pCurrentSceneWorld->GetFrustumCuller();
+	m_visibleEntities.clear();
 	for (Entity entity : m_pCurrentSceneWorld->GetAnimationEntities())
 	{
-		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
+		if (pFrustumCuller->IsVisible(entity) && m_pCurrentSceneWorld->GetStaticMeshComponent(entity) &&
+			m_pCurrentSceneWorld->GetTransformComponent(entity))
 		{
-			continue;
+			m_visibleEntities.push_back(entity);
 		}
+	}
+
+	// Bone matrices are calculated in encoding jobs as they cost more than encoding.
+	ParallelEncode(static_cast<uint32_t>(m_visibleEntities.size()), details::MinEncodeChunkSize, [this](bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex)
+	{
+		EncodeDraws(pEncoder, beginIndex, endIndex);
+	});
+}
 
-		TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
-		bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
+void AnimationRenderer::EncodeDraws(bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex) const
+{
+#ifdef VISUALIZE_BONE_WEIGHTS
+	constexpr StringCrc boneIndexUniform("u_debugBoneIndex");
+	GetRenderContext()->FillUniform(pEncoder, boneIndexUniform, m_selectedBoneIndex, 1);
+#endif
+
+	constexpr StringCrc animationProgram("AnimationProgram");
+	const bgfx::ProgramHandle programHandle = GetRenderContext()->GetProgram(animationProgram);
+
+	const cd::SceneDatabase* pSceneDatabase = m_pCurrentSceneWorld->GetSceneDatabase();
+	std::vector<cd::Matrix4x4> boneMatrices;
+	for (uint32_t entityIndex = beginIndex; entityIndex < endIndex; ++entityIndex)
+	{
+		Entity entity = m_visibleEntities[entityIndex];
+		const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+		const TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
+		pEncoder->setTransform(pTransformComponent->GetWorldMatrix().Begin());
 
-		AnimationComponent* pAnimationComponent = m_pCurrentSceneWorld->GetAnimationComponent(entity);
+		const AnimationComponent* pAnimationComponent = m_pCurrentSceneWorld->GetAnimationComponent(entity);
 
 		const cd::Animation* pAnimation = pAnimationComponent->GetAnimationData();
 		float ticksPerSecond = pAnimation->GetTicksPerSecnod();
 		assert(ticksPerSecond > 1.0f);
-		float animationTime = details::CustomFModf(animationRunningTime * ticksPerSecond, pAnimation->GetDuration());
+		float animationTime = details::CustomFModf(m_animationRunningTime * ticksPerSecond, pAnimation->GetDuration());
 
-		static std::vector<cd::Matrix4x4> boneMatrices;
 		boneMatrices.clear();
 		for (uint16_t boneIndex = 0; boneIndex < 128; ++boneIndex)
 		{
@@ -204,15 +227,14 @@ void AnimationRenderer::Render(float deltaTime)
 		const cd::Bone& rootBone = pSceneDatabase->GetBone(0);
 		details::CalculateBoneTransform(boneMatrices, pSceneDatabase, animationTime, rootBone,
 			cd::Matrix4x4::Identity(), pTransformComponent->GetWorldMatrix().Inverse());
-		bgfx::setUniform(bgfx::UniformHandle{pAnimationComponent->GetBoneMatrixsUniform()}, boneMatrices.data(), static_cast<uint16_t>(boneMatrices.size()));
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
+		pEncoder->setUniform(bgfx::UniformHandle{pAnimationComponent->GetBoneMatrixsUniform()}, boneMatrices.data(), static_cast<uint16_t>(boneMatrices.size()));
+		pEncoder->setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
+		pEncoder->setIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
 
 		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_CULL_CCW | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
-		bgfx::setState(state);
+		pEncoder->setState(state);
 
-		constexpr StringCrc animationProgram("AnimationProgram");
-		bgfx::submit(GetViewID(), GetRenderContext()->GetProgram(animationProgram));
+		pEncoder->submit(GetViewID(), programHandle);
 	}
 }
 
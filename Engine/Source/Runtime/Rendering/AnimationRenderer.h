@@ -1,5 +1,6 @@
 #pragma once
 
+#include "ECWorld/Entity.h"
 #include "Renderer.h"
 
 #include <vector>
@@ -20,8 +21,18 @@ public:
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
+private:
+	// Encodes visible animated meshes in [beginIndex, endIndex). It only reads prepared data so that it runs in worker threads.
+	void EncodeDraws(bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex) const;
+
 private:
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+	std::vector<Entity> m_visibleEntities;
+	float m_animationRunningTime = 0.0f;
+
+#ifdef VISUALIZE_BONE_WEIGHTS
+	float m_selectedBoneIndex[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+#endif
 };
 
 }
\ No newline at end of file
@@ -198,27 +198,26 @@ void DDGIRenderer::Render(float deltaTime)
 {
 	const engine::CameraComponent *pCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
 	const engine::TransformComponent* pCameraTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
+	const engine::FrustumCuller* pFrustumCuller = m_pCurrentSceneWorld->GetFrustumCuller();
 
-	for(Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
+	for (auto [entity, materialComponent, meshComponent, transformComponent] :
+		m_pCurrentSceneWorld->View<MaterialComponent, StaticMeshComponent, TransformComponent>())
 	{
-		MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
-		if(!pMaterialComponent || pMaterialComponent->GetMaterialType() != m_pCurrentSceneWorld->GetDDGIMaterialType())
+		MaterialComponent* pMaterialComponent = &materialComponent;
+		if(pMaterialComponent->GetMaterialType() != m_pCurrentSceneWorld->GetDDGIMaterialType())
 		{
 			continue;
 		}
 
-		// No mesh attached
-		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-		if(!pMeshComponent)
+		if (!pFrustumCuller->IsVisible(entity))
 		{
 			continue;
 		}
 
 		// Transform
-		if(TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
-		{
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
-		}
+		bgfx::setTransform(transformComponent.GetWorldMatrix().Begin());
+
+		StaticMeshComponent* pMeshComponent = &meshComponent;
 
 		// Mesh
 		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
@@ -26,14 +26,16 @@ void DebugRenderer::UpdateView(const float* pViewMatrix, const float* pProjectio
 
 void DebugRenderer::Render(float deltaTime)
 {
-	for (Entity entity : m_pCurrentSceneWorld->GetStaticMeshEntities())
+	const FrustumCuller* pFrustumCuller = m_pCurrentSceneWorld->GetFrustumCuller();
+	for (auto [entity, meshComponent] : m_pCurrentSceneWorld->View<StaticMeshComponent>())
 	{
-		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
+		if (!pFrustumCuller->IsVisible(entity))
 		{
 			continue;
 		}
 
+		StaticMeshComponent* pMeshComponent = &meshComponent;
+
 		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
 		{
 			pTransformComponent->Build();
@@ -0,0 +1,104 @@
+#include "DrawList.h"
+
+#include <cstring>
+#include <utility>
+
+namespace engine
+{
+
+uint32_t DrawSortKey::QuantizeDepth(float viewDepth)
+{
+	if (!(viewDepth > 0.0f))
+	{
+		return 0U;
+	}
+
+	uint32_t depthBits;
+	std::memcpy(&depthBits, &viewDepth, sizeof(float));
+
+	// The max positive value is infinity 0x7F800000 so that it is less than 2^31.
+	return depthBits >> 1;
+}
+
+uint16_t DrawSortKey::HashTextureHandle(uint16_t textureSetHash, uint16_t textureHandle)
+{
+	uint32_t hash = (static_cast<uint32_t>(textureSetHash) ^ textureHandle) * 0x9E3779B1U;
+	return static_cast<uint16_t>(hash >> 16);
+}
+
+uint64_t DrawSortKey::Build(DrawBucket bucket, uint16_t program, uint16_t textureSet, float viewDepth)
+{
+	uint64_t key = static_cast<uint64_t>(bucket) << 62;
+	uint64_t depth = QuantizeDepth(viewDepth);
+	if (DrawBucket::Opaque == bucket)
+	{
+		key |= static_cast<uint64_t>(program) << 46;
+		key |= static_cast<uint64_t>(textureSet) << 30;
+		key |= depth;
+	}
+	else
+	{
+		key |= static_cast<uint64_t>(MaxDepth - depth) << 32;
+		key |= static_cast<uint64_t>(program) << 16;
+		key |= textureSet;
+	}
+
+	return key;
+}
+
+void DrawList::Sort()
+{
+	const uint32_t itemCount = GetCount();
+	if (itemCount <= 1U)
+	{
+		return;
+	}
+
+	// Count digits of all byte passes in one loop.
+	constexpr uint32_t PassCount = sizeof(uint64_t);
+	constexpr uint32_t RadixSize = 256;
+	uint32_t histograms[PassCount][RadixSize] = {};
+	for (const Item& item : m_items)
+	{
+		for (uint32_t passIndex = 0; passIndex < PassCount; ++passIndex)
+		{
+			++histograms[passIndex][(item.sortKey >> (passIndex * 8)) & 0xFF];
+		}
+	}
+
+	m_scratchItems.resize(itemCount);
+	Item* pSource = m_items.data();
+	Item* pDestination = m_scratchItems.data();
+	for (uint32_t passIndex = 0; passIndex < PassCount; ++passIndex)
+	{
+		uint32_t* pHistogram = histograms[passIndex];
+		const uint32_t shift = passIndex * 8;
+		if (itemCount == pHistogram[(pSource[0].sortKey >> shift) & 0xFF])
+		{
+			continue;
+		}
+
+		uint32_t offset = 0U;
+		for (uint32_t digit = 0; digit < RadixSize; ++digit)
+		{
+			uint32_t count = pHistogram[digit];
+			pHistogram[digit] = offset;
+			offset += count;
+		}
+
+		for (uint32_t itemIndex = 0; itemIndex < itemCount; ++itemIndex)
+		{
+			const Item& item = pSource[itemIndex];
+			pDestination[pHistogram[(item.sortKey >> shift) & 0xFF]++] = item;
+		}
+
+		std::swap(pSource, pDestination);
+	}
+
+	if (pSource != m_items.data())
+	{
+		m_items.swap(m_scratchItems);
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// Draws are rendered bucket by bucket in this order.
+enum class DrawBucket : uint8_t
+{
+	Opaque,
+	Masked,
+	Blended,
+};
+
+// Sort key layouts from the most significant bit :
+// Opaque : | bucket 2 | program 16 | texture set 16 | depth 30 front-to-back |
+// Others : | bucket 2 | depth 30 back-to-front | program 16 | texture set 16 |
+// Opaque draws are grouped by states at first to reduce state changes and drawn front-to-back in the same states
+// to reduce overdraw. Masked and blended draws need back-to-front order more than state grouping.
+struct DrawSortKey
+{
+	static constexpr uint32_t DepthBits = 30;
+	static constexpr uint32_t MaxDepth = (1U << DepthBits) - 1U;
+
+	// Bit patterns of non-negative floats increase monotonically. Dropping the lowest mantissa bit keeps them in 30 bits.
+	// Negative depth which is behind the camera is clamped to 0.
+	static uint32_t QuantizeDepth(float viewDepth);
+
+	// Fold texture handles to 16 bits. Collisions only make sort orders less optimal.
+	static uint16_t HashTextureHandle(uint16_t textureSetHash, uint16_t textureHandle);
+
+	static uint64_t Build(DrawBucket bucket, uint16_t program, uint16_t textureSet, float viewDepth);
+	static DrawBucket GetBucket(uint64_t sortKey) { return static_cast<DrawBucket>(sortKey >> 62); }
+};
+
+// DrawList collects draws with sort keys and sorts them by LSD radix sort before submission.
+class DrawList final
+{
+public:
+	struct Item
+	{
+		uint64_t sortKey;
+		uint32_t index;
+	};
+
+public:
+	DrawList() = default;
+	DrawList(const DrawList&) = delete;
+	DrawList& operator=(const DrawList&) = delete;
+	DrawList(DrawList&&) = default;
+	DrawList& operator=(DrawList&&) = default;
+	~DrawList() = default;
+
+	void Clear() { m_items.clear(); }
+	void Reserve(uint32_t count) { m_items.reserve(count); }
+
+	// index is any user data to find the draw back, e.g. an entity.
+	void Add(uint64_t sortKey, uint32_t index) { m_items.push_back(Item{ sortKey, index }); }
+
+	// Stable sort by key. Byte passes whose digits are the same for all keys are skipped.
+	void Sort();
+
+	uint32_t GetCount() const { return static_cast<uint32_t>(m_items.size()); }
+	const std::vector<Item>& GetItems() const { return m_items; }
+
+private:
+	std::vector<Item> m_items;
+	std::vector<Item> m_scratchItems;
+};
+
+}
\ No newline at end of file
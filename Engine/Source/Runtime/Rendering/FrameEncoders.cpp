@@ -0,0 +1,69 @@
+#include "FrameEncoders.h"
+
+#include <utility>
+
+namespace engine
+{
+
+namespace
+{
+
+std::atomic<uint64_t> s_nextGeneration = 1U;
+
+struct ThreadEncoder
+{
+	uint64_t generation = 0U;
+	bgfx::Encoder* pEncoder = nullptr;
+};
+
+thread_local ThreadEncoder t_threadEncoder;
+
+}
+
+FrameEncoders::FrameEncoders(BeginFunction beginFunc, EndFunction endFunc)
+	: m_beginFunc(std::move(beginFunc))
+	, m_endFunc(std::move(endFunc))
+	, m_generation(s_nextGeneration.fetch_add(1U))
+{
+}
+
+bgfx::Encoder* FrameEncoders::Acquire()
+{
+	const uint64_t generation = m_generation.load(std::memory_order_acquire);
+	if (generation == t_threadEncoder.generation)
+	{
+		return t_threadEncoder.pEncoder;
+	}
+
+	// A failed begin is cached too so that the thread doesn't retry it until next frame.
+	bgfx::Encoder* pEncoder = m_beginFunc();
+	t_threadEncoder.generation = generation;
+	t_threadEncoder.pEncoder = pEncoder;
+	if (pEncoder)
+	{
+		std::lock_guard<std::mutex> lock(m_encodersMutex);
+		m_encoders.push_back(pEncoder);
+	}
+
+	return pEncoder;
+}
+
+void FrameEncoders::EndFrame()
+{
+	std::lock_guard<std::mutex> lock(m_encodersMutex);
+	for (bgfx::Encoder* pEncoder : m_encoders)
+	{
+		m_endFunc(pEncoder);
+	}
+	m_encoders.clear();
+
+	m_generation.store(s_nextGeneration.fetch_add(1U), std::memory_order_release);
+}
+
+uint32_t FrameEncoders::GetEncoderCount() const
+{
+	std::lock_guard<std::mutex> lock(m_encodersMutex);
+	return static_cast<uint32_t>(m_encoders.size());
+}
+
+}
\ No newline at end of file
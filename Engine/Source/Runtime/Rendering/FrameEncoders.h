@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace bgfx
+{
+
+struct Encoder;
+
+}
+
+namespace engine
+{
+
+// bgfx only gives encoders back to its pool in bgfx::frame, so that every bgfx::begin(true) holds an encoder for the rest
+// of the frame. FrameEncoders hands out at most one encoder per thread per frame. All parallel encodes of a frame,
+// e.g. world, terrain and animation renderers, share it so that the pool of workers + 2 encoders is never used up.
+// Acquire returns nullptr when the pool is used up anyway, e.g. by threads which are not workers.
+class FrameEncoders final
+{
+public:
+	using BeginFunction = std::function<bgfx::Encoder*()>;
+	using EndFunction = std::function<void(bgfx::Encoder*)>;
+
+public:
+	FrameEncoders() = delete;
+	explicit FrameEncoders(BeginFunction beginFunc, EndFunction endFunc);
+	FrameEncoders(const FrameEncoders&) = delete;
+	FrameEncoders& operator=(const FrameEncoders&) = delete;
+	FrameEncoders(FrameEncoders&&) = delete;
+	FrameEncoders& operator=(FrameEncoders&&) = delete;
+	~FrameEncoders() = default;
+
+	// Returns the encoder of current thread in current frame. It begins one at the first call of the frame.
+	bgfx::Encoder* Acquire();
+
+	// Ends all encoders of current frame. Call it before bgfx::frame when no thread is encoding.
+	void EndFrame();
+
+	uint32_t GetEncoderCount() const;
+
+private:
+	BeginFunction m_beginFunc;
+	EndFunction m_endFunc;
+
+	// Unique among all instances and frames so that threads know whether their cached encoders are stale.
+	std::atomic<uint64_t> m_generation;
+
+	mutable std::mutex m_encodersMutex;
+	std::vector<bgfx::Encoder*> m_encoders;
+};
+
+}
\ No newline at end of file
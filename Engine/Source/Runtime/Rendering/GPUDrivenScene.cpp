@@ -0,0 +1,160 @@
+#include "GPUDrivenScene.h"
+
+#include "Base/Template.h"
+#include "Core/Math/FrustumCulling.h"
+#include "Material/ShaderSchema.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <tuple>
+#include <unordered_map>
+
+namespace engine
+{
+
+namespace
+{
+
+// Draw command indexes are stored in floats of instances.
+constexpr uint32_t MaxDrawCommandCount = 1U << 24;
+
+}
+
+bool GPUDrivenScene::IsSupported(const RenderProxy& proxy)
+{
+	// Blended draws are kept on the CPU path to draw them back-to-front.
+	return DrawBucket::Blended != proxy.drawBucket && ShaderSchema::InvalidProgramHandle != proxy.instanceProgramHandle &&
+		proxy.vertexCount > 0U && proxy.indexCount > 0U;
+}
+
+bool GPUDrivenScene::Build(const std::vector<RenderProxy>& proxies)
+{
+	// Proxies which have the same buffers share one range of shared buffers. Meshes are stored in the order of first use.
+	std::vector<uint64_t> meshKeys;
+	std::vector<GPUDrivenMesh> meshes;
+	std::unordered_map<uint32_t, uint32_t> meshKeyToIndex;
+	uint32_t totalVertexCount = 0U;
+	uint32_t totalIndexCount = 0U;
+
+	m_sortedProxies.clear();
+	m_proxyMeshes.resize(proxies.size());
+	for (uint32_t proxyIndex = 0U; proxyIndex < proxies.size(); ++proxyIndex)
+	{
+		const RenderProxy& proxy = proxies[proxyIndex];
+		if (!IsSupported(proxy))
+		{
+			continue;
+		}
+
+		const uint32_t meshKey = static_cast<uint32_t>(proxy.vertexBufferHandle) << 16 | proxy.indexBufferHandle;
+		auto [itMesh, isNewMesh] = meshKeyToIndex.emplace(meshKey, static_cast<uint32_t>(meshes.size()));
+		if (isNewMesh)
+		{
+			meshKeys.push_back(static_cast<uint64_t>(meshKey) << 32 | proxy.vertexCount);
+			meshKeys.push_back(proxy.indexCount);
+			meshes.push_back(GPUDrivenMesh{ proxyIndex, totalVertexCount, proxy.vertexCount, totalIndexCount, proxy.indexCount });
+			totalVertexCount += proxy.vertexCount;
+			totalIndexCount += proxy.indexCount;
+		}
+
+		m_proxyMeshes[proxyIndex] = itMesh->second;
+		m_sortedProxies.push_back(proxyIndex);
+	}
+
+	const bool isMeshChanged = meshKeys != m_meshKeys;
+	m_meshKeys = cd::MoveTemp(meshKeys);
+	m_meshes = cd::MoveTemp(meshes);
+	m_totalVertexCount = totalVertexCount;
+	m_totalIndexCount = totalIndexCount;
+
+	// Proxies of the same material and mesh are adjacent after sorting. Proxy indexes keep the order stable.
+	std::sort(m_sortedProxies.begin(), m_sortedProxies.end(), [this, &proxies](uint32_t proxyIndexA, uint32_t proxyIndexB)
+	{
+		return std::make_tuple(proxies[proxyIndexA].materialHash, m_proxyMeshes[proxyIndexA], proxyIndexA) <
+			std::make_tuple(proxies[proxyIndexB].materialHash, m_proxyMeshes[proxyIndexB], proxyIndexB);
+	});
+
+	m_drawCommands.clear();
+	m_drawGroups.clear();
+	m_instances.resize(m_sortedProxies.size());
+	m_instanceProxies.resize(m_sortedProxies.size());
+	uint32_t lastMeshIndex = UINT32_MAX;
+	for (uint32_t instanceIndex = 0U; instanceIndex < m_sortedProxies.size(); ++instanceIndex)
+	{
+		const uint32_t proxyIndex = m_sortedProxies[instanceIndex];
+		const RenderProxy& proxy = proxies[proxyIndex];
+
+		// Hashes are compared again by values. Collided materials are split into more groups.
+		const bool isNewGroup = m_drawGroups.empty() || !HasSameMaterial(proxies[m_drawGroups.back().proxyIndex], proxy);
+		if (isNewGroup)
+		{
+			m_drawGroups.push_back(GPUDrivenDrawGroup{ proxyIndex, static_cast<uint32_t>(m_drawCommands.size()), 0U });
+		}
+
+		const uint32_t meshIndex = m_proxyMeshes[proxyIndex];
+		if (isNewGroup || meshIndex != lastMeshIndex)
+		{
+			const GPUDrivenMesh& mesh = m_meshes[meshIndex];
+			m_drawCommands.push_back(GPUDrivenDrawCommand{ mesh.indexCount, mesh.firstIndex, mesh.baseVertex, instanceIndex });
+			++m_drawGroups.back().drawCommandCount;
+			lastMeshIndex = meshIndex;
+		}
+
+		GPUDrivenInstance& instance = m_instances[instanceIndex];
+		std::memcpy(instance.worldMatrix, proxy.worldMatrix.Begin(), sizeof(instance.worldMatrix));
+		instance.drawCommandIndex = static_cast<float>(m_drawCommands.size() - 1U);
+
+		// Meshes without valid bounding boxes are never culled which is the same as FrustumCuller.
+		cd::Vec3f center = cd::Vec3f::Zero();
+		cd::Vec3f extents = cd::Vec3f::Zero();
+		const bool isAlwaysVisible = proxy.localAABB.IsEmpty();
+		if (!isAlwaysVisible)
+		{
+			FrustumCullingBatch::TransformBox(proxy.worldMatrix, proxy.localAABB.Min(), proxy.localAABB.Max(), center, extents);
+		}
+		instance.center[0] = center.x();
+		instance.center[1] = center.y();
+		instance.center[2] = center.z();
+		instance.extents[0] = extents.x();
+		instance.extents[1] = extents.y();
+		instance.extents[2] = extents.z();
+		instance.alwaysVisible = isAlwaysVisible ? 1.0f : 0.0f;
+
+		m_instanceProxies[instanceIndex] = proxyIndex;
+	}
+	assert(m_drawCommands.size() < MaxDrawCommandCount);
+
+	return isMeshChanged;
+}
+
+void GPUDrivenScene::Cull(const Frustum& frustum, std::vector<uint32_t>& outInstanceCounts, std::vector<uint32_t>& outVisibleProxies) const
+{
+	FrustumCullingBatch cullingBatch;
+	cullingBatch.Reserve(GetInstanceCount());
+	for (const GPUDrivenInstance& instance : m_instances)
+	{
+		cullingBatch.Add(cd::Vec3f(instance.center[0], instance.center[1], instance.center[2]),
+			cd::Vec3f(instance.extents[0], instance.extents[1], instance.extents[2]));
+	}
+
+	std::vector<uint8_t> visibilities(GetInstanceCount());
+	cullingBatch.Cull(frustum, visibilities.data());
+
+	// Slots of a draw command are allocated by atomics on GPU so that only the set of visible instances is deterministic.
+	outInstanceCounts.assign(GetDrawCommandCount(), 0U);
+	outVisibleProxies.clear();
+	for (uint32_t instanceIndex = 0U; instanceIndex < m_instances.size(); ++instanceIndex)
+	{
+		const GPUDrivenInstance& instance = m_instances[instanceIndex];
+		if (0.0f == instance.alwaysVisible && !visibilities[instanceIndex])
+		{
+			continue;
+		}
+
+		++outInstanceCounts[static_cast<uint32_t>(instance.drawCommandIndex)];
+		outVisibleProxies.push_back(m_instanceProxies[instanceIndex]);
+	}
+}
+
+}
\ No newline at end of file
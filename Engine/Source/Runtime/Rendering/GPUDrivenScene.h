@@ -0,0 +1,105 @@
+#pragma once
+
+#include "RenderProxy.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class Frustum;
+
+// A range of the shared vertex and index buffers where a mesh is stored.
+// proxyIndex is the first proxy which uses the mesh to read its buffer data.
+struct GPUDrivenMesh
+{
+	uint32_t proxyIndex;
+	uint32_t baseVertex;
+	uint32_t vertexCount;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+};
+
+// Arguments of an indexed indirect draw except the instance count which is counted by culling.
+// Visible instances are written to [firstInstance, firstInstance + instance count). Layout matches cs_GPUDrivenDrawArgs.sc.
+struct GPUDrivenDrawCommand
+{
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	uint32_t baseVertex;
+	uint32_t firstInstance;
+};
+
+// Proxies in a group have the same material so that draw commands [firstDrawCommand, firstDrawCommand + drawCommandCount)
+// are submitted by one indirect draw. proxyIndex is the first proxy of the group to read material data.
+struct GPUDrivenDrawGroup
+{
+	uint32_t proxyIndex;
+	uint32_t firstDrawCommand;
+	uint32_t drawCommandCount;
+};
+
+// Culling input of an instance. Layout matches cs_GPUDrivenCulling.sc.
+struct GPUDrivenInstance
+{
+	float worldMatrix[16];
+	float center[3];
+	float drawCommandIndex;
+	float extents[3];
+	float alwaysVisible;
+};
+
+// GPUDrivenScene packs opaque and masked RenderProxies into tables which are uploaded to GPU buffers.
+// A compute shader culls instances, writes visible world matrices and counts instances of draw commands.
+// Then every material group is submitted by one indirect draw whatever how many meshes and instances it has.
+// It doesn't touch bgfx so that the packing and the culling reference run headless.
+class GPUDrivenScene final
+{
+public:
+	static bool IsSupported(const RenderProxy& proxy);
+
+public:
+	GPUDrivenScene() = default;
+	GPUDrivenScene(const GPUDrivenScene&) = delete;
+	GPUDrivenScene& operator=(const GPUDrivenScene&) = delete;
+	GPUDrivenScene(GPUDrivenScene&&) = default;
+	GPUDrivenScene& operator=(GPUDrivenScene&&) = default;
+	~GPUDrivenScene() = default;
+
+	// Returns true if the mesh set changes so that shared geometry buffers should be built again.
+	bool Build(const std::vector<RenderProxy>& proxies);
+
+	// CPU reference of cs_GPUDrivenCulling.sc which uses the same frustum test as FrustumCuller.
+	// Writes visible instance counts of draw commands and visible proxy indexes in the order of instance slots.
+	void Cull(const Frustum& frustum, std::vector<uint32_t>& outInstanceCounts, std::vector<uint32_t>& outVisibleProxies) const;
+
+	const std::vector<GPUDrivenMesh>& GetMeshes() const { return m_meshes; }
+	const std::vector<GPUDrivenDrawCommand>& GetDrawCommands() const { return m_drawCommands; }
+	const std::vector<GPUDrivenDrawGroup>& GetDrawGroups() const { return m_drawGroups; }
+	const std::vector<GPUDrivenInstance>& GetInstances() const { return m_instances; }
+	const std::vector<uint32_t>& GetInstanceProxies() const { return m_instanceProxies; }
+
+	uint32_t GetTotalVertexCount() const { return m_totalVertexCount; }
+	uint32_t GetTotalIndexCount() const { return m_totalIndexCount; }
+	uint32_t GetDrawCommandCount() const { return static_cast<uint32_t>(m_drawCommands.size()); }
+	uint32_t GetInstanceCount() const { return static_cast<uint32_t>(m_instances.size()); }
+
+private:
+	std::vector<GPUDrivenMesh> m_meshes;
+	// Buffer handles and counts of meshes. Shared buffers are built again if they change.
+	std::vector<uint64_t> m_meshKeys;
+	uint32_t m_totalVertexCount = 0U;
+	uint32_t m_totalIndexCount = 0U;
+
+	std::vector<GPUDrivenDrawCommand> m_drawCommands;
+	std::vector<GPUDrivenDrawGroup> m_drawGroups;
+	std::vector<GPUDrivenInstance> m_instances;
+	std::vector<uint32_t> m_instanceProxies;
+
+	// Reused by Build to sort proxies by materials and meshes.
+	std::vector<uint32_t> m_sortedProxies;
+	std::vector<uint32_t> m_proxyMeshes;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "HiZRenderer.h"
+
+#include "ECWorld/SceneWorld.h"
+#include "RenderContext.h"
+#include "RenderTarget.h"
+#include "U_HiZ.sh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr const char* hiZSourceDepthSampler = "s_hiZSourceDepth";
+constexpr const char* hiZSize               = "u_hiZSize";
+
+constexpr uint64_t hiZTextureFlags = BGFX_TEXTURE_COMPUTE_WRITE | BGFX_SAMPLER_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+constexpr uint64_t readbackTextureFlags = BGFX_TEXTURE_BLIT_DST | BGFX_TEXTURE_READ_BACK | BGFX_SAMPLER_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+constexpr uint32_t sourceDepthSamplerFlags = BGFX_SAMPLER_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+
+// The first mip which is not larger than it in both axes is read back to test boxes on CPU.
+constexpr uint16_t ReadbackMaxSize = 256;
+
+uint32_t GetHiZGroupCount(uint32_t size)
+{
+	return (size + HIZ_THREAD_COUNT - 1U) / HIZ_THREAD_COUNT;
+}
+
+}
+
+HiZRenderer::~HiZRenderer()
+{
+	DestroyTextures();
+}
+
+void HiZRenderer::Init()
+{
+	const bgfx::Caps* pCaps = bgfx::getCaps();
+	if (BGFX_CAPS_COMPUTE == (pCaps->supported & BGFX_CAPS_COMPUTE))
+	{
+		m_downsampleDepthProgram = GetRenderContext()->CreateProgram("HiZDownsampleDepth", "cs_HiZDownsampleDepth.bin").idx;
+		m_downsampleProgram = GetRenderContext()->CreateProgram("HiZDownsample", "cs_HiZDownsample.bin").idx;
+		m_sourceDepthSampler = GetRenderContext()->CreateUniform(hiZSourceDepthSampler, bgfx::UniformType::Sampler).idx;
+		m_hiZSize = GetRenderContext()->CreateUniform(hiZSize, bgfx::UniformType::Vec4, 1).idx;
+	}
+
+	constexpr uint64_t readbackCaps = BGFX_CAPS_TEXTURE_BLIT | BGFX_CAPS_TEXTURE_READ_BACK;
+	m_isReadbackSupported = readbackCaps == (pCaps->supported & readbackCaps);
+	m_readbackDepths.resize(ReadbackMaxSize * ReadbackMaxSize);
+
+	// CPU culling falls back to occluders rasterized by FrustumCuller if depths can't be read back.
+	if (!m_isReadbackSupported)
+	{
+		m_pCurrentSceneWorld->GetFrustumCuller()->SetSoftwareOcclusionEnable(true);
+	}
+
+	bgfx::setViewName(GetViewID(), "HiZRenderer");
+}
+
+void HiZRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
+{
+	// The view only dispatches compute shaders. Scene depth can't be sampled if it is still bound to the view's frame buffer.
+	cd::Matrix4x4 viewMatrix;
+	cd::Matrix4x4 projectionMatrix;
+	std::memcpy(viewMatrix.Begin(), pViewMatrix, 16 * sizeof(float));
+	std::memcpy(projectionMatrix.Begin(), pProjectionMatrix, 16 * sizeof(float));
+	m_viewProjection = projectionMatrix * viewMatrix;
+}
+
+void HiZRenderer::Render(float deltaTime)
+{
+	if (UINT16_MAX == m_downsampleDepthProgram)
+	{
+		return;
+	}
+
+	const bgfx::TextureHandle depthTexture = GetRenderTarget()->GetDepthTextureHandle();
+	if (!bgfx::isValid(depthTexture))
+	{
+		return;
+	}
+
+	const uint16_t depthWidth = GetRenderTarget()->GetWidth();
+	const uint16_t depthHeight = GetRenderTarget()->GetHeight();
+	const uint16_t width = std::max<uint16_t>(depthWidth / 2U, 1U);
+	const uint16_t height = std::max<uint16_t>(depthHeight / 2U, 1U);
+	if (width != m_hiZWidth || height != m_hiZHeight)
+	{
+		DestroyTextures();
+		CreateTextures(width, height);
+	}
+
+	UpdateReadback();
+
+	// Blits run before dispatches of a view so that the pyramid built in last frame is copied.
+	// Only one readback is in flight. Its result is applied when bgfx reaches the returned frame.
+	const uint16_t viewID = GetViewID();
+	const FrustumCuller* pFrustumCuller = m_pCurrentSceneWorld->GetFrustumCuller();
+	if (m_isHiZReady && m_isReadbackSupported && pFrustumCuller->IsOcclusionEnable() && !pFrustumCuller->IsSoftwareOcclusionEnable() &&
+		UINT32_MAX == m_readbackFrame)
+	{
+		bgfx::blit(viewID, bgfx::TextureHandle{m_readbackTexture}, 0, 0, 0, 0, bgfx::TextureHandle{m_hiZTexture}, m_readbackMip, 0, 0, 0,
+			m_readbackWidth, m_readbackHeight);
+		m_readbackFrame = bgfx::readTexture(bgfx::TextureHandle{m_readbackTexture}, m_readbackDepths.data());
+		m_readbackViewProjection = m_hiZViewProjection;
+	}
+
+	// Mip 0 is downsampled from the depth attachment. Other mips are downsampled from previous mips.
+	float sizes[4] = { static_cast<float>(depthWidth), static_cast<float>(depthHeight), static_cast<float>(width), static_cast<float>(height) };
+	bgfx::setTexture(HIZ_SOURCE_SLOT, bgfx::UniformHandle{m_sourceDepthSampler}, depthTexture, sourceDepthSamplerFlags);
+	bgfx::setImage(HIZ_TARGET_SLOT, bgfx::TextureHandle{m_hiZTexture}, 0, bgfx::Access::Write, bgfx::TextureFormat::R32F);
+	bgfx::setUniform(bgfx::UniformHandle{m_hiZSize}, sizes, 1);
+	bgfx::dispatch(viewID, bgfx::ProgramHandle{m_downsampleDepthProgram}, GetHiZGroupCount(width), GetHiZGroupCount(height), 1U);
+
+	for (uint8_t mip = 1; mip < m_hiZMipCount; ++mip)
+	{
+		const uint16_t sourceWidth = std::max<uint16_t>(width >> (mip - 1U), 1U);
+		const uint16_t sourceHeight = std::max<uint16_t>(height >> (mip - 1U), 1U);
+		const uint16_t targetWidth = std::max<uint16_t>(width >> mip, 1U);
+		const uint16_t targetHeight = std::max<uint16_t>(height >> mip, 1U);
+		float mipSizes[4] = { static_cast<float>(sourceWidth), static_cast<float>(sourceHeight), static_cast<float>(targetWidth), static_cast<float>(targetHeight) };
+		bgfx::setImage(HIZ_SOURCE_SLOT, bgfx::TextureHandle{m_hiZTexture}, mip - 1U, bgfx::Access::Read, bgfx::TextureFormat::R32F);
+		bgfx::setImage(HIZ_TARGET_SLOT, bgfx::TextureHandle{m_hiZTexture}, mip, bgfx::Access::Write, bgfx::TextureFormat::R32F);
+		bgfx::setUniform(bgfx::UniformHandle{m_hiZSize}, mipSizes, 1);
+		bgfx::dispatch(viewID, bgfx::ProgramHandle{m_downsampleProgram}, GetHiZGroupCount(targetWidth), GetHiZGroupCount(targetHeight), 1U);
+	}
+
+	m_hiZViewProjection = m_viewProjection;
+	m_isHiZReady = true;
+}
+
+void HiZRenderer::SetEnable(bool value)
+{
+	// Depths of disabled frames are outdated.
+	if (!value)
+	{
+		m_isHiZReady = false;
+		m_readbackFrame = UINT32_MAX;
+		ResetCPUPyramid();
+	}
+
+	Renderer::SetEnable(value);
+}
+
+void HiZRenderer::CreateTextures(uint16_t width, uint16_t height)
+{
+	m_hiZWidth = width;
+	m_hiZHeight = height;
+	m_hiZMipCount = 1;
+	while ((std::max(width, height) >> m_hiZMipCount) > 0U)
+	{
+		++m_hiZMipCount;
+	}
+	m_hiZTexture = bgfx::createTexture2D(width, height, true, 1, bgfx::TextureFormat::R32F, hiZTextureFlags).idx;
+	m_isHiZReady = false;
+
+	if (m_isReadbackSupported)
+	{
+		m_readbackMip = 0;
+		while (m_readbackMip + 1U < m_hiZMipCount && ((width >> m_readbackMip) > ReadbackMaxSize || (height >> m_readbackMip) > ReadbackMaxSize))
+		{
+			++m_readbackMip;
+		}
+		m_readbackWidth = std::max<uint16_t>(width >> m_readbackMip, 1U);
+		m_readbackHeight = std::max<uint16_t>(height >> m_readbackMip, 1U);
+		m_readbackTexture = bgfx::createTexture2D(m_readbackWidth, m_readbackHeight, false, 1, bgfx::TextureFormat::R32F, readbackTextureFlags).idx;
+	}
+
+	// Pending results are for old sizes.
+	m_readbackFrame = UINT32_MAX;
+	ResetCPUPyramid();
+}
+
+void HiZRenderer::DestroyTextures()
+{
+	if (UINT16_MAX != m_hiZTexture)
+	{
+		bgfx::destroy(bgfx::TextureHandle{m_hiZTexture});
+		m_hiZTexture = UINT16_MAX;
+	}
+
+	if (UINT16_MAX != m_readbackTexture)
+	{
+		bgfx::destroy(bgfx::TextureHandle{m_readbackTexture});
+		m_readbackTexture = UINT16_MAX;
+	}
+
+	m_hiZWidth = 0;
+	m_hiZHeight = 0;
+	m_hiZMipCount = 0;
+	m_isHiZReady = false;
+}
+
+void HiZRenderer::UpdateReadback()
+{
+	if (UINT32_MAX == m_readbackFrame || GetRenderContext()->GetFrameNumber() < m_readbackFrame)
+	{
+		return;
+	}
+
+	// Software occlusion owns the pyramid if it is enabled after the readback.
+	m_readbackFrame = UINT32_MAX;
+	FrustumCuller* pFrustumCuller = m_pCurrentSceneWorld->GetFrustumCuller();
+	if (pFrustumCuller->IsSoftwareOcclusionEnable())
+	{
+		return;
+	}
+
+	const bgfx::Caps* pCaps = bgfx::getCaps();
+	pFrustumCuller->GetHiZPyramid().Build(m_readbackDepths.data(), m_readbackWidth, m_readbackHeight,
+		m_readbackViewProjection, pCaps->homogeneousDepth, pCaps->originBottomLeft);
+}
+
+void HiZRenderer::ResetCPUPyramid()
+{
+	FrustumCuller* pFrustumCuller = m_pCurrentSceneWorld->GetFrustumCuller();
+	if (!pFrustumCuller->IsSoftwareOcclusionEnable())
+	{
+		pFrustumCuller->GetHiZPyramid().Reset();
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+#include "Renderer.h"
+
+#include <vector>
+
+namespace engine
+{
+
+class SceneWorld;
+
+// HiZRenderer builds a Hi-Z pyramid which keeps the farthest depths from the D32F attachment of its render target by compute shaders.
+// It runs after all renderers which write scene depths. The pyramid is used by GPU driven culling in the next frame.
+// A small mip is also read back to FrustumCuller's HiZPyramid so that CPU draws skip occluded entities some frames later.
+// Readbacks are skipped when FrustumCuller uses software occlusion which builds the pyramid itself.
+class HiZRenderer final : public Renderer
+{
+public:
+	using Renderer::Renderer;
+	virtual ~HiZRenderer();
+
+	virtual void Init() override;
+	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
+	virtual void Render(float deltaTime) override;
+	virtual void SetEnable(bool value) override;
+
+	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
+
+	// The pyramid is ready after it is built once for current size. Mip 0 is half size of the depth attachment and rounded down.
+	bool IsHiZReady() const { return m_isHiZReady; }
+	uint16_t GetHiZTexture() const { return m_hiZTexture; }
+	uint16_t GetHiZWidth() const { return m_hiZWidth; }
+	uint16_t GetHiZHeight() const { return m_hiZHeight; }
+	uint8_t GetHiZMipCount() const { return m_hiZMipCount; }
+	const cd::Matrix4x4& GetHiZViewProjection() const { return m_hiZViewProjection; }
+
+private:
+	void CreateTextures(uint16_t width, uint16_t height);
+	void DestroyTextures();
+	void UpdateReadback();
+	void ResetCPUPyramid();
+
+private:
+	SceneWorld* m_pCurrentSceneWorld = nullptr;
+
+	uint16_t m_downsampleDepthProgram = UINT16_MAX;
+	uint16_t m_downsampleProgram = UINT16_MAX;
+	uint16_t m_sourceDepthSampler = UINT16_MAX;
+	uint16_t m_hiZSize = UINT16_MAX;
+	bool m_isReadbackSupported = false;
+
+	uint16_t m_hiZTexture = UINT16_MAX;
+	uint16_t m_hiZWidth = 0;
+	uint16_t m_hiZHeight = 0;
+	uint8_t m_hiZMipCount = 0;
+	bool m_isHiZReady = false;
+	cd::Matrix4x4 m_viewProjection;
+	cd::Matrix4x4 m_hiZViewProjection;
+
+	// Results of bgfx::readTexture are written asynchronously so that the buffer is allocated once for the largest readback mip.
+	uint16_t m_readbackTexture = UINT16_MAX;
+	uint8_t m_readbackMip = 0;
+	uint16_t m_readbackWidth = 0;
+	uint16_t m_readbackHeight = 0;
+	uint32_t m_readbackFrame = UINT32_MAX;
+	cd::Matrix4x4 m_readbackViewProjection;
+	std::vector<float> m_readbackDepths;
+};
+
+}
\ No newline at end of file
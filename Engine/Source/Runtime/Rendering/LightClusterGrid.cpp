@@ -0,0 +1,207 @@
+#include "LightClusterGrid.h"
+
+#include "Light.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace engine
+{
+
+namespace
+{
+
+// Returns 0 for lights which are not bounded by ranges.
+float GetLightBoundingRadius(const U_Light& light)
+{
+	const int lightType = static_cast<int>(light.type);
+	if (DIRECTIONAL_LIGHT == lightType || !(light.range > 0.0f))
+	{
+		return 0.0f;
+	}
+
+	// Area lights emit from their shapes so that ranges start from their edges.
+	float extent = 0.0f;
+	if (SPHERE_LIGHT == lightType || DISK_LIGHT == lightType)
+	{
+		extent = light.radius;
+	}
+	else if (RECTANGLE_LIGHT == lightType)
+	{
+		extent = 0.5f * std::sqrt(light.width * light.width + light.height * light.height);
+	}
+	else if (TUBE_LIGHT == lightType)
+	{
+		extent = 0.5f * light.width + light.radius;
+	}
+
+	// Invalid values fall back to global lights.
+	float radius = light.range + std::max(extent, 0.0f);
+	return std::isfinite(radius) ? radius : 0.0f;
+}
+
+// Tile range of a sphere in one screen axis. x / depth is monotonic for a fixed x so that
+// the NDC bounds of the sphere in the depth range are at the ends of the depth range.
+bool GetTileRange(float center, float radius, float projectionScale, float nearDepth, float farDepth, uint32_t tileCount,
+	uint32_t& minTile, uint32_t& maxTile)
+{
+	float minNDC = projectionScale * std::min((center - radius) / nearDepth, (center - radius) / farDepth);
+	float maxNDC = projectionScale * std::max((center + radius) / nearDepth, (center + radius) / farDepth);
+	if (maxNDC < -1.0f || minNDC > 1.0f)
+	{
+		return false;
+	}
+
+	const float tileScale = 0.5f * static_cast<float>(tileCount);
+	const float maxTileValue = static_cast<float>(tileCount - 1U);
+	minTile = static_cast<uint32_t>(std::clamp((minNDC + 1.0f) * tileScale, 0.0f, maxTileValue));
+	maxTile = static_cast<uint32_t>(std::clamp((maxNDC + 1.0f) * tileScale, 0.0f, maxTileValue));
+	return true;
+}
+
+// View space bounds of a tile in one screen axis inside the depth range.
+void GetTileBounds(uint32_t tile, uint32_t tileCount, float projectionScale, float nearDepth, float farDepth, float& minValue, float& maxValue)
+{
+	const float minNDC = static_cast<float>(tile) * 2.0f / static_cast<float>(tileCount) - 1.0f;
+	const float maxNDC = static_cast<float>(tile + 1U) * 2.0f / static_cast<float>(tileCount) - 1.0f;
+	minValue = std::min(minNDC * nearDepth, minNDC * farDepth) / projectionScale;
+	maxValue = std::max(maxNDC * nearDepth, maxNDC * farDepth) / projectionScale;
+}
+
+float GetSquaredDistance(float value, float minValue, float maxValue)
+{
+	float distance = value < minValue ? minValue - value : (value > maxValue ? value - maxValue : 0.0f);
+	return distance * distance;
+}
+
+}
+
+void LightClusterGrid::Build(const cd::Matrix4x4& viewMatrix, const cd::Matrix4x4& projectionMatrix, float nearPlane, float farPlane,
+	const U_Light* pLights, uint32_t lightCount)
+{
+	m_depthSliceScale = static_cast<float>(CountZ) / std::log(farPlane / nearPlane);
+	m_depthSliceBias = -std::log(nearPlane) * m_depthSliceScale;
+
+	float sliceDepths[CountZ + 1];
+	for (uint32_t slice = 0U; slice <= CountZ; ++slice)
+	{
+		sliceDepths[slice] = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(slice) / static_cast<float>(CountZ));
+	}
+
+	m_lightCount = std::min(lightCount, MaxLightCount);
+	m_clusterLightCounts.assign(ClusterCount, 0U);
+	m_clusterLights.clear();
+	m_lightIndices.clear();
+
+	// View matrix is left handed and column major.
+	const float* pView = viewMatrix.Begin();
+	const float scaleX = projectionMatrix.Begin()[0];
+	const float scaleY = projectionMatrix.Begin()[5];
+	for (uint32_t lightIndex = 0U; lightIndex < m_lightCount; ++lightIndex)
+	{
+		const U_Light& light = pLights[lightIndex];
+		const float radius = GetLightBoundingRadius(light);
+		if (0.0f == radius)
+		{
+			if (m_lightIndices.size() < MaxLightIndexCount)
+			{
+				m_lightIndices.push_back(static_cast<float>(lightIndex));
+			}
+			continue;
+		}
+
+		float center[3];
+		for (uint32_t axis = 0U; axis < 3U; ++axis)
+		{
+			center[axis] = pView[axis] * light.position.x() + pView[4 + axis] * light.position.y() + pView[8 + axis] * light.position.z() + pView[12 + axis];
+		}
+
+		const float minDepth = std::max(center[2] - radius, nearPlane);
+		const float maxDepth = std::min(center[2] + radius, farPlane);
+		if (minDepth > maxDepth)
+		{
+			continue;
+		}
+
+		const float squaredRadius = radius * radius;
+		const uint32_t maxSlice = GetDepthSlice(maxDepth);
+		for (uint32_t slice = GetDepthSlice(minDepth); slice <= maxSlice; ++slice)
+		{
+			const float sliceNear = sliceDepths[slice];
+			const float sliceFar = sliceDepths[slice + 1U];
+			const float nearDepth = std::max(sliceNear, minDepth);
+			const float farDepth = std::min(sliceFar, maxDepth);
+
+			uint32_t minTileX, maxTileX, minTileY, maxTileY;
+			if (!GetTileRange(center[0], radius, scaleX, nearDepth, farDepth, CountX, minTileX, maxTileX) ||
+				!GetTileRange(center[1], radius, scaleY, nearDepth, farDepth, CountY, minTileY, maxTileY))
+			{
+				continue;
+			}
+
+			const float squaredDistanceZ = GetSquaredDistance(center[2], sliceNear, sliceFar);
+			for (uint32_t tileY = minTileY; tileY <= maxTileY; ++tileY)
+			{
+				float minY, maxY;
+				GetTileBounds(tileY, CountY, scaleY, sliceNear, sliceFar, minY, maxY);
+				const float squaredDistanceYZ = squaredDistanceZ + GetSquaredDistance(center[1], minY, maxY);
+				if (squaredDistanceYZ > squaredRadius)
+				{
+					continue;
+				}
+
+				for (uint32_t tileX = minTileX; tileX <= maxTileX; ++tileX)
+				{
+					float minX, maxX;
+					GetTileBounds(tileX, CountX, scaleX, sliceNear, sliceFar, minX, maxX);
+					if (squaredDistanceYZ + GetSquaredDistance(center[0], minX, maxX) <= squaredRadius)
+					{
+						const uint32_t clusterIndex = GetClusterIndex(tileX, tileY, slice);
+						++m_clusterLightCounts[clusterIndex];
+						m_clusterLights.push_back(ClusterLight{ clusterIndex, lightIndex });
+					}
+				}
+			}
+		}
+	}
+	m_globalLightCount = static_cast<uint32_t>(m_lightIndices.size());
+
+	// Allocate compact light lists after global lights. Counts are reused as write cursors.
+	m_clusterData.resize(ClusterCount * 2U);
+	uint32_t lightIndexOffset = m_globalLightCount;
+	for (uint32_t clusterIndex = 0U; clusterIndex < ClusterCount; ++clusterIndex)
+	{
+		const uint32_t clusterLightCount = std::min(m_clusterLightCounts[clusterIndex], MaxLightIndexCount - lightIndexOffset);
+		m_clusterData[clusterIndex * 2U] = static_cast<float>(lightIndexOffset);
+		m_clusterData[clusterIndex * 2U + 1U] = static_cast<float>(clusterLightCount);
+		m_clusterLightCounts[clusterIndex] = lightIndexOffset;
+		lightIndexOffset += clusterLightCount;
+	}
+	m_lightIndexCount = lightIndexOffset;
+
+	const uint32_t rowCount = (m_lightIndexCount + LightIndexTextureWidth - 1U) / LightIndexTextureWidth;
+	m_lightIndices.resize(rowCount * LightIndexTextureWidth, 0.0f);
+
+	// Lights keep their orders in every cluster.
+	for (const ClusterLight& clusterLight : m_clusterLights)
+	{
+		uint32_t& writeIndex = m_clusterLightCounts[clusterLight.clusterIndex];
+		if (writeIndex < GetClusterLightOffset(clusterLight.clusterIndex) + GetClusterLightCount(clusterLight.clusterIndex))
+		{
+			m_lightIndices[writeIndex++] = static_cast<float>(clusterLight.lightIndex);
+		}
+	}
+}
+
+uint32_t LightClusterGrid::GetDepthSlice(float viewDepth) const
+{
+	if (!(viewDepth > 0.0f))
+	{
+		return 0U;
+	}
+
+	float slice = std::floor(std::log(viewDepth) * m_depthSliceScale + m_depthSliceBias);
+	return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(CountZ - 1U)));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+#include "U_LightCluster.sh"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+struct U_Light;
+
+// LightClusterGrid splits the view frustum into clusters by screen tiles and exponential depth slices.
+// Lights are binned into clusters by their bounding spheres so that a fragment only shades lights of its own cluster.
+// Lights which are not bounded, e.g. directional lights, are global lights and shaded by all fragments.
+// The results are laid out as the light cluster textures which are sampled in LightCluster.sh.
+class LightClusterGrid final
+{
+public:
+	static constexpr uint32_t CountX = LIGHT_CLUSTER_X_COUNT;
+	static constexpr uint32_t CountY = LIGHT_CLUSTER_Y_COUNT;
+	static constexpr uint32_t CountZ = LIGHT_CLUSTER_Z_COUNT;
+	static constexpr uint32_t ClusterCount = CountX * CountY * CountZ;
+	static constexpr uint32_t MaxLightCount = MAX_CLUSTERED_LIGHT_COUNT;
+	static constexpr uint32_t LightIndexTextureWidth = LIGHT_INDEX_TEXTURE_WIDTH;
+	static constexpr uint32_t MaxLightIndexCount = LIGHT_INDEX_TEXTURE_WIDTH * LIGHT_INDEX_TEXTURE_HEIGHT;
+
+	static uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t z) { return x + y * CountX + z * CountX * CountY; }
+
+public:
+	LightClusterGrid() = default;
+	LightClusterGrid(const LightClusterGrid&) = delete;
+	LightClusterGrid& operator=(const LightClusterGrid&) = delete;
+	LightClusterGrid(LightClusterGrid&&) = default;
+	LightClusterGrid& operator=(LightClusterGrid&&) = default;
+	~LightClusterGrid() = default;
+
+	// The projection matrix is expected to be a symmetric perspective projection.
+	// Lights over MaxLightCount and light indices over MaxLightIndexCount are dropped.
+	void Build(const cd::Matrix4x4& viewMatrix, const cd::Matrix4x4& projectionMatrix, float nearPlane, float farPlane,
+		const U_Light* pLights, uint32_t lightCount);
+
+	// Depth slice of a view space depth is floor(log(depth) * scale + bias).
+	float GetDepthSliceScale() const { return m_depthSliceScale; }
+	float GetDepthSliceBias() const { return m_depthSliceBias; }
+	uint32_t GetDepthSlice(float viewDepth) const;
+
+	uint32_t GetLightCount() const { return m_lightCount; }
+	uint32_t GetGlobalLightCount() const { return m_globalLightCount; }
+
+	// Light index offset and count pairs of clusters. Global lights are at the beginning of light indices.
+	// Values are stored as floats which are exact for these ranges to upload as float textures.
+	const std::vector<float>& GetClusterData() const { return m_clusterData; }
+	uint32_t GetClusterLightOffset(uint32_t clusterIndex) const { return static_cast<uint32_t>(m_clusterData[clusterIndex * 2]); }
+	uint32_t GetClusterLightCount(uint32_t clusterIndex) const { return static_cast<uint32_t>(m_clusterData[clusterIndex * 2 + 1]); }
+
+	// Light indices are padded to full rows of the light index texture.
+	const std::vector<float>& GetLightIndices() const { return m_lightIndices; }
+	uint32_t GetLightIndexCount() const { return m_lightIndexCount; }
+	uint32_t GetLightIndexRowCount() const { return static_cast<uint32_t>(m_lightIndices.size()) / LightIndexTextureWidth; }
+
+private:
+	struct ClusterLight
+	{
+		uint32_t clusterIndex;
+		uint32_t lightIndex;
+	};
+
+	float m_depthSliceScale = 0.0f;
+	float m_depthSliceBias = 0.0f;
+	uint32_t m_lightCount = 0U;
+	uint32_t m_globalLightCount = 0U;
+	uint32_t m_lightIndexCount = 0U;
+
+	std::vector<float> m_clusterData;
+	std::vector<float> m_lightIndices;
+
+	// Reused every build to count lights per cluster before writing compact lists.
+	std::vector<uint32_t> m_clusterLightCounts;
+	std::vector<ClusterLight> m_clusterLights;
+};
+
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "RenderContext.h"
 
+#include "Core/Jobs/JobSystem.h"
 #include "Log/Log.h"
 #include "Path/Path.h"
 #include "Renderer.h"
@@ -95,6 +96,10 @@ void RenderContext::Init(GraphicsBackend backend, void* hwnd)
 	}
 	}
 
+	// Renderers encode draws in the main thread and all workers at the same time. The first encoder is owned by the main thread.
+	// Others are one per thread and kept for the whole frame, see FrameEncoders.
+	initDesc.limits.maxEncoders = static_cast<uint16_t>(JobSystem::Get().GetWorkerCount() + 2U);
+
 	initDesc.platformData.nwh = hwnd;
 	bgfx::init(initDesc);
 }
@@ -128,9 +133,11 @@ void RenderContext::BeginFrame()
 
 void RenderContext::EndFrame()
 {
+	Renderer::EndFrameEncoders();
+
 	// Advance to next frame. Rendering thread will be kicked to
 	// process submitted rendering primitives.
-	bgfx::frame();
+	m_frameNumber = bgfx::frame();
 }
 
 void RenderContext::OnResize(uint16_t width, uint16_t height)
@@ -166,8 +173,10 @@ RenderTarget* RenderContext::CreateRenderTarget(StringCrc resourceCrc, std::uniq
 
 	assert(m_renderTargetCaches.size() <= MaxRenderTargetCount && "Overflow the max count of render targets.");
 
+	std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
+	RenderTarget* pNewRenderTarget = pRenderTarget.get();
 	m_renderTargetCaches[resourceCrc.Value()] = std::move(pRenderTarget);
-	return m_renderTargetCaches[resourceCrc.Value()].get();
+	return pNewRenderTarget;
 }
 
 bgfx::ShaderHandle RenderContext::CreateShader(const char* pFilePath)
@@ -199,6 +208,7 @@ bgfx::ShaderHandle RenderContext::CreateShader(const char* pFilePath)
 	if(bgfx::isValid(handle))
 	{
 		bgfx::setName(handle, pFilePath);
+		std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 		m_shaderHandleCaches[filePath.Value()] = handle;
 	}
 
@@ -222,6 +232,7 @@ bgfx::ProgramHandle RenderContext::CreateProgram(const char* pName, bgfx::Shader
 	bgfx::ProgramHandle program = bgfx::createProgram(vsh, fsh);
 	if(bgfx::isValid(program))
 	{
+		std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 		m_programHandleCaches[programName.Value()] = program;
 	}
 
@@ -245,6 +256,7 @@ bgfx::ProgramHandle RenderContext::CreateProgram(const char *pName, bgfx::Shader
 	bgfx::ProgramHandle program = bgfx::createProgram(csh, true);
 	if (bgfx::isValid(program))
 	{
+		std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 		m_programHandleCaches[programName.Value()] = program;
 	}
 
@@ -327,6 +339,7 @@ bgfx::TextureHandle RenderContext::CreateTexture(const char* pFilePath, uint64_t
 	if (bgfx::isValid(handle))
 	{
 		bgfx::setName(handle, pFilePath);
+		std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 		m_textureHandleCaches[filePath.Value()] = handle;
 	}
 
@@ -362,6 +375,7 @@ bgfx::TextureHandle RenderContext::CreateTexture(const char* pName, uint16_t wid
 	if(bgfx::isValid(texture))
 	{
 		bgfx::setName(texture, pName);
+		std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 		m_textureHandleCaches[textureName.Value()] = texture;
 	}
 	else
@@ -415,6 +429,7 @@ bgfx::UniformHandle RenderContext::CreateUniform(const char* pName, bgfx::Unifor
 	bgfx::UniformHandle uniformHandle = bgfx::createUniform(pName, uniformType, number);
 	if(bgfx::isValid(uniformHandle))
 	{
+		std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 		m_uniformHandleCaches[uniformName.Value()] = uniformHandle;
 	}
 
@@ -431,6 +446,7 @@ bgfx::VertexLayout RenderContext::CreateVertexLayout(StringCrc resourceCrc, cons
 
 	bgfx::VertexLayout newVertexLayout;
 	VertexLayoutUtility::CreateVertexLayout(newVertexLayout, vertexAttributes);
+	std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 	m_vertexLayoutCaches[resourceCrc.Value()] = newVertexLayout;
 	return newVertexLayout;
 }
@@ -445,22 +461,26 @@ bgfx::VertexLayout RenderContext::CreateVertexLayout(StringCrc resourceCrc, cons
 
 	bgfx::VertexLayout newVertexLayout;
 	VertexLayoutUtility::CreateVertexLayout(newVertexLayout, vertexAttribute);
+	std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 	m_vertexLayoutCaches[resourceCrc.Value()] = newVertexLayout;
 	return newVertexLayout;
 }
 
 void RenderContext::SetVertexLayout(StringCrc resourceCrc, bgfx::VertexLayout vertexLayoutHandle)
 {
+	std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 	m_vertexLayoutCaches[resourceCrc.Value()] = std::move(vertexLayoutHandle);
 }
 
 void RenderContext::SetTexture(StringCrc resourceCrc, bgfx::TextureHandle textureHandle)
 {
+	std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 	m_textureHandleCaches[resourceCrc.Value()] = std::move(textureHandle);
 }
 
 void RenderContext::SetUniform(StringCrc resourceCrc, bgfx::UniformHandle uniformreHandle)
 {
+	std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 	m_uniformHandleCaches[resourceCrc.Value()] = std::move(uniformreHandle);
 }
 
@@ -469,8 +489,14 @@ void RenderContext::FillUniform(StringCrc resourceCrc, const void *pData, uint16
 	bgfx::setUniform(GetUniform(resourceCrc), pData, vec4Count);
 }
 
+void RenderContext::FillUniform(bgfx::Encoder* pEncoder, StringCrc resourceCrc, const void* pData, uint16_t vec4Count) const
+{
+	pEncoder->setUniform(GetUniform(resourceCrc), pData, vec4Count);
+}
+
 RenderTarget* RenderContext::GetRenderTarget(StringCrc resourceCrc) const
 {
+	std::shared_lock<std::shared_mutex> lock(m_resourceMutex);
 	auto itResource = m_renderTargetCaches.find(resourceCrc.Value());
 	if (itResource != m_renderTargetCaches.end())
 	{
@@ -482,6 +508,7 @@ RenderTarget* RenderContext::GetRenderTarget(StringCrc resourceCrc) const
 
 const bgfx::VertexLayout& RenderContext::GetVertexLayout(StringCrc resourceCrc) const
 {
+	std::shared_lock<std::shared_mutex> lock(m_resourceMutex);
 	auto itResource = m_vertexLayoutCaches.find(resourceCrc.Value());
 	if (itResource != m_vertexLayoutCaches.end())
 	{
@@ -494,6 +521,7 @@ const bgfx::VertexLayout& RenderContext::GetVertexLayout(StringCrc resourceCrc)
 
 bgfx::ShaderHandle RenderContext::GetShader(StringCrc resourceCrc) const
 {
+	std::shared_lock<std::shared_mutex> lock(m_resourceMutex);
 	auto itResource = m_shaderHandleCaches.find(resourceCrc.Value());
 	if (itResource != m_shaderHandleCaches.end())
 	{
@@ -505,6 +533,7 @@ bgfx::ShaderHandle RenderContext::GetShader(StringCrc resourceCrc) const
 
 bgfx::ProgramHandle RenderContext::GetProgram(StringCrc resourceCrc) const
 {
+	std::shared_lock<std::shared_mutex> lock(m_resourceMutex);
 	auto itResource = m_programHandleCaches.find(resourceCrc.Value());
 	if (itResource != m_programHandleCaches.end())
 	{
@@ -516,6 +545,7 @@ bgfx::ProgramHandle RenderContext::GetProgram(StringCrc resourceCrc) const
 
 bgfx::TextureHandle RenderContext::GetTexture(StringCrc resourceCrc) const
 {
+	std::shared_lock<std::shared_mutex> lock(m_resourceMutex);
 	auto itResource = m_textureHandleCaches.find(resourceCrc.Value());
 	if (itResource != m_textureHandleCaches.end())
 	{
@@ -527,6 +557,7 @@ bgfx::TextureHandle RenderContext::GetTexture(StringCrc resourceCrc) const
 
 bgfx::UniformHandle RenderContext::GetUniform(StringCrc resourceCrc) const
 {
+	std::shared_lock<std::shared_mutex> lock(m_resourceMutex);
 	auto itResource = m_uniformHandleCaches.find(resourceCrc.Value());
 	if (itResource != m_uniformHandleCaches.end())
 	{
@@ -538,6 +569,7 @@ bgfx::UniformHandle RenderContext::GetUniform(StringCrc resourceCrc) const
 
 void RenderContext::Destory(StringCrc resourceCrc)
 {
+	std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 	DestoryImpl(resourceCrc, m_shaderHandleCaches);
 	DestoryImpl(resourceCrc, m_programHandleCaches);
 	DestoryImpl(resourceCrc, m_textureHandleCaches);
@@ -546,6 +578,7 @@ void RenderContext::Destory(StringCrc resourceCrc)
 
 void RenderContext::DestoryRenderTarget(StringCrc resourceCrc)
 {
+	std::unique_lock<std::shared_mutex> lock(m_resourceMutex);
 	m_renderTargetCaches.erase(resourceCrc.Value());
 }
 
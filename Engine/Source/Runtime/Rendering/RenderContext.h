@@ -11,6 +11,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <shared_mutex>
 #include <unordered_map>
 
 namespace engine
@@ -40,6 +41,9 @@ public:
 	void EndFrame();
 	void Shutdown();
 
+	// Number of the frame which is submitted by last EndFrame. Results of bgfx::readTexture are ready when it reaches their frame numbers.
+	uint32_t GetFrameNumber() const { return m_frameNumber; }
+
 	uint16_t GetBackBufferWidth() const { return m_backBufferWidth; }
 	uint16_t GetBackBufferHeight() const { return m_backBufferHeight; }
 	void SetBackBufferSize(uint16_t width, uint16_t height) { m_backBufferWidth = width; m_backBufferHeight = height; }
@@ -73,6 +77,12 @@ public:
 	void SetUniform(StringCrc resourceCrc, bgfx::UniformHandle uniformreHandle);
 	void FillUniform(StringCrc resourceCrc, const void *pData, uint16_t vec4Count = 1) const;
 
+	// Fills uniform to an encoder which may be used in a worker thread.
+	void FillUniform(bgfx::Encoder* pEncoder, StringCrc resourceCrc, const void* pData, uint16_t vec4Count = 1) const;
+
+	// Resources are created and destroyed in the main thread. Lookups below are safe to call from
+	// worker threads which encode draws at the same time.
+
 	RenderTarget* GetRenderTarget(StringCrc resourceCrc) const;
 	const bgfx::VertexLayout& GetVertexLayout(StringCrc resourceCrc) const;
 	bgfx::ShaderHandle GetShader(StringCrc resourceCrc) const;
@@ -85,6 +95,11 @@ public:
 
 private:
 	uint8_t m_currentViewCount = 0;
+	uint32_t m_frameNumber = 0U;
+
+	// Guards resource caches. Only writes from main thread take the exclusive lock so that
+	// lookups from main thread in create functions don't need to lock.
+	mutable std::shared_mutex m_resourceMutex;
 	std::unordered_map<size_t, std::unique_ptr<RenderTarget>> m_renderTargetCaches;
 	std::unordered_map<size_t, bgfx::VertexLayout> m_vertexLayoutCaches;
 	std::unordered_map<size_t, bgfx::ShaderHandle> m_shaderHandleCaches;
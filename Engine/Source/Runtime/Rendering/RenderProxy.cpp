@@ -0,0 +1,32 @@
+#include "RenderProxy.h"
+
+namespace engine
+{
+
+bool HasSameMaterial(const RenderProxy& proxyA, const RenderProxy& proxyB)
+{
+	if (proxyA.materialHash != proxyB.materialHash ||
+		proxyA.instanceProgramHandle != proxyB.instanceProgramHandle || proxyA.drawBucket != proxyB.drawBucket ||
+		proxyA.renderState != proxyB.renderState || proxyA.alphaCutOff != proxyB.alphaCutOff ||
+		proxyA.albedoColor != proxyB.albedoColor || proxyA.emissiveColor != proxyB.emissiveColor ||
+		proxyA.metallicRoughnessFactor != proxyB.metallicRoughnessFactor || proxyA.textureCount != proxyB.textureCount ||
+		proxyA.hasAlbedoUVOffsetAndScale != proxyB.hasAlbedoUVOffsetAndScale ||
+		(proxyA.hasAlbedoUVOffsetAndScale && proxyA.albedoUVOffsetAndScale != proxyB.albedoUVOffsetAndScale))
+	{
+		return false;
+	}
+
+	for (uint32_t textureIndex = 0U; textureIndex < proxyA.textureCount; ++textureIndex)
+	{
+		const RenderProxyTexture& textureA = proxyA.textures[textureIndex];
+		const RenderProxyTexture& textureB = proxyB.textures[textureIndex];
+		if (textureA.slot != textureB.slot || textureA.samplerHandle != textureB.samplerHandle || textureA.textureHandle != textureB.textureHandle)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+}
\ No newline at end of file
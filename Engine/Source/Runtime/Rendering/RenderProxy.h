@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Core/Math/MeshSimplifier.h"
+#include "DrawList.h"
+#include "ECWorld/Entity.h"
+#include "Math/Box.hpp"
+#include "Math/Matrix.hpp"
+#include "Math/Vector.hpp"
+
+#include <cstdint>
+
+namespace engine
+{
+
+// Texture binding of a material which is set before every submit.
+struct RenderProxyTexture
+{
+	uint8_t slot;
+	uint16_t samplerHandle;
+	uint16_t textureHandle;
+};
+
+// RenderProxy packs everything to submit a static mesh so that draws don't look up components.
+struct RenderProxy
+{
+	static constexpr uint32_t MaxTextureCount = 8U;
+
+	Entity entity;
+
+	// Dense indexes of components. They are valid until components are created or removed.
+	// Entities in StaticMeshArchetype use the same index of the archetype for all of them.
+	uint32_t materialIndex;
+	uint32_t meshIndex;
+	uint32_t transformIndex;
+	bool isInArchetype;
+
+	// Transform
+	cd::Matrix4x4 worldMatrix;
+	cd::Vec3f localCenter;
+	cd::Vec3f worldCenter;
+
+	// Mesh
+	uint16_t vertexBufferHandle;
+	uint16_t indexBufferHandle;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	cd::AABB localAABB;
+
+	// LOD 0 is the index buffer above. Other LODs share the vertex buffer.
+	uint32_t lodCount;
+	uint16_t lodIndexBufferHandles[MeshLODSettings::MaxLODCount];
+
+	// Material
+	uint16_t programHandle;
+	uint16_t instanceProgramHandle;
+	uint16_t textureSet;
+	DrawBucket drawBucket;
+	bool hasAlbedoUVOffsetAndScale;
+	uint64_t renderState;
+	uint32_t materialHash;
+	uint32_t textureCount;
+	RenderProxyTexture textures[MaxTextureCount];
+	cd::Vec4f albedoUVOffsetAndScale;
+	cd::Vec4f albedoColor;
+	cd::Vec4f emissiveColor;
+	cd::Vec4f metallicRoughnessFactor;
+	float alphaCutOff;
+
+	// Component versions of extracted data.
+	uint32_t worldMatrixVersion;
+	uint32_t materialVersion;
+	uint32_t meshVersion;
+};
+
+// Returns true if two proxies can be drawn with the same programs, states, textures and material uniforms.
+// Material hashes are compared at first. Values are compared again as hashes may collide.
+bool HasSameMaterial(const RenderProxy& proxyA, const RenderProxy& proxyB);
+
+}
\ No newline at end of file
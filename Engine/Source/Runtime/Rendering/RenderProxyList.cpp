@@ -0,0 +1,311 @@
+#include "RenderProxyList.h"
+
+#include "ECWorld/AnimationComponent.h"
+#include "ECWorld/MaterialComponent.h"
+#include "ECWorld/StaticMeshComponent.h"
+#include "ECWorld/TransformComponent.h"
+#include "Log/Log.h"
+#include "Material/MaterialType.h"
+
+#include <bgfx/bgfx.h>
+
+#include <cassert>
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr uint64_t defaultRenderingState = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
+
+DrawBucket GetDrawBucket(const MaterialComponent& materialComponent)
+{
+	if (cd::BlendMode::Opaque == materialComponent.GetBlendMode())
+	{
+		return DrawBucket::Opaque;
+	}
+	else if (cd::BlendMode::Mask == materialComponent.GetBlendMode())
+	{
+		return DrawBucket::Masked;
+	}
+
+	return DrawBucket::Blended;
+}
+
+uint32_t HashValues(uint32_t hash, const void* pValues, uint32_t valueCount)
+{
+	for (uint32_t valueIndex = 0U; valueIndex < valueCount; ++valueIndex)
+	{
+		uint32_t value;
+		std::memcpy(&value, static_cast<const uint32_t*>(pValues) + valueIndex, sizeof(uint32_t));
+		hash = (hash ^ value) * 16777619U;
+	}
+
+	return hash;
+}
+
+void ExtractMaterial(RenderProxy& proxy, const MaterialComponent& materialComponent)
+{
+	proxy.programHandle = materialComponent.GetShadreProgram();
+	proxy.instanceProgramHandle = materialComponent.GetInstanceShaderProgram();
+	proxy.drawBucket = GetDrawBucket(materialComponent);
+
+	proxy.renderState = defaultRenderingState;
+	if (!materialComponent.GetTwoSided())
+	{
+		proxy.renderState |= BGFX_STATE_CULL_CCW;
+	}
+
+	// Hash of material states to group instances which is compared again by values before merging draws.
+	uint32_t materialHash = 2166136261U;
+	uint32_t programHandle = proxy.instanceProgramHandle;
+	materialHash = HashValues(materialHash, &programHandle, 1U);
+
+	proxy.textureSet = 0U;
+	proxy.textureCount = 0U;
+	proxy.hasAlbedoUVOffsetAndScale = false;
+	for (const auto& [textureType, textureInfo] : materialComponent.GetTextureResources())
+	{
+		if (proxy.textureCount == RenderProxy::MaxTextureCount)
+		{
+			CD_ENGINE_WARN("Material {0} has more than {1} textures.", materialComponent.GetName(), RenderProxy::MaxTextureCount);
+			break;
+		}
+
+		proxy.textures[proxy.textureCount++] = RenderProxyTexture{ textureInfo.slot, textureInfo.samplerHandle, textureInfo.textureHandle };
+		proxy.textureSet = DrawSortKey::HashTextureHandle(proxy.textureSet, textureInfo.textureHandle);
+		if (cd::MaterialTextureType::BaseColor == textureType)
+		{
+			proxy.albedoUVOffsetAndScale = cd::Vec4f(textureInfo.GetUVOffset().x(), textureInfo.GetUVOffset().y(),
+				textureInfo.GetUVScale().x(), textureInfo.GetUVScale().y());
+			proxy.hasAlbedoUVOffsetAndScale = true;
+		}
+
+		uint32_t textureData[] = { textureInfo.textureHandle, textureInfo.samplerHandle, textureInfo.slot };
+		materialHash = HashValues(materialHash, textureData, 3U);
+	}
+
+	const cd::Vec3f& albedoColor = materialComponent.GetAlbedoColor();
+	const cd::Vec3f& emissiveColor = materialComponent.GetEmissiveColor();
+	proxy.albedoColor = cd::Vec4f(albedoColor.x(), albedoColor.y(), albedoColor.z(), 1.0f);
+	proxy.emissiveColor = cd::Vec4f(emissiveColor.x(), emissiveColor.y(), emissiveColor.z(), 1.0f);
+	proxy.metallicRoughnessFactor = cd::Vec4f(materialComponent.GetMetallicFactor(), materialComponent.GetRoughnessFactor(), 1.0f, 1.0f);
+	proxy.alphaCutOff = materialComponent.GetAlphaCutOff();
+
+	materialHash = HashValues(materialHash, proxy.albedoUVOffsetAndScale.Begin(), proxy.hasAlbedoUVOffsetAndScale ? 4U : 0U);
+	materialHash = HashValues(materialHash, proxy.albedoColor.Begin(), 3U);
+	materialHash = HashValues(materialHash, proxy.emissiveColor.Begin(), 3U);
+	materialHash = HashValues(materialHash, proxy.metallicRoughnessFactor.Begin(), 2U);
+	materialHash = HashValues(materialHash, &proxy.alphaCutOff, 1U);
+	uint32_t states[] = { static_cast<uint32_t>(proxy.drawBucket), static_cast<uint32_t>(proxy.renderState) };
+	proxy.materialHash = HashValues(materialHash, states, 2U);
+}
+
+void ExtractMesh(RenderProxy& proxy, const StaticMeshComponent& meshComponent)
+{
+	proxy.vertexBufferHandle = meshComponent.GetVertexBuffer();
+	proxy.indexBufferHandle = meshComponent.GetIndexBuffer();
+
+	const cd::Mesh* pMeshData = meshComponent.GetMeshData();
+	proxy.vertexCount = pMeshData ? pMeshData->GetVertexCount() : 0U;
+	proxy.indexCount = pMeshData ? pMeshData->GetPolygonCount() * cd::Polygon::Size : 0U;
+
+	proxy.lodCount = meshComponent.GetLODCount();
+	for (uint32_t lod = 0U; lod < proxy.lodCount; ++lod)
+	{
+		proxy.lodIndexBufferHandles[lod] = meshComponent.GetLODIndexBuffer(lod);
+	}
+
+	proxy.localAABB = meshComponent.GetAABB();
+	proxy.localCenter = proxy.localAABB.IsEmpty() ? cd::Vec3f::Zero() : proxy.localAABB.Center();
+}
+
+// World space center of the bounding box which is used to sort draws by depth. Matrix is column major.
+void UpdateWorldCenter(RenderProxy& proxy)
+{
+	const float* pWorld = proxy.worldMatrix.Begin();
+	const cd::Vec3f& localCenter = proxy.localCenter;
+	float worldCenter[3];
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		worldCenter[axis] = pWorld[axis] * localCenter.x() + pWorld[4 + axis] * localCenter.y() + pWorld[8 + axis] * localCenter.z() + pWorld[12 + axis];
+	}
+	proxy.worldCenter = cd::Vec3f(worldCenter[0], worldCenter[1], worldCenter[2]);
+}
+
+}
+
+RenderProxyList::RenderProxyList(ComponentsStorage<MaterialComponent>* pMaterialStorage, ComponentsStorage<StaticMeshComponent>* pStaticMeshStorage,
+	ComponentsStorage<TransformComponent>* pTransformStorage, ComponentsStorage<AnimationComponent>* pAnimationStorage,
+	StaticMeshArchetype* pStaticMeshArchetype, const MaterialType* pMaterialType)
+	: m_pMaterialStorage(pMaterialStorage)
+	, m_pStaticMeshStorage(pStaticMeshStorage)
+	, m_pTransformStorage(pTransformStorage)
+	, m_pAnimationStorage(pAnimationStorage)
+	, m_pStaticMeshArchetype(pStaticMeshArchetype)
+	, m_pMaterialType(pMaterialType)
+{
+	assert(pMaterialStorage && pStaticMeshStorage && pTransformStorage && pAnimationStorage && pMaterialType);
+}
+
+const StaticMeshComponent& RenderProxyList::GetStaticMeshComponent(const RenderProxy& proxy) const
+{
+	return proxy.isInArchetype ? m_pStaticMeshArchetype->GetComponentByIndex<StaticMeshComponent>(proxy.meshIndex) :
+		m_pStaticMeshStorage->GetDenseComponents()[proxy.meshIndex];
+}
+
+void RenderProxyList::Update(SkyType skyType)
+{
+	m_updatedCount = 0U;
+
+	// Components are created or removed so that dense indexes are changed.
+	const bool isEntitySetChanged = m_materialVersion != m_pMaterialStorage->GetVersion() ||
+		m_staticMeshVersion != m_pStaticMeshStorage->GetVersion() ||
+		m_transformVersion != m_pTransformStorage->GetVersion() ||
+		m_animationVersion != m_pAnimationStorage->GetVersion() ||
+		(m_pStaticMeshArchetype && m_archetypeVersion != m_pStaticMeshArchetype->GetVersion());
+	if (isEntitySetChanged)
+	{
+		Rebuild();
+	}
+
+	const bool isSkyTypeChanged = m_skyType != skyType;
+	const uint32_t programVersion = m_pMaterialType->GetShaderSchema().GetProgramVersion();
+	const bool isProgramChanged = m_programVersion != programVersion;
+
+	std::vector<MaterialComponent>& materialComponents = m_pMaterialStorage->GetDenseComponents();
+	const std::vector<StaticMeshComponent>& meshComponents = m_pStaticMeshStorage->GetDenseComponents();
+	const std::vector<TransformComponent>& transformComponents = m_pTransformStorage->GetDenseComponents();
+	for (RenderProxy& proxy : m_proxies)
+	{
+		MaterialComponent& materialComponent = proxy.isInArchetype ?
+			m_pStaticMeshArchetype->GetComponentByIndex<MaterialComponent>(proxy.materialIndex) : materialComponents[proxy.materialIndex];
+		const StaticMeshComponent& meshComponent = proxy.isInArchetype ?
+			m_pStaticMeshArchetype->GetComponentByIndex<StaticMeshComponent>(proxy.meshIndex) : meshComponents[proxy.meshIndex];
+		const TransformComponent& transformComponent = proxy.isInArchetype ?
+			m_pStaticMeshArchetype->GetComponentByIndex<TransformComponent>(proxy.transformIndex) : transformComponents[proxy.transformIndex];
+
+		// Sky type is applied again to changed materials as they may be reset.
+		if (isSkyTypeChanged || materialComponent.GetVersion() != proxy.materialVersion)
+		{
+			materialComponent.SetSkyType(skyType);
+		}
+
+		const bool isMaterialChanged = isProgramChanged || materialComponent.GetVersion() != proxy.materialVersion;
+		const bool isMeshChanged = meshComponent.GetVersion() != proxy.meshVersion;
+		const bool isTransformChanged = transformComponent.GetWorldMatrixVersion() != proxy.worldMatrixVersion;
+		if (!isMaterialChanged && !isMeshChanged && !isTransformChanged)
+		{
+			continue;
+		}
+
+		if (isMaterialChanged)
+		{
+			ExtractMaterial(proxy, materialComponent);
+			proxy.materialVersion = materialComponent.GetVersion();
+		}
+
+		if (isMeshChanged)
+		{
+			ExtractMesh(proxy, meshComponent);
+			proxy.meshVersion = meshComponent.GetVersion();
+		}
+
+		if (isTransformChanged)
+		{
+			proxy.worldMatrix = transformComponent.GetWorldMatrix();
+			proxy.worldMatrixVersion = transformComponent.GetWorldMatrixVersion();
+		}
+
+		if (isMeshChanged || isTransformChanged)
+		{
+			UpdateWorldCenter(proxy);
+		}
+
+		++m_updatedCount;
+	}
+
+	m_skyType = skyType;
+	m_programVersion = programVersion;
+	if (isEntitySetChanged || m_updatedCount > 0U)
+	{
+		++m_version;
+	}
+}
+
+void RenderProxyList::Rebuild()
+{
+	// Entity set changes are rare so that all proxies are created again and extracted by the following Update.
+	m_proxies.clear();
+
+	const std::vector<Entity>& entities = m_pMaterialStorage->GetEntities();
+	const std::vector<MaterialComponent>& materialComponents = m_pMaterialStorage->GetDenseComponents();
+	for (uint32_t materialIndex = 0U; materialIndex < entities.size(); ++materialIndex)
+	{
+		// TODO : improve this condition. As we want to skip some feature-specified entities to render.
+		// For example, terrain/particle/...
+		if (materialComponents[materialIndex].GetMaterialType() != m_pMaterialType)
+		{
+			continue;
+		}
+
+		// SkinMesh
+		Entity entity = entities[materialIndex];
+		if (m_pAnimationStorage->Contains(entity))
+		{
+			continue;
+		}
+
+		uint32_t meshIndex = m_pStaticMeshStorage->GetDenseIndex(entity);
+		uint32_t transformIndex = m_pTransformStorage->GetDenseIndex(entity);
+		if (ComponentsStorage<StaticMeshComponent>::InvalidIndex == meshIndex ||
+			ComponentsStorage<TransformComponent>::InvalidIndex == transformIndex)
+		{
+			continue;
+		}
+
+		RenderProxy& proxy = m_proxies.emplace_back();
+		proxy.entity = entity;
+		proxy.materialIndex = materialIndex;
+		proxy.meshIndex = meshIndex;
+		proxy.transformIndex = transformIndex;
+		proxy.isInArchetype = false;
+		proxy.worldMatrixVersion = InvalidVersion;
+		proxy.materialVersion = InvalidVersion;
+		proxy.meshVersion = InvalidVersion;
+	}
+
+	// Archetype entities own all three components so that they only need the material type check.
+	if (m_pStaticMeshArchetype)
+	{
+		uint32_t archetypeIndex = 0U;
+		m_pStaticMeshArchetype->Each([this, &archetypeIndex](Entity entity, TransformComponent&, StaticMeshComponent&, MaterialComponent& materialComponent)
+		{
+			const uint32_t index = archetypeIndex++;
+			if (materialComponent.GetMaterialType() != m_pMaterialType)
+			{
+				return;
+			}
+
+			RenderProxy& proxy = m_proxies.emplace_back();
+			proxy.entity = entity;
+			proxy.materialIndex = index;
+			proxy.meshIndex = index;
+			proxy.transformIndex = index;
+			proxy.isInArchetype = true;
+			proxy.worldMatrixVersion = InvalidVersion;
+			proxy.materialVersion = InvalidVersion;
+			proxy.meshVersion = InvalidVersion;
+		});
+		m_archetypeVersion = m_pStaticMeshArchetype->GetVersion();
+	}
+
+	m_materialVersion = m_pMaterialStorage->GetVersion();
+	m_staticMeshVersion = m_pStaticMeshStorage->GetVersion();
+	m_transformVersion = m_pTransformStorage->GetVersion();
+	m_animationVersion = m_pAnimationStorage->GetVersion();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ECWorld/ArchetypeStorage.hpp"
+#include "ECWorld/ComponentsStorage.hpp"
+#include "ECWorld/SkyComponent.h"
+#include "RenderProxy.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class AnimationComponent;
+class MaterialComponent;
+class MaterialType;
+class StaticMeshComponent;
+class TransformComponent;
+
+// RenderProxyList keeps a retained RenderProxy for every PBR static mesh in the ECWorld.
+// Proxies are rebuilt when components are created or removed. Otherwise only the data of
+// changed components are extracted again by comparing versions so that static scenes cost almost nothing.
+// Entities in StaticMeshArchetype are extracted from its chunks after the ones in per-type storages.
+// pStaticMeshArchetype is nullptr if the World doesn't enable it.
+class RenderProxyList final
+{
+public:
+	static constexpr uint32_t InvalidVersion = UINT32_MAX;
+
+public:
+	RenderProxyList() = delete;
+	explicit RenderProxyList(ComponentsStorage<MaterialComponent>* pMaterialStorage, ComponentsStorage<StaticMeshComponent>* pStaticMeshStorage,
+		ComponentsStorage<TransformComponent>* pTransformStorage, ComponentsStorage<AnimationComponent>* pAnimationStorage,
+		StaticMeshArchetype* pStaticMeshArchetype, const MaterialType* pMaterialType);
+	RenderProxyList(const RenderProxyList&) = delete;
+	RenderProxyList& operator=(const RenderProxyList&) = delete;
+	RenderProxyList(RenderProxyList&&) = default;
+	RenderProxyList& operator=(RenderProxyList&&) = default;
+	~RenderProxyList() = default;
+
+	// Sky type decides the uber shader so that it is applied to materials before extracting programs.
+	void Update(SkyType skyType);
+
+	const std::vector<RenderProxy>& GetProxies() const { return m_proxies; }
+	uint32_t GetProxyCount() const { return static_cast<uint32_t>(m_proxies.size()); }
+
+	// Count of proxies whose data are extracted again by last Update.
+	uint32_t GetUpdatedCount() const { return m_updatedCount; }
+
+	// Increased when proxies are created again or any of them is updated.
+	uint32_t GetVersion() const { return m_version; }
+
+	const StaticMeshComponent& GetStaticMeshComponent(const RenderProxy& proxy) const;
+
+private:
+	void Rebuild();
+
+private:
+	ComponentsStorage<MaterialComponent>* m_pMaterialStorage;
+	ComponentsStorage<StaticMeshComponent>* m_pStaticMeshStorage;
+	ComponentsStorage<TransformComponent>* m_pTransformStorage;
+	ComponentsStorage<AnimationComponent>* m_pAnimationStorage;
+	StaticMeshArchetype* m_pStaticMeshArchetype;
+	const MaterialType* m_pMaterialType;
+
+	uint32_t m_materialVersion = InvalidVersion;
+	uint32_t m_staticMeshVersion = InvalidVersion;
+	uint32_t m_transformVersion = InvalidVersion;
+	uint32_t m_animationVersion = InvalidVersion;
+	uint32_t m_archetypeVersion = InvalidVersion;
+	uint32_t m_programVersion = InvalidVersion;
+	SkyType m_skyType = SkyType::Count;
+
+	std::vector<RenderProxy> m_proxies;
+	uint32_t m_updatedCount = 0U;
+	uint32_t m_version = 0U;
+};
+
+}
\ No newline at end of file
@@ -22,6 +22,19 @@ bgfx::TextureHandle RenderTarget::GetTextureHandle(int index) const
 	return bgfx::getTexture(*m_pFrameBufferHandle.get(), index);
 }
 
+bgfx::TextureHandle RenderTarget::GetDepthTextureHandle() const
+{
+	for (size_t attachmentIndex = 0; attachmentIndex < m_attachmentDescriptors.size(); ++attachmentIndex)
+	{
+		if (TextureFormat::D32F == m_attachmentDescriptors[attachmentIndex].textureFormat)
+		{
+			return GetTextureHandle(static_cast<int>(attachmentIndex));
+		}
+	}
+
+	return BGFX_INVALID_HANDLE;
+}
+
 void RenderTarget::Resize(uint16_t width, uint16_t height)
 {
 	if (width == m_width && height == m_height)
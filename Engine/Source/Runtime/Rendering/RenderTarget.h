@@ -50,6 +50,9 @@ public:
 	const bgfx::FrameBufferHandle* GetFrameBufferHandle() const { return m_pFrameBufferHandle.get(); }
 	bgfx::TextureHandle GetTextureHandle(int index) const;
 
+	// Returns an invalid handle if there is no D32F attachment.
+	bgfx::TextureHandle GetDepthTextureHandle() const;
+
 public:
 	MulticastDelegate<void(uint16_t, uint16_t)> OnResize;
 
@@ -1,10 +1,18 @@
 #include "Renderer.h"
 
+#include "Core/Jobs/JobSystem.h"
+#include "FrameEncoders.h"
 #include "RenderContext.h"
 #include "RenderTarget.h"
 
 #include <bgfx/bgfx.h>
 
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 namespace engine
 {
 
@@ -39,6 +47,65 @@ void Renderer::UpdateViewRenderTarget()
 	}
 }
 
+static FrameEncoders s_frameEncoders([]() { return bgfx::begin(true); }, [](bgfx::Encoder* pEncoder) { bgfx::end(pEncoder); });
+void Renderer::EndFrameEncoders()
+{
+	s_frameEncoders.EndFrame();
+}
+
+void Renderer::ParallelEncode(uint32_t count, uint32_t minChunkSize, const EncodeFunction& encodeFunc) const
+{
+	if (0U == count)
+	{
+		return;
+	}
+
+	// The first encoder is owned by the API thread. Others are shared by worker threads.
+	// Single threaded bgfx only has the first one.
+	JobSystem& jobSystem = JobSystem::Get();
+	const uint32_t maxEncoderCount = bgfx::getCaps()->limits.maxEncoders;
+	const uint32_t maxChunkCount = std::min(jobSystem.GetWorkerCount() + 1U, maxEncoderCount > 1U ? maxEncoderCount - 1U : 0U);
+	if (count <= minChunkSize || maxChunkCount <= 1U)
+	{
+		bgfx::Encoder* pEncoder = bgfx::begin();
+		encodeFunc(pEncoder, 0U, count);
+		bgfx::end(pEncoder);
+		return;
+	}
+
+	// Threads encode chunks by their encoders of the frame which are shared with other renderers, see FrameEncoders.
+	// Chunks of threads which fail to get an encoder are encoded by the first encoder after all others.
+	std::mutex fallbackChunksMutex;
+	std::vector<std::pair<uint32_t, uint32_t>> fallbackChunks;
+	const uint32_t chunkSize = std::max(minChunkSize, (count + maxChunkCount - 1U) / maxChunkCount);
+	jobSystem.ParallelFor(count, chunkSize, [&encodeFunc, &fallbackChunksMutex, &fallbackChunks](uint32_t beginIndex, uint32_t endIndex)
+	{
+		bgfx::Encoder* pEncoder = s_frameEncoders.Acquire();
+		if (!pEncoder)
+		{
+			std::lock_guard<std::mutex> lock(fallbackChunksMutex);
+			fallbackChunks.emplace_back(beginIndex, endIndex);
+			return;
+		}
+
+		encodeFunc(pEncoder, beginIndex, endIndex);
+
+		// States which are set but not submitted must not leak to the next chunk of the encoder.
+		pEncoder->discard();
+	});
+
+	if (!fallbackChunks.empty())
+	{
+		bgfx::Encoder* pEncoder = bgfx::begin();
+		for (const auto& [beginIndex, endIndex] : fallbackChunks)
+		{
+			encodeFunc(pEncoder, beginIndex, endIndex);
+			pEncoder->discard();
+		}
+		bgfx::end(pEncoder);
+	}
+}
+
 struct PosColorTexCoord0Vertex
 {
 	float m_x;
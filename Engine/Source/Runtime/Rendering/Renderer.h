@@ -1,6 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
+
+namespace bgfx
+{
+
+struct Encoder;
+
+}
 
 namespace engine
 {
@@ -11,6 +19,9 @@ class RenderTarget;
 
 class Renderer
 {
+public:
+	using EncodeFunction = std::function<void(bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex)>;
+
 public:
 	Renderer() = delete;
 	explicit Renderer(uint16_t viewID, RenderTarget* pRenderTarget = nullptr);
@@ -23,6 +34,9 @@ public:
 	static void SetRenderContext(RenderContext* pRenderContext);
 	static RenderContext* GetRenderContext();
 
+	// Ends encoders which are kept by threads for ParallelEncode in current frame. Call it before bgfx::frame.
+	static void EndFrameEncoders();
+
 	virtual void Init() = 0;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) = 0;
 	virtual void Render(float deltaTime) = 0;
@@ -39,6 +53,12 @@ public:
 public:
 	static void ScreenSpaceQuad(const RenderTarget* pRenderTarget, bool _originBottomLeft = false, float _width = 1.0f, float _height = 1.0f);
 
+protected:
+	// Splits [0, count) into chunks which are encoded in parallel by worker threads. Every thread encodes by its own encoder
+	// which is shared by all ParallelEncode calls of the frame, so that encodeFunc must set uniforms again for every chunk.
+	// Draws of chunks are interleaved in the view. Counts not larger than minChunkSize are encoded in current thread.
+	void ParallelEncode(uint32_t count, uint32_t minChunkSize, const EncodeFunction& encodeFunc) const;
+
 protected:
 	uint16_t m_viewID = 0;
 	RenderTarget* m_pRenderTarget = nullptr;
@@ -51,6 +51,9 @@ std::vector<std::byte> LoadFile(const char* pFilePath)
 	return fileData;
 }
 
+// Sectors in a chunk are encoded by one job. Smaller chunks cost more than the encoding itself.
+constexpr uint32_t MinEncodeChunkSize = 64U;
+
 }
 
 namespace engine
@@ -82,9 +85,12 @@ void TerrainRenderer::UpdateView(const float* pViewMatrix, const float* pProject
 
 void TerrainRenderer::Render(float deltaTime)
 {
-	for (const Entity& entity : m_pCurrentSceneWorld->GetMaterialEntities())
+	// Collect visible terrain sectors in main thread which may update render infos.
+	m_visibleEntities.clear();
+	m_visiblePrograms.clear();
+	for (auto [entity, materialComponent, meshComponent] : m_pCurrentSceneWorld->View<MaterialComponent, StaticMeshComponent>())
 	{
-		if (!IsTerrainMesh(entity))
+		if (materialComponent.GetMaterialType() != m_pCurrentSceneWorld->GetTerrainMaterialType())
 		{
 			continue;
 		}
@@ -106,47 +112,60 @@ void TerrainRenderer::Render(float deltaTime)
 			continue;
 		}
 
+		// Programs are resolved in main thread as querying a variant which is not loaded records a request to the shader schema.
+		m_visibleEntities.push_back(entity);
+		m_visiblePrograms.push_back(materialComponent.GetShadreProgram());
+	}
+
+	ParallelEncode(static_cast<uint32_t>(m_visibleEntities.size()), MinEncodeChunkSize, [this](bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex)
+	{
+		EncodeDraws(pEncoder, beginIndex, endIndex);
+	});
+}
+
+void TerrainRenderer::EncodeDraws(bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex) const
+{
+	for (uint32_t entityIndex = beginIndex; entityIndex < endIndex; ++entityIndex)
+	{
+		Entity entity = m_visibleEntities[entityIndex];
 		const MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
 		const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
 
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
+		pEncoder->setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
+		pEncoder->setIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
 
-		bgfx::setTexture(m_dirtTexture.slot, bgfx::UniformHandle{m_dirtTexture.samplerHandle}, bgfx::TextureHandle{m_dirtTexture.textureHandle});
+		pEncoder->setTexture(m_dirtTexture.slot, bgfx::UniformHandle{m_dirtTexture.samplerHandle}, bgfx::TextureHandle{m_dirtTexture.textureHandle});
 		if (m_redChannelTexture.textureHandle != bgfx::kInvalidHandle && m_redChannelTexture.samplerHandle != bgfx::kInvalidHandle)
 		{
-			bgfx::setTexture(m_redChannelTexture.slot, bgfx::UniformHandle{m_redChannelTexture.samplerHandle}, bgfx::TextureHandle{m_redChannelTexture.textureHandle});
+			pEncoder->setTexture(m_redChannelTexture.slot, bgfx::UniformHandle{m_redChannelTexture.samplerHandle}, bgfx::TextureHandle{m_redChannelTexture.textureHandle});
 		}
 		if (m_greenChannelTexture.textureHandle != bgfx::kInvalidHandle && m_greenChannelTexture.samplerHandle != bgfx::kInvalidHandle)
 		{
-			bgfx::setTexture(m_greenChannelTexture.slot, bgfx::UniformHandle{m_greenChannelTexture.samplerHandle}, bgfx::TextureHandle{m_greenChannelTexture.textureHandle});
+			pEncoder->setTexture(m_greenChannelTexture.slot, bgfx::UniformHandle{m_greenChannelTexture.samplerHandle}, bgfx::TextureHandle{m_greenChannelTexture.textureHandle});
 		}
 		if (m_blueChannelTexture.textureHandle != bgfx::kInvalidHandle && m_blueChannelTexture.samplerHandle != bgfx::kInvalidHandle)
 		{
-			bgfx::setTexture(m_blueChannelTexture.slot, bgfx::UniformHandle{m_blueChannelTexture.samplerHandle}, bgfx::TextureHandle{m_blueChannelTexture.textureHandle});
+			pEncoder->setTexture(m_blueChannelTexture.slot, bgfx::UniformHandle{m_blueChannelTexture.samplerHandle}, bgfx::TextureHandle{m_blueChannelTexture.textureHandle});
 		}
 		if (m_alphaChannelTexture.textureHandle != bgfx::kInvalidHandle && m_alphaChannelTexture.samplerHandle != bgfx::kInvalidHandle)
 		{
-			bgfx::setTexture(m_alphaChannelTexture.slot, bgfx::UniformHandle{m_alphaChannelTexture.samplerHandle}, bgfx::TextureHandle{m_alphaChannelTexture.textureHandle});
+			pEncoder->setTexture(m_alphaChannelTexture.slot, bgfx::UniformHandle{m_alphaChannelTexture.samplerHandle}, bgfx::TextureHandle{m_alphaChannelTexture.textureHandle});
 		}
 
 		for (const auto& [textureType, textureInfo] : pMaterialComponent->GetTextureResources())
 		{
-			// TODO optimize by using textureInfo instead of GetTextureInfo
-			if (const MaterialComponent::TextureInfo* pTextureInfo = pMaterialComponent->GetTextureInfo(textureType))
-			{
-				bgfx::setTexture(pTextureInfo->slot, bgfx::UniformHandle{pTextureInfo->samplerHandle}, bgfx::TextureHandle{pTextureInfo->textureHandle});
-			}
+			pEncoder->setTexture(textureInfo.slot, bgfx::UniformHandle{textureInfo.samplerHandle}, bgfx::TextureHandle{textureInfo.textureHandle});
 		}
 
-		const TerrainRenderInfo& meshRenderInfo = m_entityToRenderInfo[entity];
-		bgfx::setUniform(u_terrainOrigin, static_cast<const void*>(meshRenderInfo.m_origin));
-		bgfx::setUniform(u_terrainDimension, static_cast<const void*>(meshRenderInfo.m_dimension));
+		// Render infos are not changed during encoding so that it is safe to find them in multiple threads.
+		const TerrainRenderInfo& meshRenderInfo = m_entityToRenderInfo.at(entity);
+		pEncoder->setUniform(u_terrainOrigin, static_cast<const void*>(meshRenderInfo.m_origin));
+		pEncoder->setUniform(u_terrainDimension, static_cast<const void*>(meshRenderInfo.m_dimension));
 
 		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_CULL_CCW | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
-		bgfx::setState(state);
+		pEncoder->setState(state);
 
-		bgfx::submit(GetViewID(), bgfx::ProgramHandle{pMaterialComponent->GetShadreProgram()});
+		pEncoder->submit(GetViewID(), bgfx::ProgramHandle{m_visiblePrograms[entityIndex]});
 	}
 }
 
@@ -7,6 +7,7 @@
 #include <bgfx/bgfx.h>
 
 #include <unordered_map>
+#include <vector>
 
 namespace engine
 {
@@ -52,10 +53,14 @@ private:
 
 	void UpdateUniforms();
 
+	// Encodes visible sectors in [beginIndex, endIndex). It only reads prepared data so that it runs in worker threads.
+	void EncodeDraws(bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex) const;
 
 	bool m_updateUniforms = true;
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
 	std::unordered_map<Entity, TerrainRenderInfo> m_entityToRenderInfo;
+	std::vector<Entity> m_visibleEntities;
+	std::vector<uint16_t> m_visiblePrograms;
 	uint32_t m_cullDistanceSquared = 40000;
 
 	// Textures
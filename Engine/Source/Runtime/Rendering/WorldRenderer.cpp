@@ -1,17 +1,26 @@
 #include "WorldRenderer.h"
 
+#include "ECWorld/AnimationComponent.h"
 #include "ECWorld/CameraComponent.h"
 #include "ECWorld/MaterialComponent.h"
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/SkyComponent.h"
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
-#include "LightUniforms.h"
+#include "HiZRenderer.h"
+#include "Light.h"
+#include "Log/Log.h"
+#include "Material/MaterialType.h"
 #include "Material/ShaderSchema.h"
 #include "Math/Transform.hpp"
 #include "RenderContext.h"
+#include "Rendering/Utility/VertexLayoutUtility.h"
 #include "Scene/Texture.h"
 #include "U_Environment.sh"
+#include "U_GPUDriven.sh"
+
+#include <algorithm>
+#include <cstring>
 
 namespace engine
 {
@@ -33,14 +42,90 @@ constexpr const char* metallicRoughnessFactor = "u_metallicRoughnessFactor";
 constexpr const char* albedoUVOffsetAndScale  = "u_albedoUVOffsetAndScale";
 constexpr const char* alphaCutOff             = "u_alphaCutOff";
 
-constexpr const char* lightCountAndStride     = "u_lightCountAndStride";
-constexpr const char* lightParams             = "u_lightParams";
+constexpr const char* lightClusterSampler     = "s_lightClusters";
+constexpr const char* lightIndexSampler       = "s_lightIndices";
+constexpr const char* lightParamsSampler      = "s_lightParams";
+constexpr const char* lightClusterParams      = "u_lightClusterParams";
+
+constexpr const char* lightClusterTexture     = "LightClusters";
+constexpr const char* lightIndexTexture       = "LightIndices";
+constexpr const char* lightParamsTexture      = "LightParams";
+
+constexpr const char* cullingPlanes           = "u_cullingPlanes";
+constexpr const char* gpuDrivenParams         = "u_gpuDrivenParams";
+constexpr const char* hiZSampler              = "s_hiZ";
+constexpr const char* hiZViewProjection       = "u_hiZViewProj";
+constexpr const char* hiZParams               = "u_hiZParams";
 
 constexpr uint64_t samplerFlags = BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP | BGFX_SAMPLER_W_CLAMP;
-constexpr uint64_t defaultRenderingState = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
+constexpr uint64_t lightClusterTextureFlags = BGFX_SAMPLER_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+
+// A light is stored as a row of vec4s in the light params texture.
+constexpr uint16_t LightVec4Count = sizeof(U_Light) / (4 * sizeof(float));
+static_assert(sizeof(U_Light) == LightVec4Count * 4 * sizeof(float), "U_Light should be aligned to vec4.");
+
+// A column major world matrix per instance.
+constexpr uint16_t InstanceDataStride = 16 * sizeof(float);
+
+// Draws in a chunk are encoded by one job. Smaller chunks cost more than the encoding itself.
+constexpr uint32_t MinEncodeChunkSize = 256U;
+
+static_assert(sizeof(GPUDrivenInstance) == GPU_DRIVEN_INSTANCE_VEC4_COUNT * 4 * sizeof(float), "GPUDrivenInstance should match cs_GPUDrivenCulling.sc.");
+static_assert(sizeof(GPUDrivenDrawCommand) == GPU_DRIVEN_DRAW_COMMAND_UINT_COUNT * sizeof(uint32_t), "GPUDrivenDrawCommand should match cs_GPUDrivenDrawArgs.sc.");
+
+// Compute buffers are viewed as arrays of vec4s or uints whatever their vertex layouts are.
+constexpr uint16_t vec4ComputeBufferFlags = BGFX_BUFFER_COMPUTE_FORMAT_32X4 | BGFX_BUFFER_COMPUTE_TYPE_FLOAT;
+constexpr uint16_t uintComputeBufferFlags = BGFX_BUFFER_INDEX32 | BGFX_BUFFER_COMPUTE_FORMAT_32X1 | BGFX_BUFFER_COMPUTE_TYPE_UINT;
+
+uint32_t GetGPUDrivenGroupCount(uint32_t threadCount)
+{
+	return (threadCount + GPU_DRIVEN_THREAD_COUNT - 1U) / GPU_DRIVEN_THREAD_COUNT;
+}
+
+template<typename T>
+void DestroyHandle(uint16_t& handle)
+{
+	if (UINT16_MAX != handle)
+	{
+		bgfx::destroy(T{handle});
+		handle = UINT16_MAX;
+	}
+}
+
+uint64_t GetDrawSortKey(const RenderProxy& proxy, const cd::Matrix4x4& viewMatrix)
+{
+	// View space depth of the bounding box center. View matrix is left handed and column major.
+	const float* pView = viewMatrix.Begin();
+	float viewDepth = pView[2] * proxy.worldCenter.x() + pView[6] * proxy.worldCenter.y() + pView[10] * proxy.worldCenter.z() + pView[14];
+	return DrawSortKey::Build(proxy.drawBucket, proxy.programHandle, proxy.textureSet, viewDepth);
+}
+
+// Mesh buffers of the selected LOD in high bits and a hash of material states in low bits.
+uint64_t GetInstanceKey(const RenderProxy& proxy, uint32_t lod)
+{
+	return static_cast<uint64_t>(proxy.vertexBufferHandle) << 48 | static_cast<uint64_t>(proxy.lodIndexBufferHandles[lod]) << 32 | proxy.materialHash;
+}
+
+bool CanInstance(const RenderProxy& proxyA, uint32_t lodA, const RenderProxy& proxyB, uint32_t lodB)
+{
+	return proxyA.vertexBufferHandle == proxyB.vertexBufferHandle && proxyA.lodIndexBufferHandles[lodA] == proxyB.lodIndexBufferHandles[lodB] &&
+		HasSameMaterial(proxyA, proxyB);
+}
 
 }
 
+WorldRenderer::~WorldRenderer()
+{
+	GPUDrivenResources& resources = m_gpuDrivenResources;
+	DestroyHandle<bgfx::VertexBufferHandle>(resources.vertexBuffer);
+	DestroyHandle<bgfx::IndexBufferHandle>(resources.indexBuffer);
+	DestroyHandle<bgfx::DynamicVertexBufferHandle>(resources.instanceInputBuffer);
+	DestroyHandle<bgfx::DynamicVertexBufferHandle>(resources.instanceOutputBuffer);
+	DestroyHandle<bgfx::DynamicIndexBufferHandle>(resources.drawCommandBuffer);
+	DestroyHandle<bgfx::DynamicIndexBufferHandle>(resources.instanceCountBuffer);
+	DestroyHandle<bgfx::IndirectBufferHandle>(resources.drawIndirectBuffer);
+}
+
 void WorldRenderer::Init()
 {
 	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
@@ -53,17 +138,47 @@ void WorldRenderer::Init()
 	GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
 	GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
 
-	GetRenderContext()->CreateUniform(cameraPos, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(albedoColor, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(emissiveColor, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(metallicRoughnessFactor, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(albedoUVOffsetAndScale, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(alphaCutOff, bgfx::UniformType::Vec4, 1);
-
-	GetRenderContext()->CreateUniform(lightCountAndStride, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(lightParams, bgfx::UniformType::Vec4, LightUniform::VEC4_COUNT);
+	m_uniformHandles.cameraPos = GetRenderContext()->CreateUniform(cameraPos, bgfx::UniformType::Vec4, 1).idx;
+	m_uniformHandles.albedoColor = GetRenderContext()->CreateUniform(albedoColor, bgfx::UniformType::Vec4, 1).idx;
+	m_uniformHandles.emissiveColor = GetRenderContext()->CreateUniform(emissiveColor, bgfx::UniformType::Vec4, 1).idx;
+	m_uniformHandles.metallicRoughnessFactor = GetRenderContext()->CreateUniform(metallicRoughnessFactor, bgfx::UniformType::Vec4, 1).idx;
+	m_uniformHandles.albedoUVOffsetAndScale = GetRenderContext()->CreateUniform(albedoUVOffsetAndScale, bgfx::UniformType::Vec4, 1).idx;
+	m_uniformHandles.alphaCutOff = GetRenderContext()->CreateUniform(alphaCutOff, bgfx::UniformType::Vec4, 1).idx;
+
+	GetRenderContext()->CreateUniform(lightClusterSampler, bgfx::UniformType::Sampler);
+	GetRenderContext()->CreateUniform(lightIndexSampler, bgfx::UniformType::Sampler);
+	GetRenderContext()->CreateUniform(lightParamsSampler, bgfx::UniformType::Sampler);
+	m_uniformHandles.lightClusterParams = GetRenderContext()->CreateUniform(lightClusterParams, bgfx::UniformType::Vec4, 1).idx;
+
+	GetRenderContext()->CreateTexture(lightClusterTexture, LightClusterGrid::CountX * LightClusterGrid::CountY, LightClusterGrid::CountZ, 1,
+		bgfx::TextureFormat::RG32F, lightClusterTextureFlags);
+	GetRenderContext()->CreateTexture(lightIndexTexture, LIGHT_INDEX_TEXTURE_WIDTH, LIGHT_INDEX_TEXTURE_HEIGHT, 1,
+		bgfx::TextureFormat::R32F, lightClusterTextureFlags);
+	GetRenderContext()->CreateTexture(lightParamsTexture, LightVec4Count, LightClusterGrid::MaxLightCount, 1,
+		bgfx::TextureFormat::RGBA32F, lightClusterTextureFlags);
+
+	World* pWorld = m_pCurrentSceneWorld->GetWorld();
+	m_pRenderProxyList = std::make_unique<RenderProxyList>(pWorld->GetComponents<MaterialComponent>(), pWorld->GetComponents<StaticMeshComponent>(),
+		pWorld->GetComponents<TransformComponent>(), pWorld->GetComponents<AnimationComponent>(), m_pCurrentSceneWorld->GetStaticMeshArchetype(),
+		m_pCurrentSceneWorld->GetPBRMaterialType());
+
+	constexpr uint64_t gpuDrivenCaps = BGFX_CAPS_COMPUTE | BGFX_CAPS_DRAW_INDIRECT | BGFX_CAPS_INSTANCING;
+	if (gpuDrivenCaps == (bgfx::getCaps()->supported & gpuDrivenCaps))
+	{
+		m_gpuDrivenResources.cullingProgram = GetRenderContext()->CreateProgram("GPUDrivenCulling", "cs_GPUDrivenCulling.bin").idx;
+		m_gpuDrivenResources.drawArgsProgram = GetRenderContext()->CreateProgram("GPUDrivenDrawArgs", "cs_GPUDrivenDrawArgs.bin").idx;
+		m_gpuDrivenResources.cullingPlanes = GetRenderContext()->CreateUniform(cullingPlanes, bgfx::UniformType::Vec4, Frustum::PlaneCount).idx;
+		m_gpuDrivenResources.params = GetRenderContext()->CreateUniform(gpuDrivenParams, bgfx::UniformType::Vec4, 1).idx;
+		m_gpuDrivenResources.hiZSampler = GetRenderContext()->CreateUniform(hiZSampler, bgfx::UniformType::Sampler).idx;
+		m_gpuDrivenResources.hiZViewProjection = GetRenderContext()->CreateUniform(hiZViewProjection, bgfx::UniformType::Mat4, 1).idx;
+		m_gpuDrivenResources.hiZParams = GetRenderContext()->CreateUniform(hiZParams, bgfx::UniformType::Vec4, 1).idx;
+	}
 
 	bgfx::setViewName(GetViewID(), "WorldRenderer");
+
+	// Draws are sorted by DrawList already and encoded by several encoders whose submissions interleave.
+	// Every draw passes its index in DrawList as the depth of bgfx's sort key so that bgfx restores the order.
+	bgfx::setViewMode(GetViewID(), bgfx::ViewMode::DepthAscending);
 }
 
 void WorldRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
@@ -74,132 +189,510 @@ void WorldRenderer::UpdateView(const float* pViewMatrix, const float* pProjectio
 
 void WorldRenderer::Render(float deltaTime)
 {
-	// TODO : Remove it. If every renderer need to submit camera related uniform, it should be done not inside Renderer class.
-	const cd::Transform& cameraTransform = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity())->GetTransform();
-	for (Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
+	const cd::Matrix4x4& viewMatrix = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity())->GetViewMatrix();
+	const FrustumCuller* pFrustumCuller = m_pCurrentSceneWorld->GetFrustumCuller();
+	const MeshLODSelector* pMeshLODSelector = m_pCurrentSceneWorld->GetMeshLODSelector();
+
+	// Only proxies of changed components are extracted again.
+	const SkyType crtSkyType = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity())->GetSkyType();
+	m_pRenderProxyList->Update(crtSkyType);
+
+	const bool useGPUDriven = m_isGPUDriven && IsGPUDrivenSupported();
+	if (useGPUDriven)
 	{
-		MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
-		if (!pMaterialComponent ||
-			pMaterialComponent->GetMaterialType() != m_pCurrentSceneWorld->GetPBRMaterialType())
+		UpdateGPUDrivenScene();
+	}
+
+	// Collect visible draws and sort them by render states and depth before submission.
+	// Draws which have the same mesh buffers and material are merged to an instanced draw.
+	m_drawList.Clear();
+	m_drawBatches.clear();
+	m_batchProxies.clear();
+	m_instanceList.Clear();
+	m_instanceDraws.clear();
+	const bool isInstancingSupported = 0 != (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING);
+	const std::vector<RenderProxy>& proxies = m_pRenderProxyList->GetProxies();
+	m_proxyLODs.resize(proxies.size());
+	for (uint32_t proxyIndex = 0U; proxyIndex < proxies.size(); ++proxyIndex)
+	{
+		const RenderProxy& proxy = proxies[proxyIndex];
+
+		// Culled and drawn by compute shaders.
+		if (useGPUDriven && GPUDrivenScene::IsSupported(proxy))
 		{
-			// TODO : improve this condition. As we want to skip some feature-specified entities to render.
-			// For example, terrain/particle/...
 			continue;
 		}
 
-		// No mesh attached?
-		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
+		// Culling. Archetype entities are not in the storages which systems cull and select LODs for.
+		const bool isVisible = proxy.isInArchetype ? pFrustumCuller->IsVisible(proxy.worldMatrix, proxy.localAABB) :
+			pFrustumCuller->IsVisible(proxy.entity);
+		if (!isVisible)
 		{
 			continue;
 		}
 
-		// SkinMesh
-		if(m_pCurrentSceneWorld->GetAnimationComponent(entity))
+		// Components may be built again after LODs are selected.
+		const uint32_t selectedLOD = proxy.isInArchetype ? pMeshLODSelector->SelectLOD(m_pRenderProxyList->GetStaticMeshComponent(proxy), proxy.worldMatrix) :
+			pMeshLODSelector->GetLODByDenseIndex(proxy.meshIndex);
+		const uint32_t lod = std::min(selectedLOD, proxy.lodCount - 1U);
+		m_proxyLODs[proxyIndex] = static_cast<uint8_t>(lod);
+
+		uint64_t sortKey = GetDrawSortKey(proxy, viewMatrix);
+
+		// Blended draws are not instanced to keep them back-to-front.
+		if (isInstancingSupported && DrawBucket::Blended != proxy.drawBucket &&
+			ShaderSchema::InvalidProgramHandle != proxy.instanceProgramHandle)
 		{
-			continue;
+			m_instanceList.Add(GetInstanceKey(proxy, lod), static_cast<uint32_t>(m_instanceDraws.size()));
+			m_instanceDraws.push_back(DrawList::Item{ sortKey, proxyIndex });
+		}
+		else
+		{
+			AddDrawBatch(sortKey, proxyIndex);
+		}
+	}
+
+	// Instance data is allocated from the transient buffer of current frame. Fall back to draw one by one if it is not enough.
+	const uint32_t instanceDrawCount = static_cast<uint32_t>(m_instanceDraws.size());
+	if (bgfx::getAvailInstanceDataBuffer(instanceDrawCount, InstanceDataStride) < instanceDrawCount)
+	{
+		for (const DrawList::Item& instanceDraw : m_instanceDraws)
+		{
+			AddDrawBatch(instanceDraw.sortKey, instanceDraw.index);
 		}
+	}
+	else
+	{
+		BuildInstanceBatches();
+	}
+	m_drawList.Sort();
+
+	const bool hasGPUDrivenDraws = useGPUDriven && m_gpuDrivenScene.GetInstanceCount() > 0U;
+	if (0U == m_drawList.GetCount() && !hasGPUDrivenDraws)
+	{
+		return;
+	}
+
+	UpdateFrameConstants();
+
+	// Indirect draws are opaque or masked so that they can be drawn before CPU draws.
+	if (hasGPUDrivenDraws)
+	{
+		RenderGPUDriven();
+	}
+
+	// Draws keep the order of DrawList whichever encoders submit them, see the view mode in Init.
+	// So that opaque and masked draws stay front to back for early depth tests and blended draws stay back to front.
+	ParallelEncode(m_drawList.GetCount(), MinEncodeChunkSize, [this](bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex)
+	{
+		EncodeDraws(pEncoder, beginIndex, endIndex);
+	});
+}
+
+void WorldRenderer::EncodeDraws(bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex) const
+{
+	// Uniforms are not shared between encoders so that frame constants are set for every encoder.
+	pEncoder->setUniform(bgfx::UniformHandle{m_uniformHandles.cameraPos}, m_cameraPosition.Begin(), 1);
+	pEncoder->setUniform(bgfx::UniformHandle{m_uniformHandles.lightClusterParams}, m_lightClusterParams.Begin(), 1);
+
+	const std::vector<RenderProxy>& proxies = m_pRenderProxyList->GetProxies();
+	const std::vector<DrawList::Item>& drawItems = m_drawList.GetItems();
+	for (uint32_t drawIndex = beginIndex; drawIndex < endIndex; ++drawIndex)
+	{
+		const DrawBatch& drawBatch = m_drawBatches[drawItems[drawIndex].index];
+		const uint32_t proxyIndex = m_batchProxies[drawBatch.firstProxyIndex];
+		const RenderProxy& proxy = proxies[proxyIndex];
 
 		// Transform
-		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
+		uint16_t programHandle = proxy.programHandle;
+		if (1U == drawBatch.instanceCount)
 		{
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
+			pEncoder->setTransform(proxy.worldMatrix.Begin());
+		}
+		else
+		{
+			bgfx::InstanceDataBuffer instanceDataBuffer;
+			bgfx::allocInstanceDataBuffer(&instanceDataBuffer, drawBatch.instanceCount, InstanceDataStride);
+			uint8_t* pInstanceData = instanceDataBuffer.data;
+			for (uint32_t instanceIndex = 0U; instanceIndex < drawBatch.instanceCount; ++instanceIndex)
+			{
+				const RenderProxy& instanceProxy = proxies[m_batchProxies[drawBatch.firstProxyIndex + instanceIndex]];
+				std::memcpy(pInstanceData, instanceProxy.worldMatrix.Begin(), InstanceDataStride);
+				pInstanceData += InstanceDataStride;
+			}
+			pEncoder->setInstanceDataBuffer(&instanceDataBuffer);
+			programHandle = proxy.instanceProgramHandle;
 		}
 
 		// Mesh
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
+		pEncoder->setVertexBuffer(0, bgfx::VertexBufferHandle{proxy.vertexBufferHandle});
+		pEncoder->setIndexBuffer(bgfx::IndexBufferHandle{proxy.lodIndexBufferHandles[m_proxyLODs[proxyIndex]]});
 
 		// Material
-		for (const auto& [textureType, _] : pMaterialComponent->GetTextureResources())
+		EncodeMaterial(pEncoder, proxy);
+
+		// Sort depth 0 is left for indirect draws which are drawn before CPU draws.
+		pEncoder->submit(GetViewID(), bgfx::ProgramHandle{programHandle}, drawIndex + 1U);
+	}
+}
+
+void WorldRenderer::EncodeMaterial(bgfx::Encoder* pEncoder, const RenderProxy& proxy) const
+{
+	for (uint32_t textureIndex = 0U; textureIndex < proxy.textureCount; ++textureIndex)
+	{
+		const RenderProxyTexture& texture = proxy.textures[textureIndex];
+		pEncoder->setTexture(texture.slot, bgfx::UniformHandle{texture.samplerHandle}, bgfx::TextureHandle{texture.textureHandle});
+	}
+
+	if (proxy.hasAlbedoUVOffsetAndScale)
+	{
+		pEncoder->setUniform(bgfx::UniformHandle{m_uniformHandles.albedoUVOffsetAndScale}, proxy.albedoUVOffsetAndScale.Begin(), 1);
+	}
+
+	// Sky
+	for (const FrameTexture& frameTexture : m_frameTextures)
+	{
+		pEncoder->setTexture(frameTexture.slot, bgfx::UniformHandle{frameTexture.samplerHandle}, bgfx::TextureHandle{frameTexture.textureHandle});
+	}
+
+	// Submit uniform values : material settings
+	pEncoder->setUniform(bgfx::UniformHandle{m_uniformHandles.albedoColor}, proxy.albedoColor.Begin(), 1);
+	pEncoder->setUniform(bgfx::UniformHandle{m_uniformHandles.metallicRoughnessFactor}, proxy.metallicRoughnessFactor.Begin(), 1);
+	pEncoder->setUniform(bgfx::UniformHandle{m_uniformHandles.emissiveColor}, proxy.emissiveColor.Begin(), 1);
+
+	if (DrawBucket::Masked == proxy.drawBucket)
+	{
+		pEncoder->setUniform(bgfx::UniformHandle{m_uniformHandles.alphaCutOff}, &proxy.alphaCutOff, 1);
+	}
+
+	pEncoder->setState(proxy.renderState);
+}
+
+void WorldRenderer::UpdateFrameConstants()
+{
+	// bgfx keeps uniform values until they are set again so that these uniforms are uploaded once per encoder
+	// instead of once per draw. It works in the same way on all backends as bgfx has no uniform buffer.
+
+	// TODO : Remove it. If every renderer need to submit camera related uniform, it should be done not inside Renderer class.
+	const cd::Transform& cameraTransform = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity())->GetTransform();
+	const cd::Vec3f& cameraTranslation = cameraTransform.GetTranslation();
+	m_cameraPosition = cd::Vec4f(cameraTranslation.x(), cameraTranslation.y(), cameraTranslation.z(), 1.0f);
+
+	// Bin lights into clusters of the view.
+	const CameraComponent* pCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
+	const auto& lightEntities = m_pCurrentSceneWorld->GetLightEntities();
+	const uint32_t lightEntityCount = static_cast<uint32_t>(lightEntities.size());
+	// Light component storage has continus memory address and layout.
+	const U_Light* pLights = lightEntityCount > 0 ? reinterpret_cast<const U_Light*>(m_pCurrentSceneWorld->GetLightComponent(lightEntities[0])) : nullptr;
+	m_lightClusterGrid.Build(pCameraComponent->GetViewMatrix(), pCameraComponent->GetProjectionMatrix(),
+		pCameraComponent->GetNearPlane(), pCameraComponent->GetFarPlane(), pLights, lightEntityCount);
+
+	m_lightClusterParams = cd::Vec4f(static_cast<float>(m_lightClusterGrid.GetGlobalLightCount()),
+		m_lightClusterGrid.GetDepthSliceScale(), m_lightClusterGrid.GetDepthSliceBias(), 0.0f);
+
+	// Light data is copied as it is rewritten in the next frame while bgfx may still render this frame.
+	constexpr StringCrc lightClusterTextureCrc(lightClusterTexture);
+	const std::vector<float>& clusterData = m_lightClusterGrid.GetClusterData();
+	bgfx::updateTexture2D(GetRenderContext()->GetTexture(lightClusterTextureCrc), 0, 0, 0, 0,
+		LightClusterGrid::CountX * LightClusterGrid::CountY, LightClusterGrid::CountZ,
+		bgfx::copy(clusterData.data(), static_cast<uint32_t>(clusterData.size() * sizeof(float))));
+
+	constexpr StringCrc lightIndexTextureCrc(lightIndexTexture);
+	const std::vector<float>& lightIndices = m_lightClusterGrid.GetLightIndices();
+	if (!lightIndices.empty())
+	{
+		bgfx::updateTexture2D(GetRenderContext()->GetTexture(lightIndexTextureCrc), 0, 0, 0, 0,
+			LightClusterGrid::LightIndexTextureWidth, static_cast<uint16_t>(m_lightClusterGrid.GetLightIndexRowCount()),
+			bgfx::copy(lightIndices.data(), static_cast<uint32_t>(lightIndices.size() * sizeof(float))));
+	}
+
+	constexpr StringCrc lightParamsTextureCrc(lightParamsTexture);
+	if (m_lightClusterGrid.GetLightCount() > 0)
+	{
+		bgfx::updateTexture2D(GetRenderContext()->GetTexture(lightParamsTextureCrc), 0, 0, 0, 0,
+			LightVec4Count, static_cast<uint16_t>(m_lightClusterGrid.GetLightCount()),
+			bgfx::copy(pLights, m_lightClusterGrid.GetLightCount() * static_cast<uint32_t>(sizeof(U_Light))));
+	}
+
+	m_frameTextures.clear();
+	constexpr StringCrc lightClusterSamplerCrc(lightClusterSampler);
+	constexpr StringCrc lightIndexSamplerCrc(lightIndexSampler);
+	constexpr StringCrc lightParamsSamplerCrc(lightParamsSampler);
+	m_frameTextures.push_back(FrameTexture{ LIGHT_CLUSTER_SLOT, GetRenderContext()->GetUniform(lightClusterSamplerCrc).idx,
+		GetRenderContext()->GetTexture(lightClusterTextureCrc).idx });
+	m_frameTextures.push_back(FrameTexture{ LIGHT_INDEX_SLOT, GetRenderContext()->GetUniform(lightIndexSamplerCrc).idx,
+		GetRenderContext()->GetTexture(lightIndexTextureCrc).idx });
+	m_frameTextures.push_back(FrameTexture{ LIGHT_PARAMS_SLOT, GetRenderContext()->GetUniform(lightParamsSamplerCrc).idx,
+		GetRenderContext()->GetTexture(lightParamsTextureCrc).idx });
+
+	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+	if (SkyType::SkyBox == pSkyComponent->GetSkyType())
+	{
+		// Create a new TextureHandle each frame if the skybox texture path has been updated,
+		// otherwise RenderContext::CreateTexture will automatically skip it.
+		constexpr StringCrc irrSamplerCrc(cubeIrradianceSampler);
+		GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
+		m_frameTextures.push_back(FrameTexture{ IBL_IRRADIANCE_SLOT, GetRenderContext()->GetUniform(irrSamplerCrc).idx,
+			GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetIrradianceTexturePath())).idx });
+
+		constexpr StringCrc radSamplerCrc(cubeRadianceSampler);
+		GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
+		m_frameTextures.push_back(FrameTexture{ IBL_RADIANCE_SLOT, GetRenderContext()->GetUniform(radSamplerCrc).idx,
+			GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetRadianceTexturePath())).idx });
+
+		constexpr StringCrc lutsamplerCrc(lutSampler);
+		constexpr StringCrc luttextureCrc(lutTexture);
+		m_frameTextures.push_back(FrameTexture{ BRDF_LUT_SLOT, GetRenderContext()->GetUniform(lutsamplerCrc).idx,
+			GetRenderContext()->GetTexture(luttextureCrc).idx });
+	}
+}
+
+void WorldRenderer::AddDrawBatch(uint64_t sortKey, uint32_t proxyIndex)
+{
+	m_drawList.Add(sortKey, static_cast<uint32_t>(m_drawBatches.size()));
+	m_drawBatches.push_back(DrawBatch{ static_cast<uint32_t>(m_batchProxies.size()), 1U });
+	m_batchProxies.push_back(proxyIndex);
+}
+
+void WorldRenderer::BuildInstanceBatches()
+{
+	// Draws which have the same instance keys are adjacent after sorting.
+	m_instanceList.Sort();
+
+	const std::vector<RenderProxy>& proxies = m_pRenderProxyList->GetProxies();
+	const std::vector<DrawList::Item>& instanceItems = m_instanceList.GetItems();
+	const uint32_t instanceItemCount = m_instanceList.GetCount();
+	uint32_t beginIndex = 0U;
+	while (beginIndex < instanceItemCount)
+	{
+		const DrawList::Item& firstDraw = m_instanceDraws[instanceItems[beginIndex].index];
+		const RenderProxy& firstProxy = proxies[firstDraw.index];
+
+		// The batch uses the minimum sort key of instances which is the nearest one for opaque draws.
+		uint64_t batchSortKey = firstDraw.sortKey;
+		uint32_t endIndex = beginIndex + 1U;
+		for (; endIndex < instanceItemCount && instanceItems[endIndex].sortKey == instanceItems[beginIndex].sortKey; ++endIndex)
 		{
-			if (const MaterialComponent::TextureInfo* pTextureInfo = pMaterialComponent->GetTextureInfo(textureType))
+			// Instance keys are hashes so that draws are compared again.
+			const DrawList::Item& instanceDraw = m_instanceDraws[instanceItems[endIndex].index];
+			if (!CanInstance(firstProxy, m_proxyLODs[firstDraw.index], proxies[instanceDraw.index], m_proxyLODs[instanceDraw.index]))
 			{
-				if (cd::MaterialTextureType::BaseColor == textureType)
-				{
-					constexpr StringCrc albedoUVOffsetAndScaleCrc(albedoUVOffsetAndScale);
-					cd::Vec4f uvOffsetAndScaleData(pTextureInfo->GetUVOffset().x(), pTextureInfo->GetUVOffset().y(),
-						pTextureInfo->GetUVScale().x(), pTextureInfo->GetUVScale().y());
-					GetRenderContext()->FillUniform(albedoUVOffsetAndScaleCrc, &uvOffsetAndScaleData, 1);
-				}
-
-				bgfx::setTexture(pTextureInfo->slot, bgfx::UniformHandle{pTextureInfo->samplerHandle}, bgfx::TextureHandle{pTextureInfo->textureHandle});
+				break;
 			}
+			batchSortKey = std::min(batchSortKey, instanceDraw.sortKey);
 		}
 
-		// Sky
-		SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
-		SkyType crtSkyType = pSkyComponent->GetSkyType();
-		pMaterialComponent->SetSkyType(crtSkyType);
-
-		if (crtSkyType == SkyType::SkyBox)
+		m_drawList.Add(batchSortKey, static_cast<uint32_t>(m_drawBatches.size()));
+		m_drawBatches.push_back(DrawBatch{ static_cast<uint32_t>(m_batchProxies.size()), endIndex - beginIndex });
+		for (uint32_t itemIndex = beginIndex; itemIndex < endIndex; ++itemIndex)
 		{
-			// Create a new TextureHandle each frame if the skybox texture path has been updated,
-			// otherwise RenderContext::CreateTexture will automatically skip it.
-
-			constexpr StringCrc irrSamplerCrc(cubeIrradianceSampler);
-			GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
-			bgfx::setTexture(IBL_IRRADIANCE_SLOT,
-				GetRenderContext()->GetUniform(irrSamplerCrc),
-				GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetIrradianceTexturePath())));
-
-			constexpr StringCrc radSamplerCrc(cubeRadianceSampler);
-			GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
-			bgfx::setTexture(IBL_RADIANCE_SLOT,
-				GetRenderContext()->GetUniform(radSamplerCrc),
-				GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetRadianceTexturePath())));
-
-			constexpr StringCrc lutsamplerCrc(lutSampler);
-			constexpr StringCrc luttextureCrc(lutTexture);
-			bgfx::setTexture(BRDF_LUT_SLOT, GetRenderContext()->GetUniform(lutsamplerCrc), GetRenderContext()->GetTexture(luttextureCrc));
+			m_batchProxies.push_back(m_instanceDraws[instanceItems[itemIndex].index].index);
 		}
 
-		// Submit uniform values : camera settings
-		constexpr StringCrc cameraPosCrc(cameraPos);
-		GetRenderContext()->FillUniform(cameraPosCrc, &cameraTransform.GetTranslation().x(), 1);
-
-		// Submit uniform values : material settings
-		constexpr StringCrc albedoColorCrc(albedoColor);
-		GetRenderContext()->FillUniform(albedoColorCrc, pMaterialComponent->GetAlbedoColor().Begin(), 1);
-
-		constexpr StringCrc mrFactorCrc(metallicRoughnessFactor);
-		cd::Vec4f metallicRoughnessFactorData(pMaterialComponent->GetMetallicFactor(), pMaterialComponent->GetRoughnessFactor(), 1.0f, 1.0f);
-		GetRenderContext()->FillUniform(mrFactorCrc, metallicRoughnessFactorData.Begin(), 1);
-
-		constexpr StringCrc emissiveColorCrc(emissiveColor);
-		GetRenderContext()->FillUniform(emissiveColorCrc, pMaterialComponent->GetEmissiveColor().Begin(), 1);
-
-		// Submit uniform values : light settings
-		auto lightEntities = m_pCurrentSceneWorld->GetLightEntities();
-		size_t lightEntityCount = lightEntities.size();
-		constexpr engine::StringCrc lightCountAndStrideCrc(lightCountAndStride);
-		static cd::Vec4f lightInfoData(0, LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
-		lightInfoData.x() = static_cast<float>(lightEntityCount);
-		GetRenderContext()->FillUniform(lightCountAndStrideCrc, lightInfoData.Begin(), 1);
-		if (lightEntityCount > 0)
+		beginIndex = endIndex;
+	}
+}
+
+bool WorldRenderer::IsGPUDrivenSupported() const
+{
+	// Programs are only created when compute shaders, indirect draws and instancing are supported.
+	return UINT16_MAX != m_gpuDrivenResources.cullingProgram && UINT16_MAX != m_gpuDrivenResources.drawArgsProgram;
+}
+
+void WorldRenderer::UpdateGPUDrivenScene()
+{
+	// Tables are packed again only when proxies change so that static scenes upload nothing.
+	if (m_gpuDrivenSceneVersion == m_pRenderProxyList->GetVersion())
+	{
+		return;
+	}
+	m_gpuDrivenSceneVersion = m_pRenderProxyList->GetVersion();
+
+	if (m_gpuDrivenScene.Build(m_pRenderProxyList->GetProxies()))
+	{
+		UpdateGPUDrivenGeometry();
+	}
+
+	const uint32_t instanceCount = m_gpuDrivenScene.GetInstanceCount();
+	const uint32_t drawCommandCount = m_gpuDrivenScene.GetDrawCommandCount();
+	if (0U == instanceCount)
+	{
+		return;
+	}
+
+	// Buffers grow by powers of two so that adding entities doesn't create them again every time.
+	GPUDrivenResources& resources = m_gpuDrivenResources;
+	if (instanceCount > resources.instanceCapacity)
+	{
+		DestroyHandle<bgfx::DynamicVertexBufferHandle>(resources.instanceInputBuffer);
+		DestroyHandle<bgfx::DynamicVertexBufferHandle>(resources.instanceOutputBuffer);
+
+		uint32_t capacity = std::max(resources.instanceCapacity, static_cast<uint32_t>(GPU_DRIVEN_THREAD_COUNT));
+		while (capacity < instanceCount)
 		{
-			// Light component storage has continus memory address and layout.
-			float* pLightDataBegin = reinterpret_cast<float*>(m_pCurrentSceneWorld->GetLightComponent(lightEntities[0]));
-			constexpr engine::StringCrc lightParamsCrc(lightParams);
-			GetRenderContext()->FillUniform(lightParamsCrc, pLightDataBegin, static_cast<uint16_t>(lightEntityCount * LightUniform::LIGHT_STRIDE));
+			capacity *= 2U;
 		}
 
-		uint64_t state = defaultRenderingState;
-		if (!pMaterialComponent->GetTwoSided())
+		bgfx::VertexLayout vec4Layout;
+		vec4Layout.begin().add(bgfx::Attrib::TexCoord0, 4, bgfx::AttribType::Float).end();
+		resources.instanceInputBuffer = bgfx::createDynamicVertexBuffer(capacity * GPU_DRIVEN_INSTANCE_VEC4_COUNT, vec4Layout,
+			BGFX_BUFFER_COMPUTE_READ | vec4ComputeBufferFlags).idx;
+
+		// Instance data buffers take strides from vertex layouts. An instance is a world matrix.
+		bgfx::VertexLayout matrixLayout;
+		matrixLayout.begin()
+			.add(bgfx::Attrib::TexCoord7, 4, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord6, 4, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord5, 4, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord4, 4, bgfx::AttribType::Float)
+			.end();
+		resources.instanceOutputBuffer = bgfx::createDynamicVertexBuffer(capacity, matrixLayout, BGFX_BUFFER_COMPUTE_WRITE | vec4ComputeBufferFlags).idx;
+		resources.instanceCapacity = capacity;
+	}
+
+	if (drawCommandCount > resources.drawCommandCapacity)
+	{
+		DestroyHandle<bgfx::DynamicIndexBufferHandle>(resources.drawCommandBuffer);
+		DestroyHandle<bgfx::DynamicIndexBufferHandle>(resources.instanceCountBuffer);
+		DestroyHandle<bgfx::IndirectBufferHandle>(resources.drawIndirectBuffer);
+
+		uint32_t capacity = std::max(resources.drawCommandCapacity, static_cast<uint32_t>(GPU_DRIVEN_THREAD_COUNT));
+		while (capacity < drawCommandCount)
 		{
-			state |= BGFX_STATE_CULL_CCW;
+			capacity *= 2U;
 		}
 
-		if (cd::BlendMode::Mask == pMaterialComponent->GetBlendMode())
+		resources.drawCommandBuffer = bgfx::createDynamicIndexBuffer(capacity * GPU_DRIVEN_DRAW_COMMAND_UINT_COUNT,
+			BGFX_BUFFER_COMPUTE_READ | uintComputeBufferFlags).idx;
+
+		// Counts are reset by cs_GPUDrivenDrawArgs.sc after use so that they only need to be zero at first.
+		std::vector<uint32_t> instanceCounts(capacity, 0U);
+		resources.instanceCountBuffer = bgfx::createDynamicIndexBuffer(bgfx::copy(instanceCounts.data(), capacity * static_cast<uint32_t>(sizeof(uint32_t))),
+			BGFX_BUFFER_COMPUTE_READ_WRITE | uintComputeBufferFlags).idx;
+		resources.drawIndirectBuffer = bgfx::createIndirectBuffer(capacity).idx;
+		resources.drawCommandCapacity = capacity;
+	}
+
+	const std::vector<GPUDrivenInstance>& instances = m_gpuDrivenScene.GetInstances();
+	bgfx::update(bgfx::DynamicVertexBufferHandle{resources.instanceInputBuffer}, 0U,
+		bgfx::copy(instances.data(), instanceCount * static_cast<uint32_t>(sizeof(GPUDrivenInstance))));
+
+	const std::vector<GPUDrivenDrawCommand>& drawCommands = m_gpuDrivenScene.GetDrawCommands();
+	bgfx::update(bgfx::DynamicIndexBufferHandle{resources.drawCommandBuffer}, 0U,
+		bgfx::copy(drawCommands.data(), drawCommandCount * static_cast<uint32_t>(sizeof(GPUDrivenDrawCommand))));
+}
+
+void WorldRenderer::UpdateGPUDrivenGeometry()
+{
+	GPUDrivenResources& resources = m_gpuDrivenResources;
+	DestroyHandle<bgfx::VertexBufferHandle>(resources.vertexBuffer);
+	DestroyHandle<bgfx::IndexBufferHandle>(resources.indexBuffer);
+	if (0U == m_gpuDrivenScene.GetTotalVertexCount())
+	{
+		return;
+	}
+
+	// PBR meshes are built in the required vertex format of the PBR material type so that they can share one vertex buffer.
+	bgfx::VertexLayout vertexLayout;
+	VertexLayoutUtility::CreateVertexLayout(vertexLayout, m_pCurrentSceneWorld->GetPBRMaterialType()->GetRequiredVertexFormat().GetVertexLayout());
+	const uint32_t vertexStride = vertexLayout.getStride();
+
+	const bgfx::Memory* pVertexMemory = bgfx::alloc(m_gpuDrivenScene.GetTotalVertexCount() * vertexStride);
+	const bgfx::Memory* pIndexMemory = bgfx::alloc(m_gpuDrivenScene.GetTotalIndexCount() * static_cast<uint32_t>(sizeof(uint32_t)));
+	const std::vector<RenderProxy>& proxies = m_pRenderProxyList->GetProxies();
+	for (const GPUDrivenMesh& mesh : m_gpuDrivenScene.GetMeshes())
+	{
+		const RenderProxy& proxy = proxies[mesh.proxyIndex];
+		const StaticMeshComponent& meshComponent = m_pRenderProxyList->GetStaticMeshComponent(proxy);
+		const std::vector<std::byte>& vertexData = meshComponent.GetVertexBufferData();
+		const std::vector<std::byte>& indexData = meshComponent.GetIndexBufferData();
+		uint8_t* pVertices = pVertexMemory->data + mesh.baseVertex * vertexStride;
+		uint8_t* pIndices = pIndexMemory->data + mesh.firstIndex * sizeof(uint32_t);
+		if (vertexData.size() != mesh.vertexCount * vertexStride || indexData.size() != mesh.indexCount * sizeof(uint32_t))
 		{
-			constexpr StringCrc alphaCutOffCrc(alphaCutOff);
-			GetRenderContext()->FillUniform(alphaCutOffCrc, &pMaterialComponent->GetAlphaCutOff(), 1);
+			// Indexes are 0 so that all triangles of the mesh are degenerated.
+			CD_ENGINE_WARN("Mesh of entity {0} doesn't match the vertex format of GPU driven rendering.", proxy.entity);
+			std::memset(pVertices, 0, mesh.vertexCount * vertexStride);
+			std::memset(pIndices, 0, mesh.indexCount * sizeof(uint32_t));
+			continue;
 		}
 
-		bgfx::setState(state);
+		// Indexes are relative to base vertexes of draw commands.
+		std::memcpy(pVertices, vertexData.data(), vertexData.size());
+		std::memcpy(pIndices, indexData.data(), indexData.size());
+	}
 
-		bgfx::submit(GetViewID(), bgfx::ProgramHandle{pMaterialComponent->GetShadreProgram()});
+	resources.vertexBuffer = bgfx::createVertexBuffer(pVertexMemory, vertexLayout).idx;
+	resources.indexBuffer = bgfx::createIndexBuffer(pIndexMemory, BGFX_BUFFER_INDEX32).idx;
+}
+
+void WorldRenderer::RenderGPUDriven()
+{
+	const GPUDrivenResources& resources = m_gpuDrivenResources;
+	const uint32_t instanceCount = m_gpuDrivenScene.GetInstanceCount();
+	const uint32_t drawCommandCount = m_gpuDrivenScene.GetDrawCommandCount();
+
+	// Planes which never cull are used when culling is disabled.
+	const FrustumCuller* pFrustumCuller = m_pCurrentSceneWorld->GetFrustumCuller();
+	float planes[Frustum::PlaneCount * 4];
+	for (uint32_t planeIndex = 0U; planeIndex < Frustum::PlaneCount; ++planeIndex)
+	{
+		const cd::Vec4f plane = pFrustumCuller->IsEnable() ? pFrustumCuller->GetFrustum().GetPlane(static_cast<FrustumPlane>(planeIndex)) :
+			cd::Vec4f(0.0f, 0.0f, 0.0f, 1.0f);
+		std::memcpy(&planes[planeIndex * 4], plane.Begin(), 4 * sizeof(float));
 	}
+	const bgfx::Caps* pCaps = bgfx::getCaps();
+	const cd::Vec4f params(static_cast<float>(instanceCount), static_cast<float>(drawCommandCount),
+		pCaps->homogeneousDepth ? 1.0f : 0.0f, pCaps->originBottomLeft ? 1.0f : 0.0f);
+
+	bgfx::Encoder* pEncoder = bgfx::begin();
+	pEncoder->setUniform(bgfx::UniformHandle{resources.cullingPlanes}, planes, Frustum::PlaneCount);
+	pEncoder->setUniform(bgfx::UniformHandle{resources.params}, params.Begin(), 1);
+
+	// The pyramid is built from depths of the last frame. Occlusion tests are skipped before it is ready.
+	const bool useHiZ = m_pHiZRenderer && m_pHiZRenderer->IsEnable() && m_pHiZRenderer->IsHiZReady() &&
+		pFrustumCuller->IsEnable() && pFrustumCuller->IsOcclusionEnable();
+	cd::Vec4f hiZParamsData(0.0f, 0.0f, 0.0f, 0.0f);
+	if (useHiZ)
+	{
+		hiZParamsData = cd::Vec4f(static_cast<float>(m_pHiZRenderer->GetHiZWidth()), static_cast<float>(m_pHiZRenderer->GetHiZHeight()),
+			static_cast<float>(m_pHiZRenderer->GetHiZMipCount()), 1.0f);
+		pEncoder->setTexture(GPU_DRIVEN_HIZ_SLOT, bgfx::UniformHandle{resources.hiZSampler}, bgfx::TextureHandle{m_pHiZRenderer->GetHiZTexture()},
+			BGFX_SAMPLER_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP);
+		pEncoder->setUniform(bgfx::UniformHandle{resources.hiZViewProjection}, m_pHiZRenderer->GetHiZViewProjection().Begin(), 1);
+	}
+	pEncoder->setUniform(bgfx::UniformHandle{resources.hiZParams}, hiZParamsData.Begin(), 1);
+
+	// Visible world matrices are compacted after first instances of their draw commands which are counted by atomics.
+	pEncoder->setBuffer(GPU_DRIVEN_INSTANCE_INPUT_SLOT, bgfx::DynamicVertexBufferHandle{resources.instanceInputBuffer}, bgfx::Access::Read);
+	pEncoder->setBuffer(GPU_DRIVEN_DRAW_COMMAND_SLOT, bgfx::DynamicIndexBufferHandle{resources.drawCommandBuffer}, bgfx::Access::Read);
+	pEncoder->setBuffer(GPU_DRIVEN_INSTANCE_COUNT_SLOT, bgfx::DynamicIndexBufferHandle{resources.instanceCountBuffer}, bgfx::Access::ReadWrite);
+	pEncoder->setBuffer(GPU_DRIVEN_INSTANCE_OUTPUT_SLOT, bgfx::DynamicVertexBufferHandle{resources.instanceOutputBuffer}, bgfx::Access::Write);
+	pEncoder->dispatch(GetViewID(), bgfx::ProgramHandle{resources.cullingProgram}, GetGPUDrivenGroupCount(instanceCount));
+
+	// Counts are written to indirect draw arguments.
+	pEncoder->setBuffer(GPU_DRIVEN_DRAW_COMMAND_SLOT, bgfx::DynamicIndexBufferHandle{resources.drawCommandBuffer}, bgfx::Access::Read);
+	pEncoder->setBuffer(GPU_DRIVEN_INSTANCE_COUNT_SLOT, bgfx::DynamicIndexBufferHandle{resources.instanceCountBuffer}, bgfx::Access::ReadWrite);
+	pEncoder->setBuffer(GPU_DRIVEN_DRAW_INDIRECT_SLOT, bgfx::IndirectBufferHandle{resources.drawIndirectBuffer}, bgfx::Access::Write);
+	pEncoder->dispatch(GetViewID(), bgfx::ProgramHandle{resources.drawArgsProgram}, GetGPUDrivenGroupCount(drawCommandCount));
+
+	pEncoder->setUniform(bgfx::UniformHandle{m_uniformHandles.cameraPos}, m_cameraPosition.Begin(), 1);
+	pEncoder->setUniform(bgfx::UniformHandle{m_uniformHandles.lightClusterParams}, m_lightClusterParams.Begin(), 1);
+
+	// A material group is drawn by one indirect draw whatever how many meshes and instances it has.
+	const std::vector<RenderProxy>& proxies = m_pRenderProxyList->GetProxies();
+	for (const GPUDrivenDrawGroup& drawGroup : m_gpuDrivenScene.GetDrawGroups())
+	{
+		const RenderProxy& proxy = proxies[drawGroup.proxyIndex];
+		pEncoder->setVertexBuffer(0, bgfx::VertexBufferHandle{resources.vertexBuffer});
+		pEncoder->setIndexBuffer(bgfx::IndexBufferHandle{resources.indexBuffer});
+		pEncoder->setInstanceDataBuffer(bgfx::DynamicVertexBufferHandle{resources.instanceOutputBuffer}, 0U, instanceCount);
+		EncodeMaterial(pEncoder, proxy);
+		pEncoder->submit(GetViewID(), bgfx::ProgramHandle{proxy.instanceProgramHandle}, bgfx::IndirectBufferHandle{resources.drawIndirectBuffer},
+			drawGroup.firstDrawCommand, drawGroup.drawCommandCount);
+	}
+
+	bgfx::end(pEncoder);
 }
 
 }
\ No newline at end of file
@@ -1,16 +1,25 @@
 #pragma once
 
+#include "DrawList.h"
+#include "GPUDrivenScene.h"
+#include "LightClusterGrid.h"
 #include "Renderer.h"
+#include "RenderProxyList.h"
+
+#include <memory>
+#include <vector>
 
 namespace engine
 {
 
+class HiZRenderer;
 class SceneWorld;
 
 class WorldRenderer final : public Renderer
 {
 public:
 	using Renderer::Renderer;
+	virtual ~WorldRenderer();
 
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
@@ -18,8 +27,114 @@ public:
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
+	// GPU driven rendering culls opaque and masked static meshes by compute shaders and draws them by indirect draws.
+	// It falls back to the CPU path if compute shaders or indirect draws are not supported.
+	void SetGPUDriven(bool enable) { m_isGPUDriven = enable; }
+	bool IsGPUDriven() const { return m_isGPUDriven; }
+
+	// GPU driven culling also tests instances against the Hi-Z pyramid of the last frame if it is set.
+	void SetHiZRenderer(const HiZRenderer* pHiZRenderer) { m_pHiZRenderer = pHiZRenderer; }
+
+private:
+	// Proxies in a batch are drawn by one instanced draw call if there are more than one.
+	struct DrawBatch
+	{
+		uint32_t firstProxyIndex;
+		uint32_t instanceCount;
+	};
+
+	// View invariant textures are bound per draw as bgfx resets bindings after every submit.
+	struct FrameTexture
+	{
+		uint8_t slot;
+		uint16_t samplerHandle;
+		uint16_t textureHandle;
+	};
+
+	struct UniformHandles
+	{
+		uint16_t cameraPos;
+		uint16_t lightClusterParams;
+		uint16_t albedoColor;
+		uint16_t emissiveColor;
+		uint16_t metallicRoughnessFactor;
+		uint16_t albedoUVOffsetAndScale;
+		uint16_t alphaCutOff;
+	};
+
+	// bgfx handles of GPU driven rendering. Buffers are created again when they are not large enough.
+	struct GPUDrivenResources
+	{
+		uint16_t cullingProgram = UINT16_MAX;
+		uint16_t drawArgsProgram = UINT16_MAX;
+		uint16_t cullingPlanes = UINT16_MAX;
+		uint16_t params = UINT16_MAX;
+		uint16_t hiZSampler = UINT16_MAX;
+		uint16_t hiZViewProjection = UINT16_MAX;
+		uint16_t hiZParams = UINT16_MAX;
+
+		uint16_t vertexBuffer = UINT16_MAX;
+		uint16_t indexBuffer = UINT16_MAX;
+		uint16_t instanceInputBuffer = UINT16_MAX;
+		uint16_t instanceOutputBuffer = UINT16_MAX;
+		uint16_t drawCommandBuffer = UINT16_MAX;
+		uint16_t instanceCountBuffer = UINT16_MAX;
+		uint16_t drawIndirectBuffer = UINT16_MAX;
+		uint32_t instanceCapacity = 0U;
+		uint32_t drawCommandCapacity = 0U;
+	};
+
+	void AddDrawBatch(uint64_t sortKey, uint32_t proxyIndex);
+	void BuildInstanceBatches();
+
+	// Prepares uniforms which are the same for all draws in the view and resolves view invariant textures.
+	void UpdateFrameConstants();
+
+	// Encodes sorted draws in [beginIndex, endIndex). It only reads prepared data so that it runs in worker threads.
+	void EncodeDraws(bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex) const;
+
+	// Textures, uniforms and states of a proxy's material which are shared by CPU and GPU driven draws.
+	void EncodeMaterial(bgfx::Encoder* pEncoder, const RenderProxy& proxy) const;
+
+	bool IsGPUDrivenSupported() const;
+	void UpdateGPUDrivenScene();
+	void UpdateGPUDrivenGeometry();
+	void RenderGPUDriven();
+
 private:
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+
+	// Retained draw data of static meshes which is updated incrementally by component versions.
+	std::unique_ptr<RenderProxyList> m_pRenderProxyList;
+
+	// Reused every frame to sort visible draws by render states and depth.
+	// Items are indexes of m_drawBatches.
+	DrawList m_drawList;
+	std::vector<DrawBatch> m_drawBatches;
+	std::vector<uint32_t> m_batchProxies;
+
+	// LODs of proxies which are selected by MeshLODSelector. Indexed by proxy indexes and only valid for drawn proxies.
+	std::vector<uint8_t> m_proxyLODs;
+
+	// Items are sorted by instance keys to group draws. Items are indexes of m_instanceDraws which store sort keys and proxy indexes.
+	DrawList m_instanceList;
+	std::vector<DrawList::Item> m_instanceDraws;
+
+	std::vector<FrameTexture> m_frameTextures;
+	cd::Vec4f m_cameraPosition;
+	cd::Vec4f m_lightClusterParams;
+
+	// Resolved in Init so that encoding doesn't look up uniforms by names.
+	UniformHandles m_uniformHandles;
+
+	// Lights are binned into view clusters once per view for clustered forward lighting.
+	LightClusterGrid m_lightClusterGrid;
+
+	bool m_isGPUDriven = false;
+	GPUDrivenScene m_gpuDrivenScene;
+	GPUDrivenResources m_gpuDrivenResources;
+	uint32_t m_gpuDrivenSceneVersion = RenderProxyList::InvalidVersion;
+	const HiZRenderer* m_pHiZRenderer = nullptr;
 };
 
 }
\ No newline at end of file
@@ -10,15 +10,8 @@ namespace engine
 
 void ShaderLoader::UploadUberShader(engine::MaterialType* pMaterialType)
 {
-	std::map<std::string, engine::StringCrc> outputFSPathToUberOption;
-
 	engine::ShaderSchema& shaderSchema = pMaterialType->GetShaderSchema();
 	std::string outputVSFilePath = engine::Path::GetShaderOutputPath(shaderSchema.GetVertexShaderPath());
-	for (const auto& combine : shaderSchema.GetUberCombines())
-	{
-		std::string outputFSFilePath = engine::Path::GetShaderOutputPath(shaderSchema.GetFragmentShaderPath(), combine);
-		outputFSPathToUberOption[cd::MoveTemp(outputFSFilePath)] = engine::StringCrc(combine);
-	}
 	CD_ENGINE_INFO("Material type {0} have shader variant count : {1}.", pMaterialType->GetMaterialName(), shaderSchema.GetUberCombines().size());
 
 	// Vertex shader.
@@ -26,22 +19,78 @@ void ShaderLoader::UploadUberShader(engine::MaterialType* pMaterialType)
 	const auto& VSBlob = shaderSchema.GetVSBlob();
 	bgfx::ShaderHandle vsHandle = bgfx::createShader(bgfx::makeRef(VSBlob.data(), static_cast<uint32_t>(VSBlob.size())));
 	bgfx::setName(vsHandle, outputVSFilePath.c_str());
+	shaderSchema.SetVertexShaderHandle(vsHandle.idx);
 
-	// Fragment shader.
-	for (const auto& [outputFSFilePath, uberOptionCrc] : outputFSPathToUberOption)
+	// Instance vertex shader is optional and only used when the backend supports instancing.
+	if (shaderSchema.HasInstanceVertexShader() && 0 != (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING))
 	{
-		shaderSchema.AddUberOptionFSBlob(uberOptionCrc, engine::ResourceLoader::LoadFile(outputFSFilePath.c_str()));
-	
-		const auto& FSBlob = shaderSchema.GetFSBlob(uberOptionCrc);
-		bgfx::ShaderHandle fsHandle = bgfx::createShader(bgfx::makeRef(FSBlob.data(), static_cast<uint32_t>(FSBlob.size())));
-		bgfx::setName(fsHandle, outputFSFilePath.c_str());
-		assert(bgfx::isValid(fsHandle));
-
-		// Program.
-		bgfx::ProgramHandle uberProgramHandle = bgfx::createProgram(vsHandle, fsHandle);
-		assert(bgfx::isValid(uberProgramHandle));
-		shaderSchema.SetCompiledProgram(uberOptionCrc, uberProgramHandle.idx);
+		std::string outputInstanceVSFilePath = engine::Path::GetShaderOutputPath(shaderSchema.GetInstanceVertexShaderPath());
+		shaderSchema.AddInstanceVSBlob(engine::ResourceLoader::LoadFile(outputInstanceVSFilePath.c_str()));
+		const auto& instanceVSBlob = shaderSchema.GetInstanceVSBlob();
+		bgfx::ShaderHandle instanceVSHandle = bgfx::createShader(bgfx::makeRef(instanceVSBlob.data(), static_cast<uint32_t>(instanceVSBlob.size())));
+		bgfx::setName(instanceVSHandle, outputInstanceVSFilePath.c_str());
+		shaderSchema.SetInstanceVertexShaderHandle(instanceVSHandle.idx);
 	}
+
+	// Fragment shaders. Other variants are uploaded on demand in lazy mode.
+	if (shaderSchema.IsLazyVariants())
+	{
+		UploadUberShaderVariant(pMaterialType, shaderSchema.GetUberCombines()[0]);
+		return;
+	}
+
+	for (const auto& combine : shaderSchema.GetUberCombines())
+	{
+		UploadUberShaderVariant(pMaterialType, combine);
+	}
+}
+
+bool ShaderLoader::UploadUberShaderVariant(engine::MaterialType* pMaterialType, const std::string& uberCombine)
+{
+	engine::ShaderSchema& shaderSchema = pMaterialType->GetShaderSchema();
+	const engine::StringCrc uberOptionCrc(uberCombine);
+	std::string outputFSFilePath = engine::Path::GetShaderOutputPath(shaderSchema.GetFragmentShaderPath(), uberCombine);
+	engine::ShaderSchema::ShaderBlob shaderBlob = engine::ResourceLoader::LoadFile(outputFSFilePath.c_str());
+	if (shaderBlob.empty())
+	{
+		CD_ENGINE_ERROR("Shader variant {0} is not built.", outputFSFilePath);
+		return false;
+	}
+
+	shaderSchema.AddUberOptionFSBlob(uberOptionCrc, cd::MoveTemp(shaderBlob));
+	const auto& FSBlob = shaderSchema.GetFSBlob(uberOptionCrc);
+	bgfx::ShaderHandle fsHandle = bgfx::createShader(bgfx::makeRef(FSBlob.data(), static_cast<uint32_t>(FSBlob.size())));
+	bgfx::setName(fsHandle, outputFSFilePath.c_str());
+	assert(bgfx::isValid(fsHandle));
+
+	// Program.
+	bgfx::ProgramHandle uberProgramHandle = bgfx::createProgram(bgfx::ShaderHandle{ shaderSchema.GetVertexShaderHandle() }, fsHandle);
+	assert(bgfx::isValid(uberProgramHandle));
+	shaderSchema.SetCompiledProgram(uberOptionCrc, uberProgramHandle.idx);
+
+	bgfx::ShaderHandle instanceVSHandle{ shaderSchema.GetInstanceVertexShaderHandle() };
+	if (bgfx::isValid(instanceVSHandle))
+	{
+		bgfx::ProgramHandle instanceProgramHandle = bgfx::createProgram(instanceVSHandle, fsHandle);
+		assert(bgfx::isValid(instanceProgramHandle));
+		shaderSchema.SetCompiledInstanceProgram(uberOptionCrc, instanceProgramHandle.idx);
+	}
+
+	return true;
+}
+
+uint32_t ShaderLoader::UploadRequestedUberShaderVariants(engine::MaterialType* pMaterialType)
+{
+	uint32_t uploadedCount = 0U;
+	for (const std::string& combine : pMaterialType->GetShaderSchema().TakeRequestedUberCombines())
+	{
+		if (UploadUberShaderVariant(pMaterialType, combine))
+		{
+			++uploadedCount;
+		}
+	}
+
+	return uploadedCount;
 }
 
 } // namespace editor
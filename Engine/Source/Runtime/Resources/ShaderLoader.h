@@ -11,7 +11,14 @@ namespace engine
 class ShaderLoader
 {
 public:
+	// Uploads vertex shaders and all variants, or only the DEFAULT variant in lazy mode.
 	static void UploadUberShader(engine::MaterialType* pMaterialType);
+
+	// Loads the built fragment shader of the variant and creates its programs. Returns false if it is not built.
+	static bool UploadUberShaderVariant(engine::MaterialType* pMaterialType, const std::string& uberCombine);
+
+	// Uploads variants which are requested by materials from built shaders. Returns the count of uploaded variants.
+	static uint32_t UploadRequestedUberShaderVariants(engine::MaterialType* pMaterialType);
 };
 
 } // namespace editor
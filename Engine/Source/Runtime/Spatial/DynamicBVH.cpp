@@ -0,0 +1,591 @@
+#include "DynamicBVH.h"
+
+#include "Core/Math/FrustumCulling.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+
+namespace engine
+{
+
+namespace
+{
+
+// Reused by QueryFrustum in every thread to avoid allocations per query.
+thread_local FrustumCullingBatch t_boundaryBatch;
+thread_local std::vector<Entity> t_boundaryEntities;
+thread_local std::vector<uint8_t> t_boundaryVisibilities;
+thread_local std::vector<uint32_t> t_subtreeStack;
+
+cd::AABB Union(const cd::AABB& a, const cd::AABB& b)
+{
+	return cd::AABB(
+		cd::Vec3f(std::min(a.Min().x(), b.Min().x()), std::min(a.Min().y(), b.Min().y()), std::min(a.Min().z(), b.Min().z())),
+		cd::Vec3f(std::max(a.Max().x(), b.Max().x()), std::max(a.Max().y(), b.Max().y()), std::max(a.Max().z(), b.Max().z())));
+}
+
+cd::AABB Fatten(const cd::AABB& aabb, float margin)
+{
+	return cd::AABB(
+		cd::Vec3f(aabb.Min().x() - margin, aabb.Min().y() - margin, aabb.Min().z() - margin),
+		cd::Vec3f(aabb.Max().x() + margin, aabb.Max().y() + margin, aabb.Max().z() + margin));
+}
+
+float GetSurfaceArea(const cd::AABB& aabb)
+{
+	float sizeX = aabb.Max().x() - aabb.Min().x();
+	float sizeY = aabb.Max().y() - aabb.Min().y();
+	float sizeZ = aabb.Max().z() - aabb.Min().z();
+	return 2.0f * (sizeX * sizeY + sizeY * sizeZ + sizeZ * sizeX);
+}
+
+bool Contains(const cd::AABB& outer, const cd::AABB& inner)
+{
+	return outer.Min().x() <= inner.Min().x() && outer.Min().y() <= inner.Min().y() && outer.Min().z() <= inner.Min().z() &&
+		inner.Max().x() <= outer.Max().x() && inner.Max().y() <= outer.Max().y() && inner.Max().z() <= outer.Max().z();
+}
+
+bool Overlaps(const cd::AABB& a, const cd::AABB& b)
+{
+	return a.Min().x() <= b.Max().x() && b.Min().x() <= a.Max().x() &&
+		a.Min().y() <= b.Max().y() && b.Min().y() <= a.Max().y() &&
+		a.Min().z() <= b.Max().z() && b.Min().z() <= a.Max().z();
+}
+
+cd::Vec3f GetCenter(const cd::AABB& aabb)
+{
+	return cd::Vec3f((aabb.Min().x() + aabb.Max().x()) * 0.5f, (aabb.Min().y() + aabb.Max().y()) * 0.5f, (aabb.Min().z() + aabb.Max().z()) * 0.5f);
+}
+
+cd::Vec3f GetExtents(const cd::AABB& aabb)
+{
+	return cd::Vec3f((aabb.Max().x() - aabb.Min().x()) * 0.5f, (aabb.Max().y() - aabb.Min().y()) * 0.5f, (aabb.Max().z() - aabb.Min().z()) * 0.5f);
+}
+
+}
+
+uint32_t DynamicBVH::CreateProxy(const cd::AABB& aabb, Entity entity)
+{
+	uint32_t proxyIndex = AllocateNode();
+	Node& node = m_nodes[proxyIndex];
+	node.tightAABB = aabb;
+	node.aabb = Fatten(aabb, m_fatMargin);
+	node.entity = entity;
+	node.height = 0;
+	InsertLeaf(proxyIndex);
+	++m_proxyCount;
+
+	return proxyIndex;
+}
+
+void DynamicBVH::DestroyProxy(uint32_t proxyIndex)
+{
+	assert(proxyIndex < m_nodes.size() && m_nodes[proxyIndex].IsLeaf() && m_nodes[proxyIndex].height >= 0);
+
+	RemoveLeaf(proxyIndex);
+	FreeNode(proxyIndex);
+	--m_proxyCount;
+}
+
+bool DynamicBVH::MoveProxy(uint32_t proxyIndex, const cd::AABB& aabb)
+{
+	assert(proxyIndex < m_nodes.size() && m_nodes[proxyIndex].IsLeaf() && m_nodes[proxyIndex].height >= 0);
+
+	Node& node = m_nodes[proxyIndex];
+	node.tightAABB = aabb;
+	if (Contains(node.aabb, aabb))
+	{
+		return false;
+	}
+
+	RemoveLeaf(proxyIndex);
+	m_nodes[proxyIndex].aabb = Fatten(aabb, m_fatMargin);
+	InsertLeaf(proxyIndex);
+
+	return true;
+}
+
+void DynamicBVH::Clear()
+{
+	m_nodes.clear();
+	m_rootIndex = InvalidIndex;
+	m_freeListIndex = InvalidIndex;
+	m_proxyCount = 0U;
+}
+
+void DynamicBVH::QueryAABB(const cd::AABB& aabb, std::vector<Entity>& outEntities) const
+{
+	if (InvalidIndex == m_rootIndex)
+	{
+		return;
+	}
+
+	std::vector<uint32_t> stack;
+	stack.push_back(m_rootIndex);
+	while (!stack.empty())
+	{
+		const Node& node = m_nodes[stack.back()];
+		stack.pop_back();
+		if (!Overlaps(node.aabb, aabb))
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			if (Overlaps(node.tightAABB, aabb))
+			{
+				outEntities.push_back(node.entity);
+			}
+			continue;
+		}
+
+		stack.push_back(node.childIndex1);
+		stack.push_back(node.childIndex2);
+	}
+}
+
+void DynamicBVH::QueryFrustum(const Frustum& frustum, std::vector<Entity>& outEntities) const
+{
+	if (InvalidIndex == m_rootIndex)
+	{
+		return;
+	}
+
+	t_boundaryBatch.Clear();
+	t_boundaryEntities.clear();
+
+	std::vector<uint32_t> stack;
+	stack.push_back(m_rootIndex);
+	while (!stack.empty())
+	{
+		uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+
+		const Node& node = m_nodes[nodeIndex];
+		cd::Vec3f center = GetCenter(node.aabb);
+		cd::Vec3f extents = GetExtents(node.aabb);
+		if (!frustum.Intersects(center, extents))
+		{
+			continue;
+		}
+
+		// Tight boxes are inside fat boxes.
+		if (frustum.Contains(center, extents))
+		{
+			AppendSubtree(nodeIndex, outEntities);
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			t_boundaryBatch.Add(GetCenter(node.tightAABB), GetExtents(node.tightAABB));
+			t_boundaryEntities.push_back(node.entity);
+			continue;
+		}
+
+		stack.push_back(node.childIndex1);
+		stack.push_back(node.childIndex2);
+	}
+
+	const uint32_t boundaryCount = t_boundaryBatch.GetCount();
+	t_boundaryVisibilities.resize(boundaryCount);
+	t_boundaryBatch.Cull(frustum, t_boundaryVisibilities.data());
+	for (uint32_t boundaryIndex = 0U; boundaryIndex < boundaryCount; ++boundaryIndex)
+	{
+		if (t_boundaryVisibilities[boundaryIndex])
+		{
+			outEntities.push_back(t_boundaryEntities[boundaryIndex]);
+		}
+	}
+}
+
+Entity DynamicBVH::RayCast(const cd::Ray& ray, float& outRayTime) const
+{
+	Entity nearestEntity = INVALID_ENTITY;
+	float minRayTime = FLT_MAX;
+	if (InvalidIndex == m_rootIndex)
+	{
+		return nearestEntity;
+	}
+
+	// Visit the nearer child at first so that farther subtrees are more likely to be skipped.
+	std::vector<std::pair<uint32_t, float>> stack;
+	float rootRayTime;
+	if (m_nodes[m_rootIndex].aabb.Intersects(ray, rootRayTime))
+	{
+		stack.emplace_back(m_rootIndex, rootRayTime);
+	}
+
+	while (!stack.empty())
+	{
+		auto [nodeIndex, nodeRayTime] = stack.back();
+		stack.pop_back();
+		if (nodeRayTime >= minRayTime)
+		{
+			continue;
+		}
+
+		const Node& node = m_nodes[nodeIndex];
+		if (node.IsLeaf())
+		{
+			float rayTime;
+			if (node.tightAABB.Intersects(ray, rayTime) && rayTime < minRayTime)
+			{
+				minRayTime = rayTime;
+				nearestEntity = node.entity;
+			}
+			continue;
+		}
+
+		float rayTime1;
+		float rayTime2;
+		bool isHit1 = m_nodes[node.childIndex1].aabb.Intersects(ray, rayTime1);
+		bool isHit2 = m_nodes[node.childIndex2].aabb.Intersects(ray, rayTime2);
+		if (isHit1 && isHit2 && rayTime1 < rayTime2)
+		{
+			stack.emplace_back(node.childIndex2, rayTime2);
+			stack.emplace_back(node.childIndex1, rayTime1);
+			continue;
+		}
+
+		if (isHit1)
+		{
+			stack.emplace_back(node.childIndex1, rayTime1);
+		}
+		if (isHit2)
+		{
+			stack.emplace_back(node.childIndex2, rayTime2);
+		}
+	}
+
+	if (INVALID_ENTITY != nearestEntity)
+	{
+		outRayTime = minRayTime;
+	}
+
+	return nearestEntity;
+}
+
+bool DynamicBVH::Validate() const
+{
+	if (InvalidIndex == m_rootIndex)
+	{
+		return 0U == m_proxyCount;
+	}
+
+	if (InvalidIndex != m_nodes[m_rootIndex].parentIndex)
+	{
+		return false;
+	}
+
+	uint32_t leafCount = 0U;
+	std::vector<uint32_t> stack;
+	stack.push_back(m_rootIndex);
+	while (!stack.empty())
+	{
+		uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+
+		const Node& node = m_nodes[nodeIndex];
+		if (node.IsLeaf())
+		{
+			if (0 != node.height || !Contains(node.aabb, node.tightAABB))
+			{
+				return false;
+			}
+			++leafCount;
+			continue;
+		}
+
+		const Node& child1 = m_nodes[node.childIndex1];
+		const Node& child2 = m_nodes[node.childIndex2];
+		if (child1.parentIndex != nodeIndex || child2.parentIndex != nodeIndex ||
+			node.height != 1 + std::max(child1.height, child2.height) ||
+			!Contains(node.aabb, child1.aabb) || !Contains(node.aabb, child2.aabb))
+		{
+			return false;
+		}
+
+		stack.push_back(node.childIndex1);
+		stack.push_back(node.childIndex2);
+	}
+
+	return leafCount == m_proxyCount;
+}
+
+uint32_t DynamicBVH::AllocateNode()
+{
+	uint32_t nodeIndex;
+	if (InvalidIndex != m_freeListIndex)
+	{
+		// Free nodes are linked by parentIndex.
+		nodeIndex = m_freeListIndex;
+		m_freeListIndex = m_nodes[nodeIndex].parentIndex;
+		m_nodes[nodeIndex] = Node();
+	}
+	else
+	{
+		nodeIndex = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+
+	return nodeIndex;
+}
+
+void DynamicBVH::FreeNode(uint32_t nodeIndex)
+{
+	Node& node = m_nodes[nodeIndex];
+	node.parentIndex = m_freeListIndex;
+	node.childIndex1 = InvalidIndex;
+	node.childIndex2 = InvalidIndex;
+	node.height = -1;
+	node.entity = INVALID_ENTITY;
+	m_freeListIndex = nodeIndex;
+}
+
+void DynamicBVH::InsertLeaf(uint32_t leafIndex)
+{
+	if (InvalidIndex == m_rootIndex)
+	{
+		m_rootIndex = leafIndex;
+		m_nodes[leafIndex].parentIndex = InvalidIndex;
+		return;
+	}
+
+	// Descend to the sibling which has the lowest cost of surface areas increased by inserting the leaf.
+	const cd::AABB leafAABB = m_nodes[leafIndex].aabb;
+	uint32_t siblingIndex = m_rootIndex;
+	while (!m_nodes[siblingIndex].IsLeaf())
+	{
+		const Node& node = m_nodes[siblingIndex];
+		float area = GetSurfaceArea(node.aabb);
+		float combinedArea = GetSurfaceArea(Union(node.aabb, leafAABB));
+
+		// Cost of creating a new parent for this node and the leaf.
+		float cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree.
+		float inheritanceCost = 2.0f * (combinedArea - area);
+		auto GetDescendCost = [&](uint32_t childIndex)
+		{
+			const Node& child = m_nodes[childIndex];
+			float childCombinedArea = GetSurfaceArea(Union(child.aabb, leafAABB));
+			return child.IsLeaf() ? childCombinedArea + inheritanceCost : childCombinedArea - GetSurfaceArea(child.aabb) + inheritanceCost;
+		};
+		float cost1 = GetDescendCost(node.childIndex1);
+		float cost2 = GetDescendCost(node.childIndex2);
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+
+		siblingIndex = cost1 < cost2 ? node.childIndex1 : node.childIndex2;
+	}
+
+	uint32_t oldParentIndex = m_nodes[siblingIndex].parentIndex;
+	uint32_t newParentIndex = AllocateNode();
+	Node& newParent = m_nodes[newParentIndex];
+	newParent.parentIndex = oldParentIndex;
+	newParent.aabb = Union(leafAABB, m_nodes[siblingIndex].aabb);
+	newParent.height = m_nodes[siblingIndex].height + 1;
+	newParent.childIndex1 = siblingIndex;
+	newParent.childIndex2 = leafIndex;
+	m_nodes[siblingIndex].parentIndex = newParentIndex;
+	m_nodes[leafIndex].parentIndex = newParentIndex;
+
+	if (InvalidIndex == oldParentIndex)
+	{
+		m_rootIndex = newParentIndex;
+	}
+	else if (m_nodes[oldParentIndex].childIndex1 == siblingIndex)
+	{
+		m_nodes[oldParentIndex].childIndex1 = newParentIndex;
+	}
+	else
+	{
+		m_nodes[oldParentIndex].childIndex2 = newParentIndex;
+	}
+
+	Refit(newParentIndex);
+}
+
+void DynamicBVH::RemoveLeaf(uint32_t leafIndex)
+{
+	if (leafIndex == m_rootIndex)
+	{
+		m_rootIndex = InvalidIndex;
+		return;
+	}
+
+	uint32_t parentIndex = m_nodes[leafIndex].parentIndex;
+	uint32_t grandParentIndex = m_nodes[parentIndex].parentIndex;
+	uint32_t siblingIndex = m_nodes[parentIndex].childIndex1 == leafIndex ? m_nodes[parentIndex].childIndex2 : m_nodes[parentIndex].childIndex1;
+
+	// Sibling takes the place of parent.
+	m_nodes[siblingIndex].parentIndex = grandParentIndex;
+	if (InvalidIndex == grandParentIndex)
+	{
+		m_rootIndex = siblingIndex;
+	}
+	else if (m_nodes[grandParentIndex].childIndex1 == parentIndex)
+	{
+		m_nodes[grandParentIndex].childIndex1 = siblingIndex;
+	}
+	else
+	{
+		m_nodes[grandParentIndex].childIndex2 = siblingIndex;
+	}
+
+	FreeNode(parentIndex);
+	m_nodes[leafIndex].parentIndex = InvalidIndex;
+	Refit(grandParentIndex);
+}
+
+void DynamicBVH::Refit(uint32_t nodeIndex)
+{
+	// Balance and update bounding boxes and heights from nodeIndex to root.
+	while (InvalidIndex != nodeIndex)
+	{
+		nodeIndex = Balance(nodeIndex);
+
+		Node& node = m_nodes[nodeIndex];
+		const Node& child1 = m_nodes[node.childIndex1];
+		const Node& child2 = m_nodes[node.childIndex2];
+		node.height = 1 + std::max(child1.height, child2.height);
+		node.aabb = Union(child1.aabb, child2.aabb);
+
+		nodeIndex = node.parentIndex;
+	}
+}
+
+uint32_t DynamicBVH::Balance(uint32_t indexA)
+{
+	// Rotate the higher child of A up if A's children heights differ more than 1. Returns the new root of this subtree.
+	Node& nodeA = m_nodes[indexA];
+	if (nodeA.IsLeaf() || nodeA.height < 2)
+	{
+		return indexA;
+	}
+
+	uint32_t indexB = nodeA.childIndex1;
+	uint32_t indexC = nodeA.childIndex2;
+	Node& nodeB = m_nodes[indexB];
+	Node& nodeC = m_nodes[indexC];
+	int32_t balance = nodeC.height - nodeB.height;
+
+	auto ReplaceChild = [this](uint32_t parentIndex, uint32_t oldChildIndex, uint32_t newChildIndex)
+	{
+		if (InvalidIndex == parentIndex)
+		{
+			m_rootIndex = newChildIndex;
+		}
+		else if (m_nodes[parentIndex].childIndex1 == oldChildIndex)
+		{
+			m_nodes[parentIndex].childIndex1 = newChildIndex;
+		}
+		else
+		{
+			m_nodes[parentIndex].childIndex2 = newChildIndex;
+		}
+	};
+
+	// Rotate C up.
+	if (balance > 1)
+	{
+		uint32_t indexF = nodeC.childIndex1;
+		uint32_t indexG = nodeC.childIndex2;
+		Node& nodeF = m_nodes[indexF];
+		Node& nodeG = m_nodes[indexG];
+
+		nodeC.childIndex1 = indexA;
+		nodeC.parentIndex = nodeA.parentIndex;
+		nodeA.parentIndex = indexC;
+		ReplaceChild(nodeC.parentIndex, indexA, indexC);
+
+		// The higher child of C stays with C and the other one moves to A.
+		if (nodeF.height > nodeG.height)
+		{
+			nodeC.childIndex2 = indexF;
+			nodeA.childIndex2 = indexG;
+			nodeG.parentIndex = indexA;
+			nodeA.aabb = Union(nodeB.aabb, nodeG.aabb);
+			nodeC.aabb = Union(nodeA.aabb, nodeF.aabb);
+			nodeA.height = 1 + std::max(nodeB.height, nodeG.height);
+			nodeC.height = 1 + std::max(nodeA.height, nodeF.height);
+		}
+		else
+		{
+			nodeC.childIndex2 = indexG;
+			nodeA.childIndex2 = indexF;
+			nodeF.parentIndex = indexA;
+			nodeA.aabb = Union(nodeB.aabb, nodeF.aabb);
+			nodeC.aabb = Union(nodeA.aabb, nodeG.aabb);
+			nodeA.height = 1 + std::max(nodeB.height, nodeF.height);
+			nodeC.height = 1 + std::max(nodeA.height, nodeG.height);
+		}
+
+		return indexC;
+	}
+
+	// Rotate B up.
+	if (balance < -1)
+	{
+		uint32_t indexD = nodeB.childIndex1;
+		uint32_t indexE = nodeB.childIndex2;
+		Node& nodeD = m_nodes[indexD];
+		Node& nodeE = m_nodes[indexE];
+
+		nodeB.childIndex1 = indexA;
+		nodeB.parentIndex = nodeA.parentIndex;
+		nodeA.parentIndex = indexB;
+		ReplaceChild(nodeB.parentIndex, indexA, indexB);
+
+		if (nodeD.height > nodeE.height)
+		{
+			nodeB.childIndex2 = indexD;
+			nodeA.childIndex1 = indexE;
+			nodeE.parentIndex = indexA;
+			nodeA.aabb = Union(nodeC.aabb, nodeE.aabb);
+			nodeB.aabb = Union(nodeA.aabb, nodeD.aabb);
+			nodeA.height = 1 + std::max(nodeC.height, nodeE.height);
+			nodeB.height = 1 + std::max(nodeA.height, nodeD.height);
+		}
+		else
+		{
+			nodeB.childIndex2 = indexE;
+			nodeA.childIndex1 = indexD;
+			nodeD.parentIndex = indexA;
+			nodeA.aabb = Union(nodeC.aabb, nodeD.aabb);
+			nodeB.aabb = Union(nodeA.aabb, nodeE.aabb);
+			nodeA.height = 1 + std::max(nodeC.height, nodeD.height);
+			nodeB.height = 1 + std::max(nodeA.height, nodeE.height);
+		}
+
+		return indexB;
+	}
+
+	return indexA;
+}
+
+void DynamicBVH::AppendSubtree(uint32_t nodeIndex, std::vector<Entity>& outEntities) const
+{
+	t_subtreeStack.clear();
+	t_subtreeStack.push_back(nodeIndex);
+	while (!t_subtreeStack.empty())
+	{
+		const Node& node = m_nodes[t_subtreeStack.back()];
+		t_subtreeStack.pop_back();
+		if (node.IsLeaf())
+		{
+			outEntities.push_back(node.entity);
+			continue;
+		}
+
+		t_subtreeStack.push_back(node.childIndex1);
+		t_subtreeStack.push_back(node.childIndex2);
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ECWorld/Entity.h"
+#include "Math/Box.hpp"
+#include "Math/Ray.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class Frustum;
+
+// DynamicBVH is an incrementally updated AABB tree. Every leaf is a proxy of an entity which stores a tight box
+// and an enlarged fat box. Internal nodes bound fat boxes so that small movements inside fat boxes don't change the tree.
+// Leaves are inserted by the surface area heuristic and the tree is kept balanced by rotations.
+class DynamicBVH final
+{
+public:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+public:
+	DynamicBVH() = default;
+	explicit DynamicBVH(float fatMargin) : m_fatMargin(fatMargin) {}
+	DynamicBVH(const DynamicBVH&) = default;
+	DynamicBVH& operator=(const DynamicBVH&) = default;
+	DynamicBVH(DynamicBVH&&) = default;
+	DynamicBVH& operator=(DynamicBVH&&) = default;
+	~DynamicBVH() = default;
+
+	// Returns the proxy index which keeps the same until it is destroyed.
+	uint32_t CreateProxy(const cd::AABB& aabb, Entity entity);
+	void DestroyProxy(uint32_t proxyIndex);
+
+	// Update proxy's tight box. Returns true if the proxy moved out of its fat box so that the tree changed.
+	bool MoveProxy(uint32_t proxyIndex, const cd::AABB& aabb);
+
+	Entity GetEntity(uint32_t proxyIndex) const { return m_nodes[proxyIndex].entity; }
+	const cd::AABB& GetAABB(uint32_t proxyIndex) const { return m_nodes[proxyIndex].tightAABB; }
+	const cd::AABB& GetFatAABB(uint32_t proxyIndex) const { return m_nodes[proxyIndex].aabb; }
+
+	void Clear();
+	uint32_t GetProxyCount() const { return m_proxyCount; }
+
+	// Leaf height is 0 and an empty tree's height is -1.
+	int32_t GetHeight() const { return InvalidIndex == m_rootIndex ? -1 : m_nodes[m_rootIndex].height; }
+
+	// Append entities whose tight boxes overlap aabb.
+	void QueryAABB(const cd::AABB& aabb, std::vector<Entity>& outEntities) const;
+
+	// Append entities whose tight boxes intersect frustum.
+	// Subtrees fully inside frustum are accepted without tests and leaves on the boundary are tested in SIMD batches.
+	void QueryFrustum(const Frustum& frustum, std::vector<Entity>& outEntities) const;
+
+	// Returns the entity whose tight box is nearest to ray origin along the ray or INVALID_ENTITY.
+	Entity RayCast(const cd::Ray& ray, float& outRayTime) const;
+
+	// Check parent links, heights and bounding boxes. Used by tests.
+	bool Validate() const;
+
+private:
+	struct Node
+	{
+		cd::AABB aabb;
+		cd::AABB tightAABB;
+		uint32_t parentIndex = InvalidIndex;
+		uint32_t childIndex1 = InvalidIndex;
+		uint32_t childIndex2 = InvalidIndex;
+		int32_t height = -1;
+		Entity entity = INVALID_ENTITY;
+
+		bool IsLeaf() const { return InvalidIndex == childIndex1; }
+	};
+
+	uint32_t AllocateNode();
+	void FreeNode(uint32_t nodeIndex);
+	void InsertLeaf(uint32_t leafIndex);
+	void RemoveLeaf(uint32_t leafIndex);
+	uint32_t Balance(uint32_t nodeIndex);
+	void Refit(uint32_t nodeIndex);
+	void AppendSubtree(uint32_t nodeIndex, std::vector<Entity>& outEntities) const;
+
+private:
+	float m_fatMargin = 0.1f;
+	std::vector<Node> m_nodes;
+	uint32_t m_rootIndex = InvalidIndex;
+	uint32_t m_freeListIndex = InvalidIndex;
+	uint32_t m_proxyCount = 0U;
+};
+
+}
\ No newline at end of file
@@ -1,16 +1,27 @@
+#include "Core/Jobs/JobSystem.h"
 #include "Core/StringCrc.h"
+#include "ECWorld/AnimationComponent.h"
+#include "ECWorld/ArchetypeStorage.hpp"
 #include "ECWorld/CameraComponent.h"
 #include "ECWorld/LightComponent.h"
 #include "ECWorld/MaterialComponent.h"
+#include "ECWorld/MeshLODSelector.h"
 #include "ECWorld/HierarchyComponent.h"
+#include "ECWorld/NameComponent.h"
 #include "ECWorld/World.h"
 #include "ECWorld/StaticMeshComponent.h"
+#include "ECWorld/SystemScheduler.h"
 #include "ECWorld/TransformComponent.h"
+#include "ECWorld/TransformHierarchy.h"
+#include "Material/MaterialType.h"
+#include "Rendering/RenderProxyList.h"
 #include "Utilities/PerformanceProfiler.h"
 
 #include <cassert>
+#include <cmath>
 #include <random>
 #include <set>
+#include <unordered_map>
 
 namespace
 {
@@ -26,12 +37,15 @@ void Test_CreateEntity()
 	constexpr int allocateCount = 1000;
 	Entity entities[allocateCount];
 
-#pragma omp parallel for
-	for (int i = 0; i < allocateCount; ++i)
+	JobSystem jobSystem;
+	jobSystem.ParallelFor(allocateCount, 1U, [&world, &entities](uint32_t begin, uint32_t end)
 	{
-		Entity entity = world.CreateEntity();
-		entities[i] = entity;
-	}
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			Entity entity = world.CreateEntity();
+			entities[i] = entity;
+		}
+	});
 
 	std::set<Entity> uniqueEntities;
 	for (Entity entity : entities)
@@ -83,7 +97,6 @@ std::vector<Entity> Test_CreateEntityComponents(World& world, Factory& factory)
 	Entity meshEntites[allocateCount];
 
 	// TODO : make it thread safe?
-	//#pragma omp parallel for
 	for (int i = 0; i < allocateCount; ++i)
 	{
 		Entity meshEntity = world.CreateEntity();
@@ -184,6 +197,672 @@ void Test_RemoveEntityComponentsByOrder(Factory& factory, const std::vector<Enti
 	printf("\n[Success] Test_RemoveEntityComponentsByOrder\n");
 }
 
+void Test_ComponentsView()
+{
+	World world;
+	ComponentsStorage<HierarchyComponent>* pHierarchy = world.Register<HierarchyComponent>();
+	ComponentsStorage<NameComponent>* pName = world.Register<NameComponent>();
+
+	// Only odd entities own both components.
+	constexpr Entity entityCount = 1000;
+	for (Entity entity = 0; entity < entityCount; ++entity)
+	{
+		pHierarchy->CreateComponent(entity).SetParentEntity(entity);
+		if (entity % 2 == 1)
+		{
+			pName->CreateComponent(entity);
+		}
+	}
+
+	auto view = world.View<HierarchyComponent, NameComponent>();
+	assert(view.GetDrivingEntityCount() == entityCount / 2);
+
+	size_t matchedCount = 0;
+	for (auto [entity, hierarchy, name] : view)
+	{
+		assert(entity % 2 == 1 && hierarchy.GetParentEntity() == entity);
+		hierarchy.SetParentEntity(INVALID_ENTITY);
+		++matchedCount;
+	}
+	assert(matchedCount == entityCount / 2);
+
+	// Components are returned by reference so modifications are visible in storage.
+	view.Each([](Entity entity, HierarchyComponent& hierarchy, NameComponent&)
+	{
+		assert(hierarchy.GetParentEntity() == INVALID_ENTITY);
+		hierarchy.SetParentEntity(entity);
+	});
+	assert(pHierarchy->GetComponent(1)->GetParentEntity() == 1 && pHierarchy->GetComponent(0)->GetParentEntity() == 0);
+
+	printf("\n[Success] Test_ComponentsView\n");
+}
+
+void Test_ArchetypeStorage()
+{
+	ArchetypeStorage<HierarchyComponent, NameComponent> storage;
+
+	constexpr Entity entityCount = ArchetypeStorage<HierarchyComponent, NameComponent>::ChunkCapacity * 3 + 1;
+	for (Entity entity = 0; entity < entityCount; ++entity)
+	{
+		auto [hierarchy, name] = storage.CreateComponents(entity);
+		hierarchy.SetParentEntity(entity);
+	}
+	assert(storage.GetCount() == entityCount && storage.GetChunkCount() == 4 && storage.GetVersion() == entityCount);
+
+	// Remove the first entity so that the last one moves into chunk 0 and the last chunk is released.
+	storage.RemoveComponents(0);
+	assert(storage.GetCount() == entityCount - 1 && storage.GetChunkCount() == 3 && storage.GetVersion() == entityCount + 1);
+	assert(!storage.Contains(0) && storage.GetComponent<HierarchyComponent>(entityCount - 1)->GetParentEntity() == entityCount - 1);
+
+	// Indexes follow the order of Each.
+	uint32_t visitedCount = 0U;
+	storage.Each([&storage, &visitedCount](Entity entity, HierarchyComponent& hierarchy, NameComponent&)
+	{
+		assert(hierarchy.GetParentEntity() == entity && &storage.GetComponentByIndex<HierarchyComponent>(visitedCount) == &hierarchy);
+		++visitedCount;
+	});
+	assert(visitedCount == entityCount - 1);
+
+	printf("\n[Success] Test_ArchetypeStorage\n");
+}
+
+// Compare render extraction of Transform, StaticMesh and Material between per-type storages and archetype chunks.
+void Test_ArchetypeStoragePerformance()
+{
+	struct DrawData
+	{
+		cd::Matrix4x4 worldMatrix;
+		uint16_t vertexBuffer;
+		bool twoSided;
+	};
+
+	constexpr Entity entityCount = 100000;
+	constexpr int extractRounds = 10;
+	std::vector<DrawData> drawList;
+	drawList.reserve(entityCount);
+
+	World world;
+	world.Register<TransformComponent>();
+	world.Register<StaticMeshComponent>();
+	world.Register<MaterialComponent>();
+	ArchetypeStorage<TransformComponent, StaticMeshComponent, MaterialComponent>* pArchetype =
+		world.RegisterArchetype<TransformComponent, StaticMeshComponent, MaterialComponent>();
+
+	for (Entity entity = 0; entity < entityCount; ++entity)
+	{
+		world.CreateComponent<TransformComponent>(entity);
+		world.CreateComponent<StaticMeshComponent>(entity);
+		world.CreateComponent<MaterialComponent>(entity);
+		pArchetype->CreateComponents(entity);
+	}
+
+	auto ExtractDrawData = [&drawList](Entity, TransformComponent& transform, StaticMeshComponent& mesh, MaterialComponent& material)
+	{
+		drawList.push_back({ transform.GetWorldMatrix(), mesh.GetVertexBuffer(), material.GetTwoSided() });
+	};
+
+	{
+		cdtools::PerformanceProfiler perf("Extract 100k draws x 10 from ComponentsStorage");
+		auto view = world.View<TransformComponent, StaticMeshComponent, MaterialComponent>();
+		for (int round = 0; round < extractRounds; ++round)
+		{
+			drawList.clear();
+			view.Each(ExtractDrawData);
+		}
+	}
+	assert(drawList.size() == entityCount);
+
+	{
+		cdtools::PerformanceProfiler perf("Extract 100k draws x 10 from ArchetypeStorage");
+		for (int round = 0; round < extractRounds; ++round)
+		{
+			drawList.clear();
+			pArchetype->Each(ExtractDrawData);
+		}
+	}
+	assert(drawList.size() == entityCount);
+
+	printf("\n[Success] Test_ArchetypeStoragePerformance\n");
+}
+
+#define DEFINE_TEST_VALUE_COMPONENT(ComponentType) \
+struct ComponentType \
+{ \
+	static constexpr StringCrc GetClassName() \
+	{ \
+		constexpr StringCrc className(#ComponentType); \
+		return className; \
+	} \
+	uint64_t value = 0; \
+};
+
+DEFINE_TEST_VALUE_COMPONENT(ValueAComponent);
+DEFINE_TEST_VALUE_COMPONENT(ValueBComponent);
+DEFINE_TEST_VALUE_COMPONENT(ValueCComponent);
+DEFINE_TEST_VALUE_COMPONENT(ValueDComponent);
+
+// Systems only modify components they declared as write and only read components they declared as read.
+void AddTestSystems(SystemScheduler& scheduler, World& world)
+{
+	auto* pA = world.GetComponents<ValueAComponent>();
+	auto* pB = world.GetComponents<ValueBComponent>();
+	auto* pC = world.GetComponents<ValueCComponent>();
+	auto* pD = world.GetComponents<ValueDComponent>();
+
+	scheduler.AddSystem("WriteA", SystemAccess().Write<ValueAComponent>(), [pA](float)
+	{
+		for (ValueAComponent& a : pA->GetDenseComponents()) { a.value = a.value * 3 + 1; }
+	});
+	scheduler.AddSystem("WriteB", SystemAccess().Write<ValueBComponent>(), [pB](float)
+	{
+		for (ValueBComponent& b : pB->GetDenseComponents()) { b.value = b.value * 7 + 2; }
+	});
+	scheduler.AddSystem("ReadABWriteC", SystemAccess().Read<ValueAComponent, ValueBComponent>().Write<ValueCComponent>(), [pA, pB, pC](float)
+	{
+		for (Entity entity : pC->GetEntities()) { pC->GetComponent(entity)->value += pA->GetComponent(entity)->value ^ pB->GetComponent(entity)->value; }
+	});
+	scheduler.AddSystem("ReadAWriteD", SystemAccess().Read<ValueAComponent>().Write<ValueDComponent>(), [pA, pD](float)
+	{
+		for (Entity entity : pD->GetEntities()) { pD->GetComponent(entity)->value += pA->GetComponent(entity)->value % 1000; }
+	});
+	scheduler.AddSystem("ReadCDWriteA", SystemAccess().Read<ValueCComponent, ValueDComponent>().Write<ValueAComponent>(), [pA, pC, pD](float)
+	{
+		for (Entity entity : pA->GetEntities()) { pA->GetComponent(entity)->value = (pC->GetComponent(entity)->value + pD->GetComponent(entity)->value) % 1000003; }
+	});
+}
+
+void CreateTestValueComponents(World& world, Entity entityCount)
+{
+	world.Register<ValueAComponent>();
+	world.Register<ValueBComponent>();
+	world.Register<ValueCComponent>();
+	world.Register<ValueDComponent>();
+	for (Entity entity = 0; entity < entityCount; ++entity)
+	{
+		world.CreateComponent<ValueAComponent>(entity).value = entity;
+		world.CreateComponent<ValueBComponent>(entity).value = entity * 2;
+		world.CreateComponent<ValueCComponent>(entity);
+		world.CreateComponent<ValueDComponent>(entity);
+	}
+}
+
+void Test_SystemScheduler()
+{
+	constexpr Entity entityCount = 100000;
+	constexpr int frameCount = 10;
+
+	World serialWorld;
+	SystemScheduler serialScheduler;
+	CreateTestValueComponents(serialWorld, entityCount);
+	AddTestSystems(serialScheduler, serialWorld);
+
+	World parallelWorld;
+	SystemScheduler parallelScheduler;
+	CreateTestValueComponents(parallelWorld, entityCount);
+	AddTestSystems(parallelScheduler, parallelWorld);
+
+	// WriteA and WriteB are independent. Others wait for the systems they conflict with.
+	assert(parallelScheduler.GetDependencies(0).empty() && parallelScheduler.GetDependencies(1).empty());
+	assert((parallelScheduler.GetDependencies(2) == std::vector<uint32_t>{ 0, 1 }));
+	assert((parallelScheduler.GetDependencies(3) == std::vector<uint32_t>{ 0 }));
+	assert((parallelScheduler.GetDependencies(4) == std::vector<uint32_t>{ 0, 2, 3 }));
+
+	{
+		cdtools::PerformanceProfiler perf("SystemScheduler serial run");
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			serialScheduler.RunSerial(0.016f);
+		}
+	}
+
+	{
+		JobSystem jobSystem(4);
+		cdtools::PerformanceProfiler perf("SystemScheduler parallel run");
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			parallelScheduler.Run(0.016f, jobSystem);
+		}
+	}
+
+	for (Entity entity = 0; entity < entityCount; ++entity)
+	{
+		assert(serialWorld.GetComponents<ValueAComponent>()->GetComponent(entity)->value == parallelWorld.GetComponents<ValueAComponent>()->GetComponent(entity)->value);
+		assert(serialWorld.GetComponents<ValueBComponent>()->GetComponent(entity)->value == parallelWorld.GetComponents<ValueBComponent>()->GetComponent(entity)->value);
+		assert(serialWorld.GetComponents<ValueCComponent>()->GetComponent(entity)->value == parallelWorld.GetComponents<ValueCComponent>()->GetComponent(entity)->value);
+		assert(serialWorld.GetComponents<ValueDComponent>()->GetComponent(entity)->value == parallelWorld.GetComponents<ValueDComponent>()->GetComponent(entity)->value);
+	}
+
+	printf("\n[Success] Test_SystemScheduler\n");
+}
+
+bool IsNearlyEqual(const cd::Matrix4x4& a, const cd::Matrix4x4& b)
+{
+	for (int index = 0; index < 16; ++index)
+	{
+		float delta = a.Begin()[index] - b.Begin()[index];
+		if (delta > 0.001f || delta < -0.001f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Parent entity is always smaller than child entity. Components are created reversely so that storage order is child before parent.
+void CreateTestHierarchy(World& world, const std::vector<Entity>& parentEntities)
+{
+	const Entity entityCount = static_cast<Entity>(parentEntities.size());
+	for (Entity entity = entityCount; entity > 0; --entity)
+	{
+		Entity currentEntity = entity - 1;
+		float offset = static_cast<float>(currentEntity % 7) * 0.01f;
+		float scale = 0 == currentEntity % 3 ? 1.001f : 1.0f;
+		world.CreateComponent<TransformComponent>(currentEntity).SetTransform(
+			cd::Transform(cd::Vec3f(offset, -offset, 2.0f * offset), cd::Quaternion::Identity(), cd::Vec3f(scale, scale, scale)));
+		if (INVALID_ENTITY != parentEntities[currentEntity])
+		{
+			world.CreateComponent<HierarchyComponent>(currentEntity).SetParentEntity(parentEntities[currentEntity]);
+		}
+	}
+}
+
+std::vector<cd::Matrix4x4> BuildExpectedWorldMatrices(World& world, const std::vector<Entity>& parentEntities)
+{
+	std::vector<cd::Matrix4x4> worldMatrices(parentEntities.size());
+	for (Entity entity = 0; entity < parentEntities.size(); ++entity)
+	{
+		cd::Matrix4x4 localMatrix = world.GetComponents<TransformComponent>()->GetComponent(entity)->GetTransform().GetMatrix();
+		worldMatrices[entity] = INVALID_ENTITY == parentEntities[entity] ? localMatrix : worldMatrices[parentEntities[entity]] * localMatrix;
+	}
+
+	return worldMatrices;
+}
+
+bool CheckWorldMatrices(World& world, const std::vector<Entity>& parentEntities)
+{
+	std::vector<cd::Matrix4x4> expectedWorldMatrices = BuildExpectedWorldMatrices(world, parentEntities);
+	for (Entity entity = 0; entity < parentEntities.size(); ++entity)
+	{
+		if (!IsNearlyEqual(world.GetComponents<TransformComponent>()->GetComponent(entity)->GetWorldMatrix(), expectedWorldMatrices[entity]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint32_t GetSubtreeSize(const std::vector<Entity>& parentEntities, Entity rootEntity)
+{
+	std::vector<uint8_t> isInSubtree(parentEntities.size(), 0);
+	uint32_t subtreeSize = 0;
+	for (Entity entity = rootEntity; entity < parentEntities.size(); ++entity)
+	{
+		Entity parentEntity = parentEntities[entity];
+		if (entity == rootEntity || (INVALID_ENTITY != parentEntity && isInSubtree[parentEntity]))
+		{
+			isInSubtree[entity] = 1;
+			++subtreeSize;
+		}
+	}
+
+	return subtreeSize;
+}
+
+void Test_TransformHierarchy()
+{
+	// A 1000 depth chain, a wide random tree under it and several roots.
+	constexpr Entity entityCount = 100000;
+	constexpr Entity chainLength = 1000;
+	std::vector<Entity> parentEntities(entityCount, INVALID_ENTITY);
+	std::mt19937 randomEngine(20230901);
+	for (Entity entity = 1; entity < entityCount; ++entity)
+	{
+		if (entity < chainLength)
+		{
+			parentEntities[entity] = entity - 1;
+		}
+		else if (entity % 10000 != 0)
+		{
+			parentEntities[entity] = std::uniform_int_distribution<Entity>(chainLength / 2, entity - 1)(randomEngine);
+		}
+	}
+
+	World world;
+	ComponentsStorage<HierarchyComponent>* pHierarchyStorage = world.Register<HierarchyComponent>();
+	ComponentsStorage<TransformComponent>* pTransformStorage = world.Register<TransformComponent>();
+	CreateTestHierarchy(world, parentEntities);
+
+	TransformHierarchy transformHierarchy(pHierarchyStorage, pTransformStorage);
+	{
+		cdtools::PerformanceProfiler perf("TransformHierarchy rebuild and update 100k nodes serially");
+		transformHierarchy.Update();
+	}
+	assert(entityCount == transformHierarchy.GetUpdatedCount());
+	assert(CheckWorldMatrices(world, parentEntities));
+
+	// Parent before child in sorted entities.
+	std::vector<uint32_t> sortedPositions(entityCount);
+	for (uint32_t sortedIndex = 0; sortedIndex < entityCount; ++sortedIndex)
+	{
+		sortedPositions[transformHierarchy.GetSortedEntities()[sortedIndex]] = sortedIndex;
+	}
+	for (Entity entity = 0; entity < entityCount; ++entity)
+	{
+		assert(INVALID_ENTITY == parentEntities[entity] || sortedPositions[parentEntities[entity]] < sortedPositions[entity]);
+	}
+
+	// Nothing changed.
+	transformHierarchy.Update();
+	assert(0 == transformHierarchy.GetUpdatedCount());
+
+	// Only the subtree of modified entity is rebuilt.
+	JobSystem jobSystem;
+	constexpr Entity modifiedEntity = chainLength - 10;
+	pTransformStorage->GetComponent(modifiedEntity)->SetTransform(cd::Transform(cd::Vec3f(1.0f, 2.0f, 3.0f), cd::Quaternion::Identity(), cd::Vec3f::One()));
+	{
+		cdtools::PerformanceProfiler perf("TransformHierarchy update dirty subtree in parallel");
+		transformHierarchy.Update(&jobSystem);
+	}
+	assert(GetSubtreeSize(parentEntities, modifiedEntity) == transformHierarchy.GetUpdatedCount());
+	assert(CheckWorldMatrices(world, parentEntities));
+
+	// Move children of the chain end to the first root.
+	for (Entity entity = chainLength; entity < entityCount; ++entity)
+	{
+		if (chainLength - 1 == parentEntities[entity])
+		{
+			parentEntities[entity] = 0;
+			pHierarchyStorage->GetComponent(entity)->SetParentEntity(0);
+		}
+	}
+	transformHierarchy.MarkTopologyDirty();
+	transformHierarchy.Update(&jobSystem);
+	assert(CheckWorldMatrices(world, parentEntities));
+
+	for (int round = 0; round < 3; ++round)
+	{
+		for (TransformComponent& transformComponent : pTransformStorage->GetDenseComponents())
+		{
+			transformComponent.Dirty();
+		}
+
+		{
+			cdtools::PerformanceProfiler perf("TransformHierarchy update all 100k nodes serially");
+			transformHierarchy.Update();
+		}
+
+		for (TransformComponent& transformComponent : pTransformStorage->GetDenseComponents())
+		{
+			transformComponent.Dirty();
+		}
+
+		{
+			cdtools::PerformanceProfiler perf("TransformHierarchy update all 100k nodes in parallel");
+			transformHierarchy.Update(&jobSystem);
+		}
+	}
+	assert(CheckWorldMatrices(world, parentEntities));
+
+	printf("\n[Success] Test_TransformHierarchy\n");
+}
+
+// The old ComponentsStorage implementation which maps entity to index by std::unordered_map.
+// It is kept here as a baseline to compare with the sparse set implementation.
+template<typename Component>
+class HashMapComponentsStorage
+{
+public:
+	bool Contains(Entity entity) const { return m_entityToIndex.find(entity) != m_entityToIndex.end(); }
+	size_t GetCount() const { return m_entityToIndex.size(); }
+
+	Component* GetComponent(Entity entity)
+	{
+		auto itIndex = m_entityToIndex.find(entity);
+		return itIndex == m_entityToIndex.end() ? nullptr : &m_components[itIndex->second];
+	}
+
+	Component& CreateComponent(Entity entity)
+	{
+		m_entityToIndex[entity] = m_components.size();
+		m_entities.emplace_back(entity);
+		m_components.emplace_back();
+		return m_components.back();
+	}
+
+	void RemoveComponent(Entity entity)
+	{
+		auto itIndex = m_entityToIndex.find(entity);
+		if (itIndex == m_entityToIndex.end())
+		{
+			return;
+		}
+
+		if (m_entityToIndex.size() > 1)
+		{
+			size_t unusedIndex = itIndex->second;
+			Entity lastEntity = m_entities.back();
+			m_entities[unusedIndex] = lastEntity;
+			m_components[unusedIndex] = cd::MoveTemp(m_components.back());
+			m_entityToIndex[lastEntity] = unusedIndex;
+		}
+
+		m_entities.pop_back();
+		m_components.pop_back();
+		m_entityToIndex.erase(entity);
+	}
+
+private:
+	std::vector<Entity> m_entities;
+	std::vector<Component> m_components;
+	std::unordered_map<Entity, size_t> m_entityToIndex;
+};
+
+template<typename Storage>
+void Test_StoragePerformance(const char* pStorageName)
+{
+	printf("\n[%s]\n", pStorageName);
+
+	constexpr Entity entityCount = 100000;
+	constexpr int lookupRounds = 10;
+
+	Storage storage;
+	{
+		cdtools::PerformanceProfiler perf("Create 100k components");
+		for (Entity entity = 0; entity < entityCount; ++entity)
+		{
+			storage.CreateComponent(entity).SetParentEntity(entity);
+		}
+	}
+	assert(storage.GetCount() == entityCount);
+
+	std::vector<Entity> shuffledEntities(entityCount);
+	for (Entity entity = 0; entity < entityCount; ++entity)
+	{
+		shuffledEntities[entity] = entity;
+	}
+	std::shuffle(shuffledEntities.begin(), shuffledEntities.end(), std::default_random_engine(entityCount));
+
+	{
+		cdtools::PerformanceProfiler perf("Lookup 100k components x 10");
+		uint64_t checkSum = 0;
+		for (int round = 0; round < lookupRounds; ++round)
+		{
+			for (Entity entity : shuffledEntities)
+			{
+				checkSum += storage.GetComponent(entity)->GetParentEntity();
+			}
+		}
+		assert(checkSum == static_cast<uint64_t>(entityCount) * (entityCount - 1) / 2 * lookupRounds);
+	}
+
+	{
+		cdtools::PerformanceProfiler perf("Remove 100k components randomly");
+		for (Entity entity : shuffledEntities)
+		{
+			storage.RemoveComponent(entity);
+		}
+	}
+	assert(storage.GetCount() == 0);
+}
+
+void Test_SparseSetStorage()
+{
+	ComponentsStorage<HierarchyComponent> storage;
+
+	// Sparse entity ids should only allocate the pages they touch.
+	constexpr Entity farEntity = 10000000;
+	storage.CreateComponent(farEntity).SetParentEntity(1);
+	storage.CreateComponent(0).SetParentEntity(2);
+	storage.CreateComponent(5).SetParentEntity(3);
+	assert(storage.Contains(farEntity) && storage.Contains(0) && storage.Contains(5));
+	assert(!storage.Contains(1) && !storage.Contains(farEntity + 1) && !storage.Contains(INVALID_ENTITY));
+
+	// Swap and pop keeps the dense arrays packed and updates the moved entity's index.
+	storage.RemoveComponent(farEntity);
+	assert(storage.GetCount() == 2 && !storage.Contains(farEntity));
+	assert(storage.GetEntities()[0] == 5 && storage.GetComponent(5)->GetParentEntity() == 3);
+	assert(storage.GetComponent(0)->GetParentEntity() == 2);
+
+	storage.RemoveComponent(5);
+	storage.RemoveComponent(0);
+	storage.RemoveComponent(0);
+	assert(storage.GetCount() == 0 && !storage.Contains(0));
+
+	printf("\n[Success] Test_SparseSetStorage\n");
+}
+
+void Test_StaticMeshArchetypeExtraction()
+{
+	World world;
+	ComponentsStorage<HierarchyComponent>* pHierarchyStorage = world.Register<HierarchyComponent>();
+	ComponentsStorage<TransformComponent>* pTransformStorage = world.Register<TransformComponent>();
+	ComponentsStorage<StaticMeshComponent>* pStaticMeshStorage = world.Register<StaticMeshComponent>();
+	ComponentsStorage<MaterialComponent>* pMaterialStorage = world.Register<MaterialComponent>();
+	ComponentsStorage<AnimationComponent>* pAnimationStorage = world.Register<AnimationComponent>();
+	StaticMeshArchetype* pStaticMeshArchetype = world.RegisterArchetype<TransformComponent, StaticMeshComponent, MaterialComponent>();
+
+	MaterialType materialType;
+	materialType.SetShaderSchema(ShaderSchema("vs_test.sc", "fs_test.sc"));
+	materialType.GetShaderSchema().SetCompiledProgram(ShaderSchema::DefaultUberShaderCrc, 1U);
+
+	// Entities in three chunks. Their transforms are only built by TransformHierarchy.
+	constexpr Entity entityCount = StaticMeshArchetype::ChunkCapacity * 2 + 1;
+	for (Entity entity = 0; entity < entityCount; ++entity)
+	{
+		auto [transformComponent, staticMeshComponent, materialComponent] = pStaticMeshArchetype->CreateComponents(entity);
+		transformComponent.SetTransform(cd::Transform(cd::Vec3f(static_cast<float>(entity), 0.0f, 0.0f), cd::Quaternion::Identity(), cd::Vec3f(1.0f, 1.0f, 1.0f)));
+		materialComponent.SetMaterialType(&materialType);
+	}
+
+	JobSystem jobSystem(4);
+	TransformHierarchy transformHierarchy(pHierarchyStorage, pTransformStorage);
+	transformHierarchy.SetStaticMeshArchetype(pStaticMeshArchetype);
+	transformHierarchy.Update(&jobSystem);
+	assert(entityCount == transformHierarchy.GetUpdatedCount());
+
+	RenderProxyList renderProxyList(pMaterialStorage, pStaticMeshStorage, pTransformStorage, pAnimationStorage, pStaticMeshArchetype, &materialType);
+	renderProxyList.Update(SkyType::None);
+	assert(entityCount == renderProxyList.GetProxyCount());
+	for (const RenderProxy& proxy : renderProxyList.GetProxies())
+	{
+		assert(proxy.isInArchetype && static_cast<float>(proxy.entity) == proxy.worldMatrix.Begin()[12]);
+		assert(static_cast<float>(proxy.entity) == proxy.worldCenter.x());
+	}
+
+	// Nothing changed.
+	transformHierarchy.Update(&jobSystem);
+	renderProxyList.Update(SkyType::None);
+	assert(0U == transformHierarchy.GetUpdatedCount() && 0U == renderProxyList.GetUpdatedCount());
+
+	// Moved entity is rebuilt and extracted again alone.
+	constexpr Entity movedEntity = StaticMeshArchetype::ChunkCapacity + 1;
+	pStaticMeshArchetype->GetComponent<TransformComponent>(movedEntity)->SetTransform(
+		cd::Transform(cd::Vec3f(0.0f, 5.0f, 0.0f), cd::Quaternion::Identity(), cd::Vec3f(1.0f, 1.0f, 1.0f)));
+	transformHierarchy.Update(&jobSystem);
+	renderProxyList.Update(SkyType::None);
+	assert(1U == transformHierarchy.GetUpdatedCount() && 1U == renderProxyList.GetUpdatedCount());
+	const RenderProxy& movedProxy = renderProxyList.GetProxies()[movedEntity];
+	assert(movedEntity == movedProxy.entity && 0.0f == movedProxy.worldMatrix.Begin()[12] && 5.0f == movedProxy.worldMatrix.Begin()[13]);
+	assert(5.0f == movedProxy.worldCenter.y());
+
+	// Removing an entity rebuilds proxies from chunks.
+	pStaticMeshArchetype->RemoveComponents(0);
+	renderProxyList.Update(SkyType::None);
+	assert(entityCount - 1 == renderProxyList.GetProxyCount());
+
+	printf("\n[Success] Test_StaticMeshArchetypeExtraction\n");
+}
+
+void Test_MeshLODSelection()
+{
+	// Errors of LOD 0 to 3 in mesh space. The projection has 60 degrees vertical fov.
+	const float lodErrors[] = { 0.0f, 0.01f, 0.05f, 0.2f };
+	const float projectionScaleY = 1.0f / std::tan(3.14159265f / 6.0f);
+	constexpr float maxScreenError = MeshLODSelector::DefaultMaxScreenError;
+
+	// Close meshes and cameras inside bounds use LOD 0. Farther meshes use coarser LODs.
+	assert(0 == MeshLODSelector::SelectLOD(lodErrors, 4, 1.0f, -1.0f, projectionScaleY, maxScreenError));
+	assert(0 == MeshLODSelector::SelectLOD(lodErrors, 4, 1.0f, 1.0f, projectionScaleY, maxScreenError));
+	assert(2 == MeshLODSelector::SelectLOD(lodErrors, 4, 1.0f, 100.0f, projectionScaleY, maxScreenError));
+	assert(3 == MeshLODSelector::SelectLOD(lodErrors, 4, 1.0f, 1000.0f, projectionScaleY, maxScreenError));
+	assert(0 == MeshLODSelector::SelectLOD(lodErrors, 1, 1.0f, 1000.0f, projectionScaleY, maxScreenError));
+
+	// Scaled meshes have larger errors in world space.
+	assert(1 == MeshLODSelector::SelectLOD(lodErrors, 4, 10.0f, 100.0f, projectionScaleY, maxScreenError));
+
+	// LODs never get finer with distance and zero errors need the mesh to be far enough.
+	uint32_t previousLOD = 0;
+	for (float distance = 0.5f; distance < 2000.0f; distance *= 1.1f)
+	{
+		uint32_t lod = MeshLODSelector::SelectLOD(lodErrors, 4, 1.0f, distance, projectionScaleY, maxScreenError);
+		assert(lod >= previousLOD && lod < 4);
+		previousLOD = lod;
+	}
+	assert(3 == previousLOD);
+	assert(0 == MeshLODSelector::SelectLOD(lodErrors, 4, 1.0f, 1000.0f, projectionScaleY, 0.0f));
+
+	printf("\n[Success] Test_MeshLODSelection\n");
+}
+
+void Test_LazyShaderVariants()
+{
+	constexpr uint16_t defaultProgram = 1U;
+	constexpr uint16_t albedoProgram = 2U;
+
+	MaterialType materialType;
+	ShaderSchema shaderSchema("vs_test.sc", "fs_test.sc");
+	shaderSchema.RegisterUberOption(Uber::ALBEDO_MAP);
+	shaderSchema.RegisterUberOption(Uber::NORMAL_MAP);
+	shaderSchema.SetLazyVariants(true);
+	materialType.SetShaderSchema(cd::MoveTemp(shaderSchema));
+
+	ShaderSchema& lazySchema = materialType.GetShaderSchema();
+	lazySchema.SetCompiledProgram(ShaderSchema::DefaultUberShaderCrc, defaultProgram);
+
+	MaterialComponent materialComponent;
+	materialComponent.SetMaterialType(&materialType);
+	materialComponent.ActiveUberShaderOption(Uber::ALBEDO_MAP);
+	materialComponent.MatchUberShaderCrc();
+
+	// Variant which is not compiled falls back to DEFAULT and is requested only once.
+	assert(defaultProgram == materialComponent.GetShadreProgram());
+	assert(defaultProgram == materialComponent.GetShadreProgram());
+	std::vector<std::string> requestedCombines = lazySchema.TakeRequestedUberCombines();
+	assert(1 == requestedCombines.size() && "ALBEDOMAP;" == requestedCombines[0]);
+	assert(lazySchema.TakeRequestedUberCombines().empty());
+
+	// Cached handles are refreshed by program version after the variant is loaded.
+	const uint32_t programVersion = lazySchema.GetProgramVersion();
+	lazySchema.SetCompiledProgram(StringCrc(requestedCombines[0]), albedoProgram);
+	assert(programVersion != lazySchema.GetProgramVersion());
+	assert(albedoProgram == materialComponent.GetShadreProgram());
+	assert(lazySchema.TakeRequestedUberCombines().empty());
+
+	printf("\n[Success] Test_LazyShaderVariants\n");
+}
+
 }
 
 int main()
@@ -196,5 +875,17 @@ int main()
 	Test_RemoveEntityComponentsRandly(factory, meshEntites);
 	Test_RemoveEntityComponentsByOrder(factory, meshEntites);
 
+	Test_SparseSetStorage();
+	Test_ComponentsView();
+	Test_ArchetypeStorage();
+	Test_ArchetypeStoragePerformance();
+	Test_SystemScheduler();
+	Test_TransformHierarchy();
+	Test_StaticMeshArchetypeExtraction();
+	Test_MeshLODSelection();
+	Test_LazyShaderVariants();
+	Test_StoragePerformance<HashMapComponentsStorage<HierarchyComponent>>("Before : std::unordered_map index");
+	Test_StoragePerformance<ComponentsStorage<HierarchyComponent>>("After : paged sparse set index");
+
 	return 0;
 }
\ No newline at end of file
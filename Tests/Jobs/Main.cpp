@@ -0,0 +1,300 @@
+#include "Core/Jobs/JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+
+using namespace engine;
+
+double GetElapsedMilliseconds(std::chrono::steady_clock::time_point startTime)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Test_SubmitAndWait()
+{
+	JobSystem jobSystem(4);
+
+	constexpr uint32_t jobCount = 10000;
+	std::atomic<uint32_t> executedCount = 0U;
+	JobCounter counter;
+	for (uint32_t jobIndex = 0U; jobIndex < jobCount; ++jobIndex)
+	{
+		jobSystem.Submit([&executedCount]() { executedCount.fetch_add(1U); }, &counter);
+	}
+	jobSystem.Wait(counter);
+	assert(counter.IsDone() && jobCount == executedCount.load());
+
+	// Nested jobs go to workers' own deques and are stolen by idle workers.
+	executedCount.store(0U);
+	JobCounter nestedCounter;
+	for (uint32_t jobIndex = 0U; jobIndex < 100U; ++jobIndex)
+	{
+		jobSystem.Submit([&jobSystem, &executedCount, &nestedCounter]()
+		{
+			for (uint32_t nestedIndex = 0U; nestedIndex < 100U; ++nestedIndex)
+			{
+				jobSystem.Submit([&executedCount]() { executedCount.fetch_add(1U); }, &nestedCounter);
+			}
+		}, &nestedCounter);
+	}
+	jobSystem.Wait(nestedCounter);
+	assert(10000U == executedCount.load());
+
+	printf("\n[Success] Test_SubmitAndWait\n");
+}
+
+void Test_Dependencies()
+{
+	JobSystem jobSystem(4);
+
+	// Three stages. Every job of a stage checks that all jobs of the previous stage finished.
+	constexpr uint32_t jobCountPerStage = 64;
+	std::atomic<uint32_t> stage1Count = 0U;
+	std::atomic<uint32_t> stage2Count = 0U;
+	std::atomic<bool> isOrderCorrect = true;
+
+	JobCounter stage1Counter;
+	JobCounter stage2Counter;
+	JobCounter stage3Counter;
+	for (uint32_t jobIndex = 0U; jobIndex < jobCountPerStage; ++jobIndex)
+	{
+		jobSystem.Submit([&stage1Count]()
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			stage1Count.fetch_add(1U);
+		}, &stage1Counter);
+	}
+
+	for (uint32_t jobIndex = 0U; jobIndex < jobCountPerStage; ++jobIndex)
+	{
+		jobSystem.Submit([&stage1Count, &stage2Count, &isOrderCorrect]()
+		{
+			if (jobCountPerStage != stage1Count.load())
+			{
+				isOrderCorrect.store(false);
+			}
+			stage2Count.fetch_add(1U);
+		}, &stage2Counter, &stage1Counter);
+	}
+
+	jobSystem.Submit([&stage2Count, &isOrderCorrect]()
+	{
+		if (jobCountPerStage != stage2Count.load())
+		{
+			isOrderCorrect.store(false);
+		}
+	}, &stage3Counter, &stage2Counter);
+
+	jobSystem.Wait(stage3Counter);
+	assert(isOrderCorrect.load() && stage1Counter.IsDone() && stage2Counter.IsDone());
+
+	// Depending on a finished counter queues the job immediately.
+	JobCounter lateCounter;
+	jobSystem.Submit([]() {}, &lateCounter, &stage1Counter);
+	jobSystem.Wait(lateCounter);
+
+	printf("\n[Success] Test_Dependencies\n");
+}
+
+void Test_ParallelFor()
+{
+	JobSystem jobSystem(4);
+
+	constexpr uint32_t elementCount = 100003;
+	std::vector<uint32_t> values(elementCount, 0U);
+	for (uint32_t grainSize : { 0U, 1U, 7U, 1024U, elementCount, elementCount * 2U })
+	{
+		jobSystem.ParallelFor(elementCount, grainSize, [&values, grainSize](uint32_t begin, uint32_t end)
+		{
+			assert(begin < end && (0U == grainSize || end - begin <= grainSize));
+			for (uint32_t index = begin; index < end; ++index)
+			{
+				++values[index];
+			}
+		});
+	}
+
+	// Every element is visited exactly once per ParallelFor.
+	for (uint32_t value : values)
+	{
+		assert(6U == value);
+	}
+
+	jobSystem.ParallelFor(0U, 16U, [](uint32_t, uint32_t) { assert(false); });
+
+	printf("\n[Success] Test_ParallelFor\n");
+}
+
+void Test_MainThreadJobs()
+{
+	JobSystem jobSystem(2);
+
+	// Workers forward bgfx-like calls to main thread.
+	const std::thread::id mainThreadID = std::this_thread::get_id();
+	std::atomic<uint32_t> mainThreadExecutedCount = 0U;
+	JobCounter workerCounter;
+	JobCounter mainThreadCounter;
+	for (uint32_t jobIndex = 0U; jobIndex < 16U; ++jobIndex)
+	{
+		jobSystem.Submit([&jobSystem, &mainThreadCounter, &mainThreadExecutedCount, mainThreadID]()
+		{
+			jobSystem.SubmitToMainThread([&mainThreadExecutedCount, mainThreadID]()
+			{
+				assert(std::this_thread::get_id() == mainThreadID);
+				mainThreadExecutedCount.fetch_add(1U);
+			}, &mainThreadCounter);
+		}, &workerCounter);
+	}
+	jobSystem.Wait(workerCounter);
+
+	assert(0U == mainThreadExecutedCount.load() && !mainThreadCounter.IsDone());
+	jobSystem.ExecuteMainThreadJobs();
+	assert(16U == mainThreadExecutedCount.load() && mainThreadCounter.IsDone());
+
+	printf("\n[Success] Test_MainThreadJobs\n");
+}
+
+void Test_BackgroundJobs()
+{
+	JobSystem jobSystem(2);
+
+	// A long background job holds one worker. Frame jobs still finish and Wait in main thread never picks it up.
+	const std::thread::id mainThreadID = std::this_thread::get_id();
+	std::atomic<bool> isReleased = false;
+	std::atomic<bool> isExecutedInMainThread = false;
+	JobCounter backgroundCounter;
+	jobSystem.SubmitBackground([&isReleased, &isExecutedInMainThread, mainThreadID]()
+	{
+		isExecutedInMainThread.store(std::this_thread::get_id() == mainThreadID);
+		while (!isReleased.load())
+		{
+			std::this_thread::yield();
+		}
+	}, &backgroundCounter);
+
+	std::atomic<uint32_t> executedCount = 0U;
+	JobCounter counter;
+	for (uint32_t jobIndex = 0U; jobIndex < 1000U; ++jobIndex)
+	{
+		jobSystem.Submit([&executedCount]() { executedCount.fetch_add(1U); }, &counter);
+	}
+	jobSystem.Wait(counter);
+	assert(1000U == executedCount.load() && !backgroundCounter.IsDone());
+
+	isReleased.store(true);
+	while (!backgroundCounter.IsDone())
+	{
+		std::this_thread::yield();
+	}
+	assert(!isExecutedInMainThread.load());
+
+	printf("\n[Success] Test_BackgroundJobs\n");
+}
+
+// Measure the cost to submit, schedule and finish an empty job.
+void Test_SchedulingOverhead()
+{
+	JobSystem jobSystem;
+	printf("\nJobSystem worker count : %u\n", jobSystem.GetWorkerCount());
+
+	constexpr uint32_t jobCount = 200000;
+	for (int round = 0; round < 3; ++round)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		JobCounter counter;
+		for (uint32_t jobIndex = 0U; jobIndex < jobCount; ++jobIndex)
+		{
+			jobSystem.Submit([]() {}, &counter);
+		}
+		jobSystem.Wait(counter);
+		double costTime = GetElapsedMilliseconds(startTime);
+		printf("Submit %u empty jobs from main thread : %.3f ms, %.1f ns per job\n", jobCount, costTime, costTime * 1000000.0 / jobCount);
+	}
+
+	for (int round = 0; round < 3; ++round)
+	{
+		std::atomic<uint32_t> checkSum = 0U;
+		auto startTime = std::chrono::steady_clock::now();
+		jobSystem.ParallelFor(jobCount, 1U, [&checkSum](uint32_t begin, uint32_t) { checkSum.fetch_add(begin, std::memory_order_relaxed); });
+		double costTime = GetElapsedMilliseconds(startTime);
+		printf("ParallelFor %u ranges of grain size 1 : %.3f ms, %.1f ns per range\n", jobCount, costTime, costTime * 1000000.0 / jobCount);
+	}
+
+	printf("\n[Success] Test_SchedulingOverhead\n");
+}
+
+// Run the same ALU bound ParallelFor from 1 to N threads. The caller thread always joins so N threads means N - 1 workers.
+void Test_Scaling()
+{
+	const uint32_t hardwareThreadCount = std::max(std::thread::hardware_concurrency(), 1U);
+
+	constexpr uint32_t elementCount = 1 << 22;
+	std::vector<float> results(elementCount);
+	auto Work = [&results](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t index = begin; index < end; ++index)
+		{
+			float value = static_cast<float>(index);
+			for (int iteration = 0; iteration < 16; ++iteration)
+			{
+				value = std::sqrt(value + 1.0f) * 1.5f;
+			}
+			results[index] = value;
+		}
+	};
+
+	// 1, 2, 4, ... and hardware thread count.
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threadCount = 1U; threadCount < hardwareThreadCount; threadCount *= 2U)
+	{
+		threadCounts.push_back(threadCount);
+	}
+	threadCounts.push_back(hardwareThreadCount);
+
+	double singleThreadTime = 0.0;
+	for (uint32_t threadCount : threadCounts)
+	{
+		double costTime = 0.0;
+		if (1U == threadCount)
+		{
+			auto startTime = std::chrono::steady_clock::now();
+			Work(0U, elementCount);
+			costTime = GetElapsedMilliseconds(startTime);
+			singleThreadTime = costTime;
+		}
+		else
+		{
+			JobSystem jobSystem(threadCount - 1U);
+			auto startTime = std::chrono::steady_clock::now();
+			jobSystem.ParallelFor(elementCount, 4096U, Work);
+			costTime = GetElapsedMilliseconds(startTime);
+		}
+
+		printf("ParallelFor %u elements on %u threads : %.3f ms, speedup %.2fx\n", elementCount, threadCount, costTime, singleThreadTime / costTime);
+	}
+
+	printf("\n[Success] Test_Scaling\n");
+}
+
+}
+
+int main()
+{
+	Test_SubmitAndWait();
+	Test_Dependencies();
+	Test_ParallelFor();
+	Test_MainThreadJobs();
+	Test_BackgroundJobs();
+	Test_SchedulingOverhead();
+	Test_Scaling();
+
+	return 0;
+}
\ No newline at end of file
@@ -1,8 +1,22 @@
 // Test functions are generated by GPT 3.5.
 
+#include <algorithm>
 #include <cassert>
-
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Core/Math/FrustumCulling.h"
+#include "Core/Math/HiZPyramid.h"
+#include "Core/Math/MeshOptimizer.h"
+#include "Core/Math/MeshSimplifier.h"
+#include "Core/Math/OcclusionRasterizer.h"
+#include "Core/Math/TransformBatch.h"
 #include "Math/Quaternion.hpp"
+#include "Math/Transform.hpp"
+#include "Utilities/PerformanceProfiler.h"
 
 void TestVector()
 {
@@ -309,10 +323,597 @@ void TestQuaternion()
 	//}
 }
 
+std::vector<cd::Transform> CreateRandomTransforms(uint32_t count)
+{
+	std::mt19937 randomEngine(count);
+	std::uniform_real_distribution<float> positionDistribution(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> axisDistribution(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> angleDistribution(-3.1415926f, 3.1415926f);
+	std::uniform_real_distribution<float> scaleDistribution(0.1f, 10.0f);
+
+	std::vector<cd::Transform> transforms;
+	transforms.reserve(count);
+	for (uint32_t index = 0; index < count; ++index)
+	{
+		float axisX = axisDistribution(randomEngine);
+		float axisY = axisDistribution(randomEngine);
+		float axisZ = axisDistribution(randomEngine) + 2.0f;
+		float axisLength = std::sqrt(axisX * axisX + axisY * axisY + axisZ * axisZ);
+		cd::Vec3f axis(axisX / axisLength, axisY / axisLength, axisZ / axisLength);
+		cd::Vec3f translation(positionDistribution(randomEngine), positionDistribution(randomEngine), positionDistribution(randomEngine));
+		cd::Vec3f scale(scaleDistribution(randomEngine), scaleDistribution(randomEngine), scaleDistribution(randomEngine));
+		transforms.emplace_back(translation, cd::Quaternion::FromAxisAngle(axis, angleDistribution(randomEngine)), scale);
+	}
+
+	return transforms;
+}
+
+void TestTransformBatch()
+{
+	printf("Best SIMD path : %s\n", engine::GetSIMDPathName(engine::GetBestSIMDPath()));
+
+	// Odd count so that SIMD paths have remaining transforms to process in scalar.
+	constexpr uint32_t transformCount = 1003;
+	std::vector<cd::Transform> transforms = CreateRandomTransforms(transformCount);
+	engine::TransformBatch transformBatch;
+	transformBatch.Reserve(transformCount);
+	for (const cd::Transform& transform : transforms)
+	{
+		transformBatch.Add(transform);
+	}
+	assert(transformCount == transformBatch.GetCount());
+
+	for (engine::SIMDPath path : { engine::SIMDPath::Scalar, engine::SIMDPath::SSE, engine::SIMDPath::AVX2 })
+	{
+		std::vector<cd::Matrix4x4> matrices(transformCount);
+		transformBatch.BuildMatrices(matrices.data(), path);
+		for (uint32_t index = 0; index < transformCount; ++index)
+		{
+			cd::Matrix4x4 expectedMatrix = transforms[index].GetMatrix();
+			for (int elementIndex = 0; elementIndex < 16; ++elementIndex)
+			{
+				float expected = expectedMatrix.Begin()[elementIndex];
+				float actual = matrices[index].Begin()[elementIndex];
+				assert(std::fabs(expected - actual) <= 1e-4f * std::fmax(1.0f, std::fabs(expected)));
+			}
+		}
+	}
+
+	transformBatch.Clear();
+	assert(0 == transformBatch.GetCount());
+}
+
+void BenchmarkTransformBatch()
+{
+	for (uint32_t transformCount : { 10000, 100000, 1000000 })
+	{
+		std::vector<cd::Transform> transforms = CreateRandomTransforms(transformCount);
+		std::vector<cd::Matrix4x4> matrices(transformCount);
+
+		std::string countName = std::to_string(transformCount);
+		{
+			std::string profileName = "cd::Transform::GetMatrix x " + countName;
+			cdtools::PerformanceProfiler perf(profileName.c_str());
+			for (uint32_t index = 0; index < transformCount; ++index)
+			{
+				matrices[index] = transforms[index].GetMatrix();
+			}
+		}
+
+		engine::TransformBatch transformBatch;
+		transformBatch.Reserve(transformCount);
+		for (const cd::Transform& transform : transforms)
+		{
+			transformBatch.Add(transform);
+		}
+
+		for (engine::SIMDPath path : { engine::SIMDPath::Scalar, engine::SIMDPath::SSE, engine::SIMDPath::AVX2 })
+		{
+			std::string profileName = std::string("TransformBatch ") + engine::GetSIMDPathName(path) + " x " + countName;
+			cdtools::PerformanceProfiler perf(profileName.c_str());
+			transformBatch.BuildMatrices(matrices.data(), path);
+		}
+	}
+}
+
+// Left handed perspective camera at eye which looks at +Z.
+cd::Matrix4x4 CreateViewProjection(const cd::Vec3f& eye, float nearPlane, float farPlane, bool homogeneousDepth)
+{
+	constexpr float aspect = 16.0f / 9.0f;
+	constexpr float tanHalfFov = 0.5f;
+
+	cd::Matrix4x4 projection;
+	projection.Clear();
+	float* pProjection = projection.Begin();
+	pProjection[0] = 1.0f / (tanHalfFov * aspect);
+	pProjection[5] = 1.0f / tanHalfFov;
+	pProjection[10] = homogeneousDepth ? (farPlane + nearPlane) / (farPlane - nearPlane) : farPlane / (farPlane - nearPlane);
+	pProjection[11] = 1.0f;
+	pProjection[14] = homogeneousDepth ? -2.0f * farPlane * nearPlane / (farPlane - nearPlane) : -nearPlane * farPlane / (farPlane - nearPlane);
+
+	cd::Matrix4x4 view = cd::Matrix4x4::Identity();
+	float* pView = view.Begin();
+	pView[12] = -eye.x();
+	pView[13] = -eye.y();
+	pView[14] = -eye.z();
+
+	return projection * view;
+}
+
+void TestFrustumCulling()
+{
+	for (bool homogeneousDepth : { false, true })
+	{
+		engine::Frustum frustum;
+		frustum.Build(CreateViewProjection(cd::Vec3f(0.0f, 0.0f, 0.0f), 0.1f, 100.0f, homogeneousDepth), homogeneousDepth);
+
+		// Planes face inside.
+		const cd::Vec4f& nearPlane = frustum.GetPlane(engine::FrustumPlane::Near);
+		assert(nearPlane.z() > 0.99f && std::fabs(nearPlane.w() + 0.1f) < 1e-3f);
+		const cd::Vec4f& farPlane = frustum.GetPlane(engine::FrustumPlane::Far);
+		assert(farPlane.z() < -0.99f && std::fabs(farPlane.w() - 100.0f) < 1e-2f);
+
+		const cd::Vec3f unitExtents(1.0f, 1.0f, 1.0f);
+		assert(frustum.Intersects(cd::Vec3f(0.0f, 0.0f, 10.0f), unitExtents));
+		assert(!frustum.Intersects(cd::Vec3f(0.0f, 0.0f, -10.0f), unitExtents));
+		assert(!frustum.Intersects(cd::Vec3f(0.0f, 0.0f, 200.0f), unitExtents));
+		assert(!frustum.Intersects(cd::Vec3f(100.0f, 0.0f, 10.0f), unitExtents));
+		assert(!frustum.Intersects(cd::Vec3f(0.0f, -100.0f, 10.0f), unitExtents));
+
+		// Boxes across planes are visible.
+		assert(frustum.Intersects(cd::Vec3f(0.0f, 0.0f, 0.0f), unitExtents));
+		assert(frustum.Intersects(cd::Vec3f(0.0f, 0.0f, 100.5f), unitExtents));
+		assert(frustum.Intersects(cd::Vec3f(18.0f, 0.0f, 20.0f), unitExtents));
+	}
+
+	// Random boxes which are transformed by random matrices. All paths should have the same results as testing 8 corners' bounds.
+	constexpr uint32_t boxCount = 1003;
+	engine::Frustum frustum;
+	frustum.Build(CreateViewProjection(cd::Vec3f(0.0f, 0.0f, -20.0f), 0.1f, 60.0f, false), false);
+	std::vector<cd::Transform> transforms = CreateRandomTransforms(boxCount);
+	std::vector<uint8_t> expectedVisibilities(boxCount);
+	uint32_t expectedVisibleCount = 0;
+	engine::FrustumCullingBatch cullingBatch;
+	cullingBatch.Reserve(boxCount);
+	for (uint32_t index = 0; index < boxCount; ++index)
+	{
+		cd::Vec3f localMin(-1.0f, -0.5f, -2.0f);
+		cd::Vec3f localMax(1.0f, 1.5f, 0.0f);
+		cd::Matrix4x4 worldMatrix = transforms[index].GetMatrix();
+		cullingBatch.Add(worldMatrix, localMin, localMax);
+
+		const float* pMatrix = worldMatrix.Begin();
+		float worldMin[3] = { INFINITY, INFINITY, INFINITY };
+		float worldMax[3] = { -INFINITY, -INFINITY, -INFINITY };
+		for (uint32_t cornerIndex = 0; cornerIndex < 8; ++cornerIndex)
+		{
+			float corner[3] = { cornerIndex & 1 ? localMax.x() : localMin.x(), cornerIndex & 2 ? localMax.y() : localMin.y(), cornerIndex & 4 ? localMax.z() : localMin.z() };
+			for (uint32_t rowIndex = 0; rowIndex < 3; ++rowIndex)
+			{
+				float value = pMatrix[rowIndex] * corner[0] + pMatrix[4 + rowIndex] * corner[1] + pMatrix[8 + rowIndex] * corner[2] + pMatrix[12 + rowIndex];
+				worldMin[rowIndex] = std::fmin(worldMin[rowIndex], value);
+				worldMax[rowIndex] = std::fmax(worldMax[rowIndex], value);
+			}
+		}
+
+		cd::Vec3f center((worldMin[0] + worldMax[0]) * 0.5f, (worldMin[1] + worldMax[1]) * 0.5f, (worldMin[2] + worldMax[2]) * 0.5f);
+		cd::Vec3f extents((worldMax[0] - worldMin[0]) * 0.5f, (worldMax[1] - worldMin[1]) * 0.5f, (worldMax[2] - worldMin[2]) * 0.5f);
+		expectedVisibilities[index] = frustum.Intersects(center, extents) ? 1 : 0;
+		expectedVisibleCount += expectedVisibilities[index];
+	}
+	assert(boxCount == cullingBatch.GetCount());
+	assert(expectedVisibleCount > 0 && expectedVisibleCount < boxCount);
+
+	for (engine::SIMDPath path : { engine::SIMDPath::Scalar, engine::SIMDPath::SSE, engine::SIMDPath::AVX2 })
+	{
+		std::vector<uint8_t> visibilities(boxCount, 2);
+		uint32_t visibleCount = cullingBatch.Cull(frustum, visibilities.data(), path);
+		assert(expectedVisibleCount == visibleCount);
+		assert(expectedVisibilities == visibilities);
+	}
+
+	cullingBatch.Clear();
+	assert(0 == cullingBatch.GetCount());
+}
+
+void TestHiZPyramid()
+{
+	constexpr uint32_t width = 64;
+	constexpr uint32_t height = 36;
+	for (bool homogeneousDepth : { false, true })
+	{
+		for (bool originBottomLeft : { false, true })
+		{
+			cd::Matrix4x4 viewProjection = CreateViewProjection(cd::Vec3f(0.0f, 0.0f, 0.0f), 0.1f, 100.0f, homogeneousDepth);
+			const float* pMatrix = viewProjection.Begin();
+			float wallNDCDepth = (pMatrix[10] * 10.0f + pMatrix[14]) / 10.0f;
+			float wallDepth = homogeneousDepth ? wallNDCDepth * 0.5f + 0.5f : wallNDCDepth;
+
+			// A wall at z = 10 covers NDC x in [-0.5, 0.5] and y in [0, 0.9]. Other texels are cleared to the far plane.
+			std::vector<float> depths(width * height);
+			for (uint32_t row = 0; row < height; ++row)
+			{
+				float ndcY = (static_cast<float>(row) + 0.5f) / height * 2.0f - 1.0f;
+				ndcY = originBottomLeft ? ndcY : -ndcY;
+				for (uint32_t column = 0; column < width; ++column)
+				{
+					float ndcX = (static_cast<float>(column) + 0.5f) / width * 2.0f - 1.0f;
+					bool isWall = ndcX >= -0.5f && ndcX <= 0.5f && ndcY >= 0.0f && ndcY <= 0.9f;
+					depths[row * width + column] = isWall ? wallDepth : 1.0f;
+				}
+			}
+
+			engine::HiZPyramid hiZPyramid;
+			assert(!hiZPyramid.IsValid());
+			assert(!hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 4.0f, 20.0f), cd::Vec3f(1.0f, 1.0f, 1.0f)));
+
+			hiZPyramid.Build(depths.data(), width, height, viewProjection, homogeneousDepth, originBottomLeft);
+			assert(7 == hiZPyramid.GetMipCount());
+			assert(8 == hiZPyramid.GetMipWidth(3) && 5 == hiZPyramid.GetMipHeight(3));
+			assert(1 == hiZPyramid.GetMipWidth(6) && 1 == hiZPyramid.GetMipHeight(6));
+			assert(1.0f == hiZPyramid.GetDepth(6, 0, 0));
+			for (uint32_t row = 0; row < hiZPyramid.GetMipHeight(1); ++row)
+			{
+				for (uint32_t column = 0; column < hiZPyramid.GetMipWidth(1); ++column)
+				{
+					float maxDepth = std::fmax(std::fmax(depths[row * 2 * width + column * 2], depths[row * 2 * width + column * 2 + 1]),
+						std::fmax(depths[(row * 2 + 1) * width + column * 2], depths[(row * 2 + 1) * width + column * 2 + 1]));
+					assert(maxDepth == hiZPyramid.GetDepth(1, column, row));
+				}
+			}
+
+			// Boxes behind the wall are occluded. Boxes in front of it, beside it or across its edges are not.
+			const cd::Vec3f unitExtents(1.0f, 1.0f, 1.0f);
+			assert(hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 4.0f, 20.0f), unitExtents));
+			assert(hiZPyramid.IsOccluded(cd::Vec3f(-3.0f, 3.0f, 50.0f), cd::Vec3f(2.0f, 1.0f, 5.0f)));
+			assert(!hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 1.0f, 5.0f), cd::Vec3f(0.5f, 0.5f, 0.5f)));
+			assert(!hiZPyramid.IsOccluded(cd::Vec3f(0.0f, -4.0f, 20.0f), unitExtents));
+			assert(!hiZPyramid.IsOccluded(cd::Vec3f(8.9f, 4.0f, 20.0f), unitExtents));
+			assert(!hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 4.0f, 10.0f), unitExtents));
+
+			// Boxes across the camera plane or outside of the screen are left to frustum culling.
+			assert(!hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 0.0f, 0.0f), unitExtents));
+			assert(!hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 4.0f, -20.0f), unitExtents));
+			assert(!hiZPyramid.IsOccluded(cd::Vec3f(100.0f, 4.0f, 20.0f), unitExtents));
+
+			// Large boxes are tested in coarse mips.
+			std::fill(depths.begin(), depths.end(), wallDepth);
+			hiZPyramid.Build(depths.data(), width, height, viewProjection, homogeneousDepth, originBottomLeft);
+			assert(hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 0.0f, 40.0f), cd::Vec3f(15.0f, 10.0f, 1.0f)));
+
+			hiZPyramid.Reset();
+			assert(!hiZPyramid.IsValid());
+			assert(!hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 0.0f, 40.0f), cd::Vec3f(15.0f, 10.0f, 1.0f)));
+		}
+	}
+}
+
+void TestOcclusionRasterizer()
+{
+	constexpr uint32_t width = 64;
+	constexpr uint32_t height = 36;
+
+	// A wall at z = 10 covers x in [-5, 5] and y in [-3, 3], which is NDC x in [-0.5625, 0.5625] and y in [-0.6, 0.6].
+	// Its triangles have different windings.
+	const cd::Vec3f positions[] = {
+		cd::Vec3f(-5.0f, -3.0f, 10.0f), cd::Vec3f(5.0f, -3.0f, 10.0f), cd::Vec3f(5.0f, 3.0f, 10.0f), cd::Vec3f(-5.0f, 3.0f, 10.0f),
+		cd::Vec3f(0.0f, 0.0f, -1.0f), cd::Vec3f(1.0f, 0.0f, 5.0f), cd::Vec3f(0.0f, 1.0f, 5.0f),
+		cd::Vec3f(100.0f, 0.0f, 10.0f), cd::Vec3f(101.0f, 0.0f, 10.0f), cd::Vec3f(100.0f, 1.0f, 10.0f),
+	};
+	const uint32_t indices[] = { 0, 1, 2, 0, 3, 2, 4, 5, 6, 7, 8, 9 };
+
+	for (bool homogeneousDepth : { false, true })
+	{
+		cd::Matrix4x4 viewProjection = CreateViewProjection(cd::Vec3f(0.0f, 0.0f, 0.0f), 0.1f, 100.0f, homogeneousDepth);
+		const float* pMatrix = viewProjection.Begin();
+		float wallNDCDepth = (pMatrix[10] * 10.0f + pMatrix[14]) / 10.0f;
+		float wallDepth = homogeneousDepth ? wallNDCDepth * 0.5f + 0.5f : wallNDCDepth;
+
+		// Triangles across the near plane or outside of the screen are skipped.
+		engine::OcclusionRasterizer rasterizer;
+		rasterizer.Begin(width, height, viewProjection, homogeneousDepth);
+		rasterizer.AddOccluder(cd::Matrix4x4::Identity(), positions, 10, indices, 12);
+		assert(2 == rasterizer.GetTriangleCount());
+		assert(5 == rasterizer.GetBandCount());
+
+		rasterizer.RasterizeBands(0, rasterizer.GetBandCount(), engine::SIMDPath::Scalar);
+		const std::vector<float> scalarDepths = rasterizer.GetDepths();
+		for (uint32_t row = 0; row < height; ++row)
+		{
+			for (uint32_t column = 0; column < width; ++column)
+			{
+				// Pixel centers inside the wall have its depth without cracks on the shared edge. Others are cleared to the far plane.
+				float ndcX = (static_cast<float>(column) + 0.5f) / width * 2.0f - 1.0f;
+				float ndcY = 1.0f - (static_cast<float>(row) + 0.5f) / height * 2.0f;
+				bool isWall = std::fabs(ndcX) < 0.5625f && std::fabs(ndcY) < 0.6f;
+				float depth = rasterizer.GetDepth(column, row);
+				assert(isWall ? std::fabs(depth - wallDepth) < 1e-5f : 1.0f == depth);
+			}
+		}
+
+		// SIMD paths and bands rasterized separately in any order have the same depths.
+		for (engine::SIMDPath path : { engine::SIMDPath::SSE, engine::SIMDPath::AVX2 })
+		{
+			for (uint32_t bandIndex = rasterizer.GetBandCount(); bandIndex > 0; --bandIndex)
+			{
+				rasterizer.RasterizeBands(bandIndex - 1, bandIndex, path);
+			}
+			for (uint32_t index = 0; index < width * height; ++index)
+			{
+				assert(std::fabs(scalarDepths[index] - rasterizer.GetDepths()[index]) < 1e-6f);
+			}
+		}
+
+		// Occludees are tested in the same frame as occluders are rasterized.
+		engine::HiZPyramid hiZPyramid;
+		rasterizer.BuildHiZPyramid(hiZPyramid);
+		assert(hiZPyramid.IsValid() && width == hiZPyramid.GetMipWidth(0) && height == hiZPyramid.GetMipHeight(0));
+		const cd::Vec3f unitExtents(1.0f, 1.0f, 1.0f);
+		assert(hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 0.0f, 30.0f), unitExtents));
+		assert(hiZPyramid.IsOccluded(cd::Vec3f(2.0f, -1.0f, 60.0f), cd::Vec3f(3.0f, 2.0f, 10.0f)));
+		assert(!hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 0.0f, 5.0f), cd::Vec3f(0.5f, 0.5f, 0.5f)));
+		assert(!hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 0.0f, 10.0f), unitExtents));
+		assert(!hiZPyramid.IsOccluded(cd::Vec3f(25.0f, 0.0f, 30.0f), unitExtents));
+
+		// World matrices move occluders.
+		cd::Matrix4x4 worldMatrix = cd::Matrix4x4::Identity();
+		worldMatrix.Begin()[12] = 40.0f;
+		rasterizer.Begin(width, height, viewProjection, homogeneousDepth);
+		rasterizer.AddOccluder(worldMatrix, positions, 4, indices, 6);
+		rasterizer.RasterizeBands(0, rasterizer.GetBandCount());
+		rasterizer.BuildHiZPyramid(hiZPyramid);
+		assert(1.0f == rasterizer.GetDepth(width / 2, height / 2));
+		assert(!hiZPyramid.IsOccluded(cd::Vec3f(0.0f, 0.0f, 30.0f), unitExtents));
+	}
+}
+
+// A size x size grid on XZ plane whose heights are bumpHeight * sin(x / 2) * cos(z / 2).
+// Left and right halves have their own vertices in the middle column, which is an attribute seam.
+void CreateGridMesh(uint32_t size, float bumpHeight, std::vector<cd::Vec3f>& outPositions, std::vector<uint32_t>& outIndices)
+{
+	const uint32_t middle = size / 2;
+	for (uint32_t half = 0; half < 2; ++half)
+	{
+		const uint32_t beginColumn = 0 == half ? 0 : middle;
+		const uint32_t endColumn = 0 == half ? middle : size;
+		const uint32_t firstVertex = static_cast<uint32_t>(outPositions.size());
+		const uint32_t columnCount = endColumn - beginColumn + 1;
+		for (uint32_t row = 0; row <= size; ++row)
+		{
+			for (uint32_t column = beginColumn; column <= endColumn; ++column)
+			{
+				float x = static_cast<float>(column);
+				float z = static_cast<float>(row);
+				outPositions.push_back(cd::Vec3f(x, bumpHeight * std::sin(x * 0.5f) * std::cos(z * 0.5f), z));
+			}
+		}
+
+		for (uint32_t row = 0; row < size; ++row)
+		{
+			for (uint32_t column = 0; column + 1 < columnCount; ++column)
+			{
+				uint32_t v0 = firstVertex + row * columnCount + column;
+				uint32_t v1 = v0 + columnCount;
+				outIndices.insert(outIndices.end(), { v0, v1, v0 + 1, v0 + 1, v1, v1 + 1 });
+			}
+		}
+	}
+}
+
+void TestMeshSimplifier()
+{
+	constexpr uint32_t size = 32;
+	const auto getNormalY = [](const std::vector<cd::Vec3f>& positions, const uint32_t* pTriangle)
+	{
+		const cd::Vec3f& a = positions[pTriangle[0]];
+		const cd::Vec3f& b = positions[pTriangle[1]];
+		const cd::Vec3f& c = positions[pTriangle[2]];
+		return (c.x() - a.x()) * (b.z() - a.z()) - (c.z() - a.z()) * (b.x() - a.x());
+	};
+
+	// A flat grid loses inner vertices for free. Borders and the seam are kept so that the area is the same and nothing flips.
+	std::vector<cd::Vec3f> flatPositions;
+	std::vector<uint32_t> flatIndices;
+	CreateGridMesh(size, 0.0f, flatPositions, flatIndices);
+	const uint32_t flatVertexCount = static_cast<uint32_t>(flatPositions.size());
+	const uint32_t flatIndexCount = static_cast<uint32_t>(flatIndices.size());
+
+	std::vector<uint32_t> simplifiedIndices;
+	float error = engine::MeshSimplifier::Simplify(flatPositions.data(), flatVertexCount, flatIndices.data(), flatIndexCount, 0, 1e-4f, simplifiedIndices);
+	assert(error < 1e-5f);
+	assert(simplifiedIndices.size() % 3 == 0 && simplifiedIndices.size() * 4 < flatIndices.size());
+
+	double area = 0.0;
+	std::vector<bool> isUsed(flatVertexCount, false);
+	for (size_t index = 0; index < simplifiedIndices.size(); index += 3)
+	{
+		float normalY = getNormalY(flatPositions, &simplifiedIndices[index]);
+		assert(normalY > 0.0f);
+		area += normalY * 0.5;
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			assert(simplifiedIndices[index + corner] < flatVertexCount);
+			isUsed[simplifiedIndices[index + corner]] = true;
+		}
+	}
+	assert(std::fabs(area - size * size) < 1e-3);
+	for (uint32_t vertexIndex = 0; vertexIndex < flatVertexCount; ++vertexIndex)
+	{
+		const cd::Vec3f& position = flatPositions[vertexIndex];
+		bool isBorder = 0.0f == position.x() || 0.0f == position.z() || size == position.x() || size == position.z();
+		bool isSeam = size / 2 == position.x();
+		assert(!(isBorder || isSeam) || isUsed[vertexIndex]);
+	}
+
+	// The same input always has the same output.
+	std::vector<uint32_t> repeatedIndices;
+	engine::MeshSimplifier::Simplify(flatPositions.data(), flatVertexCount, flatIndices.data(), flatIndexCount, 0, 1e-4f, repeatedIndices);
+	assert(repeatedIndices == simplifiedIndices);
+
+	// Bumps stop simplification at the target error or the target count.
+	std::vector<cd::Vec3f> bumpyPositions;
+	std::vector<uint32_t> bumpyIndices;
+	CreateGridMesh(size, 1.0f, bumpyPositions, bumpyIndices);
+	const uint32_t bumpyVertexCount = static_cast<uint32_t>(bumpyPositions.size());
+	const uint32_t bumpyIndexCount = static_cast<uint32_t>(bumpyIndices.size());
+
+	error = engine::MeshSimplifier::Simplify(bumpyPositions.data(), bumpyVertexCount, bumpyIndices.data(), bumpyIndexCount, 0, 0.05f, simplifiedIndices);
+	assert(error > 0.0f && error <= 0.05f);
+	assert(simplifiedIndices.size() < bumpyIndices.size());
+	const size_t smallErrorIndexCount = simplifiedIndices.size();
+
+	error = engine::MeshSimplifier::Simplify(bumpyPositions.data(), bumpyVertexCount, bumpyIndices.data(), bumpyIndexCount, bumpyIndexCount / 2, 10.0f, simplifiedIndices);
+	assert(simplifiedIndices.size() <= bumpyIndexCount / 2 && simplifiedIndices.size() + 30 > bumpyIndexCount / 2);
+	assert(error <= 10.0f);
+
+	error = engine::MeshSimplifier::Simplify(bumpyPositions.data(), bumpyVertexCount, bumpyIndices.data(), bumpyIndexCount, 0, 0.5f, simplifiedIndices);
+	assert(error <= 0.5f && simplifiedIndices.size() < smallErrorIndexCount);
+
+	// LODs get fewer triangles and larger errors in the limits of settings.
+	engine::MeshLODSettings settings;
+	std::vector<engine::MeshLOD> lods = engine::MeshSimplifier::BuildLODs(bumpyPositions.data(), bumpyVertexCount, bumpyIndices.data(), bumpyIndexCount, settings);
+	assert(settings.lodCount - 1 == lods.size());
+	const float meshSize = std::sqrt(2.0f * size * size + 4.0f);
+	size_t previousIndexCount = bumpyIndices.size();
+	float previousError = 0.0f;
+	for (size_t lod = 0; lod < lods.size(); ++lod)
+	{
+		assert(!lods[lod].indices.empty() && lods[lod].indices.size() < previousIndexCount);
+		assert(lods[lod].indices.size() >= static_cast<size_t>(bumpyIndexCount / 3 * settings.targetRatios[lod]) * 3);
+		assert(lods[lod].error >= previousError && lods[lod].error <= settings.targetErrors[lod] * meshSize);
+		previousIndexCount = lods[lod].indices.size();
+		previousError = lods[lod].error;
+	}
+
+	// A flat level which can't drop enough triangles ends the chain.
+	settings.targetErrors[0] = 0.0f;
+	lods = engine::MeshSimplifier::BuildLODs(bumpyPositions.data(), bumpyVertexCount, bumpyIndices.data(), bumpyIndexCount, settings);
+	assert(lods.empty());
+}
+
+void TestMeshOptimizer()
+{
+	std::vector<cd::Vec3f> positions;
+	std::vector<uint32_t> indices;
+	CreateGridMesh(64, 1.0f, positions, indices);
+	const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+	const uint32_t indexCount = static_cast<uint32_t>(indices.size());
+
+	// Triangles of imported meshes are often in an order which doesn't care about caches.
+	std::vector<uint32_t> triangleOrder(indexCount / 3);
+	for (uint32_t triangleIndex = 0; triangleIndex < triangleOrder.size(); ++triangleIndex)
+	{
+		triangleOrder[triangleIndex] = triangleIndex;
+	}
+	std::shuffle(triangleOrder.begin(), triangleOrder.end(), std::mt19937(indexCount));
+	std::vector<uint32_t> shuffledIndices;
+	for (uint32_t triangleIndex : triangleOrder)
+	{
+		shuffledIndices.insert(shuffledIndices.end(), indices.begin() + triangleIndex * 3, indices.begin() + triangleIndex * 3 + 3);
+	}
+
+	// Triangles are rotated to start from their smallest indexes so that windings are compared.
+	const auto getSortedTriangles = [](const std::vector<uint32_t>& triangleIndices)
+	{
+		std::vector<std::vector<uint32_t>> triangles;
+		for (size_t index = 0; index < triangleIndices.size(); index += 3)
+		{
+			std::vector<uint32_t> triangle(triangleIndices.begin() + index, triangleIndices.begin() + index + 3);
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+	const auto sourceTriangles = getSortedTriangles(shuffledIndices);
+
+	const float sourceACMR = engine::MeshOptimizer::GetACMR(shuffledIndices.data(), indexCount, vertexCount);
+	const float sourceATVR = engine::MeshOptimizer::GetATVR(shuffledIndices.data(), indexCount, vertexCount);
+	assert(sourceACMR > 2.0f && sourceATVR > 4.0f);
+
+	std::vector<uint32_t> optimizedIndices = shuffledIndices;
+	engine::MeshOptimizer::OptimizeVertexCache(optimizedIndices.data(), indexCount, vertexCount);
+	const float cacheACMR = engine::MeshOptimizer::GetACMR(optimizedIndices.data(), indexCount, vertexCount);
+	const float cacheATVR = engine::MeshOptimizer::GetATVR(optimizedIndices.data(), indexCount, vertexCount);
+	assert(getSortedTriangles(optimizedIndices) == sourceTriangles);
+	assert(cacheACMR < 0.8f && cacheATVR < 1.6f);
+
+	// Sorting clusters for overdraw costs a little vertex cache efficiency.
+	engine::MeshOptimizer::OptimizeOverdraw(optimizedIndices.data(), indexCount, positions.data(), vertexCount);
+	const float overdrawACMR = engine::MeshOptimizer::GetACMR(optimizedIndices.data(), indexCount, vertexCount);
+	const float overdrawATVR = engine::MeshOptimizer::GetATVR(optimizedIndices.data(), indexCount, vertexCount);
+	assert(getSortedTriangles(optimizedIndices) == sourceTriangles);
+	assert(overdrawACMR < cacheACMR * 1.1f);
+
+	// Vertices are renumbered in the order of first uses. The cache behaves the same.
+	std::vector<uint32_t> fetchIndices = optimizedIndices;
+	std::vector<uint32_t> remap;
+	engine::MeshOptimizer::OptimizeVertexFetch(fetchIndices.data(), indexCount, vertexCount, remap);
+	uint32_t nextVertex = 0;
+	for (uint32_t index = 0; index < indexCount; ++index)
+	{
+		assert(fetchIndices[index] == remap[optimizedIndices[index]] && fetchIndices[index] <= nextVertex);
+		nextVertex = std::max(nextVertex, fetchIndices[index] + 1);
+	}
+	std::vector<uint32_t> sortedRemap = remap;
+	std::sort(sortedRemap.begin(), sortedRemap.end());
+	for (uint32_t vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		assert(sortedRemap[vertexIndex] == vertexIndex);
+	}
+	assert(std::fabs(engine::MeshOptimizer::GetACMR(fetchIndices.data(), indexCount, vertexCount) - overdrawACMR) < 1e-6f);
+
+	printf("ACMR : %.3f -> vertex cache %.3f -> overdraw %.3f\n", sourceACMR, cacheACMR, overdrawACMR);
+	printf("ATVR : %.3f -> vertex cache %.3f -> overdraw %.3f\n", sourceATVR, cacheATVR, overdrawATVR);
+}
+
+void BenchmarkFrustumCulling()
+{
+	engine::Frustum frustum;
+	frustum.Build(CreateViewProjection(cd::Vec3f(0.0f, 0.0f, -20.0f), 0.1f, 60.0f, false), false);
+
+	for (uint32_t boxCount : { 10000, 100000, 1000000 })
+	{
+		std::vector<cd::Transform> transforms = CreateRandomTransforms(boxCount);
+		engine::FrustumCullingBatch cullingBatch;
+		cullingBatch.Reserve(boxCount);
+		for (const cd::Transform& transform : transforms)
+		{
+			cullingBatch.Add(transform.GetTranslation(), transform.GetScale());
+		}
+
+		std::vector<uint8_t> visibilities(boxCount);
+		std::string countName = std::to_string(boxCount);
+		{
+			std::string profileName = "Frustum::Intersects x " + countName;
+			cdtools::PerformanceProfiler perf(profileName.c_str());
+			for (uint32_t index = 0; index < boxCount; ++index)
+			{
+				visibilities[index] = frustum.Intersects(transforms[index].GetTranslation(), transforms[index].GetScale()) ? 1 : 0;
+			}
+		}
+
+		for (engine::SIMDPath path : { engine::SIMDPath::Scalar, engine::SIMDPath::SSE, engine::SIMDPath::AVX2 })
+		{
+			std::string profileName = std::string("FrustumCullingBatch ") + engine::GetSIMDPathName(path) + " x " + countName;
+			cdtools::PerformanceProfiler perf(profileName.c_str());
+			cullingBatch.Cull(frustum, visibilities.data(), path);
+		}
+	}
+}
+
 int main()
 {
 	TestVector();
 	TestQuaternion();
+	TestTransformBatch();
+	BenchmarkTransformBatch();
+	TestFrustumCulling();
+	BenchmarkFrustumCulling();
+	TestHiZPyramid();
+	TestOcclusionRasterizer();
+	TestMeshSimplifier();
+	TestMeshOptimizer();
 
 	return 0;
 }
\ No newline at end of file
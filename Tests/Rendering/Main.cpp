@@ -0,0 +1,980 @@
+#include "Core/Jobs/JobSystem.h"
+#include "Core/Math/FrustumCulling.h"
+#include "Core/Math/HiZPyramid.h"
+#include "Rendering/DrawList.h"
+#include "Rendering/FrameEncoders.h"
+#include "Rendering/GPUDrivenScene.h"
+#include "Rendering/Light.h"
+#include "Rendering/LightClusterGrid.h"
+#include "Rendering/LightUniforms.h"
+#include "U_GPUDriven.sh"
+#include "Utilities/PerformanceProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using namespace engine;
+
+void Test_DrawSortKey()
+{
+	// Depth quantization is monotonic.
+	assert(0U == DrawSortKey::QuantizeDepth(-1.0f));
+	assert(0U == DrawSortKey::QuantizeDepth(0.0f));
+	assert(DrawSortKey::QuantizeDepth(0.5f) < DrawSortKey::QuantizeDepth(1.0f));
+	assert(DrawSortKey::QuantizeDepth(1.0f) < DrawSortKey::QuantizeDepth(1000.0f));
+	assert(DrawSortKey::QuantizeDepth(1000.0f) <= DrawSortKey::MaxDepth);
+
+	// Buckets are ordered opaque, masked and blended regardless of other fields.
+	uint64_t opaqueKey = DrawSortKey::Build(DrawBucket::Opaque, UINT16_MAX, UINT16_MAX, 1.0e10f);
+	uint64_t maskedKey = DrawSortKey::Build(DrawBucket::Masked, 0U, 0U, 1.0e10f);
+	uint64_t blendedKey = DrawSortKey::Build(DrawBucket::Blended, 0U, 0U, 1.0e10f);
+	assert(opaqueKey < maskedKey && maskedKey < blendedKey);
+	assert(DrawBucket::Opaque == DrawSortKey::GetBucket(opaqueKey));
+	assert(DrawBucket::Masked == DrawSortKey::GetBucket(maskedKey));
+	assert(DrawBucket::Blended == DrawSortKey::GetBucket(blendedKey));
+
+	// Opaque draws are grouped by program, then textures and sorted front-to-back.
+	assert(DrawSortKey::Build(DrawBucket::Opaque, 1U, 9U, 100.0f) < DrawSortKey::Build(DrawBucket::Opaque, 2U, 0U, 1.0f));
+	assert(DrawSortKey::Build(DrawBucket::Opaque, 1U, 1U, 100.0f) < DrawSortKey::Build(DrawBucket::Opaque, 1U, 2U, 1.0f));
+	assert(DrawSortKey::Build(DrawBucket::Opaque, 1U, 1U, 1.0f) < DrawSortKey::Build(DrawBucket::Opaque, 1U, 1U, 2.0f));
+
+	// Masked and blended draws are sorted back-to-front at first.
+	for (DrawBucket bucket : { DrawBucket::Masked, DrawBucket::Blended })
+	{
+		assert(DrawSortKey::Build(bucket, 9U, 9U, 2.0f) < DrawSortKey::Build(bucket, 1U, 1U, 1.0f));
+		assert(DrawSortKey::Build(bucket, 1U, 9U, 1.0f) < DrawSortKey::Build(bucket, 2U, 1U, 1.0f));
+	}
+
+	// Texture sets with different orders of handles are different.
+	uint16_t textureSet1 = DrawSortKey::HashTextureHandle(DrawSortKey::HashTextureHandle(0U, 1U), 2U);
+	uint16_t textureSet2 = DrawSortKey::HashTextureHandle(DrawSortKey::HashTextureHandle(0U, 1U), 2U);
+	uint16_t textureSet3 = DrawSortKey::HashTextureHandle(DrawSortKey::HashTextureHandle(0U, 1U), 3U);
+	assert(textureSet1 == textureSet2 && textureSet1 != textureSet3);
+
+	printf("\n[Success] Test_DrawSortKey\n");
+}
+
+void CheckSorted(const DrawList& drawList, std::vector<DrawList::Item> expectedItems)
+{
+	std::stable_sort(expectedItems.begin(), expectedItems.end(), [](const DrawList::Item& lhs, const DrawList::Item& rhs)
+	{
+		return lhs.sortKey < rhs.sortKey;
+	});
+
+	assert(drawList.GetCount() == expectedItems.size());
+	for (uint32_t itemIndex = 0; itemIndex < drawList.GetCount(); ++itemIndex)
+	{
+		assert(drawList.GetItems()[itemIndex].sortKey == expectedItems[itemIndex].sortKey);
+		assert(drawList.GetItems()[itemIndex].index == expectedItems[itemIndex].index);
+	}
+}
+
+void Test_DrawList()
+{
+	std::mt19937 randomEngine(2023);
+	std::uniform_int_distribution<uint32_t> bucketDistribution(0U, 2U);
+	std::uniform_int_distribution<uint32_t> programDistribution(0U, 16U);
+	std::uniform_int_distribution<uint32_t> textureDistribution(0U, 64U);
+	std::uniform_real_distribution<float> depthDistribution(-10.0f, 1000.0f);
+
+	DrawList drawList;
+	drawList.Sort();
+	assert(0U == drawList.GetCount());
+
+	for (uint32_t drawCount : { 1U, 2U, 100U, 10000U })
+	{
+		drawList.Clear();
+		std::vector<DrawList::Item> expectedItems;
+		for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
+		{
+			uint64_t sortKey = DrawSortKey::Build(static_cast<DrawBucket>(bucketDistribution(randomEngine)),
+				static_cast<uint16_t>(programDistribution(randomEngine)),
+				static_cast<uint16_t>(textureDistribution(randomEngine)), depthDistribution(randomEngine));
+			drawList.Add(sortKey, drawIndex);
+			expectedItems.push_back(DrawList::Item{ sortKey, drawIndex });
+		}
+
+		drawList.Sort();
+		CheckSorted(drawList, expectedItems);
+	}
+
+	// Equal keys keep their orders.
+	drawList.Clear();
+	std::vector<DrawList::Item> expectedItems;
+	for (uint32_t drawIndex = 0; drawIndex < 1000U; ++drawIndex)
+	{
+		uint64_t sortKey = DrawSortKey::Build(DrawBucket::Opaque, static_cast<uint16_t>(drawIndex % 3), 0U, 1.0f);
+		drawList.Add(sortKey, drawIndex);
+		expectedItems.push_back(DrawList::Item{ sortKey, drawIndex });
+	}
+	drawList.Sort();
+	CheckSorted(drawList, expectedItems);
+
+	printf("\n[Success] Test_DrawList\n");
+}
+
+void Test_DrawListPerformance()
+{
+	std::mt19937 randomEngine(2023);
+	std::uniform_int_distribution<uint32_t> bucketDistribution(0U, 2U);
+	std::uniform_int_distribution<uint32_t> programDistribution(0U, 64U);
+	std::uniform_int_distribution<uint32_t> textureDistribution(0U, UINT16_MAX);
+	std::uniform_real_distribution<float> depthDistribution(0.1f, 1000.0f);
+
+	for (uint32_t drawCount : { 1000U, 10000U, 100000U })
+	{
+		std::vector<DrawList::Item> items;
+		for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
+		{
+			items.push_back(DrawList::Item{ DrawSortKey::Build(static_cast<DrawBucket>(bucketDistribution(randomEngine)),
+				static_cast<uint16_t>(programDistribution(randomEngine)),
+				static_cast<uint16_t>(textureDistribution(randomEngine)), depthDistribution(randomEngine)), drawIndex });
+		}
+
+		std::string countName = std::to_string(drawCount);
+		std::vector<DrawList::Item> stdItems = items;
+		{
+			std::string profileName = "std::sort x " + countName;
+			cdtools::PerformanceProfiler perf(profileName.c_str());
+			std::sort(stdItems.begin(), stdItems.end(), [](const DrawList::Item& lhs, const DrawList::Item& rhs)
+			{
+				return lhs.sortKey < rhs.sortKey;
+			});
+		}
+
+		DrawList drawList;
+		drawList.Reserve(drawCount);
+		for (const DrawList::Item& item : items)
+		{
+			drawList.Add(item.sortKey, item.index);
+		}
+
+		{
+			std::string profileName = "DrawList::Sort x " + countName;
+			cdtools::PerformanceProfiler perf(profileName.c_str());
+			drawList.Sort();
+		}
+		for (uint32_t itemIndex = 0; itemIndex < drawCount; ++itemIndex)
+		{
+			assert(drawList.GetItems()[itemIndex].sortKey == stdItems[itemIndex].sortKey);
+		}
+	}
+
+	printf("\n[Success] Test_DrawListPerformance\n");
+}
+
+cd::Matrix4x4 GetLightClusterProjection(float tanHalfFov, float aspect, float nearPlane, float farPlane)
+{
+	cd::Matrix4x4 projection;
+	projection.Clear();
+	float* pMatrix = projection.Begin();
+	pMatrix[0] = 1.0f / (tanHalfFov * aspect);
+	pMatrix[5] = 1.0f / tanHalfFov;
+	pMatrix[10] = farPlane / (farPlane - nearPlane);
+	pMatrix[11] = 1.0f;
+	pMatrix[14] = -nearPlane * farPlane / (farPlane - nearPlane);
+	return projection;
+}
+
+std::vector<U_Light> GetRandomLights(uint32_t lightCount, uint32_t directionalLightCount, float farPlane)
+{
+	std::mt19937 randomEngine(2023);
+	std::uniform_real_distribution<float> positionDistribution(-farPlane * 0.5f, farPlane * 0.5f);
+	std::uniform_real_distribution<float> depthDistribution(-10.0f, farPlane);
+	std::uniform_real_distribution<float> rangeDistribution(0.5f, 20.0f);
+	std::uniform_int_distribution<int> typeDistribution(0, 3);
+
+	std::vector<U_Light> lights(lightCount);
+	for (uint32_t lightIndex = 0; lightIndex < lightCount; ++lightIndex)
+	{
+		U_Light& light = lights[lightIndex];
+		light.position = cd::Vec3f(positionDistribution(randomEngine), positionDistribution(randomEngine), depthDistribution(randomEngine));
+		light.range = rangeDistribution(randomEngine);
+		light.radius = 1.0f;
+		light.width = 2.0f;
+		light.height = 1.0f;
+
+		constexpr int localLightTypes[] = { POINT_LIGHT, SPOT_LIGHT, SPHERE_LIGHT, RECTANGLE_LIGHT };
+		light.type = static_cast<float>(lightIndex < directionalLightCount ? DIRECTIONAL_LIGHT : localLightTypes[typeDistribution(randomEngine)]);
+	}
+
+	return lights;
+}
+
+void Test_LightClusterGrid()
+{
+	constexpr float tanHalfFov = 0.5f;
+	constexpr float aspect = 16.0f / 9.0f;
+	constexpr float nearPlane = 0.1f;
+	constexpr float farPlane = 200.0f;
+	cd::Matrix4x4 projection = GetLightClusterProjection(tanHalfFov, aspect, nearPlane, farPlane);
+	std::vector<U_Light> lights = GetRandomLights(1000U, 2U, farPlane);
+
+	LightClusterGrid lightClusterGrid;
+	lightClusterGrid.Build(cd::Matrix4x4::Identity(), projection, nearPlane, farPlane, lights.data(), static_cast<uint32_t>(lights.size()));
+	assert(1000U == lightClusterGrid.GetLightCount());
+	assert(2U == lightClusterGrid.GetGlobalLightCount());
+	assert(lightClusterGrid.GetLightIndices().size() == lightClusterGrid.GetLightIndexRowCount() * LightClusterGrid::LightIndexTextureWidth);
+	assert(lightClusterGrid.GetLightIndexCount() <= lightClusterGrid.GetLightIndices().size());
+
+	// Depth slices cover the depth range.
+	assert(0U == lightClusterGrid.GetDepthSlice(nearPlane));
+	assert(LightClusterGrid::CountZ - 1U == lightClusterGrid.GetDepthSlice(farPlane * 0.999f));
+	assert(lightClusterGrid.GetDepthSlice(1.0f) < lightClusterGrid.GetDepthSlice(10.0f));
+
+	// Every light which reaches a point must be in the cluster of the point. Clusters are found as LightCluster.sh does.
+	std::mt19937 randomEngine(2023);
+	std::uniform_real_distribution<float> ndcDistribution(-0.999f, 0.999f);
+	std::uniform_real_distribution<float> depthDistribution(nearPlane, farPlane);
+	uint32_t testedLightCount = 0U;
+	for (uint32_t pointIndex = 0; pointIndex < 20000U; ++pointIndex)
+	{
+		float ndcX = ndcDistribution(randomEngine);
+		float ndcY = ndcDistribution(randomEngine);
+		float depth = depthDistribution(randomEngine);
+		cd::Vec3f point(ndcX * depth / projection.Begin()[0], ndcY * depth / projection.Begin()[5], depth);
+
+		uint32_t tileX = static_cast<uint32_t>(std::floor((ndcX * 0.5f + 0.5f) * LightClusterGrid::CountX));
+		uint32_t tileY = static_cast<uint32_t>(std::floor((ndcY * 0.5f + 0.5f) * LightClusterGrid::CountY));
+		uint32_t clusterIndex = LightClusterGrid::GetClusterIndex(tileX, tileY, lightClusterGrid.GetDepthSlice(depth));
+		uint32_t lightOffset = lightClusterGrid.GetClusterLightOffset(clusterIndex);
+		uint32_t lightCount = lightClusterGrid.GetClusterLightCount(clusterIndex);
+		assert(lightOffset >= lightClusterGrid.GetGlobalLightCount());
+		assert(lightOffset + lightCount <= lightClusterGrid.GetLightIndexCount());
+
+		const float* pBegin = lightClusterGrid.GetLightIndices().data() + lightOffset;
+		const float* pEnd = pBegin + lightCount;
+		assert(std::is_sorted(pBegin, pEnd));
+		for (uint32_t lightIndex = lightClusterGrid.GetGlobalLightCount(); lightIndex < lights.size(); ++lightIndex)
+		{
+			const U_Light& light = lights[lightIndex];
+			float distanceX = light.position.x() - point.x();
+			float distanceY = light.position.y() - point.y();
+			float distanceZ = light.position.z() - point.z();
+			if (std::sqrt(distanceX * distanceX + distanceY * distanceY + distanceZ * distanceZ) < light.range)
+			{
+				assert(std::binary_search(pBegin, pEnd, static_cast<float>(lightIndex)));
+				++testedLightCount;
+			}
+		}
+	}
+	assert(testedLightCount > 0U);
+
+	// Unbounded lights are global lights.
+	std::vector<U_Light> unboundedLights = GetRandomLights(3U, 0U, farPlane);
+	unboundedLights[1].range = 0.0f;
+	unboundedLights[2].range = INFINITY;
+	lightClusterGrid.Build(cd::Matrix4x4::Identity(), projection, nearPlane, farPlane, unboundedLights.data(), 3U);
+	assert(2U == lightClusterGrid.GetGlobalLightCount());
+	assert(1.0f == lightClusterGrid.GetLightIndices()[0] && 2.0f == lightClusterGrid.GetLightIndices()[1]);
+
+	printf("\n[Success] Test_LightClusterGrid\n");
+}
+
+void Test_LightClusterGridPerformance()
+{
+	constexpr float tanHalfFov = 0.5f;
+	constexpr float aspect = 16.0f / 9.0f;
+	constexpr float nearPlane = 0.1f;
+	constexpr float farPlane = 200.0f;
+	cd::Matrix4x4 projection = GetLightClusterProjection(tanHalfFov, aspect, nearPlane, farPlane);
+
+	LightClusterGrid lightClusterGrid;
+	for (uint32_t lightCount : { 100U, 1000U, LightClusterGrid::MaxLightCount })
+	{
+		std::vector<U_Light> lights = GetRandomLights(lightCount, 1U, farPlane);
+		std::string profileName = "LightClusterGrid::Build x " + std::to_string(lightCount);
+		{
+			cdtools::PerformanceProfiler perf(profileName.c_str());
+			lightClusterGrid.Build(cd::Matrix4x4::Identity(), projection, nearPlane, farPlane, lights.data(), lightCount);
+		}
+
+		uint32_t maxClusterLightCount = 0U;
+		for (uint32_t clusterIndex = 0; clusterIndex < LightClusterGrid::ClusterCount; ++clusterIndex)
+		{
+			maxClusterLightCount = std::max(maxClusterLightCount, lightClusterGrid.GetClusterLightCount(clusterIndex));
+		}
+		printf("%u lights : %u light indices, at most %u lights per cluster\n", lightCount, lightClusterGrid.GetLightIndexCount(), maxClusterLightCount);
+	}
+
+	printf("\n[Success] Test_LightClusterGridPerformance\n");
+}
+
+// Records uniform and sampler values with their opcodes as bgfx::UniformBuffer does in setUniform/setTexture.
+class UniformStream
+{
+public:
+	void Reset() { m_data.clear(); m_uniformCount = 0U; }
+
+	void Write(uint16_t handle, const void* pValue, uint16_t vec4Count)
+	{
+		const uint32_t opcode = (static_cast<uint32_t>(handle) << 16) | vec4Count;
+		const size_t offset = m_data.size();
+		m_data.resize(offset + sizeof(opcode) + vec4Count * 4U * sizeof(float));
+		std::memcpy(m_data.data() + offset, &opcode, sizeof(opcode));
+		std::memcpy(m_data.data() + offset + sizeof(opcode), pValue, vec4Count * 4U * sizeof(float));
+		++m_uniformCount;
+	}
+
+	void WriteSampler(uint16_t handle, uint8_t stage)
+	{
+		float value[4] = { static_cast<float>(stage), 0.0f, 0.0f, 0.0f };
+		Write(handle, value, 1U);
+	}
+
+	size_t GetSize() const { return m_data.size(); }
+	uint32_t GetUniformCount() const { return m_uniformCount; }
+
+private:
+	std::vector<uint8_t> m_data;
+	uint32_t m_uniformCount = 0U;
+};
+
+void Test_FrameConstantsPerformance()
+{
+	// Compares the CPU cost of light and camera uniforms for 10k draws and 1k lights in three ways:
+	// filled per draw, filled once per view as frame constants, and binned into clusters which are uploaded once as textures.
+	// bgfx itself is not linked in tests so that the draw cost is what WorldRenderer writes through setUniform/setTexture.
+	constexpr uint32_t drawCount = 10000U;
+	constexpr uint32_t lightCount = 1000U;
+	constexpr uint32_t materialVec4Count = 4U;
+	constexpr float tanHalfFov = 0.5f;
+	constexpr float aspect = 16.0f / 9.0f;
+	constexpr float nearPlane = 0.1f;
+	constexpr float farPlane = 200.0f;
+	cd::Matrix4x4 projection = GetLightClusterProjection(tanHalfFov, aspect, nearPlane, farPlane);
+	std::vector<U_Light> lights = GetRandomLights(lightCount, 1U, farPlane);
+	const cd::Vec4f cameraPosition(0.0f, 0.0f, 0.0f, 1.0f);
+	const cd::Vec4f materialData[materialVec4Count] = {};
+
+	// The light uniform array holds MAX_LIGHT_COUNT lights at most.
+	const uint16_t uniformLightCount = static_cast<uint16_t>(std::min<uint32_t>(lightCount, MAX_LIGHT_COUNT));
+	const cd::Vec4f lightCountAndStride(static_cast<float>(uniformLightCount), LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
+	std::vector<float> lightParams(LightUniform::VEC4_COUNT * 4U);
+	std::memcpy(lightParams.data(), lights.data(), uniformLightCount * LightUniform::LIGHT_STRIDE * 4U * sizeof(float));
+
+	const uint16_t lightVec4Count = uniformLightCount * LightUniform::LIGHT_STRIDE;
+	UniformStream uniformStream;
+	auto SubmitDraws = [&](uint32_t samplerCount, bool perDrawLights)
+	{
+		for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
+		{
+			if (perDrawLights)
+			{
+				uniformStream.Write(0U, cameraPosition.Begin(), 1U);
+				uniformStream.Write(1U, lightCountAndStride.Begin(), 1U);
+				uniformStream.Write(2U, lightParams.data(), lightVec4Count);
+			}
+			for (uint32_t samplerIndex = 0; samplerIndex < samplerCount; ++samplerIndex)
+			{
+				uniformStream.WriteSampler(static_cast<uint16_t>(3U + samplerIndex), static_cast<uint8_t>(samplerIndex));
+			}
+			uniformStream.Write(16U, materialData, materialVec4Count);
+		}
+	};
+
+	size_t perDrawSize;
+	{
+		uniformStream.Reset();
+		cdtools::PerformanceProfiler perf("Per draw light uniforms, 10k draws, 1k lights");
+		SubmitDraws(3U, true);
+		perDrawSize = uniformStream.GetSize();
+	}
+	printf("%u uniforms, %zu bytes\n", uniformStream.GetUniformCount(), perDrawSize);
+
+	size_t frameConstantsSize;
+	{
+		uniformStream.Reset();
+		cdtools::PerformanceProfiler perf("Frame constant light uniforms, 10k draws, 1k lights");
+		uniformStream.Write(0U, cameraPosition.Begin(), 1U);
+		uniformStream.Write(1U, lightCountAndStride.Begin(), 1U);
+		uniformStream.Write(2U, lightParams.data(), lightVec4Count);
+		SubmitDraws(3U, false);
+		frameConstantsSize = uniformStream.GetSize();
+	}
+	printf("%u uniforms, %zu bytes\n", uniformStream.GetUniformCount(), frameConstantsSize);
+
+	// All lights are shaded instead of the first MAX_LIGHT_COUNT ones. Textures are copied as bgfx::copy does for updateTexture2D.
+	LightClusterGrid lightClusterGrid;
+	size_t clusteredSize;
+	size_t textureSize;
+	{
+		uniformStream.Reset();
+		cdtools::PerformanceProfiler perf("Clustered lights, 10k draws, 1k lights");
+		lightClusterGrid.Build(cd::Matrix4x4::Identity(), projection, nearPlane, farPlane, lights.data(), lightCount);
+		std::vector<float> clusterTexture = lightClusterGrid.GetClusterData();
+		std::vector<float> lightIndexTexture = lightClusterGrid.GetLightIndices();
+		std::vector<U_Light> lightParamsTexture(lights.begin(), lights.begin() + lightClusterGrid.GetLightCount());
+		textureSize = (clusterTexture.size() + lightIndexTexture.size()) * sizeof(float) + lightParamsTexture.size() * sizeof(U_Light);
+
+		const cd::Vec4f lightClusterParams(static_cast<float>(lightClusterGrid.GetGlobalLightCount()),
+			lightClusterGrid.GetDepthSliceScale(), lightClusterGrid.GetDepthSliceBias(), 0.0f);
+		uniformStream.Write(0U, cameraPosition.Begin(), 1U);
+		uniformStream.Write(1U, lightClusterParams.Begin(), 1U);
+		SubmitDraws(6U, false);
+		clusteredSize = uniformStream.GetSize();
+	}
+	printf("%u uniforms, %zu bytes, %zu texture bytes\n", uniformStream.GetUniformCount(), clusteredSize, textureSize);
+	assert(lightCount == lightClusterGrid.GetLightCount());
+
+	// Draw calls stay the same. Only view invariant data is written once.
+	const size_t lightUniformSize = 3U * sizeof(uint32_t) + (2U + lightVec4Count) * 4U * sizeof(float);
+	assert(frameConstantsSize + (drawCount - 1U) * lightUniformSize == perDrawSize);
+	assert(clusteredSize < perDrawSize);
+
+	printf("\n[Success] Test_FrameConstantsPerformance\n");
+}
+
+RenderProxy CreateGPUDrivenProxy(uint16_t meshHandle, uint32_t vertexCount, uint32_t indexCount, uint16_t programHandle, float x, float z)
+{
+	RenderProxy proxy{};
+	proxy.worldMatrix = cd::Matrix4x4::Identity();
+	proxy.worldMatrix.Begin()[12] = x;
+	proxy.worldMatrix.Begin()[14] = z;
+	proxy.vertexBufferHandle = meshHandle;
+	proxy.indexBufferHandle = meshHandle;
+	proxy.vertexCount = vertexCount;
+	proxy.indexCount = indexCount;
+	proxy.localAABB = cd::AABB(cd::Vec3f(-1.0f, -1.0f, -1.0f), cd::Vec3f(1.0f, 1.0f, 1.0f));
+	proxy.programHandle = programHandle;
+	proxy.instanceProgramHandle = programHandle;
+	proxy.drawBucket = DrawBucket::Opaque;
+	proxy.materialHash = programHandle;
+	proxy.albedoColor = cd::Vec4f(1.0f, 1.0f, 1.0f, 1.0f);
+	proxy.emissiveColor = cd::Vec4f(0.0f, 0.0f, 0.0f, 1.0f);
+	proxy.metallicRoughnessFactor = cd::Vec4f(0.0f, 1.0f, 1.0f, 1.0f);
+	return proxy;
+}
+
+void Test_GPUDrivenScene()
+{
+	// Two materials share three meshes. Blended proxies and proxies without instance programs stay on the CPU path.
+	std::vector<RenderProxy> proxies;
+	proxies.push_back(CreateGPUDrivenProxy(3U, 24U, 36U, 1U, 0.0f, 10.0f));
+	proxies.push_back(CreateGPUDrivenProxy(5U, 100U, 300U, 2U, 2.0f, 10.0f));
+	proxies.push_back(CreateGPUDrivenProxy(3U, 24U, 36U, 2U, -2.0f, 10.0f));
+	proxies.push_back(CreateGPUDrivenProxy(3U, 24U, 36U, 1U, 0.0f, -10.0f));
+	proxies.push_back(CreateGPUDrivenProxy(7U, 8U, 12U, 1U, 200.0f, 10.0f));
+	proxies.push_back(CreateGPUDrivenProxy(5U, 100U, 300U, 1U, 1.0f, 20.0f));
+	proxies.push_back(CreateGPUDrivenProxy(5U, 100U, 300U, 3U, 1.0f, 20.0f));
+	proxies.back().drawBucket = DrawBucket::Blended;
+	proxies.push_back(CreateGPUDrivenProxy(5U, 100U, 300U, UINT16_MAX, 1.0f, 20.0f));
+
+	GPUDrivenScene gpuDrivenScene;
+	assert(gpuDrivenScene.Build(proxies));
+	assert(!GPUDrivenScene::IsSupported(proxies[6]) && !GPUDrivenScene::IsSupported(proxies[7]));
+
+	// Meshes are packed in the order of first use.
+	const std::vector<GPUDrivenMesh>& meshes = gpuDrivenScene.GetMeshes();
+	assert(3U == meshes.size());
+	assert(0U == meshes[0].baseVertex && 0U == meshes[0].firstIndex);
+	assert(24U == meshes[1].baseVertex && 36U == meshes[1].firstIndex && 300U == meshes[1].indexCount);
+	assert(124U == meshes[2].baseVertex && 336U == meshes[2].firstIndex);
+	assert(132U == gpuDrivenScene.GetTotalVertexCount() && 348U == gpuDrivenScene.GetTotalIndexCount());
+
+	// Material 1 draws meshes 3, 5 and 7. Material 2 draws meshes 3 and 5.
+	assert(6U == gpuDrivenScene.GetInstanceCount());
+	const std::vector<GPUDrivenDrawGroup>& drawGroups = gpuDrivenScene.GetDrawGroups();
+	assert(2U == drawGroups.size());
+	assert(1U == proxies[drawGroups[0].proxyIndex].materialHash && 0U == drawGroups[0].firstDrawCommand && 3U == drawGroups[0].drawCommandCount);
+	assert(2U == proxies[drawGroups[1].proxyIndex].materialHash && 3U == drawGroups[1].firstDrawCommand && 2U == drawGroups[1].drawCommandCount);
+
+	// Instances of a draw command are adjacent and cover all instances.
+	const std::vector<GPUDrivenDrawCommand>& drawCommands = gpuDrivenScene.GetDrawCommands();
+	const std::vector<uint32_t>& instanceProxies = gpuDrivenScene.GetInstanceProxies();
+	assert(5U == drawCommands.size());
+	assert(0U == drawCommands[0].firstInstance && 36U == drawCommands[0].indexCount && 0U == drawCommands[0].baseVertex);
+	assert(0U == instanceProxies[0] && 3U == instanceProxies[1]);
+	for (uint32_t instanceIndex = 0U; instanceIndex < gpuDrivenScene.GetInstanceCount(); ++instanceIndex)
+	{
+		const GPUDrivenInstance& instance = gpuDrivenScene.GetInstances()[instanceIndex];
+		const GPUDrivenDrawCommand& drawCommand = drawCommands[static_cast<uint32_t>(instance.drawCommandIndex)];
+		const RenderProxy& proxy = proxies[instanceProxies[instanceIndex]];
+		assert(drawCommand.firstInstance <= instanceIndex);
+		assert(drawCommand.indexCount == proxy.indexCount);
+		assert(proxy.worldMatrix.Begin()[12] == instance.worldMatrix[12] && proxy.worldMatrix.Begin()[12] == instance.center[0]);
+		assert(1.0f == instance.extents[0] && 0.0f == instance.alwaysVisible);
+	}
+
+	// Culling reference has the same visible set as testing proxies one by one.
+	Frustum frustum;
+	frustum.Build(GetLightClusterProjection(0.5f, 16.0f / 9.0f, 0.1f, 100.0f), false);
+	std::vector<uint32_t> instanceCounts;
+	std::vector<uint32_t> visibleProxies;
+	gpuDrivenScene.Cull(frustum, instanceCounts, visibleProxies);
+	assert(drawCommands.size() == instanceCounts.size());
+	assert(std::vector<uint32_t>({ 1U, 1U, 0U, 1U, 1U }) == instanceCounts);
+	std::sort(visibleProxies.begin(), visibleProxies.end());
+	assert(std::vector<uint32_t>({ 0U, 1U, 2U, 5U }) == visibleProxies);
+
+	// Moving proxies doesn't change shared geometry.
+	proxies[3].worldMatrix.Begin()[14] = 10.0f;
+	assert(!gpuDrivenScene.Build(proxies));
+	gpuDrivenScene.Cull(frustum, instanceCounts, visibleProxies);
+	assert(5U == visibleProxies.size());
+
+	// Recycled buffer handles of different meshes are packed again.
+	proxies[4].vertexCount = 16U;
+	assert(gpuDrivenScene.Build(proxies));
+	assert(140U == gpuDrivenScene.GetTotalVertexCount());
+
+	printf("\n[Success] Test_GPUDrivenScene\n");
+}
+
+// Mips of HiZRenderer's texture as cs_HiZDownsample.sc builds them. Sizes are rounded down and the last column and row cover the rest.
+std::vector<std::vector<float>> BuildGPUHiZMips(const std::vector<float>& depths, int width, int height, int mipCount)
+{
+	std::vector<std::vector<float>> mips{ depths };
+	for (int mip = 1; mip < mipCount; ++mip)
+	{
+		const int sourceWidth = std::max(width >> (mip - 1), 1);
+		const int sourceHeight = std::max(height >> (mip - 1), 1);
+		const int targetWidth = std::max(width >> mip, 1);
+		const int targetHeight = std::max(height >> mip, 1);
+		const std::vector<float>& source = mips.back();
+		std::vector<float> target(targetWidth * targetHeight);
+		for (int targetY = 0; targetY < targetHeight; ++targetY)
+		{
+			for (int targetX = 0; targetX < targetWidth; ++targetX)
+			{
+				int lastX = targetX == targetWidth - 1 ? sourceWidth - 1 : std::min(targetX * 2 + 1, sourceWidth - 1);
+				int lastY = targetY == targetHeight - 1 ? sourceHeight - 1 : std::min(targetY * 2 + 1, sourceHeight - 1);
+				float depth = 0.0f;
+				for (int y = targetY * 2; y <= lastY; ++y)
+				{
+					for (int x = targetX * 2; x <= lastX; ++x)
+					{
+						depth = std::max(depth, source[y * sourceWidth + x]);
+					}
+				}
+				target[targetY * targetWidth + targetX] = depth;
+			}
+		}
+		mips.push_back(std::move(target));
+	}
+	return mips;
+}
+
+// Uniforms and buffers of cs_GPUDrivenCulling.sc which WorldRenderer::RenderGPUDriven binds.
+struct GPUDrivenCullingInput
+{
+	float cullingPlanes[Frustum::PlaneCount][4];
+	float gpuDrivenParams[4];
+	cd::Matrix4x4 hiZViewProj;
+	float hiZParams[4];
+	const std::vector<std::vector<float>>* pHiZMips;
+};
+
+// Line by line port of IsOccludedByHiZ in cs_GPUDrivenCulling.sc.
+bool IsOccludedByGPUHiZ(const GPUDrivenCullingInput& input, const float* center, const float* extents)
+{
+	float ndcMin[3] = { 1.0e30f, 1.0e30f, 1.0e30f };
+	float ndcMax[3] = { -1.0e30f, -1.0e30f, -1.0e30f };
+	const float* pMatrix = input.hiZViewProj.Begin();
+	for (int cornerIndex = 0; cornerIndex < 8; ++cornerIndex)
+	{
+		float corner[3] = { center[0] + extents[0] * (float(cornerIndex & 1) * 2.0f - 1.0f), center[1] + extents[1] * (float((cornerIndex >> 1) & 1) * 2.0f - 1.0f),
+			center[2] + extents[2] * (float((cornerIndex >> 2) & 1) * 2.0f - 1.0f) };
+		float clip[4];
+		for (int row = 0; row < 4; ++row)
+		{
+			clip[row] = pMatrix[row] * corner[0] + pMatrix[4 + row] * corner[1] + pMatrix[8 + row] * corner[2] + pMatrix[12 + row];
+		}
+		if (clip[3] <= 0.0f)
+		{
+			return false;
+		}
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			ndcMin[axis] = std::min(ndcMin[axis], clip[axis] / clip[3]);
+			ndcMax[axis] = std::max(ndcMax[axis], clip[axis] / clip[3]);
+		}
+	}
+
+	float minDepth = input.gpuDrivenParams[2] != 0.0f ? ndcMin[2] * 0.5f + 0.5f : ndcMin[2];
+	if (minDepth <= 0.0f || minDepth > 1.0f || ndcMax[0] < -1.0f || ndcMin[0] > 1.0f || ndcMax[1] < -1.0f || ndcMin[1] > 1.0f)
+	{
+		return false;
+	}
+
+	float size[2] = { input.hiZParams[0], input.hiZParams[1] };
+	float rectMin[2];
+	float rectMax[2];
+	for (int axis = 0; axis < 2; ++axis)
+	{
+		rectMin[axis] = (std::clamp(ndcMin[axis], -1.0f, 1.0f) * 0.5f + 0.5f) * size[axis];
+		rectMax[axis] = (std::clamp(ndcMax[axis], -1.0f, 1.0f) * 0.5f + 0.5f) * size[axis];
+	}
+	if (input.gpuDrivenParams[3] == 0.0f)
+	{
+		float firstRow = size[1] - rectMax[1];
+		rectMax[1] = size[1] - rectMin[1];
+		rectMin[1] = firstRow;
+	}
+
+	int texelMin[2];
+	int texelMax[2];
+	for (int axis = 0; axis < 2; ++axis)
+	{
+		texelMin[axis] = static_cast<int>(std::max(std::floor(rectMin[axis]) - 1.0f, 0.0f));
+		texelMax[axis] = static_cast<int>(std::min(std::floor(rectMax[axis]) + 1.0f, size[axis] - 1.0f));
+	}
+	int mip = 0;
+	int mipCount = static_cast<int>(input.hiZParams[2]);
+	while (mip + 1 < mipCount && ((texelMax[0] >> mip) - (texelMin[0] >> mip) > 3 || (texelMax[1] >> mip) - (texelMin[1] >> mip) > 3))
+	{
+		++mip;
+	}
+
+	int mipSize[2] = { std::max(static_cast<int>(size[0]) >> mip, 1), std::max(static_cast<int>(size[1]) >> mip, 1) };
+	float maxDepth = 0.0f;
+	for (int y = texelMin[1] >> mip; y <= (texelMax[1] >> mip); ++y)
+	{
+		for (int x = texelMin[0] >> mip; x <= (texelMax[0] >> mip); ++x)
+		{
+			maxDepth = std::max(maxDepth, (*input.pHiZMips)[mip][std::min(y, mipSize[1] - 1) * mipSize[0] + std::min(x, mipSize[0] - 1)]);
+		}
+	}
+
+	return minDepth > maxDepth;
+}
+
+// Port of main in cs_GPUDrivenCulling.sc which runs every invocation in order. Returns counts of s_instanceCounts.
+std::vector<uint32_t> DispatchGPUDrivenCulling(const GPUDrivenCullingInput& input, const GPUDrivenScene& gpuDrivenScene, std::vector<float>& instanceOutput)
+{
+	const float* s_instanceInput = reinterpret_cast<const float*>(gpuDrivenScene.GetInstances().data());
+	const uint32_t* s_drawCommands = reinterpret_cast<const uint32_t*>(gpuDrivenScene.GetDrawCommands().data());
+	std::vector<uint32_t> s_instanceCounts(gpuDrivenScene.GetDrawCommandCount(), 0U);
+	instanceOutput.assign(gpuDrivenScene.GetInstanceCount() * 16U, 0.0f);
+
+	for (uint32_t instanceIndex = 0U; instanceIndex < static_cast<uint32_t>(input.gpuDrivenParams[0]); ++instanceIndex)
+	{
+		const float* centerAndDrawCommand = s_instanceInput + (instanceIndex * GPU_DRIVEN_INSTANCE_VEC4_COUNT + 4U) * 4U;
+		const float* extentsAndFlag = s_instanceInput + (instanceIndex * GPU_DRIVEN_INSTANCE_VEC4_COUNT + 5U) * 4U;
+
+		bool isVisible = true;
+		if (extentsAndFlag[3] == 0.0f)
+		{
+			for (uint32_t planeIndex = 0U; planeIndex < Frustum::PlaneCount; ++planeIndex)
+			{
+				const float* plane = input.cullingPlanes[planeIndex];
+				float distance = plane[0] * centerAndDrawCommand[0] + plane[1] * centerAndDrawCommand[1] + plane[2] * centerAndDrawCommand[2] + plane[3];
+				float radius = std::abs(plane[0]) * extentsAndFlag[0] + std::abs(plane[1]) * extentsAndFlag[1] + std::abs(plane[2]) * extentsAndFlag[2];
+				isVisible = isVisible && distance + radius >= 0.0f;
+			}
+		}
+
+		if (!isVisible || (extentsAndFlag[3] == 0.0f && input.hiZParams[3] != 0.0f && IsOccludedByGPUHiZ(input, centerAndDrawCommand, extentsAndFlag)))
+		{
+			continue;
+		}
+
+		uint32_t drawCommandIndex = static_cast<uint32_t>(centerAndDrawCommand[3]);
+		uint32_t slot = s_instanceCounts[drawCommandIndex]++;
+		uint32_t firstInstance = s_drawCommands[drawCommandIndex * GPU_DRIVEN_DRAW_COMMAND_UINT_COUNT + 3U];
+		std::copy(s_instanceInput + instanceIndex * GPU_DRIVEN_INSTANCE_VEC4_COUNT * 4U, s_instanceInput + (instanceIndex * GPU_DRIVEN_INSTANCE_VEC4_COUNT + 4U) * 4U,
+			instanceOutput.begin() + (firstInstance + slot) * 16U);
+	}
+
+	return s_instanceCounts;
+}
+
+// Returns true if all depth texels which the box's screen rect covers are nearer than the box. Row 0 is the top of the screen.
+bool IsHiddenByDepths(const std::vector<float>& depths, int width, int height, const cd::Matrix4x4& viewProjection, const cd::Vec3f& center, const cd::Vec3f& extents)
+{
+	const float* pMatrix = viewProjection.Begin();
+	float ndcMin[3] = { INFINITY, INFINITY, INFINITY };
+	float ndcMax[3] = { -INFINITY, -INFINITY, -INFINITY };
+	for (uint32_t cornerIndex = 0U; cornerIndex < 8U; ++cornerIndex)
+	{
+		cd::Vec3f corner(center.x() + ((cornerIndex & 1U) ? extents.x() : -extents.x()), center.y() + ((cornerIndex & 2U) ? extents.y() : -extents.y()),
+			center.z() + ((cornerIndex & 4U) ? extents.z() : -extents.z()));
+		float clip[4];
+		for (int row = 0; row < 4; ++row)
+		{
+			clip[row] = pMatrix[row] * corner.x() + pMatrix[4 + row] * corner.y() + pMatrix[8 + row] * corner.z() + pMatrix[12 + row];
+		}
+		if (clip[3] <= 0.0f)
+		{
+			return false;
+		}
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			ndcMin[axis] = std::min(ndcMin[axis], clip[axis] / clip[3]);
+			ndcMax[axis] = std::max(ndcMax[axis], clip[axis] / clip[3]);
+		}
+	}
+
+	const int x0 = std::clamp(static_cast<int>(std::floor((ndcMin[0] * 0.5f + 0.5f) * width)), 0, width - 1);
+	const int x1 = std::clamp(static_cast<int>(std::floor((ndcMax[0] * 0.5f + 0.5f) * width)), 0, width - 1);
+	const int y0 = std::clamp(static_cast<int>(std::floor((0.5f - ndcMax[1] * 0.5f) * height)), 0, height - 1);
+	const int y1 = std::clamp(static_cast<int>(std::floor((0.5f - ndcMin[1] * 0.5f) * height)), 0, height - 1);
+	for (int y = y0; y <= y1; ++y)
+	{
+		for (int x = x0; x <= x1; ++x)
+		{
+			if (depths[y * width + x] >= ndcMin[2])
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void Test_GPUDrivenCulling()
+{
+	// The CPU path culls proxies by Frustum and by a HiZPyramid built from a read back mip of HiZRenderer's texture.
+	// The GPU path runs cs_GPUDrivenCulling.sc on all mips of the texture. Frustum culling should find the same proxies.
+	// Occlusion culling may hide more proxies on GPU as mip 0 is finer, but only the ones which are hidden so that images are the same.
+	constexpr int hiZWidth = 512;
+	constexpr int hiZHeight = 256;
+	constexpr int readbackMip = 1;
+	constexpr float nearPlane = 0.1f;
+	constexpr float farPlane = 200.0f;
+	const cd::Matrix4x4 viewProjection = GetLightClusterProjection(0.5f, 16.0f / 9.0f, nearPlane, farPlane);
+	const float* pMatrix = viewProjection.Begin();
+
+	// A wall at z = 20 covers NDC x in [-0.5, 0.5] and y in [-0.5, 0.5]. Other texels are cleared to the far plane.
+	const float wallDepth = (pMatrix[10] * 20.0f + pMatrix[14]) / 20.0f;
+	std::vector<float> depths(hiZWidth * hiZHeight);
+	for (int row = 0; row < hiZHeight; ++row)
+	{
+		float ndcY = 1.0f - (static_cast<float>(row) + 0.5f) / hiZHeight * 2.0f;
+		for (int column = 0; column < hiZWidth; ++column)
+		{
+			float ndcX = (static_cast<float>(column) + 0.5f) / hiZWidth * 2.0f - 1.0f;
+			depths[row * hiZWidth + column] = std::abs(ndcX) <= 0.5f && std::abs(ndcY) <= 0.5f ? wallDepth : 1.0f;
+		}
+	}
+
+	int mipCount = 1;
+	while ((std::max(hiZWidth, hiZHeight) >> mipCount) > 0)
+	{
+		++mipCount;
+	}
+	std::vector<std::vector<float>> gpuMips = BuildGPUHiZMips(depths, hiZWidth, hiZHeight, mipCount);
+	HiZPyramid hiZPyramid;
+	hiZPyramid.Build(gpuMips[readbackMip].data(), hiZWidth >> readbackMip, hiZHeight >> readbackMip, viewProjection, false, false);
+
+	// Proxies in front of, behind and around the wall, crossing and out of frustum planes.
+	std::mt19937 randomEngine(2023);
+	std::uniform_real_distribution<float> positionDistribution(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> depthDistribution(-10.0f, 220.0f);
+	std::uniform_real_distribution<float> scaleDistribution(0.2f, 4.0f);
+	std::uniform_int_distribution<uint32_t> meshDistribution(0U, 3U);
+	std::vector<RenderProxy> proxies;
+	for (uint32_t proxyIndex = 0U; proxyIndex < 4000U; ++proxyIndex)
+	{
+		uint32_t mesh = meshDistribution(randomEngine);
+		proxies.push_back(CreateGPUDrivenProxy(static_cast<uint16_t>(mesh), 24U, 36U + mesh * 6U, static_cast<uint16_t>(1U + proxyIndex % 3U),
+			positionDistribution(randomEngine), depthDistribution(randomEngine)));
+		float* pWorld = proxies.back().worldMatrix.Begin();
+		pWorld[0] = scaleDistribution(randomEngine);
+		pWorld[5] = scaleDistribution(randomEngine);
+		pWorld[10] = scaleDistribution(randomEngine);
+		pWorld[13] = positionDistribution(randomEngine) * 0.5f;
+	}
+
+	GPUDrivenScene gpuDrivenScene;
+	gpuDrivenScene.Build(proxies);
+	Frustum frustum;
+	frustum.Build(viewProjection, false);
+
+	GPUDrivenCullingInput input;
+	for (uint32_t planeIndex = 0U; planeIndex < Frustum::PlaneCount; ++planeIndex)
+	{
+		std::copy(frustum.GetPlane(static_cast<FrustumPlane>(planeIndex)).Begin(), frustum.GetPlane(static_cast<FrustumPlane>(planeIndex)).Begin() + 4,
+			input.cullingPlanes[planeIndex]);
+	}
+	input.gpuDrivenParams[0] = static_cast<float>(gpuDrivenScene.GetInstanceCount());
+	input.gpuDrivenParams[1] = static_cast<float>(gpuDrivenScene.GetDrawCommandCount());
+	input.gpuDrivenParams[2] = 0.0f;
+	input.gpuDrivenParams[3] = 0.0f;
+	input.hiZViewProj = viewProjection;
+	input.pHiZMips = &gpuMips;
+
+	for (bool useHiZ : { false, true })
+	{
+		input.hiZParams[0] = static_cast<float>(hiZWidth);
+		input.hiZParams[1] = static_cast<float>(hiZHeight);
+		input.hiZParams[2] = static_cast<float>(mipCount);
+		input.hiZParams[3] = useHiZ ? 1.0f : 0.0f;
+		std::vector<float> instanceOutput;
+		std::vector<uint32_t> gpuInstanceCounts = DispatchGPUDrivenCulling(input, gpuDrivenScene, instanceOutput);
+
+		// Visible proxies of the CPU path as FrustumCuller finds them.
+		std::vector<uint32_t> cpuVisibleProxies;
+		std::vector<cd::Vec3f> worldCenters;
+		std::vector<cd::Vec3f> worldExtents;
+		for (uint32_t proxyIndex = 0U; proxyIndex < proxies.size(); ++proxyIndex)
+		{
+			const RenderProxy& proxy = proxies[proxyIndex];
+			cd::Vec3f center = cd::Vec3f::Zero();
+			cd::Vec3f extents = cd::Vec3f::Zero();
+			FrustumCullingBatch::TransformBox(proxy.worldMatrix, proxy.localAABB.Min(), proxy.localAABB.Max(), center, extents);
+			worldCenters.push_back(center);
+			worldExtents.push_back(extents);
+			if (frustum.Intersects(center, extents) && !(useHiZ && hiZPyramid.IsOccluded(center, extents)))
+			{
+				cpuVisibleProxies.push_back(proxyIndex);
+			}
+		}
+
+		// Every draw command draws the world matrices of its visible proxies.
+		std::vector<uint32_t> gpuVisibleProxies;
+		const std::vector<GPUDrivenDrawCommand>& drawCommands = gpuDrivenScene.GetDrawCommands();
+		for (uint32_t drawCommandIndex = 0U; drawCommandIndex < drawCommands.size(); ++drawCommandIndex)
+		{
+			for (uint32_t slot = 0U; slot < gpuInstanceCounts[drawCommandIndex]; ++slot)
+			{
+				const float* pWorldMatrix = instanceOutput.data() + (drawCommands[drawCommandIndex].firstInstance + slot) * 16U;
+				for (uint32_t proxyIndex = 0U; proxyIndex < proxies.size(); ++proxyIndex)
+				{
+					if (std::equal(pWorldMatrix, pWorldMatrix + 16, proxies[proxyIndex].worldMatrix.Begin()))
+					{
+						assert(proxies[proxyIndex].indexCount == drawCommands[drawCommandIndex].indexCount);
+						gpuVisibleProxies.push_back(proxyIndex);
+						break;
+					}
+				}
+			}
+		}
+		std::sort(gpuVisibleProxies.begin(), gpuVisibleProxies.end());
+		assert(std::includes(cpuVisibleProxies.begin(), cpuVisibleProxies.end(), gpuVisibleProxies.begin(), gpuVisibleProxies.end()));
+		assert(!gpuVisibleProxies.empty() && gpuVisibleProxies.size() < proxies.size());
+
+		std::vector<uint32_t> gpuOccludedProxies;
+		std::set_difference(cpuVisibleProxies.begin(), cpuVisibleProxies.end(), gpuVisibleProxies.begin(), gpuVisibleProxies.end(),
+			std::back_inserter(gpuOccludedProxies));
+		assert(useHiZ || gpuOccludedProxies.empty());
+		for (uint32_t proxyIndex : gpuOccludedProxies)
+		{
+			assert(IsHiddenByDepths(depths, hiZWidth, hiZHeight, viewProjection, worldCenters[proxyIndex], worldExtents[proxyIndex]));
+		}
+
+		if (!useHiZ)
+		{
+			std::vector<uint32_t> instanceCounts;
+			std::vector<uint32_t> visibleProxies;
+			gpuDrivenScene.Cull(frustum, instanceCounts, visibleProxies);
+			assert(instanceCounts == gpuInstanceCounts);
+		}
+		printf("%s : %zu of %zu proxies are visible on CPU, %zu on GPU\n", useHiZ ? "Frustum and HiZ culling" : "Frustum culling",
+			cpuVisibleProxies.size(), proxies.size(), gpuVisibleProxies.size());
+	}
+
+	printf("\n[Success] Test_GPUDrivenCulling\n");
+}
+
+void Test_FrameEncoders()
+{
+	// A fake pool like bgfx's which gives encoders back only at the end of frame.
+	// workers + 1 encoders as the first encoder of the main thread is not in the pool.
+	constexpr uint32_t workerCount = 4U;
+	constexpr uint32_t poolSize = workerCount + 1U;
+	std::vector<uint8_t> encoderStorage(poolSize);
+	std::vector<bgfx::Encoder*> freeEncoders;
+	for (uint8_t& encoder : encoderStorage)
+	{
+		freeEncoders.push_back(reinterpret_cast<bgfx::Encoder*>(&encoder));
+	}
+
+	std::mutex poolMutex;
+	std::vector<bgfx::Encoder*> endedEncoders;
+	FrameEncoders frameEncoders([&poolMutex, &freeEncoders]() -> bgfx::Encoder*
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		if (freeEncoders.empty())
+		{
+			return nullptr;
+		}
+
+		bgfx::Encoder* pEncoder = freeEncoders.back();
+		freeEncoders.pop_back();
+		return pEncoder;
+	},
+	[&endedEncoders](bgfx::Encoder* pEncoder)
+	{
+		endedEncoders.push_back(pEncoder);
+	});
+
+	JobSystem jobSystem(workerCount);
+	for (uint32_t frameIndex = 0U; frameIndex < 3U; ++frameIndex)
+	{
+		// World, terrain and animation renderers encode in parallel one after another in the same frame.
+		// Every one splits into more chunks than threads. None of them runs out of encoders.
+		std::atomic<uint32_t> missingEncoderCount = 0U;
+		std::atomic<uint32_t> encodedCount = 0U;
+		std::mutex usedEncodersMutex;
+		std::set<bgfx::Encoder*> usedEncoders;
+		for (uint32_t rendererIndex = 0U; rendererIndex < 3U; ++rendererIndex)
+		{
+			jobSystem.ParallelFor(10000U, 64U, [&](uint32_t beginIndex, uint32_t endIndex)
+			{
+				bgfx::Encoder* pEncoder = frameEncoders.Acquire();
+				if (!pEncoder)
+				{
+					missingEncoderCount.fetch_add(1U);
+					return;
+				}
+
+				encodedCount.fetch_add(endIndex - beginIndex);
+				std::lock_guard<std::mutex> lock(usedEncodersMutex);
+				usedEncoders.insert(pEncoder);
+			});
+		}
+		assert(0U == missingEncoderCount.load() && 30000U == encodedCount.load());
+		assert(usedEncoders.size() == frameEncoders.GetEncoderCount() && usedEncoders.size() <= poolSize);
+
+		// All encoders are ended once and go back to the pool.
+		frameEncoders.EndFrame();
+		assert(0U == frameEncoders.GetEncoderCount() && usedEncoders.size() == endedEncoders.size());
+		assert(usedEncoders == std::set<bgfx::Encoder*>(endedEncoders.begin(), endedEncoders.end()));
+		freeEncoders.insert(freeEncoders.end(), endedEncoders.begin(), endedEncoders.end());
+		endedEncoders.clear();
+	}
+
+	// Acquire returns nullptr when the pool is used up, e.g. by threads which are not workers, until next frame.
+	std::vector<bgfx::Encoder*> allEncoders;
+	allEncoders.swap(freeEncoders);
+	assert(!frameEncoders.Acquire() && !frameEncoders.Acquire() && 0U == frameEncoders.GetEncoderCount());
+	frameEncoders.EndFrame();
+	freeEncoders.swap(allEncoders);
+	bgfx::Encoder* pEncoder = frameEncoders.Acquire();
+	assert(pEncoder && pEncoder == frameEncoders.Acquire() && 1U == frameEncoders.GetEncoderCount());
+	frameEncoders.EndFrame();
+
+	printf("\n[Success] Test_FrameEncoders\n");
+}
+
+}
+
+int main()
+{
+	Test_DrawSortKey();
+	Test_DrawList();
+	Test_DrawListPerformance();
+	Test_LightClusterGrid();
+	Test_LightClusterGridPerformance();
+	Test_FrameConstantsPerformance();
+	Test_GPUDrivenScene();
+	Test_GPUDrivenCulling();
+	Test_FrameEncoders();
+
+	return 0;
+}
\ No newline at end of file
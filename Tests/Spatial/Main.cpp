@@ -0,0 +1,323 @@
+#include "Core/Math/FrustumCulling.h"
+#include "Spatial/DynamicBVH.h"
+#include "Utilities/PerformanceProfiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using namespace engine;
+
+constexpr float WorldHalfSize = 500.0f;
+
+cd::AABB CreateRandomBox(std::mt19937& randomEngine)
+{
+	std::uniform_real_distribution<float> positionDistribution(-WorldHalfSize, WorldHalfSize);
+	std::uniform_real_distribution<float> sizeDistribution(0.5f, 5.0f);
+	cd::Vec3f center(positionDistribution(randomEngine), positionDistribution(randomEngine), positionDistribution(randomEngine));
+	cd::Vec3f halfSize(sizeDistribution(randomEngine), sizeDistribution(randomEngine), sizeDistribution(randomEngine));
+	return cd::AABB(cd::Vec3f(center.x() - halfSize.x(), center.y() - halfSize.y(), center.z() - halfSize.z()),
+		cd::Vec3f(center.x() + halfSize.x(), center.y() + halfSize.y(), center.z() + halfSize.z()));
+}
+
+cd::AABB OffsetBox(const cd::AABB& aabb, float offset)
+{
+	return cd::AABB(cd::Vec3f(aabb.Min().x() + offset, aabb.Min().y() + offset, aabb.Min().z() + offset),
+		cd::Vec3f(aabb.Max().x() + offset, aabb.Max().y() + offset, aabb.Max().z() + offset));
+}
+
+cd::Ray CreateRandomRay(std::mt19937& randomEngine)
+{
+	std::uniform_real_distribution<float> positionDistribution(-WorldHalfSize, WorldHalfSize);
+	std::uniform_real_distribution<float> directionDistribution(-1.0f, 1.0f);
+	float x = directionDistribution(randomEngine);
+	float y = directionDistribution(randomEngine);
+	float z = directionDistribution(randomEngine) + 2.0f;
+	float length = std::sqrt(x * x + y * y + z * z);
+	return cd::Ray(cd::Vec3f(positionDistribution(randomEngine), positionDistribution(randomEngine), -WorldHalfSize - 10.0f),
+		cd::Vec3f(x / length, y / length, z / length));
+}
+
+// Left handed perspective camera at eye which looks at +Z.
+Frustum CreateFrustum(const cd::Vec3f& eye, float farPlane)
+{
+	constexpr float aspect = 16.0f / 9.0f;
+	constexpr float tanHalfFov = 0.5f;
+	constexpr float nearPlane = 0.1f;
+
+	cd::Matrix4x4 viewProjection;
+	viewProjection.Clear();
+	float* pMatrix = viewProjection.Begin();
+	pMatrix[0] = 1.0f / (tanHalfFov * aspect);
+	pMatrix[5] = 1.0f / tanHalfFov;
+	pMatrix[10] = farPlane / (farPlane - nearPlane);
+	pMatrix[11] = 1.0f;
+	pMatrix[12] = -eye.x() * pMatrix[0];
+	pMatrix[13] = -eye.y() * pMatrix[5];
+	pMatrix[14] = -eye.z() * pMatrix[10] - nearPlane * farPlane / (farPlane - nearPlane);
+	pMatrix[15] = -eye.z();
+
+	Frustum frustum;
+	frustum.Build(viewProjection, false);
+	return frustum;
+}
+
+cd::Vec3f GetCenter(const cd::AABB& aabb)
+{
+	return cd::Vec3f((aabb.Min().x() + aabb.Max().x()) * 0.5f, (aabb.Min().y() + aabb.Max().y()) * 0.5f, (aabb.Min().z() + aabb.Max().z()) * 0.5f);
+}
+
+cd::Vec3f GetExtents(const cd::AABB& aabb)
+{
+	return cd::Vec3f((aabb.Max().x() - aabb.Min().x()) * 0.5f, (aabb.Max().y() - aabb.Min().y()) * 0.5f, (aabb.Max().z() - aabb.Min().z()) * 0.5f);
+}
+
+bool Overlaps(const cd::AABB& a, const cd::AABB& b)
+{
+	return a.Min().x() <= b.Max().x() && b.Min().x() <= a.Max().x() &&
+		a.Min().y() <= b.Max().y() && b.Min().y() <= a.Max().y() &&
+		a.Min().z() <= b.Max().z() && b.Min().z() <= a.Max().z();
+}
+
+// Linear scans which are the same as SceneView::PickSceneMesh before BVH.
+Entity LinearRayCast(const std::vector<cd::AABB>& boxes, const std::vector<uint8_t>& isAlive, const cd::Ray& ray, float& outRayTime)
+{
+	float minRayTime = FLT_MAX;
+	Entity nearestEntity = INVALID_ENTITY;
+	for (uint32_t index = 0; index < boxes.size(); ++index)
+	{
+		float rayTime;
+		if (isAlive[index] && boxes[index].Intersects(ray, rayTime) && rayTime < minRayTime)
+		{
+			minRayTime = rayTime;
+			nearestEntity = index;
+		}
+	}
+
+	outRayTime = minRayTime;
+	return nearestEntity;
+}
+
+std::vector<Entity> LinearQueryAABB(const std::vector<cd::AABB>& boxes, const std::vector<uint8_t>& isAlive, const cd::AABB& aabb)
+{
+	std::vector<Entity> entities;
+	for (uint32_t index = 0; index < boxes.size(); ++index)
+	{
+		if (isAlive[index] && Overlaps(boxes[index], aabb))
+		{
+			entities.push_back(index);
+		}
+	}
+
+	return entities;
+}
+
+std::vector<Entity> LinearQueryFrustum(const std::vector<cd::AABB>& boxes, const std::vector<uint8_t>& isAlive, const Frustum& frustum)
+{
+	std::vector<Entity> entities;
+	for (uint32_t index = 0; index < boxes.size(); ++index)
+	{
+		if (isAlive[index] && frustum.Intersects(GetCenter(boxes[index]), GetExtents(boxes[index])))
+		{
+			entities.push_back(index);
+		}
+	}
+
+	return entities;
+}
+
+void CheckQueries(const DynamicBVH& bvh, const std::vector<cd::AABB>& boxes, const std::vector<uint8_t>& isAlive, std::mt19937& randomEngine)
+{
+	assert(bvh.Validate());
+
+	for (uint32_t queryIndex = 0; queryIndex < 100; ++queryIndex)
+	{
+		cd::Ray ray = CreateRandomRay(randomEngine);
+		float expectedRayTime;
+		Entity expectedEntity = LinearRayCast(boxes, isAlive, ray, expectedRayTime);
+		float rayTime;
+		Entity entity = bvh.RayCast(ray, rayTime);
+		assert(expectedEntity == entity);
+		assert(INVALID_ENTITY == entity || expectedRayTime == rayTime);
+
+		cd::AABB queryBox = CreateRandomBox(randomEngine);
+		queryBox = cd::AABB(cd::Vec3f(queryBox.Min().x() - 50.0f, queryBox.Min().y() - 50.0f, queryBox.Min().z() - 50.0f), queryBox.Max());
+		std::vector<Entity> entities;
+		bvh.QueryAABB(queryBox, entities);
+		std::sort(entities.begin(), entities.end());
+		assert(LinearQueryAABB(boxes, isAlive, queryBox) == entities);
+	}
+
+	for (float eyeZ : { -WorldHalfSize - 10.0f, 0.0f, 300.0f })
+	{
+		Frustum frustum = CreateFrustum(cd::Vec3f(0.0f, 0.0f, eyeZ), 400.0f);
+		std::vector<Entity> entities;
+		bvh.QueryFrustum(frustum, entities);
+		std::sort(entities.begin(), entities.end());
+		assert(LinearQueryFrustum(boxes, isAlive, frustum) == entities);
+	}
+}
+
+void Test_DynamicBVH()
+{
+	std::mt19937 randomEngine(1234);
+
+	constexpr uint32_t boxCount = 2000;
+	DynamicBVH bvh(0.5f);
+	std::vector<cd::AABB> boxes;
+	std::vector<uint32_t> proxyIndexes;
+	std::vector<uint8_t> isAlive(boxCount, 1);
+	for (Entity entity = 0; entity < boxCount; ++entity)
+	{
+		boxes.push_back(CreateRandomBox(randomEngine));
+		proxyIndexes.push_back(bvh.CreateProxy(boxes.back(), entity));
+		assert(entity == bvh.GetEntity(proxyIndexes.back()));
+	}
+	assert(boxCount == bvh.GetProxyCount());
+
+	// Balanced tree should be much lower than a list.
+	printf("BVH height of %u proxies : %d\n", boxCount, bvh.GetHeight());
+	assert(bvh.GetHeight() < 32);
+	CheckQueries(bvh, boxes, isAlive, randomEngine);
+
+	// Small movements stay in fat boxes.
+	for (Entity entity = 0; entity < boxCount; entity += 2)
+	{
+		boxes[entity] = OffsetBox(boxes[entity], 0.25f);
+		assert(!bvh.MoveProxy(proxyIndexes[entity], boxes[entity]));
+	}
+	CheckQueries(bvh, boxes, isAlive, randomEngine);
+
+	// Large movements reinsert proxies.
+	for (Entity entity = 1; entity < boxCount; entity += 3)
+	{
+		boxes[entity] = CreateRandomBox(randomEngine);
+		assert(bvh.MoveProxy(proxyIndexes[entity], boxes[entity]));
+	}
+	CheckQueries(bvh, boxes, isAlive, randomEngine);
+
+	// Destroy and create proxies to reuse free nodes.
+	for (Entity entity = 0; entity < boxCount; entity += 5)
+	{
+		bvh.DestroyProxy(proxyIndexes[entity]);
+		isAlive[entity] = 0;
+	}
+	CheckQueries(bvh, boxes, isAlive, randomEngine);
+
+	for (Entity entity = 0; entity < boxCount; entity += 10)
+	{
+		boxes[entity] = CreateRandomBox(randomEngine);
+		proxyIndexes[entity] = bvh.CreateProxy(boxes[entity], entity);
+		isAlive[entity] = 1;
+	}
+	CheckQueries(bvh, boxes, isAlive, randomEngine);
+
+	for (Entity entity = 0; entity < boxCount; ++entity)
+	{
+		if (isAlive[entity])
+		{
+			bvh.DestroyProxy(proxyIndexes[entity]);
+		}
+	}
+	assert(0 == bvh.GetProxyCount() && -1 == bvh.GetHeight() && bvh.Validate());
+
+	printf("\n[Success] Test_DynamicBVH\n");
+}
+
+void Test_DynamicBVHPerformance()
+{
+	constexpr uint32_t queryCount = 1000;
+	for (uint32_t boxCount : { 1000, 10000, 100000 })
+	{
+		std::mt19937 randomEngine(boxCount);
+		std::vector<cd::AABB> boxes;
+		boxes.reserve(boxCount);
+		for (uint32_t index = 0; index < boxCount; ++index)
+		{
+			boxes.push_back(CreateRandomBox(randomEngine));
+		}
+		std::vector<uint8_t> isAlive(boxCount, 1);
+		std::vector<cd::Ray> rays;
+		for (uint32_t queryIndex = 0; queryIndex < queryCount; ++queryIndex)
+		{
+			rays.push_back(CreateRandomRay(randomEngine));
+		}
+
+		std::string countName = std::to_string(boxCount);
+		printf("\n[%s boxes]\n", countName.c_str());
+
+		DynamicBVH bvh;
+		{
+			std::string profileName = "Build BVH x " + countName;
+			cdtools::PerformanceProfiler perf(profileName.c_str());
+			for (uint32_t index = 0; index < boxCount; ++index)
+			{
+				bvh.CreateProxy(boxes[index], index);
+			}
+		}
+
+		uint32_t linearHitCount = 0;
+		{
+			std::string profileName = "Linear ray cast x " + std::to_string(queryCount);
+			cdtools::PerformanceProfiler perf(profileName.c_str());
+			for (const cd::Ray& ray : rays)
+			{
+				float rayTime;
+				linearHitCount += INVALID_ENTITY != LinearRayCast(boxes, isAlive, ray, rayTime) ? 1 : 0;
+			}
+		}
+
+		uint32_t bvhHitCount = 0;
+		{
+			std::string profileName = "BVH ray cast x " + std::to_string(queryCount);
+			cdtools::PerformanceProfiler perf(profileName.c_str());
+			for (const cd::Ray& ray : rays)
+			{
+				float rayTime;
+				bvhHitCount += INVALID_ENTITY != bvh.RayCast(ray, rayTime) ? 1 : 0;
+			}
+		}
+		assert(linearHitCount == bvhHitCount);
+
+		// Linear culling is the SIMD batch used by FrustumCuller without BVH.
+		Frustum frustum = CreateFrustum(cd::Vec3f(0.0f, 0.0f, -WorldHalfSize), 300.0f);
+		FrustumCullingBatch cullingBatch;
+		std::vector<uint8_t> visibilities(boxCount);
+		uint32_t linearVisibleCount = 0;
+		{
+			cdtools::PerformanceProfiler perf("Linear SIMD frustum culling");
+			for (const cd::AABB& aabb : boxes)
+			{
+				cullingBatch.Add(GetCenter(aabb), GetExtents(aabb));
+			}
+			linearVisibleCount = cullingBatch.Cull(frustum, visibilities.data());
+		}
+
+		std::vector<Entity> visibleEntities;
+		{
+			cdtools::PerformanceProfiler perf("BVH frustum culling");
+			bvh.QueryFrustum(frustum, visibleEntities);
+		}
+		assert(linearVisibleCount == visibleEntities.size());
+	}
+
+	printf("\n[Success] Test_DynamicBVHPerformance\n");
+}
+
+}
+
+int main()
+{
+	Test_DynamicBVH();
+	Test_DynamicBVHPerformance();
+
+	return 0;
+}
\ No newline at end of file